@@ -0,0 +1,187 @@
+#define _DEFAULT_SOURCE
+
+#include "blocking_queue.h"
+#include "queue.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <time.h>
+
+/**
+ * a producer feeding 8 byte messages to consumer threads through a bounded queue:
+ * a fixed `queue` with a mutex and two condition variables, the way `threadpool`
+ * waits for tasks, against `blocking_queue` one element at a time and in batches.
+ * usage: bench_blocking_queue [messages] [consumers] [batch] [capacity]
+ */
+
+enum { CONDVAR, BLOCKING_SINGLE, BLOCKING_BATCH, VARIANTS };
+
+#define MAX_BATCH 1024
+
+typedef struct
+{
+    pthread_mutex_t lock;
+    pthread_cond_t  not_empty;
+    pthread_cond_t  not_full;
+    queue          *items;
+    size_t          capacity;
+    bool            closed;
+} condvar_queue;
+
+struct pipe_args
+{
+    int             variant;
+    condvar_queue  *condvar;
+    blocking_queue *blocking;
+    size_t          messages;
+    size_t          batch;
+    uint64_t        checksum;
+};
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void condvar_enque(condvar_queue *q, const uint64_t *message)
+{
+    pthread_mutex_lock(&q->lock);
+    while ((size_t)queue_size(q->items) >= q->capacity)
+        pthread_cond_wait(&q->not_full, &q->lock);
+    queue_enque(q->items, message, sizeof(*message));
+    pthread_mutex_unlock(&q->lock);
+    pthread_cond_signal(&q->not_empty);
+}
+
+static bool condvar_deque(condvar_queue *q, uint64_t *message)
+{
+    pthread_mutex_lock(&q->lock);
+    while (queue_size(q->items) == 0 && !q->closed)
+        pthread_cond_wait(&q->not_empty, &q->lock);
+    bool dequeued = queue_deque_into(q->items, message);
+    pthread_mutex_unlock(&q->lock);
+    pthread_cond_signal(&q->not_full);
+    return dequeued;
+}
+
+void *producer(void *argp)
+{
+    struct pipe_args *args = argp;
+    uint64_t buffer[MAX_BATCH];
+
+    for (uint64_t next = 0; next < args->messages;)
+    {
+        size_t n = args->variant == BLOCKING_BATCH ? args->batch : 1;
+        if (n > args->messages - next)
+            n = args->messages - next;
+        for (size_t i = 0; i < n; i++)
+            buffer[i] = next + i;
+
+        if (args->variant == CONDVAR)
+            condvar_enque(args->condvar, buffer);
+        else
+            blocking_queue_enque_batch(args->blocking, buffer, n);
+        next += n;
+    }
+    return NULL;
+}
+
+void *consumer(void *argp)
+{
+    struct pipe_args *args = argp;
+    uint64_t buffer[MAX_BATCH];
+
+    while (true)
+    {
+        size_t count = args->variant == CONDVAR         ? condvar_deque(args->condvar, buffer)
+                     : args->variant == BLOCKING_SINGLE ? blocking_queue_deque(args->blocking, buffer)
+                                                        : blocking_queue_deque_batch(args->blocking, buffer, args->batch,
+                                                                                     BLOCKING_QUEUE_NO_TIMEOUT);
+        if (count == 0)
+            break; // closed and drained
+        for (size_t i = 0; i < count; i++)
+            args->checksum += buffer[i];
+    }
+    return NULL;
+}
+
+int main(int argc, char **argv)
+{
+    size_t messages = argc > 1 ? strtoul(argv[1], NULL, 10) : 10000000;
+    size_t consumers = argc > 2 ? strtoul(argv[2], NULL, 10) : 4;
+    size_t batch = argc > 3 ? strtoul(argv[3], NULL, 10) : 64;
+    size_t capacity = argc > 4 ? strtoul(argv[4], NULL, 10) : 1024;
+    if (batch == 0 || batch > MAX_BATCH)
+        batch = MAX_BATCH;
+    if (consumers == 0)
+        consumers = 1;
+
+    const char *names[VARIANTS] = { "mutex + condvar", "blocking_queue_deque", "blocking_queue_deque_batch" };
+    double elapsed[VARIANTS];
+    bool valid = true;
+
+    pthread_t *threads = malloc(consumers * sizeof(pthread_t));
+    struct pipe_args *args = malloc((consumers + 1) * sizeof(struct pipe_args));
+    if (threads == NULL || args == NULL)
+        return 1;
+
+    for (int v = 0; v < VARIANTS; v++)
+    {
+        condvar_queue condvar = {
+            .lock = PTHREAD_MUTEX_INITIALIZER,
+            .not_empty = PTHREAD_COND_INITIALIZER,
+            .not_full = PTHREAD_COND_INITIALIZER,
+            .items = queue_create_fixed(sizeof(uint64_t), capacity),
+            .capacity = capacity,
+        };
+        blocking_queue *blocking = blocking_queue_create(sizeof(uint64_t), capacity);
+        if (condvar.items == NULL || blocking == NULL)
+            return 1;
+
+        double start = now();
+        for (size_t t = 0; t <= consumers; t++)
+        {
+            args[t] = (struct pipe_args){ v, &condvar, blocking, messages, batch, 0 };
+            if (t < consumers)
+                pthread_create(&threads[t], NULL, consumer, &args[t]);
+        }
+        producer(&args[consumers]);
+
+        /* the consumers leave once everything was taken */
+        if (v == CONDVAR)
+        {
+            pthread_mutex_lock(&condvar.lock);
+            condvar.closed = true;
+            pthread_mutex_unlock(&condvar.lock);
+            pthread_cond_broadcast(&condvar.not_empty);
+        }
+        else
+            blocking_queue_close(blocking);
+
+        uint64_t checksum = 0;
+        for (size_t t = 0; t < consumers; t++)
+        {
+            pthread_join(threads[t], NULL);
+            checksum += args[t].checksum;
+        }
+        elapsed[v] = now() - start;
+        valid = valid && checksum == (uint64_t)messages * (messages - 1) / 2;
+
+        queue_destroy(condvar.items);
+        blocking_queue_destroy(blocking);
+    }
+
+    printf("%zu 8 byte messages, 1 producer, %zu consumers, capacity %zu, batches of %zu%s\n", messages, consumers,
+           capacity, batch, valid ? "" : " CHECKSUM MISMATCH");
+    printf("%-28s %10s %10s\n", "", "Mmsg/s", "speedup");
+    for (int v = 0; v < VARIANTS; v++)
+        printf("%-28s %10.1f %9.1fx\n", names[v], messages / elapsed[v] / 1e6, elapsed[CONDVAR] / elapsed[v]);
+
+    free(args);
+    free(threads);
+    return 0;
+}
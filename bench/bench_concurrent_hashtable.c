@@ -0,0 +1,137 @@
+#define _DEFAULT_SOURCE
+
+#include "concurrent_hashtable.h"
+#include "hashtable.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+/**
+ * throughput of an 80/20 get/put mix for a sweep of thread counts,
+ * concurrent_hashtable against a hashtable behind one global mutex.
+ * usage: bench_concurrent_hashtable [max_threads] [ops_per_thread]
+ */
+
+#define KEYS 1000000
+
+struct worker_args
+{
+    void            *table;
+    pthread_mutex_t *mutex;
+    size_t           ops;
+    unsigned int     seed;
+};
+
+size_t bench_hash(void *key)
+{
+    uint64_t k = *(uint64_t *)key;
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdull;
+    k ^= k >> 33;
+    return k;
+}
+
+size_t bench_compare(const void *key1, const void *key2)
+{
+    return *(const uint64_t *)key1 != *(const uint64_t *)key2;
+}
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+void *concurrent_worker(void *argp)
+{
+    struct worker_args *args = argp;
+    unsigned int seed = args->seed;
+    uint64_t value;
+
+    for (size_t i = 0; i < args->ops; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        uint64_t key = (seed >> 4) % KEYS;
+        if (seed % 10 < 8)
+            concurrent_hashtable_get(args->table, &key, &value, sizeof(value), NULL);
+        else
+            concurrent_hashtable_put(args->table, &key, sizeof(key), &i, sizeof(i));
+    }
+    return NULL;
+}
+
+void *mutex_worker(void *argp)
+{
+    struct worker_args *args = argp;
+    unsigned int seed = args->seed;
+    uint64_t value;
+
+    for (size_t i = 0; i < args->ops; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        uint64_t key = (seed >> 4) % KEYS;
+        pthread_mutex_lock(args->mutex);
+        if (seed % 10 < 8)
+            hashtable_get_into(args->table, &key, &value, sizeof(value), NULL);
+        else
+            hashtable_put(args->table, &key, sizeof(key), &i, sizeof(i));
+        pthread_mutex_unlock(args->mutex);
+    }
+    return NULL;
+}
+
+static double run(void *(*worker)(void *), void *table, pthread_mutex_t *mutex,
+                  const size_t thread_number, const size_t ops)
+{
+    pthread_t threads[thread_number];
+    struct worker_args args[thread_number];
+
+    double start = now();
+    for (size_t i = 0; i < thread_number; i++)
+    {
+        args[i] = (struct worker_args){ table, mutex, ops, (unsigned int)i * 7919 + 1 };
+        pthread_create(&threads[i], NULL, worker, &args[i]);
+    }
+    for (size_t i = 0; i < thread_number; i++)
+        pthread_join(threads[i], NULL);
+
+    return thread_number * ops / (now() - start);
+}
+
+int main(int argc, char **argv)
+{
+    size_t max_threads = argc > 1 ? strtoul(argv[1], NULL, 10) : 32;
+    size_t ops = argc > 2 ? strtoul(argv[2], NULL, 10) : 1000000;
+
+    concurrent_hashtable *cht = concurrent_hashtable_create(bench_hash, bench_compare);
+    hashtable *ht = hashtable_create(bench_hash, bench_compare);
+    pthread_mutex_t mutex;
+    pthread_mutex_init(&mutex, NULL);
+    if (cht == NULL || ht == NULL)
+        return 1;
+
+    for (uint64_t key = 0; key < KEYS; key++)
+    {
+        concurrent_hashtable_put(cht, &key, sizeof(key), &key, sizeof(key));
+        hashtable_put(ht, &key, sizeof(key), &key, sizeof(key));
+    }
+
+    printf("%8s %18s %18s %10s\n", "threads", "concurrent ops/s", "mutex ops/s", "speedup");
+    double single = 0;
+    for (size_t threads = 1; threads <= max_threads; threads *= 2)
+    {
+        double concurrent = run(concurrent_worker, cht, NULL, threads, ops);
+        double locked = run(mutex_worker, ht, &mutex, threads, ops);
+        if (threads == 1)
+            single = concurrent;
+        printf("%8zu %18.0f %18.0f %9.2fx\n", threads, concurrent, locked, concurrent / single);
+    }
+
+    pthread_mutex_destroy(&mutex);
+    hashtable_destroy(ht);
+    concurrent_hashtable_destroy(cht);
+    return 0;
+}
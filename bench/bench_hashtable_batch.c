@@ -0,0 +1,81 @@
+#define _DEFAULT_SOURCE
+
+#include "hashtable.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+/**
+ * random lookups on a table bigger than the last level cache,
+ * one hashtable_get_ref per key against hashtable_get_many.
+ * usage: bench_hashtable_batch [keys] [lookups]
+ */
+
+size_t bench_hash(void *key)
+{
+    uint64_t k = *(uint64_t *)key;
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdull;
+    k ^= k >> 33;
+    return k;
+}
+
+size_t bench_compare(const void *key1, const void *key2)
+{
+    return *(const uint64_t *)key1 != *(const uint64_t *)key2;
+}
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char **argv)
+{
+    size_t keys = argc > 1 ? strtoul(argv[1], NULL, 10) : 4000000;
+    size_t lookups = argc > 2 ? strtoul(argv[2], NULL, 10) : 10000000;
+
+    hashtable *ht = hashtable_create(bench_hash, bench_compare);
+    uint64_t *probe = malloc(lookups * sizeof(uint64_t));
+    const void **probe_keys = malloc(lookups * sizeof(void *));
+    const void **values = malloc(lookups * sizeof(void *));
+    if (ht == NULL || probe == NULL || probe_keys == NULL || values == NULL)
+        return 1;
+
+    for (uint64_t key = 0; key < keys; key++)
+        hashtable_put(ht, &key, sizeof(key), &key, sizeof(key));
+
+    unsigned int seed = 42;
+    for (size_t i = 0; i < lookups; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        probe[i] = ((uint64_t)seed << 16 ^ seed) % keys;
+        probe_keys[i] = &probe[i];
+    }
+
+    uint64_t checksum = 0;
+    double start = now();
+    for (size_t i = 0; i < lookups; i++)
+        checksum += *(const uint64_t *)hashtable_get_ref(ht, probe_keys[i], NULL);
+    double single = now() - start;
+
+    start = now();
+    hashtable_get_many(ht, probe_keys, lookups, values, NULL);
+    for (size_t i = 0; i < lookups; i++)
+        checksum -= *(const uint64_t *)values[i];
+    double batched = now() - start;
+
+    printf("%zu keys, %zu random lookups (checksum %s)\n", keys, lookups, checksum == 0 ? "ok" : "MISMATCH");
+    printf("%-24s %12.1f Mops/s\n", "hashtable_get_ref", lookups / single / 1e6);
+    printf("%-24s %12.1f Mops/s (%.2fx)\n", "hashtable_get_many", lookups / batched / 1e6, single / batched);
+
+    free(values);
+    free(probe_keys);
+    free(probe);
+    hashtable_destroy(ht);
+    return 0;
+}
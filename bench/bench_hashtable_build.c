@@ -0,0 +1,84 @@
+#define _DEFAULT_SOURCE
+
+#include "hashtable.h"
+#include "hashtable_parallel.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+/**
+ * bulk build of a table from an array of records: sequential puts, put_many
+ * and hashtable_build_parallel for a sweep of thread counts.
+ * usage: bench_hashtable_build [records] [max_threads]
+ */
+
+size_t bench_compare(const void *key1, const void *key2)
+{
+    return *(const uint64_t *)key1 != *(const uint64_t *)key2;
+}
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char **argv)
+{
+    size_t records = argc > 1 ? strtoul(argv[1], NULL, 10) : 10000000;
+    size_t max_threads = argc > 2 ? strtoul(argv[2], NULL, 10) : 16;
+
+    uint64_t *keys = malloc(records * sizeof(uint64_t));
+    hashtable_entry *entries = malloc(records * sizeof(hashtable_entry));
+    if (keys == NULL || entries == NULL)
+        return 1;
+
+    unsigned int seed = 42;
+    for (size_t i = 0; i < records; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        keys[i] = (uint64_t)seed << 32 | i;
+        entries[i] = (hashtable_entry){ &keys[i], sizeof(uint64_t), &keys[i], sizeof(uint64_t) };
+    }
+
+    printf("%zu records\n%-28s %12s\n", records, "", "Mrecords/s");
+
+    hashtable *ht = hashtable_create(hash_uint64_t, bench_compare);
+    double start = now();
+    for (size_t i = 0; i < records; i++)
+        hashtable_put(ht, &keys[i], sizeof(uint64_t), &keys[i], sizeof(uint64_t));
+    double sequential = now() - start;
+    printf("%-28s %12.2f\n", "hashtable_put", records / sequential / 1e6);
+    hashtable_destroy(ht);
+
+    ht = hashtable_create(hash_uint64_t, bench_compare);
+    start = now();
+    hashtable_put_many(ht, entries, records);
+    printf("%-28s %12.2f\n", "hashtable_put_many", records / (now() - start) / 1e6);
+    hashtable_destroy(ht);
+
+    for (size_t threads = 1; threads <= max_threads; threads *= 2)
+    {
+        threadpool *tp = threadpool_create(threads);
+        ht = hashtable_create(hash_uint64_t, bench_compare);
+        if (tp == NULL || ht == NULL)
+            return 1;
+
+        start = now();
+        bool built = hashtable_build_parallel(ht, entries, records, tp);
+        double elapsed = now() - start;
+
+        char label[32];
+        snprintf(label, sizeof(label), "build_parallel %zu threads", threads);
+        printf("%-28s %12.2f (%.2fx)%s\n", label, records / elapsed / 1e6, sequential / elapsed, built ? "" : " FAILED");
+        hashtable_destroy(ht);
+        threadpool_destroy(tp, false);
+    }
+
+    free(entries);
+    free(keys);
+    return 0;
+}
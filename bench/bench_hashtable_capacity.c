@@ -0,0 +1,92 @@
+#define _DEFAULT_SOURCE
+
+#include "hashtable.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+/**
+ * bulk load of sequential keys into a table grown on demand against one
+ * created with the final capacity, then random lookups for a sweep of
+ * grow load factors.
+ * usage: bench_hashtable_capacity [keys] [lookups]
+ */
+
+size_t bench_compare(const void *key1, const void *key2)
+{
+    return *(const uint64_t *)key1 != *(const uint64_t *)key2;
+}
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static double load(hashtable *ht, const size_t keys)
+{
+    double start = now();
+    for (uint64_t key = 0; key < keys; key++)
+        hashtable_put(ht, &key, sizeof(key), &key, sizeof(key));
+    return now() - start;
+}
+
+static double lookup(const hashtable *ht, const uint64_t *probe, const size_t lookups, uint64_t *checksum)
+{
+    double start = now();
+    for (size_t i = 0; i < lookups; i++)
+        *checksum += *(const uint64_t *)hashtable_get_ref(ht, &probe[i], NULL);
+    return now() - start;
+}
+
+int main(int argc, char **argv)
+{
+    size_t keys = argc > 1 ? strtoul(argv[1], NULL, 10) : 10000000;
+    size_t lookups = argc > 2 ? strtoul(argv[2], NULL, 10) : 10000000;
+
+    uint64_t *probe = malloc(lookups * sizeof(uint64_t));
+    if (probe == NULL)
+        return 1;
+
+    unsigned int seed = 42;
+    for (size_t i = 0; i < lookups; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        probe[i] = ((uint64_t)seed << 16 ^ seed) % keys;
+    }
+
+    hashtable *grown = hashtable_create(hash_uint64_t, bench_compare);
+    hashtable *reserved = hashtable_create_with_capacity(hash_uint64_t, bench_compare, keys);
+    if (grown == NULL || reserved == NULL)
+        return 1;
+
+    double grown_time = load(grown, keys);
+    double reserved_time = load(reserved, keys);
+    printf("%zu keys bulk load\n", keys);
+    printf("%-28s %12.1f Mops/s\n", "hashtable_create", keys / grown_time / 1e6);
+    printf("%-28s %12.1f Mops/s (%.2fx)\n", "hashtable_create_with_capacity",
+           keys / reserved_time / 1e6, grown_time / reserved_time);
+    hashtable_destroy(grown);
+    hashtable_destroy(reserved);
+
+    printf("\n%zu random lookups\n%12s %12s %12s\n", lookups, "load factor", "buckets", "Mops/s");
+    const double load_factors[] = {0.5, 0.75, 1.0, 2.0};
+    for (size_t i = 0; i < sizeof(load_factors) / sizeof(load_factors[0]); i++)
+    {
+        hashtable *ht = hashtable_create(hash_uint64_t, bench_compare);
+        if (ht == NULL || !hashtable_set_load_factors(ht, load_factors[i], 0) || !hashtable_reserve(ht, keys))
+            return 1;
+        load(ht, keys);
+
+        uint64_t checksum = 0;
+        double elapsed = lookup(ht, probe, lookups, &checksum);
+        printf("%12.2f %12zu %12.1f\n", load_factors[i], ht->buckets_size, lookups / elapsed / 1e6);
+        hashtable_destroy(ht);
+    }
+
+    free(probe);
+    return 0;
+}
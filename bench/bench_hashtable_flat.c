@@ -0,0 +1,108 @@
+#define _DEFAULT_SOURCE
+
+#include "hashtable.h"
+#include "hashtable_flat.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+/**
+ * uint64 -> uint64 map: inserts, random hits and random misses, the chained
+ * hashtable against hashtable_flat. Both gets return a malloc'd copy, misses
+ * don't allocate and only measure the probe.
+ * usage: bench_hashtable_flat [keys] [lookups]
+ */
+
+size_t bench_compare(const void *key1, const void *key2)
+{
+    return *(const uint64_t *)key1 != *(const uint64_t *)key2;
+}
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char **argv)
+{
+    size_t keys = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000;
+    size_t lookups = argc > 2 ? strtoul(argv[2], NULL, 10) : 10000000;
+
+    hashtable *chained = hashtable_create(hash_uint64_t, bench_compare);
+    hashtable_flat *flat = hashtable_flat_create(hash_uint64_t, bench_compare);
+    uint64_t *probe = malloc(lookups * sizeof(uint64_t));
+    if (chained == NULL || flat == NULL || probe == NULL)
+        return 1;
+
+    unsigned int seed = 42;
+    for (size_t i = 0; i < lookups; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        probe[i] = ((uint64_t)seed << 16 ^ seed) % keys;
+    }
+
+    double start = now();
+    for (uint64_t key = 0; key < keys; key++)
+        hashtable_put(chained, &key, sizeof(key), &key, sizeof(key));
+    double chained_put = now() - start;
+
+    start = now();
+    for (uint64_t key = 0; key < keys; key++)
+        hashtable_flat_put(flat, &key, sizeof(key), &key, sizeof(key));
+    double flat_put = now() - start;
+
+    uint64_t checksum = 0;
+    start = now();
+    for (size_t i = 0; i < lookups; i++)
+    {
+        uint64_t *value = hashtable_get(chained, &probe[i]);
+        checksum += *value;
+        free(value);
+    }
+    double chained_hit = now() - start;
+
+    start = now();
+    for (size_t i = 0; i < lookups; i++)
+    {
+        uint64_t *value = hashtable_flat_get(flat, &probe[i]);
+        checksum -= *value;
+        free(value);
+    }
+    double flat_hit = now() - start;
+
+    /* every probed key is shifted past the stored ones */
+    size_t misses = 0;
+    start = now();
+    for (size_t i = 0; i < lookups; i++)
+    {
+        uint64_t key = probe[i] + keys;
+        misses += hashtable_get(chained, &key) == NULL;
+    }
+    double chained_miss = now() - start;
+
+    start = now();
+    for (size_t i = 0; i < lookups; i++)
+    {
+        uint64_t key = probe[i] + keys;
+        misses -= hashtable_flat_get(flat, &key) == NULL;
+    }
+    double flat_miss = now() - start;
+
+    printf("%zu keys, %zu random lookups (checksum %s)\n", keys, lookups,
+           checksum == 0 && misses == 0 ? "ok" : "MISMATCH");
+    printf("%-16s %12s %12s %12s\n", "", "put Mops/s", "hit Mops/s", "miss Mops/s");
+    printf("%-16s %12.1f %12.1f %12.1f\n", "hashtable", keys / chained_put / 1e6,
+           lookups / chained_hit / 1e6, lookups / chained_miss / 1e6);
+    printf("%-16s %12.1f %12.1f %12.1f (%.2fx, %.2fx, %.2fx)\n", "hashtable_flat", keys / flat_put / 1e6,
+           lookups / flat_hit / 1e6, lookups / flat_miss / 1e6,
+           chained_put / flat_put, chained_hit / flat_hit, chained_miss / flat_miss);
+
+    free(probe);
+    hashtable_flat_destroy(flat);
+    hashtable_destroy(chained);
+    return 0;
+}
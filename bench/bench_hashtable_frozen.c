@@ -0,0 +1,80 @@
+#define _DEFAULT_SOURCE
+
+#include "hashtable.h"
+#include "hashtable_frozen.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+/**
+ * uint64 -> uint64 table: freeze time, memory and random lookups of the
+ * chained hashtable against its frozen copy.
+ * usage: bench_hashtable_frozen [keys] [lookups]
+ */
+
+size_t bench_compare(const void *key1, const void *key2)
+{
+    return *(const uint64_t *)key1 != *(const uint64_t *)key2;
+}
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char **argv)
+{
+    size_t keys = argc > 1 ? strtoul(argv[1], NULL, 10) : 4000000;
+    size_t lookups = argc > 2 ? strtoul(argv[2], NULL, 10) : 10000000;
+
+    hashtable *ht = hashtable_create(hash_uint64_t, bench_compare);
+    uint64_t *probe = malloc(lookups * sizeof(uint64_t));
+    if (ht == NULL || probe == NULL)
+        return 1;
+
+    for (uint64_t key = 0; key < keys; key++)
+        hashtable_put(ht, &key, sizeof(key), &key, sizeof(key));
+
+    unsigned int seed = 42;
+    for (size_t i = 0; i < lookups; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        probe[i] = ((uint64_t)seed << 16 ^ seed) % keys;
+    }
+
+    double start = now();
+    hashtable_frozen *frozen = hashtable_freeze(ht);
+    double freeze = now() - start;
+    if (frozen == NULL)
+        return 1;
+
+    uint64_t checksum = 0;
+    start = now();
+    for (size_t i = 0; i < lookups; i++)
+        checksum += *(const uint64_t *)hashtable_get_ref(ht, &probe[i], NULL);
+    double chained = now() - start;
+
+    start = now();
+    for (size_t i = 0; i < lookups; i++)
+        checksum -= *(const uint64_t *)hashtable_frozen_get(frozen, &probe[i], NULL);
+    double frozen_time = now() - start;
+
+    hashtable_statistics stats;
+    hashtable_stats(ht, &stats);
+
+    printf("%zu keys, %zu random lookups (checksum %s), frozen in %.2f s\n",
+           keys, lookups, checksum == 0 ? "ok" : "MISMATCH", freeze);
+    printf("%-20s %12s %12s\n", "", "bytes/pair", "Mops/s");
+    printf("%-20s %12.1f %12.1f\n", "hashtable", (double)stats.total_bytes / keys, lookups / chained / 1e6);
+    printf("%-20s %12.1f %12.1f (%.2fx)\n", "hashtable_frozen", (double)frozen->image_size / keys,
+           lookups / frozen_time / 1e6, chained / frozen_time);
+
+    hashtable_frozen_destroy(frozen);
+    hashtable_destroy(ht);
+    free(probe);
+    return 0;
+}
@@ -0,0 +1,112 @@
+#define _DEFAULT_SOURCE
+
+#include "hashtable.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <malloc.h>
+
+/**
+ * large values built in malloc'd buffers: stored with `hashtable_put` and freed
+ * by the caller, then removed with `hashtable_get` + `hashtable_remove`, against
+ * `hashtable_put_owned` and `hashtable_take`. The heap is never trimmed and large
+ * buffers aren't mmapped, every round but the first reuses the memory freed by the
+ * previous one so page faults don't hide the copies.
+ * usage: bench_hashtable_owned [keys] [value size] [rounds]
+ */
+
+size_t bench_compare(const void *key1, const void *key2)
+{
+    return *(const uint64_t *)key1 != *(const uint64_t *)key2;
+}
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void *build_value(const uint64_t key, const size_t value_size)
+{
+    unsigned char *value = malloc(value_size);
+    if (value == NULL)
+        exit(1);
+    memset(value, (int)key, value_size);
+    return value;
+}
+
+int main(int argc, char **argv)
+{
+    size_t keys = argc > 1 ? strtoul(argv[1], NULL, 10) : 100000;
+    size_t value_size = argc > 2 ? strtoul(argv[2], NULL, 10) : 4096;
+    size_t rounds = argc > 3 ? strtoul(argv[3], NULL, 10) : 5;
+
+    mallopt(M_TRIM_THRESHOLD, INT32_MAX);
+    mallopt(M_MMAP_THRESHOLD, INT32_MAX);
+
+    hashtable *copied = hashtable_create(hash_uint64_t, bench_compare);
+    hashtable *owned = hashtable_create(hash_uint64_t, bench_compare);
+    if (copied == NULL || owned == NULL || value_size == 0)
+        return 1;
+
+    double copy_put = 0, owned_put = 0, copy_remove = 0, owned_take = 0;
+    size_t checksum = 0, taken_checksum = 0;
+    for (size_t round = 0; round < rounds; round++)
+    {
+        double start = now();
+        for (uint64_t key = 0; key < keys; key++)
+        {
+            void *value = build_value(key, value_size);
+            hashtable_put(copied, &key, sizeof(key), value, value_size);
+            free(value);
+        }
+        copy_put += now() - start;
+
+        start = now();
+        for (uint64_t key = 0; key < keys; key++)
+        {
+            unsigned char *value = hashtable_get(copied, &key);
+            hashtable_remove(copied, &key);
+            checksum += value[value_size - 1];
+            free(value);
+        }
+        copy_remove += now() - start;
+
+        start = now();
+        for (uint64_t key = 0; key < keys; key++)
+        {
+            uint64_t *owned_key = malloc(sizeof(uint64_t));
+            if (owned_key == NULL)
+                return 1;
+            *owned_key = key;
+            hashtable_put_owned(owned, owned_key, sizeof(key), build_value(key, value_size), value_size);
+        }
+        owned_put += now() - start;
+
+        start = now();
+        for (uint64_t key = 0; key < keys; key++)
+        {
+            void *taken_key;
+            unsigned char *value;
+            hashtable_take(owned, &key, &taken_key, NULL, (void **)&value, NULL);
+            taken_checksum += value[value_size - 1];
+            free(taken_key);
+            free(value);
+        }
+        owned_take += now() - start;
+    }
+
+    printf("%zu keys, %zu byte values, %zu rounds%s\n", keys, value_size, rounds,
+           checksum == taken_checksum ? "" : " CHECKSUM MISMATCH");
+    printf("%-28s %10s %10s\n", "", "insert ms", "remove ms");
+    printf("%-28s %10.1f %10.1f\n", "put, get + remove (copies)", copy_put * 1e3, copy_remove * 1e3);
+    printf("%-28s %10.1f %10.1f\n", "put_owned, take", owned_put * 1e3, owned_take * 1e3);
+
+    hashtable_destroy(copied);
+    hashtable_destroy(owned);
+    return 0;
+}
@@ -0,0 +1,100 @@
+#define _DEFAULT_SOURCE
+
+#include "hashtable.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+/**
+ * a table of persistent keys plus a few expiring ones, spread over one second:
+ * reclaiming them with a full sweep of `hashtable_keyset` checking an expiry
+ * stored in the value, against `hashtable_put_ttl` and `hashtable_expire`.
+ * usage: bench_hashtable_ttl [keys] [expiring keys]
+ */
+
+static uint64_t fake_now = 0;
+
+static uint64_t fake_clock(void)
+{
+    return fake_now;
+}
+
+size_t bench_compare(const void *key1, const void *key2)
+{
+    return *(const uint64_t *)key1 != *(const uint64_t *)key2;
+}
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* every key whose value is an expiry at or before `time` is removed */
+static size_t sweep(hashtable *ht, const uint64_t time)
+{
+    size_t removed = 0;
+    void **keyset = hashtable_keyset(ht);
+    for (size_t i = 0; keyset != NULL && keyset[i] != NULL; i++)
+    {
+        const uint64_t *expires_at = hashtable_get_ref(ht, keyset[i], NULL);
+        if (*expires_at != 0 && *expires_at <= time)
+        {
+            uint64_t key = *(const uint64_t *)keyset[i];
+            hashtable_remove(ht, &key);
+            removed++;
+        }
+    }
+    free(keyset);
+    return removed;
+}
+
+int main(int argc, char **argv)
+{
+    size_t keys = argc > 1 ? strtoul(argv[1], NULL, 10) : 2000000;
+    size_t expiring = argc > 2 ? strtoul(argv[2], NULL, 10) : 20000;
+
+    hashtable *swept = hashtable_create(hash_uint64_t, bench_compare);
+    hashtable *wheeled = hashtable_create(hash_uint64_t, bench_compare);
+    if (swept == NULL || wheeled == NULL || !hashtable_set_clock(wheeled, fake_clock))
+        return 1;
+
+    uint64_t persistent = 0;
+    for (uint64_t key = 0; key < keys; key++)
+    {
+        hashtable_put(swept, &key, sizeof(key), &persistent, sizeof(persistent));
+        hashtable_put(wheeled, &key, sizeof(key), &persistent, sizeof(persistent));
+    }
+    for (uint64_t i = 0; i < expiring; i++)
+    {
+        uint64_t key = keys + i, ttl = 1 + i * 1000 / expiring;
+        hashtable_put(swept, &key, sizeof(key), &ttl, sizeof(ttl));
+        hashtable_put_ttl(wheeled, &key, sizeof(key), &key, sizeof(key), ttl);
+    }
+
+    /* one reclaim every 100 ms for a second */
+    double sweep_time = 0, expire_time = 0;
+    size_t swept_pairs = 0, expired_pairs = 0;
+    for (fake_now = 100; fake_now <= 1000; fake_now += 100)
+    {
+        double start = now();
+        swept_pairs += sweep(swept, fake_now);
+        sweep_time += now() - start;
+
+        start = now();
+        expired_pairs += hashtable_expire(wheeled, SIZE_MAX);
+        expire_time += now() - start;
+    }
+
+    printf("%zu keys, %zu expiring over 1 s, reclaimed every 100 ms\n", keys, expiring);
+    printf("%-20s %10s %12s\n", "", "reclaimed", "total ms");
+    printf("%-20s %10zu %12.2f\n", "keyset sweep", swept_pairs, sweep_time * 1e3);
+    printf("%-20s %10zu %12.2f\n", "hashtable_expire", expired_pairs, expire_time * 1e3);
+
+    hashtable_destroy(swept);
+    hashtable_destroy(wheeled);
+    return 0;
+}
@@ -0,0 +1,89 @@
+#define _DEFAULT_SOURCE
+
+#include "hashtable.h"
+#include "hashtable_typed.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+/**
+ * uint64 -> struct map: inserts then random lookups, the generic hashtable
+ * with hash_uint64_t against the same map generated by HASHTABLE_DECLARE.
+ * usage: bench_hashtable_typed [keys] [lookups]
+ */
+
+struct record
+{
+    uint64_t id;
+    double   score;
+};
+
+HASHTABLE_DECLARE(record_map, uint64_t, struct record, hashtable_typed_hash_int, HASHTABLE_TYPED_EQUAL)
+
+size_t bench_compare(const void *key1, const void *key2)
+{
+    return *(const uint64_t *)key1 != *(const uint64_t *)key2;
+}
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char **argv)
+{
+    size_t keys = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000;
+    size_t lookups = argc > 2 ? strtoul(argv[2], NULL, 10) : 10000000;
+
+    hashtable *generic = hashtable_create(hash_uint64_t, bench_compare);
+    record_map *typed = record_map_create();
+    uint64_t *probe = malloc(lookups * sizeof(uint64_t));
+    if (generic == NULL || typed == NULL || probe == NULL)
+        return 1;
+
+    unsigned int seed = 42;
+    for (size_t i = 0; i < lookups; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        probe[i] = ((uint64_t)seed << 16 ^ seed) % keys;
+    }
+
+    double start = now();
+    for (uint64_t key = 0; key < keys; key++)
+    {
+        struct record record = { key, key * 0.5 };
+        hashtable_put(generic, &key, sizeof(key), &record, sizeof(record));
+    }
+    double generic_put = now() - start;
+
+    start = now();
+    for (uint64_t key = 0; key < keys; key++)
+        record_map_put(typed, key, (struct record){ key, key * 0.5 });
+    double typed_put = now() - start;
+
+    uint64_t checksum = 0;
+    start = now();
+    for (size_t i = 0; i < lookups; i++)
+        checksum += ((const struct record *)hashtable_get_ref(generic, &probe[i], NULL))->id;
+    double generic_get = now() - start;
+
+    start = now();
+    for (size_t i = 0; i < lookups; i++)
+        checksum -= record_map_get(typed, probe[i])->id;
+    double typed_get = now() - start;
+
+    printf("%zu keys, %zu random lookups (checksum %s)\n", keys, lookups, checksum == 0 ? "ok" : "MISMATCH");
+    printf("%-20s %12s %12s\n", "", "put Mops/s", "get Mops/s");
+    printf("%-20s %12.1f %12.1f\n", "hashtable", keys / generic_put / 1e6, lookups / generic_get / 1e6);
+    printf("%-20s %12.1f %12.1f (%.2fx, %.2fx)\n", "HASHTABLE_DECLARE", keys / typed_put / 1e6,
+           lookups / typed_get / 1e6, generic_put / typed_put, generic_get / typed_get);
+
+    free(probe);
+    record_map_destroy(typed);
+    hashtable_destroy(generic);
+    return 0;
+}
@@ -0,0 +1,105 @@
+#define _DEFAULT_SOURCE
+
+#include "hashtable.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+/**
+ * counting occurrences of random uint64 keys: `hashtable_get` then `hashtable_put`,
+ * against `hashtable_upsert` and `hashtable_get_or_insert`.
+ * usage: bench_hashtable_upsert [distinct keys] [updates]
+ */
+
+size_t bench_compare(const void *key1, const void *key2)
+{
+    return *(const uint64_t *)key1 != *(const uint64_t *)key2;
+}
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void increment(void *value, const size_t value_size, void *context)
+{
+    (void)value_size;
+    (void)context;
+    (*(uint64_t *)value)++;
+}
+
+static void get_and_put(hashtable *ht, const uint64_t *key)
+{
+    uint64_t *count = hashtable_get(ht, key);
+    uint64_t updated = count == NULL ? 1 : *count + 1;
+    hashtable_put(ht, key, sizeof(*key), &updated, sizeof(updated));
+    free(count);
+}
+
+static void upsert(hashtable *ht, const uint64_t *key)
+{
+    uint64_t one = 1;
+    hashtable_upsert(ht, key, sizeof(*key), &one, sizeof(one), increment, NULL);
+}
+
+static void get_or_insert(hashtable *ht, const uint64_t *key)
+{
+    uint64_t *count = hashtable_get_or_insert(ht, key, sizeof(*key), NULL, sizeof(uint64_t), NULL);
+    (*count)++;
+}
+
+static double run(void (*count_key)(hashtable *ht, const uint64_t *key),
+                  const uint64_t *keys, const size_t updates, uint64_t *checksum)
+{
+    hashtable *ht = hashtable_create(hash_uint64_t, bench_compare);
+    if (ht == NULL)
+        exit(1);
+
+    double start = now();
+    for (size_t i = 0; i < updates; i++)
+        count_key(ht, &keys[i]);
+    double elapsed = now() - start;
+
+    *checksum = 0;
+    for (size_t i = 0; i < updates; i += 97)
+        *checksum += *(const uint64_t *)hashtable_get_ref(ht, &keys[i], NULL);
+    hashtable_destroy(ht);
+    return elapsed;
+}
+
+int main(int argc, char **argv)
+{
+    size_t distinct = argc > 1 ? strtoul(argv[1], NULL, 10) : 100000;
+    size_t updates = argc > 2 ? strtoul(argv[2], NULL, 10) : 20000000;
+
+    uint64_t *keys = malloc(updates * sizeof(uint64_t));
+    if (keys == NULL || distinct == 0)
+        return 1;
+
+    unsigned int seed = 42;
+    for (size_t i = 0; i < updates; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        keys[i] = ((uint64_t)seed << 16 ^ seed) % distinct;
+    }
+
+    uint64_t reference, checksum;
+    double baseline = run(get_and_put, keys, updates, &reference);
+    printf("%zu updates of %zu distinct keys\n", updates, distinct);
+    printf("%-24s %10s\n", "", "Mops/s");
+    printf("%-24s %10.1f\n", "hashtable_get + put", updates / baseline / 1e6);
+
+    double elapsed = run(upsert, keys, updates, &checksum);
+    printf("%-24s %10.1f (%.2fx)%s\n", "hashtable_upsert", updates / elapsed / 1e6, baseline / elapsed,
+           checksum == reference ? "" : " CHECKSUM MISMATCH");
+    elapsed = run(get_or_insert, keys, updates, &checksum);
+    printf("%-24s %10.1f (%.2fx)%s\n", "hashtable_get_or_insert", updates / elapsed / 1e6, baseline / elapsed,
+           checksum == reference ? "" : " CHECKSUM MISMATCH");
+
+    free(keys);
+    return 0;
+}
@@ -0,0 +1,144 @@
+#define _DEFAULT_SOURCE
+
+#include "queue.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+
+/**
+ * throughput of 8 byte messages for a sweep of thread counts, with as many
+ * producers as consumers: mpmc_queue against a fixed queue behind one mutex,
+ * both bounded to the same capacity.
+ * usage: bench_mpmc_queue [max_threads per side] [messages per producer] [capacity]
+ */
+
+struct worker_args
+{
+    mpmc_queue      *mpmc;
+    queue           *locked;
+    pthread_mutex_t *mutex;
+    size_t           capacity;
+    size_t           messages;
+    uint64_t         checksum;
+};
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static bool try_enque(struct worker_args *args, const uint64_t *message)
+{
+    if (args->mpmc != NULL)
+        return mpmc_queue_try_enque(args->mpmc, message);
+
+    pthread_mutex_lock(args->mutex);
+    bool enqueued = (size_t)queue_size(args->locked) < args->capacity && queue_enque(args->locked, message, sizeof(*message));
+    pthread_mutex_unlock(args->mutex);
+    return enqueued;
+}
+
+static bool try_deque(struct worker_args *args, uint64_t *message)
+{
+    if (args->mpmc != NULL)
+        return mpmc_queue_try_deque(args->mpmc, message);
+
+    pthread_mutex_lock(args->mutex);
+    bool dequeued = queue_deque_into(args->locked, message);
+    pthread_mutex_unlock(args->mutex);
+    return dequeued;
+}
+
+void *producer(void *argp)
+{
+    struct worker_args *args = argp;
+    for (uint64_t i = 0; i < args->messages; i++)
+        while (!try_enque(args, &i))
+            sched_yield();
+    return NULL;
+}
+
+void *consumer(void *argp)
+{
+    struct worker_args *args = argp;
+    uint64_t message;
+    for (size_t i = 0; i < args->messages; i++)
+    {
+        while (!try_deque(args, &message))
+            sched_yield();
+        args->checksum += message;
+    }
+    return NULL;
+}
+
+/* every consumer takes as many messages as a producer sends, returns the messages per second */
+static double run(const size_t threads, struct worker_args *shared, bool *valid)
+{
+    pthread_t *ids = malloc(2 * threads * sizeof(pthread_t));
+    struct worker_args *args = malloc(2 * threads * sizeof(struct worker_args));
+    if (ids == NULL || args == NULL)
+        exit(1);
+
+    double start = now();
+    for (size_t t = 0; t < 2 * threads; t++)
+    {
+        args[t] = *shared;
+        pthread_create(&ids[t], NULL, t < threads ? producer : consumer, &args[t]);
+    }
+    uint64_t checksum = 0;
+    for (size_t t = 0; t < 2 * threads; t++)
+    {
+        pthread_join(ids[t], NULL);
+        checksum += args[t].checksum;
+    }
+    double elapsed = now() - start;
+
+    *valid = *valid && checksum == threads * (shared->messages * (shared->messages - 1) / 2);
+    free(args);
+    free(ids);
+    return threads * shared->messages / elapsed;
+}
+
+int main(int argc, char **argv)
+{
+    size_t max_threads = argc > 1 ? strtoul(argv[1], NULL, 10) : 16;
+    size_t messages = argc > 2 ? strtoul(argv[2], NULL, 10) : 1000000;
+    size_t capacity = argc > 3 ? strtoul(argv[3], NULL, 10) : 1024;
+
+    bool valid = true;
+    printf("%-10s %16s %16s %8s\n", "threads", "mutex Mmsg/s", "mpmc Mmsg/s", "speedup");
+    for (size_t threads = 1; threads <= max_threads; threads *= 2)
+    {
+        pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+        struct worker_args shared = {
+            .locked = queue_create_fixed(sizeof(uint64_t), capacity),
+            .mutex = &mutex,
+            .capacity = capacity,
+            .messages = messages,
+        };
+        if (shared.locked == NULL)
+            return 1;
+        double locked = run(threads, &shared, &valid);
+        queue_destroy(shared.locked);
+
+        shared = (struct worker_args){
+            .mpmc = mpmc_queue_create(sizeof(uint64_t), capacity),
+            .messages = messages,
+        };
+        if (shared.mpmc == NULL)
+            return 1;
+        double mpmc = run(threads, &shared, &valid);
+        mpmc_queue_destroy(shared.mpmc);
+
+        printf("%2zu + %-5zu %16.1f %16.1f %7.1fx\n", threads, threads, locked / 1e6, mpmc / 1e6, mpmc / locked);
+    }
+    if (!valid)
+        printf("CHECKSUM MISMATCH\n");
+    return 0;
+}
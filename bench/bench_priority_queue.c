@@ -0,0 +1,146 @@
+#define _DEFAULT_SOURCE
+
+#include "priority_queue.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+/**
+ * 16 byte events keyed by a 64 bit time, for a binary heap against 4-ary and
+ * 8-ary heaps: pushes then pops of every element, heapify of an array then pops,
+ * a hold model (pop the earliest event, push one later) at constant size, and
+ * decrease-keys through handles.
+ * usage: bench_priority_queue [elements] [hold operations]
+ */
+
+enum { PUSH_POP, HEAPIFY_POP, HOLD, DECREASE_KEY, WORKLOADS };
+
+struct event
+{
+    uint64_t time;
+    uint64_t id;
+};
+
+int compare_event(const void *elem1, const void *elem2)
+{
+    uint64_t a = ((const struct event *)elem1)->time, b = ((const struct event *)elem2)->time;
+    return (a > b) - (a < b);
+}
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static uint64_t next_random(uint64_t *state)
+{
+    // xorshift64
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+static double run(const int workload, const size_t arity, const struct event *events, const size_t n,
+                  const size_t operations, uint64_t *checksum)
+{
+    priority_queue *pq = workload == DECREASE_KEY ? priority_queue_create_tracked(sizeof(struct event), arity, compare_event)
+                                                  : priority_queue_create(sizeof(struct event), arity, compare_event);
+    priority_queue_handle *handles = malloc(n * sizeof(priority_queue_handle));
+    struct event *out = malloc(n * sizeof(struct event));
+    if (pq == NULL || handles == NULL || out == NULL)
+        exit(1);
+
+    /* the hold model and the decrease-keys start from a full queue, outside of the timing */
+    if (workload == HOLD || workload == DECREASE_KEY)
+        priority_queue_push_n(pq, events, n, workload == DECREASE_KEY ? handles : NULL);
+
+    uint64_t state = 88172645463325252ull;
+    struct event event;
+    double start = now();
+    switch (workload)
+    {
+    case PUSH_POP:
+        for (size_t i = 0; i < n; i++)
+            priority_queue_push(pq, &events[i], NULL);
+        for (size_t i = 0; i < n; i++)
+        {
+            priority_queue_pop(pq, &event);
+            *checksum += event.time;
+        }
+        break;
+    case HEAPIFY_POP:
+        priority_queue_push_n(pq, events, n, NULL);
+        for (size_t popped = 0; popped < n;)
+        {
+            size_t count = priority_queue_pop_n(pq, out, 1024);
+            for (size_t i = 0; i < count; i++)
+                *checksum += out[i].time;
+            popped += count;
+        }
+        break;
+    case HOLD:
+        for (size_t i = 0; i < operations; i++)
+        {
+            priority_queue_pop(pq, &event);
+            *checksum += event.time;
+            event.time += next_random(&state) % (n * 2);
+            priority_queue_push(pq, &event, NULL);
+        }
+        break;
+    case DECREASE_KEY:
+        for (size_t i = 0; i < operations; i++)
+        {
+            size_t index = next_random(&state) % n;
+            event = (struct event){ events[index].time / 2, events[index].id };
+            priority_queue_update(pq, handles[index], &event);
+            *checksum += priority_queue_peek(pq) != NULL ? ((const struct event *)priority_queue_peek(pq))->time : 0;
+        }
+        break;
+    }
+    double elapsed = now() - start;
+
+    free(out);
+    free(handles);
+    priority_queue_destroy(pq);
+    return elapsed;
+}
+
+int main(int argc, char **argv)
+{
+    size_t n = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000;
+    size_t operations = argc > 2 ? strtoul(argv[2], NULL, 10) : 5000000;
+
+    struct event *events = malloc(n * sizeof(struct event));
+    if (events == NULL)
+        return 1;
+    uint64_t state = 2463534242ull;
+    for (size_t i = 0; i < n; i++)
+        events[i] = (struct event){ next_random(&state) >> 16, i };
+
+    const size_t arities[] = {2, 4, 8};
+    const char *names[WORKLOADS] = { "push + pop", "heapify + pop_n", "hold", "decrease-key" };
+    printf("%zu events of %zu bytes, %zu hold and decrease-key operations\n", n, sizeof(struct event), operations);
+    printf("%-18s %12s %12s %12s %10s %10s\n", "ms", "binary", "4-ary", "8-ary", "4 vs 2", "8 vs 2");
+    bool valid = true;
+    for (int w = 0; w < WORKLOADS; w++)
+    {
+        double elapsed[3];
+        uint64_t checksums[3] = {0};
+        for (int a = 0; a < 3; a++)
+            elapsed[a] = run(w, arities[a], events, n, operations, &checksums[a]);
+        /* the decrease-keys peek after every update, and the same events win whatever the arity */
+        valid = valid && checksums[0] == checksums[1] && checksums[0] == checksums[2];
+        printf("%-18s %12.1f %12.1f %12.1f %9.2fx %9.2fx\n", names[w], elapsed[0] * 1e3, elapsed[1] * 1e3,
+               elapsed[2] * 1e3, elapsed[0] / elapsed[1], elapsed[0] / elapsed[2]);
+    }
+    if (!valid)
+        printf("CHECKSUM MISMATCH\n");
+
+    free(events);
+    return 0;
+}
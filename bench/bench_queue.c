@@ -0,0 +1,82 @@
+#define _DEFAULT_SOURCE
+
+#include "queue.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+/**
+ * a FIFO of 16 byte items kept around `depth` elements: the linked queue with
+ * `queue_deque`, against a fixed queue with `queue_deque_into`.
+ * usage: bench_queue [operations] [depth]
+ */
+
+typedef struct
+{
+    uint64_t id;
+    uint64_t payload;
+} item;
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static double run(queue *q, const size_t operations, const size_t depth, const bool fixed, uint64_t *checksum)
+{
+    double start = now();
+    for (uint64_t i = 0; i < depth; i++)
+    {
+        item in = { i, i * 3 };
+        queue_enque(q, &in, sizeof(in));
+    }
+
+    *checksum = 0;
+    for (uint64_t i = depth; i < depth + operations; i++)
+    {
+        item in = { i, i * 3 };
+        queue_enque(q, &in, sizeof(in));
+        if (fixed)
+        {
+            item out;
+            queue_deque_into(q, &out);
+            *checksum += out.id ^ out.payload;
+        }
+        else
+        {
+            item *out = queue_deque(q);
+            *checksum += out->id ^ out->payload;
+            free(out);
+        }
+    }
+    return now() - start;
+}
+
+int main(int argc, char **argv)
+{
+    size_t operations = argc > 1 ? strtoul(argv[1], NULL, 10) : 20000000;
+    size_t depth = argc > 2 ? strtoul(argv[2], NULL, 10) : 1000;
+
+    queue *linked = queue_create();
+    queue *fixed = queue_create_fixed(sizeof(item), depth + 1);
+    if (linked == NULL || fixed == NULL)
+        return 1;
+
+    uint64_t linked_checksum, fixed_checksum;
+    double linked_time = run(linked, operations, depth, false, &linked_checksum);
+    double fixed_time = run(fixed, operations, depth, true, &fixed_checksum);
+
+    printf("%zu enqueue/dequeue pairs of %zu byte items, depth %zu%s\n", operations, sizeof(item), depth,
+           linked_checksum == fixed_checksum ? "" : " CHECKSUM MISMATCH");
+    printf("%-28s %10s\n", "", "Mops/s");
+    printf("%-28s %10.1f\n", "queue_create + queue_deque", operations / linked_time / 1e6);
+    printf("%-28s %10.1f (%.1fx)\n", "queue_create_fixed + _into", operations / fixed_time / 1e6, linked_time / fixed_time);
+
+    queue_destroy(linked);
+    queue_destroy(fixed);
+    return 0;
+}
@@ -0,0 +1,170 @@
+#define _GNU_SOURCE
+
+#include "queue.h"
+#include "spsc_queue.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <time.h>
+
+/**
+ * 8 byte messages from a producer thread to a consumer thread pinned to two
+ * different cores when there are two: a fixed `queue` behind a mutex, against
+ * `spsc_queue` one element at a time and in batches.
+ * usage: bench_spsc_queue [messages] [batch] [capacity]
+ */
+
+enum { MUTEX_QUEUE, SPSC_SINGLE, SPSC_BATCH, VARIANTS };
+
+#define MAX_BATCH 1024
+
+struct pipe_args
+{
+    int              variant;
+    int              cpu;
+    queue           *locked;
+    pthread_mutex_t *mutex;
+    spsc_queue      *spsc;
+    size_t           messages;
+    size_t           batch;
+    size_t           capacity;
+    uint64_t         checksum;
+};
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void pin(const int cpu)
+{
+    if (cpu < 0)
+        return;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+/* the mutex queue is bounded like the ring, so both keep the same amount of messages in flight */
+static size_t locked_push(struct pipe_args *args, const uint64_t *message)
+{
+    pthread_mutex_lock(args->mutex);
+    bool pushed = (size_t)queue_size(args->locked) < args->capacity && queue_enque(args->locked, message, sizeof(*message));
+    pthread_mutex_unlock(args->mutex);
+    return pushed;
+}
+
+static size_t locked_pop(struct pipe_args *args, uint64_t *message)
+{
+    pthread_mutex_lock(args->mutex);
+    bool popped = queue_deque_into(args->locked, message);
+    pthread_mutex_unlock(args->mutex);
+    return popped;
+}
+
+void *producer(void *argp)
+{
+    struct pipe_args *args = argp;
+    uint64_t buffer[MAX_BATCH];
+    pin(args->cpu);
+
+    for (uint64_t next = 0; next < args->messages;)
+    {
+        size_t n = args->variant == SPSC_BATCH ? args->batch : 1;
+        if (n > args->messages - next)
+            n = args->messages - next;
+        for (size_t i = 0; i < n; i++)
+            buffer[i] = next + i;
+
+        for (size_t pushed = 0; pushed < n;)
+        {
+            size_t count = args->variant == MUTEX_QUEUE ? locked_push(args, buffer)
+                         : args->variant == SPSC_SINGLE ? spsc_push(args->spsc, buffer)
+                                                        : spsc_push_n(args->spsc, buffer + pushed, n - pushed);
+            /* only matters when both threads share a core */
+            if (count == 0)
+                sched_yield();
+            pushed += count;
+        }
+        next += n;
+    }
+    return NULL;
+}
+
+void *consumer(void *argp)
+{
+    struct pipe_args *args = argp;
+    uint64_t buffer[MAX_BATCH];
+    pin(args->cpu < 0 ? -1 : args->cpu + 1);
+
+    for (size_t received = 0; received < args->messages;)
+    {
+        size_t count = args->variant == MUTEX_QUEUE ? locked_pop(args, buffer)
+                     : args->variant == SPSC_SINGLE ? spsc_pop(args->spsc, buffer)
+                                                    : spsc_pop_n(args->spsc, buffer, args->batch);
+        if (count == 0)
+            sched_yield();
+        for (size_t i = 0; i < count; i++)
+            args->checksum += buffer[i];
+        received += count;
+    }
+    return NULL;
+}
+
+int main(int argc, char **argv)
+{
+    size_t messages = argc > 1 ? strtoul(argv[1], NULL, 10) : 100000000;
+    size_t batch = argc > 2 ? strtoul(argv[2], NULL, 10) : 64;
+    size_t capacity = argc > 3 ? strtoul(argv[3], NULL, 10) : 4096;
+    if (batch == 0 || batch > MAX_BATCH)
+        batch = MAX_BATCH;
+
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    const char *names[VARIANTS] = { "mutex + queue", "spsc_push / spsc_pop", "spsc_push_n / spsc_pop_n" };
+    double elapsed[VARIANTS];
+    bool valid[VARIANTS];
+
+    for (int v = 0; v < VARIANTS; v++)
+    {
+        /* the mutex queue gets fewer messages, it would take minutes otherwise */
+        pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+        struct pipe_args args = {
+            .variant = v,
+            .cpu = cpus > 1 ? 0 : -1,
+            .locked = queue_create_fixed(sizeof(uint64_t), capacity),
+            .mutex = &mutex,
+            .spsc = spsc_queue_create(sizeof(uint64_t), capacity),
+            .messages = v == MUTEX_QUEUE ? messages / 10 : messages,
+            .batch = batch,
+            .capacity = capacity,
+        };
+        if (args.locked == NULL || args.spsc == NULL)
+            return 1;
+
+        pthread_t producer_thread, consumer_thread;
+        double start = now();
+        pthread_create(&consumer_thread, NULL, consumer, &args);
+        pthread_create(&producer_thread, NULL, producer, &args);
+        pthread_join(producer_thread, NULL);
+        pthread_join(consumer_thread, NULL);
+        elapsed[v] = (now() - start) / args.messages;
+        valid[v] = args.checksum == (uint64_t)args.messages * (args.messages - 1) / 2;
+
+        queue_destroy(args.locked);
+        spsc_queue_destroy(args.spsc);
+    }
+
+    printf("8 byte messages, capacity %zu, batches of %zu, %ld cpus%s\n", capacity, batch, cpus,
+           valid[MUTEX_QUEUE] && valid[SPSC_SINGLE] && valid[SPSC_BATCH] ? "" : " CHECKSUM MISMATCH");
+    printf("%-26s %10s %10s\n", "", "Mmsg/s", "ns/msg");
+    for (int v = 0; v < VARIANTS; v++)
+        printf("%-26s %10.1f %10.2f\n", names[v], 1 / elapsed[v] / 1e6, elapsed[v] * 1e9);
+    return 0;
+}
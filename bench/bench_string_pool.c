@@ -0,0 +1,133 @@
+#define _DEFAULT_SOURCE
+
+#include "hashtable.h"
+#include "string_pool.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * many tables keyed by the same vocabulary of strings: NUL terminated keys copied
+ * into every pair with `hash_string` and `compare_string`, against length prefixed
+ * `hashtable_string` keys pointing to the caller's strings, and against pointers to
+ * strings interned once in a `string_pool`.
+ * usage: bench_string_pool [distinct strings] [tables]
+ */
+
+enum { COPIED, PREFIXED, INTERNED, VARIANTS };
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static size_t table_bytes(hashtable **tables, const size_t n)
+{
+    size_t bytes = 0;
+    for (size_t t = 0; t < n; t++)
+    {
+        hashtable_statistics stats;
+        hashtable_stats(tables[t], &stats);
+        bytes += stats.total_bytes;
+    }
+    return bytes;
+}
+
+static void *key_of(const size_t variant, char **words, const hashtable_string *prefixed,
+                    const hashtable_string **interned, const size_t i)
+{
+    return variant == COPIED ? (void *)words[i] : variant == PREFIXED ? (void *)&prefixed[i] : (void *)&interned[i];
+}
+
+int main(int argc, char **argv)
+{
+    size_t distinct = argc > 1 ? strtoul(argv[1], NULL, 10) : 200000;
+    size_t tables = argc > 2 ? strtoul(argv[2], NULL, 10) : 20;
+
+    char **words = malloc(distinct * sizeof(char *));
+    hashtable_string *prefixed = malloc(distinct * sizeof(hashtable_string));
+    const hashtable_string **interned = malloc(distinct * sizeof(hashtable_string *));
+    hashtable **sets = malloc(VARIANTS * tables * sizeof(hashtable *));
+    string_pool *pool = string_pool_create();
+    if (words == NULL || prefixed == NULL || interned == NULL || sets == NULL || pool == NULL)
+        return 1;
+
+    for (size_t i = 0; i < distinct; i++)
+    {
+        char buffer[64];
+        int length = snprintf(buffer, sizeof(buffer), "/var/lib/collection/entry-%07zu/name", i * 7919 % distinct);
+        words[i] = malloc(length + 1);
+        if (words[i] == NULL)
+            return 1;
+        memcpy(words[i], buffer, length + 1);
+        prefixed[i] = hashtable_string_make(words[i], length);
+    }
+
+    size_t (*hash_functions[VARIANTS])(void *) = { hash_string, hash_hashtable_string, hash_interned_string };
+    size_t (*compare_functions[VARIANTS])(const void *, const void *) = {
+        compare_string, compare_hashtable_string, compare_interned_string
+    };
+    const char *names[VARIANTS] = { "copied C strings", "(ptr, len) keys", "interned pointers" };
+    double build[VARIANTS], lookup[VARIANTS];
+    size_t bytes[VARIANTS], sums[VARIANTS] = {0};
+
+    for (size_t v = 0; v < VARIANTS; v++)
+    {
+        /* every table holds every word, interning is part of the build */
+        hashtable **variant_tables = &sets[v * tables];
+        double start = now();
+        for (size_t t = 0; t < tables; t++)
+        {
+            variant_tables[t] = hashtable_create_with_capacity(hash_functions[v], compare_functions[v], distinct);
+            if (variant_tables[t] == NULL)
+                return 1;
+            for (size_t i = 0; i < distinct; i++)
+            {
+                if (v == INTERNED)
+                    interned[i] = string_pool_intern(pool, words[i], prefixed[i].length);
+                size_t key_size = v == COPIED ? prefixed[i].length + 1 : v == PREFIXED ? sizeof(hashtable_string)
+                                                                                       : sizeof(hashtable_string *);
+                hashtable_put(variant_tables[t], key_of(v, words, prefixed, interned, i), key_size, &i, sizeof(i));
+            }
+        }
+        build[v] = now() - start;
+
+        /* lookups with keys the caller already holds */
+        start = now();
+        for (size_t t = 0; t < tables; t++)
+            for (size_t i = 0; i < distinct; i++)
+                sums[v] += *(const size_t *)hashtable_get_ref(variant_tables[t], key_of(v, words, prefixed, interned, i), NULL);
+        lookup[v] = now() - start;
+
+        bytes[v] = table_bytes(variant_tables, tables);
+    }
+
+    /* the copied strings live in the pairs, the others are charged their strings once */
+    string_pool_statistics pool_stats;
+    string_pool_stats(pool, &pool_stats);
+    for (size_t i = 0; i < distinct; i++)
+        bytes[PREFIXED] += prefixed[i].length + 1;
+    bytes[INTERNED] += pool_stats.total_bytes;
+
+    printf("%zu tables of the same %zu strings, %zu pairs%s\n", tables, distinct, tables * distinct,
+           sums[COPIED] == sums[PREFIXED] && sums[COPIED] == sums[INTERNED] ? "" : " CHECKSUM MISMATCH");
+    printf("%-20s %10s %12s %10s\n", "", "build ms", "lookup ms", "MB");
+    for (size_t v = 0; v < VARIANTS; v++)
+        printf("%-20s %10.1f %12.1f %10.1f\n", names[v], build[v] * 1e3, lookup[v] * 1e3, bytes[v] / 1e6);
+
+    for (size_t i = 0; i < VARIANTS * tables; i++)
+        hashtable_destroy(sets[i]);
+    for (size_t i = 0; i < distinct; i++)
+        free(words[i]);
+    string_pool_destroy(pool);
+    free(sets);
+    free(interned);
+    free(prefixed);
+    free(words);
+    return 0;
+}
@@ -0,0 +1,282 @@
+#define _DEFAULT_SOURCE
+
+#include "blocking_queue.h"
+
+#include <stdlib.h>
+#include <limits.h>
+#include <time.h>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#else
+#include <sched.h>
+#endif
+
+#define NO_DEADLINE UINT64_MAX
+
+static uint64_t monotonic_nanoseconds(void);
+static uint64_t deadline_after(const uint64_t timeout);
+static bool wait_for(blocking_queue *q, blocking_queue_waiters *waiters, const uint64_t deadline);
+static int signal_waiters(blocking_queue_waiters *waiters, const size_t n);
+static void futex_wait(_Atomic uint32_t *word, const uint32_t expected, const uint64_t deadline);
+static void futex_wake(_Atomic uint32_t *word, const int n);
+
+blocking_queue *blocking_queue_create(const size_t elem_size, const size_t capacity)
+{
+    if (elem_size == 0)
+        return NULL;
+
+    blocking_queue *q = calloc(1, sizeof(blocking_queue));
+    if (q == NULL)
+        return NULL;
+
+    q->items = queue_create_fixed(elem_size, capacity);
+    if (q->items == NULL)
+    {
+        free(q);
+        return NULL;
+    }
+    pthread_mutex_init(&q->lock, NULL);
+    q->capacity = capacity;
+
+    return q;
+}
+
+bool blocking_queue_enque(blocking_queue *q, const void *data)
+{
+    return blocking_queue_enque_batch(q, data, 1) == 1;
+}
+
+size_t blocking_queue_enque_batch(blocking_queue *q, const void *data, const size_t n)
+{
+    if (q == NULL || data == NULL)
+        return 0;
+
+    const unsigned char *elems = data;
+    size_t done = 0;
+    while (done < n)
+    {
+        pthread_mutex_lock(&q->lock);
+        while (!q->closed && q->capacity != 0 && q->items->size >= q->capacity)
+            wait_for(q, &q->producers, NO_DEADLINE);
+        if (q->closed)
+        {
+            pthread_mutex_unlock(&q->lock);
+            break;
+        }
+
+        /* as many as fit, the consumers are signalled once for all of them */
+        size_t count = n - done;
+        if (q->capacity != 0 && count > q->capacity - q->items->size)
+            count = q->capacity - q->items->size;
+        size_t enqueued = 0;
+        while (enqueued < count && queue_enque(q->items, elems + (done + enqueued) * q->items->elem_size, q->items->elem_size))
+            enqueued++;
+        int wake = signal_waiters(&q->consumers, enqueued);
+        pthread_mutex_unlock(&q->lock);
+
+        if (wake > 0)
+            futex_wake(&q->consumers.sequence, wake);
+        done += enqueued;
+        if (enqueued < count)
+            break; // the ring couldn't grow
+    }
+
+    return done;
+}
+
+bool blocking_queue_deque(blocking_queue *q, void *out)
+{
+    return blocking_queue_deque_batch(q, out, 1, BLOCKING_QUEUE_NO_TIMEOUT) == 1;
+}
+
+bool blocking_queue_deque_timed(blocking_queue *q, void *out, const uint64_t timeout)
+{
+    return blocking_queue_deque_batch(q, out, 1, timeout) == 1;
+}
+
+size_t blocking_queue_deque_batch(blocking_queue *q, void *out, const size_t max_n, const uint64_t timeout)
+{
+    if (q == NULL || out == NULL || max_n == 0)
+        return 0;
+
+    uint64_t deadline = deadline_after(timeout);
+    pthread_mutex_lock(&q->lock);
+    while (q->items->size == 0 && !q->closed)
+        if (!wait_for(q, &q->consumers, deadline))
+            break;
+
+    unsigned char *elems = out;
+    size_t count = 0;
+    while (count < max_n && queue_deque_into(q->items, elems + count * q->items->elem_size))
+        count++;
+    int wake = q->capacity != 0 ? signal_waiters(&q->producers, count) : 0;
+    pthread_mutex_unlock(&q->lock);
+
+    if (wake > 0)
+        futex_wake(&q->producers.sequence, wake);
+    return count;
+}
+
+void blocking_queue_close(blocking_queue *q)
+{
+    if (q == NULL)
+        return;
+
+    /* every waiter has to come back and see the queue closed */
+    pthread_mutex_lock(&q->lock);
+    q->closed = true;
+    atomic_fetch_add(&q->consumers.sequence, 1);
+    atomic_fetch_add(&q->producers.sequence, 1);
+    bool wake_consumers = q->consumers.waiting > 0;
+    bool wake_producers = q->producers.waiting > 0;
+    pthread_mutex_unlock(&q->lock);
+
+    if (wake_consumers)
+        futex_wake(&q->consumers.sequence, INT_MAX);
+    if (wake_producers)
+        futex_wake(&q->producers.sequence, INT_MAX);
+}
+
+bool blocking_queue_drained(blocking_queue *q)
+{
+    if (q == NULL)
+        return false;
+
+    pthread_mutex_lock(&q->lock);
+    bool drained = q->closed && q->items->size == 0;
+    pthread_mutex_unlock(&q->lock);
+    return drained;
+}
+
+int blocking_queue_size(blocking_queue *q)
+{
+    if (q == NULL)
+        return -1;
+
+    pthread_mutex_lock(&q->lock);
+    int size = queue_size(q->items);
+    pthread_mutex_unlock(&q->lock);
+    return size;
+}
+
+void blocking_queue_destroy(blocking_queue *q)
+{
+    if (q == NULL)
+        return;
+
+    queue_destroy(q->items);
+    pthread_mutex_destroy(&q->lock);
+    free(q);
+}
+
+static uint64_t monotonic_nanoseconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t deadline_after(const uint64_t timeout)
+{
+    /* beyond a couple of centuries is forever */
+    if (timeout >= NO_DEADLINE / 2 / 1000000)
+        return NO_DEADLINE;
+    return monotonic_nanoseconds() + timeout * 1000000;
+}
+
+/**
+ * called and returning with the lock held, the caller checks its condition again
+ * afterwards: a wake up only means the other side did something. Returns false
+ * without waiting once the deadline has passed.
+ */
+static bool wait_for(blocking_queue *q, blocking_queue_waiters *waiters, const uint64_t deadline)
+{
+    if (deadline != NO_DEADLINE && monotonic_nanoseconds() >= deadline)
+        return false;
+
+    /* read under the lock, any change the other side makes from now on bumps it */
+    uint32_t sequence = atomic_load_explicit(&waiters->sequence, memory_order_relaxed);
+    waiters->waiting++;
+    pthread_mutex_unlock(&q->lock);
+
+    bool woken = false;
+    for (int i = 0; i < BLOCKING_QUEUE_SPIN && !woken; i++)
+        woken = atomic_load_explicit(&waiters->sequence, memory_order_acquire) != sequence;
+    if (!woken)
+    {
+        /* either the other side sees us sleeping, or the kernel sees its new sequence */
+        atomic_fetch_add(&waiters->sleeping, 1);
+        futex_wait(&waiters->sequence, sequence, deadline);
+        atomic_fetch_sub(&waiters->sleeping, 1);
+    }
+
+    /* whoever comes back first consumes a signal, a late one only costs an extra wake up */
+    pthread_mutex_lock(&q->lock);
+    waiters->waiting--;
+    if (waiters->signalled > 0)
+        waiters->signalled--;
+    return true;
+}
+
+/**
+ * under the lock, after `n` elements or slots became available: returns how many
+ * sleepers to wake after unlocking. A waiter woken but not running yet is already
+ * signalled, the next calls don't make a syscall for it again.
+ */
+static int signal_waiters(blocking_queue_waiters *waiters, const size_t n)
+{
+    if (n == 0 || waiters->waiting <= waiters->signalled)
+        return 0;
+
+    atomic_fetch_add(&waiters->sequence, 1);
+    size_t count = waiters->waiting - waiters->signalled;
+    if (count > n)
+        count = n;
+    waiters->signalled += count;
+
+    /* the spinning waiters see the new sequence by themselves */
+    if (atomic_load(&waiters->sleeping) == 0)
+        return 0;
+    return count < INT_MAX ? (int)count : INT_MAX;
+}
+
+#ifdef __linux__
+static void futex_wait(_Atomic uint32_t *word, const uint32_t expected, const uint64_t deadline)
+{
+    struct timespec timeout, *timeout_pointer = NULL;
+    if (deadline != NO_DEADLINE)
+    {
+        uint64_t now = monotonic_nanoseconds();
+        if (now >= deadline)
+            return;
+        timeout.tv_sec = (deadline - now) / 1000000000;
+        timeout.tv_nsec = (deadline - now) % 1000000000;
+        timeout_pointer = &timeout;
+    }
+    /* returns at once if `word` isn't `expected` anymore, spurious returns are fine */
+    syscall(SYS_futex, (uint32_t *)word, FUTEX_WAIT_PRIVATE, expected, timeout_pointer, NULL, 0);
+}
+
+static void futex_wake(_Atomic uint32_t *word, const int n)
+{
+    syscall(SYS_futex, (uint32_t *)word, FUTEX_WAKE_PRIVATE, n, NULL, NULL, 0);
+}
+#else
+/* without futexes a sleeper yields and checks again, the waking side has nothing to do */
+static void futex_wait(_Atomic uint32_t *word, const uint32_t expected, const uint64_t deadline)
+{
+    (void)word;
+    (void)expected;
+    (void)deadline;
+    sched_yield();
+}
+
+static void futex_wake(_Atomic uint32_t *word, const int n)
+{
+    (void)word;
+    (void)n;
+}
+#endif
@@ -0,0 +1,150 @@
+#ifndef BLOCKING_QUEUE_H
+#define BLOCKING_QUEUE_H
+
+#include "queue.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+/* times a waiting thread checks for a wakeup before sleeping in the kernel */
+#define BLOCKING_QUEUE_SPIN       200
+#define BLOCKING_QUEUE_NO_TIMEOUT UINT64_MAX
+
+/**
+ * one side of the queue threads wait on, consumers for elements and producers for
+ * room. `waiting` counts the threads spinning or sleeping, `signalled` the ones
+ * already bound to come back, both under the lock: only when some waiter isn't
+ * signalled yet does the other side bump `sequence`, which the waiters watch and
+ * sleep on with a futex. `sleeping` counts the ones in the kernel, the only ones
+ * that need a wake up syscall.
+ */
+typedef struct
+{
+    _Atomic uint32_t sequence;
+    _Atomic uint32_t sleeping;
+    size_t           waiting;
+    size_t           signalled;
+} blocking_queue_waiters;
+
+/**
+ * a FIFO of fixed size elements stored in a `queue_create_fixed` ring behind one
+ * mutex. Dequeuing a batch takes the lock once, and a thread only makes a syscall
+ * to wake another one that is asleep. Once closed, enqueues fail and dequeues keep
+ * returning the remaining elements until the queue is drained.
+ */
+typedef struct
+{
+    pthread_mutex_t        lock;
+    queue                 *items;
+    size_t                 capacity;  // 0 when unbounded
+    bool                   closed;
+    blocking_queue_waiters consumers;
+    blocking_queue_waiters producers;
+} blocking_queue;
+
+/**
+ * @brief creates a new empty queue of elements of `elem_size` bytes.
+ * Allocated memory from the queue must be freed with `blocking_queue_destroy`.
+ *
+ * @param elem_size size of every element in bytes
+ * @param capacity maximum number of elements, producers block while the queue
+ * is full. 0 for an unbounded queue
+ * @return blocking_queue* pointer to the newly created queue, NULL on failure
+ */
+blocking_queue *blocking_queue_create(const size_t elem_size, const size_t capacity);
+
+/**
+ * @brief copies an element at the end of the queue, waiting for room if the
+ * queue is bounded and full.
+ *
+ * @param q pointer to the queue
+ * @param data pointer to the `elem_size` bytes to enqueue
+ * @return true on success
+ * @return false if the queue is closed or an error occurred
+ */
+bool blocking_queue_enque(blocking_queue *q, const void *data);
+
+/**
+ * @brief copies `n` consecutive elements at the end of the queue, as many as
+ * fit each time the lock is taken, waiting for room if the queue is full.
+ *
+ * @param q pointer to the queue
+ * @param data pointer to `n` elements of `elem_size` bytes
+ * @param n number of elements to enqueue
+ * @return size_t number of elements enqueued, less than `n` if the queue was closed
+ */
+size_t blocking_queue_enque_batch(blocking_queue *q, const void *data, const size_t n);
+
+/**
+ * @brief removes the first element of the queue copying it into caller storage,
+ * waiting for one if the queue is empty.
+ *
+ * @param q pointer to the queue
+ * @param out pointer to a buffer of at least `elem_size` bytes
+ * @return true on success
+ * @return false if the queue is closed and drained, or an error occurred
+ */
+bool blocking_queue_deque(blocking_queue *q, void *out);
+
+/**
+ * @brief same as `blocking_queue_deque`, giving up after `timeout` milliseconds.
+ *
+ * @param q pointer to the queue
+ * @param out pointer to a buffer of at least `elem_size` bytes
+ * @param timeout maximum wait in milliseconds, 0 to never wait,
+ * `BLOCKING_QUEUE_NO_TIMEOUT` to wait forever
+ * @return true on success
+ * @return false on timeout, if the queue is closed and drained, or an error occurred
+ */
+bool blocking_queue_deque_timed(blocking_queue *q, void *out, const uint64_t timeout);
+
+/**
+ * @brief removes up to `max_n` elements from the front of the queue under a single
+ * lock acquisition, waiting up to `timeout` milliseconds for the first one.
+ *
+ * @param q pointer to the queue
+ * @param out pointer to a buffer of at least `max_n * elem_size` bytes
+ * @param max_n maximum number of elements to dequeue
+ * @param timeout maximum wait in milliseconds, 0 to never wait,
+ * `BLOCKING_QUEUE_NO_TIMEOUT` to wait forever
+ * @return size_t number of elements dequeued, 0 on timeout or if the queue is
+ * closed and drained
+ */
+size_t blocking_queue_deque_batch(blocking_queue *q, void *out, const size_t max_n, const uint64_t timeout);
+
+/**
+ * @brief closes the queue: enqueues fail from now on, and waiting consumers are
+ * woken up once the remaining elements are dequeued. Safe to call more than once.
+ *
+ * @param q pointer to the queue
+ */
+void blocking_queue_close(blocking_queue *q);
+
+/**
+ * @brief tells if the queue is closed and empty, e.g. to know why a dequeue failed.
+ *
+ * @param q pointer to the queue
+ * @return true if the queue is closed and no element is left
+ * @return false otherwise
+ */
+bool blocking_queue_drained(blocking_queue *q);
+
+/**
+ * @brief returns the number of elements in the queue
+ *
+ * @param q pointer to the queue
+ * @return int -1 if the pointer is null, the size of the queue otherwise
+ */
+int blocking_queue_size(blocking_queue *q);
+
+/**
+ * @brief frees the queue and the remaining elements. No thread may be using it,
+ * close it and join its users first.
+ *
+ * @param q pointer to the queue to destroy
+ */
+void blocking_queue_destroy(blocking_queue *q);
+
+#endif // BLOCKING_QUEUE_H
@@ -0,0 +1,512 @@
+#include "concurrent_hashtable.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#define CONCURRENT_HASHTABLE_READERS 256 // threads that can read without locking at the same time
+#define RECLAIM_THRESHOLD            64  // retired nodes per stripe before trying to free them
+
+#define STRIPE_INDEX(hash) ((hash) & (CONCURRENT_HASHTABLE_STRIPES - 1))
+
+/* ========== EPOCH BASED RECLAMATION ========== */
+/**
+ * A reader publishes the global epoch it entered in, 0 while it's outside a
+ * lookup. The global epoch only advances once every active reader has seen the
+ * current one, so memory retired in epoch e is unreachable by anyone at e + 2.
+ */
+typedef struct
+{
+    alignas(CONCURRENT_HASHTABLE_CACHE_LINE)
+    _Atomic size_t epoch;
+    atomic_bool    in_use;
+} reader_slot;
+
+static reader_slot reader_slots[CONCURRENT_HASHTABLE_READERS];
+static _Atomic size_t global_epoch = 1;
+static _Thread_local reader_slot *thread_slot = NULL;
+static pthread_key_t slot_key;
+static pthread_once_t slot_key_once = PTHREAD_ONCE_INIT;
+
+static void release_reader_slot(void *slot);
+static void create_slot_key(void);
+static reader_slot *claim_reader_slot(void);
+static size_t try_advance_epoch(void);
+/* ============================================= */
+
+static concurrent_hashtable_buckets *create_buckets(const size_t size);
+static concurrent_hashtable_node *create_node(const void *key, const size_t key_size,
+                                              const void *value, const size_t value_size,
+                                              const size_t hash);
+static void retire_node(concurrent_hashtable_stripe *stripe, concurrent_hashtable_node *node);
+static void reclaim_nodes(concurrent_hashtable_stripe *stripe);
+static void free_nodes(concurrent_hashtable_node *node);
+static void resize_concurrent_hashtable(concurrent_hashtable *ht, const size_t expected_size);
+static bool migrate_stripe(concurrent_hashtable *ht, const size_t index, concurrent_hashtable_buckets *target);
+
+concurrent_hashtable *concurrent_hashtable_create(size_t (*hash_function)(void *key),
+                                                  size_t (*compare_key_function)(const void *key1, const void *key2))
+{
+    if (hash_function == NULL || compare_key_function == NULL)
+        return NULL;
+
+    concurrent_hashtable *ht = aligned_alloc(alignof(concurrent_hashtable), sizeof(concurrent_hashtable));
+    if (ht == NULL) return NULL;
+
+    concurrent_hashtable_buckets *buckets = create_buckets(CONCURRENT_HASHTABLE_INITIAL_SIZE);
+    if (buckets == NULL)
+    {
+        free(ht);
+        return NULL;
+    }
+
+    atomic_init(&ht->buckets, buckets);
+    ht->old_buckets = NULL;
+    ht->retired_buckets = NULL;
+    pthread_mutex_init(&ht->resize_lock, NULL);
+    ht->hash_function = hash_function;
+    ht->compare_key_function = compare_key_function;
+
+    for (size_t i = 0; i < CONCURRENT_HASHTABLE_STRIPES; i++)
+    {
+        pthread_mutex_init(&ht->stripes[i].lock, NULL);
+        atomic_init(&ht->stripes[i].buckets, buckets);
+        atomic_init(&ht->stripes[i].pair_number, 0);
+        ht->stripes[i].retired = NULL;
+        ht->stripes[i].retired_number = 0;
+    }
+
+    return ht;
+}
+
+bool concurrent_hashtable_put(concurrent_hashtable *ht,
+                              const void *key, const size_t key_size,
+                              const void *value, const size_t value_size)
+{
+    if (ht == NULL || key == NULL || key_size == 0 || value == NULL || value_size == 0)
+        return false;
+
+    size_t hash = ht->hash_function((void *)key);
+    concurrent_hashtable_node *node = create_node(key, key_size, value, value_size, hash);
+    if (node == NULL)
+        return false;
+
+    concurrent_hashtable_stripe *stripe = &ht->stripes[STRIPE_INDEX(hash)];
+    pthread_mutex_lock(&stripe->lock);
+
+    /* a stripe is only migrated under its lock, the buckets can't change under ours */
+    concurrent_hashtable_buckets *buckets = atomic_load_explicit(&stripe->buckets, memory_order_relaxed);
+    _Atomic(concurrent_hashtable_node *) *link = &buckets->heads[hash & (buckets->size - 1)];
+    concurrent_hashtable_node *current = atomic_load_explicit(link, memory_order_relaxed);
+    while (current != NULL)
+    {
+        if (current->hash == hash && ht->compare_key_function(current->data, key) == 0)
+        {
+            /* readers either see the old node or the complete new one */
+            atomic_store_explicit(&node->next, atomic_load_explicit(&current->next, memory_order_relaxed), memory_order_relaxed);
+            atomic_store_explicit(link, node, memory_order_release);
+            retire_node(stripe, current);
+            pthread_mutex_unlock(&stripe->lock);
+            return true;
+        }
+        link = &current->next;
+        current = atomic_load_explicit(link, memory_order_relaxed);
+    }
+
+    link = &buckets->heads[hash & (buckets->size - 1)];
+    atomic_store_explicit(&node->next, atomic_load_explicit(link, memory_order_relaxed), memory_order_relaxed);
+    atomic_store_explicit(link, node, memory_order_release);
+
+    size_t stripe_pairs = atomic_load_explicit(&stripe->pair_number, memory_order_relaxed) + 1;
+    atomic_store_explicit(&stripe->pair_number, stripe_pairs, memory_order_relaxed);
+    size_t buckets_size = buckets->size;
+    pthread_mutex_unlock(&stripe->lock);
+
+    /* every stripe sees the same share of the keys, its own load factor stands for the table's */
+    if (stripe_pairs > buckets_size / CONCURRENT_HASHTABLE_STRIPES * 3 / 4)
+        resize_concurrent_hashtable(ht, buckets_size);
+
+    return true;
+}
+
+bool concurrent_hashtable_get(concurrent_hashtable *ht, const void *key,
+                              void *buffer, const size_t buffer_size, size_t *value_size)
+{
+    if (ht == NULL || key == NULL)
+        return false;
+
+    size_t hash = ht->hash_function((void *)key);
+    concurrent_hashtable_stripe *stripe = &ht->stripes[STRIPE_INDEX(hash)];
+
+    reader_slot *slot = claim_reader_slot();
+    if (slot != NULL)
+    {
+        atomic_store(&slot->epoch, atomic_load(&global_epoch));
+        atomic_thread_fence(memory_order_seq_cst);
+    }
+    else
+    {
+        /* out of reader slots, fall back on excluding the writers of this stripe */
+        pthread_mutex_lock(&stripe->lock);
+    }
+
+    bool found = false;
+    concurrent_hashtable_buckets *buckets = atomic_load_explicit(&stripe->buckets, memory_order_acquire);
+    concurrent_hashtable_node *current = atomic_load_explicit(&buckets->heads[hash & (buckets->size - 1)], memory_order_acquire);
+    while (current != NULL)
+    {
+        if (current->hash == hash && ht->compare_key_function(current->data, key) == 0)
+        {
+            if (value_size != NULL)
+                *value_size = current->value_size;
+            found = buffer != NULL && buffer_size >= current->value_size;
+            if (found)
+                memcpy(buffer, current->data + current->key_size, current->value_size);
+            break;
+        }
+        current = atomic_load_explicit(&current->next, memory_order_acquire);
+    }
+
+    if (slot != NULL)
+        atomic_store_explicit(&slot->epoch, 0, memory_order_release);
+    else
+        pthread_mutex_unlock(&stripe->lock);
+
+    return found;
+}
+
+bool concurrent_hashtable_remove(concurrent_hashtable *ht, const void *key)
+{
+    if (ht == NULL || key == NULL)
+        return false;
+
+    size_t hash = ht->hash_function((void *)key);
+    concurrent_hashtable_stripe *stripe = &ht->stripes[STRIPE_INDEX(hash)];
+    pthread_mutex_lock(&stripe->lock);
+
+    concurrent_hashtable_buckets *buckets = atomic_load_explicit(&stripe->buckets, memory_order_relaxed);
+    _Atomic(concurrent_hashtable_node *) *link = &buckets->heads[hash & (buckets->size - 1)];
+    concurrent_hashtable_node *current = atomic_load_explicit(link, memory_order_relaxed);
+    while (current != NULL)
+    {
+        if (current->hash == hash && ht->compare_key_function(current->data, key) == 0)
+        {
+            /* the unlinked node keeps its next pointer for readers still standing on it */
+            atomic_store_explicit(link, atomic_load_explicit(&current->next, memory_order_relaxed), memory_order_release);
+            atomic_store_explicit(&stripe->pair_number,
+                                  atomic_load_explicit(&stripe->pair_number, memory_order_relaxed) - 1,
+                                  memory_order_relaxed);
+            retire_node(stripe, current);
+            pthread_mutex_unlock(&stripe->lock);
+            return true;
+        }
+        link = &current->next;
+        current = atomic_load_explicit(link, memory_order_relaxed);
+    }
+
+    pthread_mutex_unlock(&stripe->lock);
+    return false;
+}
+
+bool concurrent_hashtable_size(concurrent_hashtable *ht, size_t *size)
+{
+    if (ht == NULL || size == NULL)
+        return false;
+
+    *size = 0;
+    for (size_t i = 0; i < CONCURRENT_HASHTABLE_STRIPES; i++)
+        *size += atomic_load_explicit(&ht->stripes[i].pair_number, memory_order_relaxed);
+    return true;
+}
+
+void concurrent_hashtable_destroy(concurrent_hashtable *ht)
+{
+    if (ht == NULL)
+        return;
+
+    /* after a failed migration the stripes may not all live in the same buckets */
+    for (size_t i = 0; i < CONCURRENT_HASHTABLE_STRIPES; i++)
+    {
+        concurrent_hashtable_buckets *buckets = atomic_load_explicit(&ht->stripes[i].buckets, memory_order_relaxed);
+        for (size_t j = i; j < buckets->size; j += CONCURRENT_HASHTABLE_STRIPES)
+            free_nodes(atomic_load_explicit(&buckets->heads[j], memory_order_relaxed));
+    }
+    free(atomic_load(&ht->buckets));
+
+    concurrent_hashtable_buckets *lists[] = {ht->old_buckets, ht->retired_buckets};
+    for (size_t i = 0; i < 2; i++)
+    {
+        while (lists[i] != NULL)
+        {
+            concurrent_hashtable_buckets *to_free = lists[i];
+            lists[i] = to_free->retired_next;
+            free(to_free);
+        }
+    }
+    pthread_mutex_destroy(&ht->resize_lock);
+
+    for (size_t i = 0; i < CONCURRENT_HASHTABLE_STRIPES; i++)
+    {
+        concurrent_hashtable_node *current = ht->stripes[i].retired;
+        while (current != NULL)
+        {
+            concurrent_hashtable_node *to_free = current;
+            current = current->retired_next;
+            free(to_free);
+        }
+        pthread_mutex_destroy(&ht->stripes[i].lock);
+    }
+    free(ht);
+}
+
+static void release_reader_slot(void *slot)
+{
+    atomic_store(&((reader_slot *)slot)->in_use, false);
+}
+
+static void create_slot_key(void)
+{
+    pthread_key_create(&slot_key, release_reader_slot);
+}
+
+static reader_slot *claim_reader_slot(void)
+{
+    if (thread_slot != NULL)
+        return thread_slot;
+
+    pthread_once(&slot_key_once, create_slot_key);
+    for (size_t i = 0; i < CONCURRENT_HASHTABLE_READERS; i++)
+    {
+        bool expected = false;
+        if (atomic_compare_exchange_strong(&reader_slots[i].in_use, &expected, true))
+        {
+            /* given back when the thread exits */
+            thread_slot = &reader_slots[i];
+            pthread_setspecific(slot_key, thread_slot);
+            return thread_slot;
+        }
+    }
+    return NULL;
+}
+
+static size_t try_advance_epoch(void)
+{
+    size_t epoch = atomic_load(&global_epoch);
+    atomic_thread_fence(memory_order_seq_cst);
+
+    for (size_t i = 0; i < CONCURRENT_HASHTABLE_READERS; i++)
+    {
+        if (!atomic_load_explicit(&reader_slots[i].in_use, memory_order_relaxed))
+            continue;
+        size_t reader_epoch = atomic_load(&reader_slots[i].epoch);
+        if (reader_epoch != 0 && reader_epoch != epoch)
+            return epoch;
+    }
+
+    atomic_compare_exchange_strong(&global_epoch, &epoch, epoch + 1);
+    return atomic_load(&global_epoch);
+}
+
+static concurrent_hashtable_buckets *create_buckets(const size_t size)
+{
+    concurrent_hashtable_buckets *buckets = malloc(sizeof(concurrent_hashtable_buckets) +
+                                                   size * sizeof(_Atomic(concurrent_hashtable_node *)));
+    if (buckets == NULL)
+        return NULL;
+
+    buckets->size = size;
+    buckets->retired_next = NULL;
+    buckets->retire_epoch = 0;
+    for (size_t i = 0; i < size; i++)
+        atomic_init(&buckets->heads[i], NULL);
+
+    return buckets;
+}
+
+static concurrent_hashtable_node *create_node(const void *key, const size_t key_size,
+                                              const void *value, const size_t value_size,
+                                              const size_t hash)
+{
+    concurrent_hashtable_node *node = malloc(sizeof(concurrent_hashtable_node) + key_size + value_size);
+    if (node == NULL)
+        return NULL;
+
+    atomic_init(&node->next, NULL);
+    node->retired_next = NULL;
+    node->retire_epoch = 0;
+    node->hash = hash;
+    node->key_size = key_size;
+    node->value_size = value_size;
+    memcpy(node->data, key, key_size);
+    memcpy(node->data + key_size, value, value_size);
+
+    return node;
+}
+
+static void retire_node(concurrent_hashtable_stripe *stripe, concurrent_hashtable_node *node)
+{
+    // the caller holds the stripe lock and already unlinked the node
+
+    /* the unlink must be visible before the epoch it's tagged with is read */
+    atomic_thread_fence(memory_order_seq_cst);
+    node->retire_epoch = atomic_load(&global_epoch);
+    node->retired_next = stripe->retired;
+    stripe->retired = node;
+
+    if (++stripe->retired_number >= RECLAIM_THRESHOLD)
+        reclaim_nodes(stripe);
+}
+
+static void reclaim_nodes(concurrent_hashtable_stripe *stripe)
+{
+    size_t epoch = try_advance_epoch();
+
+    /* the list is sorted from the newest retirement to the oldest */
+    concurrent_hashtable_node **link = &stripe->retired;
+    while (*link != NULL && (*link)->retire_epoch + 2 > epoch)
+        link = &(*link)->retired_next;
+
+    concurrent_hashtable_node *current = *link;
+    *link = NULL;
+    while (current != NULL)
+    {
+        concurrent_hashtable_node *to_free = current;
+        current = current->retired_next;
+        free(to_free);
+        stripe->retired_number--;
+    }
+}
+
+static void free_nodes(concurrent_hashtable_node *node)
+{
+    while (node != NULL)
+    {
+        concurrent_hashtable_node *to_free = node;
+        node = atomic_load_explicit(&node->next, memory_order_relaxed);
+        free(to_free);
+    }
+}
+
+/**
+ * doubles the buckets if the stripe that asked still lives in buckets of
+ * `expected_size` entries, then moves the stripes into the newest buckets one at
+ * a time: only the writers of the stripe being copied wait, the other stripes
+ * keep accepting puts and removes. A put that finds a resize running leaves the
+ * work to it. Readers keep walking the old chains, the pairs are copied into
+ * new nodes and the old nodes and buckets are retired instead of being relinked
+ * under their feet.
+ */
+static void resize_concurrent_hashtable(concurrent_hashtable *ht, const size_t expected_size)
+{
+    if (pthread_mutex_trylock(&ht->resize_lock) != 0)
+        return; // another writer is resizing
+
+    concurrent_hashtable_buckets *target = atomic_load_explicit(&ht->buckets, memory_order_relaxed);
+    if (target->size == expected_size)
+    {
+        concurrent_hashtable_buckets *new_buckets = create_buckets(target->size * 2);
+        if (new_buckets == NULL)
+        {
+            pthread_mutex_unlock(&ht->resize_lock);
+            return;
+        }
+        target->retired_next = ht->old_buckets;
+        ht->old_buckets = target;
+        atomic_store_explicit(&ht->buckets, new_buckets, memory_order_relaxed);
+        target = new_buckets;
+    }
+    // otherwise the stripe asking is one an earlier resize failed to migrate
+
+    bool migrated = true;
+    for (size_t i = 0; i < CONCURRENT_HASHTABLE_STRIPES && migrated; i++)
+        migrated = migrate_stripe(ht, i, target);
+
+    /* once no stripe uses them, the old buckets only wait for the readers */
+    if (migrated)
+    {
+        size_t retire_epoch = atomic_load(&global_epoch);
+        while (ht->old_buckets != NULL)
+        {
+            concurrent_hashtable_buckets *old_buckets = ht->old_buckets;
+            ht->old_buckets = old_buckets->retired_next;
+            old_buckets->retire_epoch = retire_epoch;
+            old_buckets->retired_next = ht->retired_buckets;
+            ht->retired_buckets = old_buckets;
+        }
+    }
+
+    /* retired buckets are only touched here, under the resize lock */
+    size_t epoch = try_advance_epoch();
+    concurrent_hashtable_buckets **link = &ht->retired_buckets;
+    while (*link != NULL && (*link)->retire_epoch + 2 > epoch)
+        link = &(*link)->retired_next;
+    concurrent_hashtable_buckets *retired = *link;
+    *link = NULL;
+    while (retired != NULL)
+    {
+        concurrent_hashtable_buckets *to_free = retired;
+        retired = retired->retired_next;
+        free(to_free);
+    }
+
+    pthread_mutex_unlock(&ht->resize_lock);
+}
+
+/**
+ * copies the chains of stripe `index` into `target` and publishes them there.
+ * The buckets of a stripe are the same at every size, so stripes migrated one
+ * after the other never write to the same heads of `target`.
+ */
+static bool migrate_stripe(concurrent_hashtable *ht, const size_t index, concurrent_hashtable_buckets *target)
+{
+    concurrent_hashtable_stripe *stripe = &ht->stripes[index];
+    pthread_mutex_lock(&stripe->lock);
+
+    concurrent_hashtable_buckets *source = atomic_load_explicit(&stripe->buckets, memory_order_relaxed);
+    if (source == target)
+    {
+        pthread_mutex_unlock(&stripe->lock);
+        return true;
+    }
+
+    for (size_t i = index; i < source->size; i += CONCURRENT_HASHTABLE_STRIPES)
+    {
+        concurrent_hashtable_node *current = atomic_load_explicit(&source->heads[i], memory_order_relaxed);
+        for (; current != NULL; current = atomic_load_explicit(&current->next, memory_order_relaxed))
+        {
+            concurrent_hashtable_node *copy = create_node(current->data, current->key_size,
+                                                          current->data + current->key_size, current->value_size,
+                                                          current->hash);
+            if (copy == NULL)
+            {
+                /* the stripe stays in its old buckets, a later resize retries it */
+                for (size_t j = index; j < target->size; j += CONCURRENT_HASHTABLE_STRIPES)
+                {
+                    free_nodes(atomic_load_explicit(&target->heads[j], memory_order_relaxed));
+                    atomic_store_explicit(&target->heads[j], NULL, memory_order_relaxed);
+                }
+                pthread_mutex_unlock(&stripe->lock);
+                return false;
+            }
+            size_t target_index = copy->hash & (target->size - 1);
+            atomic_store_explicit(&copy->next, atomic_load_explicit(&target->heads[target_index], memory_order_relaxed), memory_order_relaxed);
+            atomic_store_explicit(&target->heads[target_index], copy, memory_order_relaxed);
+        }
+    }
+
+    atomic_store_explicit(&stripe->buckets, target, memory_order_release);
+
+    for (size_t i = index; i < source->size; i += CONCURRENT_HASHTABLE_STRIPES)
+    {
+        concurrent_hashtable_node *current = atomic_load_explicit(&source->heads[i], memory_order_relaxed);
+        while (current != NULL)
+        {
+            concurrent_hashtable_node *next_node = atomic_load_explicit(&current->next, memory_order_relaxed);
+            retire_node(stripe, current);
+            current = next_node;
+        }
+    }
+
+    pthread_mutex_unlock(&stripe->lock);
+    return true;
+}
@@ -0,0 +1,144 @@
+#ifndef CONCURRENT_HASHTABLE_H
+#define CONCURRENT_HASHTABLE_H
+
+#include <stddef.h>
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#define CONCURRENT_HASHTABLE_STRIPES      64   // power of two
+#define CONCURRENT_HASHTABLE_INITIAL_SIZE 1024 // power of two, multiple of the stripes
+#define CONCURRENT_HASHTABLE_CACHE_LINE   64
+
+/**
+ * nodes are immutable once published, except for `next`: an update
+ * publishes a new node in place of the old one, so readers always see
+ * a complete key and value. Unlinked nodes go on their stripe's retired
+ * list until no reader can still be traversing them.
+ */
+typedef struct concurrent_hashtable_node
+{
+    _Atomic(struct concurrent_hashtable_node *) next;
+    struct concurrent_hashtable_node           *retired_next;
+    size_t                                      retire_epoch;
+    size_t                                      hash;
+    size_t                                      key_size;
+    size_t                                      value_size;
+    unsigned char                               data[]; // key bytes followed by the value bytes
+} concurrent_hashtable_node;
+
+typedef struct concurrent_hashtable_buckets
+{
+    size_t                               size;
+    struct concurrent_hashtable_buckets *retired_next;
+    size_t                               retire_epoch;
+    _Atomic(concurrent_hashtable_node *) heads[];
+} concurrent_hashtable_buckets;
+
+/**
+ * a bucket always belongs to stripe `hash & (CONCURRENT_HASHTABLE_STRIPES - 1)`, at
+ * any size. While a resize is migrating the stripes, some of them still live in
+ * the previous buckets, `buckets` tells which array holds this stripe's chains.
+ */
+typedef struct
+{
+    alignas(CONCURRENT_HASHTABLE_CACHE_LINE)
+    pthread_mutex_t                         lock;
+    _Atomic(concurrent_hashtable_buckets *) buckets;
+    _Atomic size_t                          pair_number;
+    concurrent_hashtable_node              *retired;
+    size_t                                  retired_number;
+} concurrent_hashtable_stripe;
+
+typedef struct concurrent_hashtable
+{
+    _Atomic(concurrent_hashtable_buckets *) buckets;         // newest buckets, every stripe ends up there
+    concurrent_hashtable_buckets           *old_buckets;     // replaced buckets some stripes may still use
+    concurrent_hashtable_buckets           *retired_buckets;
+    pthread_mutex_t                         resize_lock;
+    size_t                                (*hash_function)(void *key);
+    size_t                                (*compare_key_function)(const void *key1, const void *key2);
+    concurrent_hashtable_stripe             stripes[CONCURRENT_HASHTABLE_STRIPES];
+} concurrent_hashtable;
+
+/**
+ * @brief creates a new empty hashtable that can be shared between threads.
+ * Writers serialize per lock stripe, readers never take a lock. Growing the table
+ * migrates one stripe at a time, so a resize only ever blocks the writers of the
+ * stripe being copied. Allocated memory from the hashtable must be freed with
+ * `concurrent_hashtable_destroy`.
+ *
+ * @param hash_function pointer to the hash function
+ * @param compare_key_function pointer to the key comparison function
+ * @return concurrent_hashtable* pointer to the newly created hashtable
+ */
+concurrent_hashtable *concurrent_hashtable_create(size_t (*hash_function)(void *key),
+                                                  size_t (*compare_key_function)(const void *key1, const void *key2));
+
+/**
+ * @brief inserts a new pair into the hashtable.
+ * If the key already exists, its value is updated. Safe to call from any thread.
+ * The put that crosses the load factor also migrates the stripes to the doubled
+ * buckets, copying every pair before it returns; puts that cross it while a
+ * resize runs leave it to that one and return at once.
+ *
+ * @param ht pointer to the hashtable you want to insert the pair into
+ * @param key pointer to the first byte of the key
+ * @param key_size size of the key in bytes
+ * @param value pointer to the first byte of the value
+ * @param value_size size of the value in bytes
+ * @return true if the pair was successfully inserted or updated
+ * @return false if an error occurred (e.g., memory allocation failure)
+ */
+bool concurrent_hashtable_put(concurrent_hashtable *ht,
+                              const void *key, const size_t key_size,
+                              const void *value, const size_t value_size);
+
+/**
+ * @brief copies the value associated with the given key into a caller provided buffer.
+ * Lock free, the value is copied while the pair is protected from reclamation so
+ * the buffer never sees a half updated value. If the buffer is too small nothing is
+ * copied, but the required size is still reported through `value_size`.
+ *
+ * @param ht pointer to the hashtable you want to retrieve the value from
+ * @param key pointer to the first byte of the key
+ * @param buffer pointer to the memory the value will be copied into
+ * @param buffer_size size of the buffer in bytes
+ * @param value_size pointer to a variable where the size of the value will be stored, can be NULL
+ * @return true if the value was copied into the buffer
+ * @return false if the key does not exist or the buffer is too small
+ */
+bool concurrent_hashtable_get(concurrent_hashtable *ht, const void *key,
+                              void *buffer, const size_t buffer_size, size_t *value_size);
+
+/**
+ * @brief removes the pair associated with the given key from the hashtable.
+ * Safe to call from any thread.
+ *
+ * @param ht pointer to the hashtable you want to remove the pair from
+ * @param key pointer to the first byte of the key
+ * @return true if the pair was successfully removed
+ * @return false if the key does not exist in the hashtable
+ */
+bool concurrent_hashtable_remove(concurrent_hashtable *ht, const void *key);
+
+/**
+ * @brief returns the number of pairs in the hashtable.
+ * With concurrent writers the result is a snapshot that may already be outdated.
+ *
+ * @param ht pointer to the hashtable you want to get the size of
+ * @param size pointer to a variable where the size will be stored
+ * @return true if the size was successfully retrieved
+ * @return false if an error occurred (e.g., invalid hashtable pointer)
+ */
+bool concurrent_hashtable_size(concurrent_hashtable *ht, size_t *size);
+
+/**
+ * @brief destroys the hashtable and frees all allocated memory.
+ * No other thread may be using the hashtable.
+ *
+ * @param ht pointer to the hashtable to destroy
+ */
+void concurrent_hashtable_destroy(concurrent_hashtable *ht);
+
+#endif // CONCURRENT_HASHTABLE_H
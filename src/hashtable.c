@@ -1,14 +1,140 @@
+#define _DEFAULT_SOURCE
+
 #include "hashtable.h"
 
 #include <stdlib.h>
 #include <string.h>
 #include <stdint.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <sys/random.h>
+
+#define PAIR_ALIGN(size) (((size) + sizeof(void *) - 1) & ~(sizeof(void *) - 1))
+#define PAIR_INLINE_VALUE(pair) ((pair)->data + PAIR_ALIGN((pair)->key_size))
+
+/* adopted pairs have no inline key, their value is only inline after a copy made room for it */
+#define KEY_ADOPTED(pair) ((pair)->key != (pair)->data)
+#define VALUE_ADOPTED(pair) ((pair)->value_capacity == 0)
+#define VALUE_INLINE(pair) (!KEY_ADOPTED(pair) && (pair)->value == PAIR_INLINE_VALUE(pair))
+
+#define BUCKET_INDEX(hash, size) ((hash) & ((size) - 1))
+
+#ifdef HASHTABLE_STATS
+/* lookups take a const hashtable, the counters are the only thing they modify */
+#define COUNT_LOOKUP(ht, found) \
+    ((found) ? ((hashtable *)(ht))->hits++ : ((hashtable *)(ht))->misses++)
+#define TIME_REHASH_STEP(steps) true
+#else
+#define COUNT_LOOKUP(ht, found) ((void)0)
+/* an incremental step runs on every put/remove, only whole rehashes read the clock */
+#define TIME_REHASH_STEP(steps) ((steps) == SIZE_MAX)
+#endif
+
+/* a table uses either the seeded or the plain callbacks, never both */
+#define HASH_KEY(ht, key) ((ht)->seeded_hash_function != NULL                                 \
+                           ? (ht)->seeded_hash_function((key), (ht)->key_size, (ht)->seed)    \
+                           : (ht)->hash_function((void *)(key)))
+#define KEYS_EQUAL(ht, key1, key2) ((ht)->sized_compare_key_function != NULL                           \
+                                    ? (ht)->sized_compare_key_function((key1), (key2), (ht)->key_size) == 0 \
+                                    : (ht)->compare_key_function((key1), (key2)) == 0)
 
 hashtable_pair *create_hashtable_pair(const void *key, const size_t key_size,
-                                      const void *value, const size_t value_size);
+                                      const void *value, const size_t value_size,
+                                      const size_t hash);
+
+void free_hashtable_pair(const hashtable *ht, hashtable_pair *pair);
+static void release_key(const hashtable *ht, void *key);
+static void release_value(const hashtable *ht, hashtable_pair *pair);
+static bool update_hashtable_pair(const hashtable *ht, hashtable_pair *pair, const void *value, const size_t value_size);
+static bool valid_entry(const hashtable *ht, const hashtable_entry *entry);
+static bool put_hashed(hashtable *ht,
+                       const void *key, const size_t key_size,
+                       const void *value, const size_t value_size,
+                       const size_t hash, const uint64_t expires_at);
+static hashtable_pair *find_or_insert(hashtable *ht,
+                                      const void *key, const size_t key_size,
+                                      const void *init_value, const size_t value_size,
+                                      const size_t hash, bool *inserted);
+static void unlink_pair(hashtable *ht, hashtable_pair **link);
+static void prefetch_group(const hashtable *ht, const size_t *hashes, hashtable_pair ***slots, const size_t n);
+static size_t scan_bucket(const hashtable *ht, const hashtable_pair *current,
+                          void (*function)(const hashtable_entry *entry, void *context), void *context);
+static size_t next_cursor(const size_t cursor, const size_t mask);
+/* ========== PARALLEL BUILD AND REHASH ========== */
+typedef struct
+{
+    hashtable             *ht;
+    const hashtable_entry *entries;
+    size_t                 n;
+    size_t                *hashes;
+    size_t                *order;     // entry indexes grouped by bucket range, in input order
+    size_t                *positions; // slices x ranges matrix: entries of slice s in bucket range r
+    size_t                *inserted;  // new pairs per bucket range
+    size_t                 slices;
+    size_t                 ranges;
+    size_t                 range_shift;
+    atomic_bool            failed;
+} build_context;
 
-void free_hashtable_pair(hashtable_pair *pair);
+static void hash_entries(void *context, const size_t part, const size_t parts);
+static void scatter_entries(void *context, const size_t part, const size_t parts);
+static void link_entries(void *context, const size_t part, const size_t parts);
+static void rehash_range(void *context, const size_t part, const size_t parts);
+/* ================================================ */
+
+/* ========== EXPIRATION TIMING WHEEL ========== */
+/**
+ * TIMER_LEVELS wheels of TIMER_SLOTS slots, a slot of level l spans 64^l milliseconds:
+ * level 0 covers the next 64 ms and level 3 the next 4.6 hours, timers further away
+ * wait in the farthest slot of level 3 and are placed again when it comes around.
+ * Whenever a wheel turns, the slot it reaches is emptied into the levels below, so a
+ * timer moves at most TIMER_LEVELS times before it lands in the expired list.
+ */
+#define TIMER_SLOT_BITS 6
+#define TIMER_SLOTS (1u << TIMER_SLOT_BITS)
+#define TIMER_LEVELS 4
+#define TIMER_SPAN(level) (1ull << (TIMER_SLOT_BITS * (level))) // milliseconds per slot of `level`
+
+typedef struct hashtable_timer
+{
+    hashtable_pair         *pair;
+    uint64_t                expires_at;
+    struct hashtable_timer *next;
+    struct hashtable_timer *prev;
+    unsigned char           level; // TIMER_LEVELS in the expired list
+    unsigned char           slot;
+} hashtable_timer;
+
+/* every timer due at or before `tick` is in `expired` */
+typedef struct hashtable_timer_wheel
+{
+    hashtable_timer *slots[TIMER_LEVELS][TIMER_SLOTS];
+    uint64_t         occupied[TIMER_LEVELS]; // bit s set when slots[level][s] isn't empty
+    hashtable_timer *expired;
+    uint64_t         tick;
+} hashtable_timer_wheel;
+
+static uint64_t now_milliseconds(const hashtable *ht);
+static bool pair_expired(const hashtable *ht, const hashtable_pair *pair);
+static bool schedule_pair(hashtable *ht, hashtable_pair *pair, const uint64_t expires_at);
+static void cancel_timer(hashtable *ht, hashtable_pair *pair);
+static void link_timer(hashtable_timer_wheel *wheel, hashtable_timer *timer, const size_t level, const size_t slot);
+static void unlink_timer(hashtable_timer_wheel *wheel, hashtable_timer *timer);
+static void place_timer(hashtable_timer_wheel *wheel, hashtable_timer *timer);
+static void advance_wheel(hashtable_timer_wheel *wheel, const uint64_t now);
+static size_t reclaim_expired(hashtable *ht, const size_t max_pairs);
+/* ================================================ */
+
+static hashtable *allocate_hashtable(const size_t buckets_size);
+static size_t buckets_for(const hashtable *ht, const size_t capacity);
+static void update_thresholds(hashtable *ht);
+static uint64_t monotonic_nanoseconds(void);
+static uint64_t random_seed(const void *salt);
+static hashtable_pair *find_hashtable_pair(const hashtable *ht, const void *key);
+static hashtable_pair **find_hashtable_link(const hashtable *ht, const void *key, const size_t hash);
 static bool resize_hashtable(hashtable *ht, const size_t new_size);
+static void rehash_step(hashtable *ht, const size_t steps);
+static void free_buckets(const hashtable *ht, hashtable_pair **buckets, const size_t buckets_size);
 
 hashtable *hashtable_create(size_t (*hash_function)(void *key),
                             size_t (*compare_key_function)(const void *key1, const void *key2))
@@ -16,20 +142,50 @@ hashtable *hashtable_create(size_t (*hash_function)(void *key),
     if (hash_function == NULL || compare_key_function == NULL)
         return NULL;
 
-    hashtable *ht = malloc(sizeof(hashtable));
+    hashtable *ht = allocate_hashtable(INITIAL_BUCKETS_SIZE);
     if (ht == NULL) return NULL;
 
-    ht->buckets_size = INITIAL_BUCKETS_SIZE;
-    ht->pair_number = 0;
     ht->hash_function = hash_function;
     ht->compare_key_function = compare_key_function;
 
-    ht->buckets = calloc(ht->buckets_size, sizeof(hashtable_pair *));
-    if (ht->buckets == NULL)
-    {
-        free(ht);
+    return ht;
+}
+
+hashtable *hashtable_create_with_capacity(size_t (*hash_function)(void *key),
+                                          size_t (*compare_key_function)(const void *key1, const void *key2),
+                                          const size_t capacity)
+{
+    if (hash_function == NULL || compare_key_function == NULL)
         return NULL;
-    }
+
+    size_t buckets_size = buckets_for(NULL, capacity);
+    if (buckets_size == 0)
+        return NULL;
+
+    hashtable *ht = allocate_hashtable(buckets_size);
+    if (ht == NULL) return NULL;
+
+    ht->hash_function = hash_function;
+    ht->compare_key_function = compare_key_function;
+    ht->min_buckets_size = buckets_size;
+
+    return ht;
+}
+
+hashtable *hashtable_create_seeded(size_t (*hash_function)(const void *key, const size_t key_size, const uint64_t seed),
+                                   size_t (*compare_key_function)(const void *key1, const void *key2, const size_t key_size),
+                                   const size_t key_size)
+{
+    if (hash_function == NULL || compare_key_function == NULL)
+        return NULL;
+
+    hashtable *ht = allocate_hashtable(INITIAL_BUCKETS_SIZE);
+    if (ht == NULL) return NULL;
+
+    ht->seeded_hash_function = hash_function;
+    ht->sized_compare_key_function = compare_key_function;
+    ht->key_size = key_size;
+    ht->seed = random_seed(ht);
 
     return ht;
 }
@@ -40,290 +196,1583 @@ bool hashtable_put(hashtable *ht,
 {
     if (ht == NULL || key == NULL || key_size == 0 || value == NULL || value_size == 0)
         return false;
+    if (ht->key_size != 0 && key_size != ht->key_size)
+        return false;
 
-    hashtable_pair *new_pair = create_hashtable_pair(key, key_size, value, value_size);
-    if (new_pair == NULL)
+    return put_hashed(ht, key, key_size, value, value_size, HASH_KEY(ht, key), 0);
+}
+
+bool hashtable_put_ttl(hashtable *ht,
+                       const void *key, const size_t key_size,
+                       const void *value, const size_t value_size,
+                       const uint64_t ttl)
+{
+    if (ht == NULL || key == NULL || key_size == 0 || value == NULL || value_size == 0 || ttl == 0)
+        return false;
+    if (ht->key_size != 0 && key_size != ht->key_size)
         return false;
 
-    size_t index = ht->hash_function((void *)key) % ht->buckets_size;
-    hashtable_pair *current = ht->buckets[index];
-    while (current != NULL)
+    if (ht->timers == NULL)
     {
-        if (ht->compare_key_function(current->key, key) == 0)
-        {
-            /* don't need new pair, just update */
-            free_hashtable_pair(new_pair);
+        ht->timers = calloc(1, sizeof(hashtable_timer_wheel));
+        if (ht->timers == NULL)
+            return false;
+        ht->timers->tick = now_milliseconds(ht);
+    }
 
-            free(current->value);
-            current->value = malloc(value_size);
-            if (current->value == NULL)
-                return false;
-            memcpy(current->value, value, value_size);
-            current->value_size = value_size;
-            return true;
-        }
-        current = current->next;
+    uint64_t now = now_milliseconds(ht);
+    uint64_t expires_at = ttl > UINT64_MAX - now ? UINT64_MAX : now + ttl;
+    return put_hashed(ht, key, key_size, value, value_size, HASH_KEY(ht, key), expires_at);
+}
+
+bool hashtable_put_owned(hashtable *ht,
+                         void *key, const size_t key_size,
+                         void *value, const size_t value_size)
+{
+    if (ht == NULL || key == NULL || key_size == 0 || value == NULL || value_size == 0)
+        return false;
+    if (ht->key_size != 0 && key_size != ht->key_size)
+        return false;
+
+    if (ht->old_buckets != NULL)
+        rehash_step(ht, HASHTABLE_REHASH_STEP);
+
+    size_t hash = HASH_KEY(ht, key);
+    hashtable_pair **link = find_hashtable_link(ht, key, hash);
+    if (link != NULL)
+    {
+        /* nothing can fail from here, the buffers are adopted */
+        hashtable_pair *pair = *link;
+        if (pair->value != value)
+            release_value(ht, pair);
+        pair->value = value;
+        pair->value_size = value_size;
+        pair->value_capacity = 0;
+        if (pair->key != key)
+            release_key(ht, key);
+        if (pair->timer != NULL)
+            cancel_timer(ht, pair);
+        return true;
     }
+
+    hashtable_pair *new_pair = malloc(sizeof(hashtable_pair));
+    if (new_pair == NULL)
+        return false;
+    *new_pair = (hashtable_pair){
+        .key = key,
+        .key_size = key_size,
+        .value = value,
+        .value_size = value_size,
+        .hash = hash,
+    };
+
+    size_t index = BUCKET_INDEX(hash, ht->buckets_size);
     new_pair->next = ht->buckets[index];
     ht->buckets[index] = new_pair;
     ht->pair_number++;
 
-    if (ht->pair_number > ht->buckets_size * 0.75)
-        return resize_hashtable(ht, ht->buckets_size * 2);
+    if (ht->timers != NULL)
+        reclaim_expired(ht, HASHTABLE_EXPIRE_STEP);
+
+    /* the buffers are adopted, a failed grow only leaves the table fuller than its load factor */
+    if (ht->pair_number > ht->grow_threshold)
+        resize_hashtable(ht, ht->buckets_size * 2);
 
     return true;
 }
 
-void *hashtable_get(const hashtable *ht, const void *key)
+bool hashtable_set_destructors(hashtable *ht, void (*key_destructor)(void *key), void (*value_destructor)(void *value))
 {
-    if (ht == NULL || key == NULL)
-        return NULL;
+    if (ht == NULL)
+        return false;
 
-    size_t index = ht->hash_function((void *)key) % ht->buckets_size;
-    hashtable_pair *current = ht->buckets[index];
-    while (current != NULL)
-    {
-        if (ht->compare_key_function(current->key, key) == 0)
-        {
-            void *value_copy = malloc(current->value_size);
-            if (value_copy == NULL)
-                return NULL;
-            memcpy(value_copy, current->value, current->value_size);
-            return value_copy;
-        }
-        current = current->next;
-    }
-    return NULL;
+    ht->key_destructor = key_destructor;
+    ht->value_destructor = value_destructor;
+    return true;
 }
 
-bool hashtable_remove(hashtable *ht, const void *key)
+bool hashtable_upsert(hashtable *ht,
+                      const void *key, const size_t key_size,
+                      const void *init_value, const size_t value_size,
+                      void (*update)(void *value, const size_t value_size, void *context), void *context)
 {
-    if (ht == NULL || key == NULL)
+    if (ht == NULL || key == NULL || key_size == 0 || value_size == 0 || update == NULL)
+        return false;
+    if (ht->key_size != 0 && key_size != ht->key_size)
         return false;
 
-    size_t index = ht->hash_function((void *)key) % ht->buckets_size;
-    hashtable_pair *current = ht->buckets[index];
-    hashtable_pair *previous = NULL;
-
-    while (current != NULL)
-    {
-        if (ht->compare_key_function(current->key, key) == 0)
-        {
-            if (previous == NULL)
-                ht->buckets[index] = current->next;
-            else
-                previous->next = current->next;
-
-            free_hashtable_pair(current);
-            ht->pair_number--;
-            break;
-        }
-        previous = current;
-        current = current->next;
-    }
-
-    if (ht->pair_number < ht->buckets_size * 0.5 && ht->buckets_size > INITIAL_BUCKETS_SIZE)
-        return resize_hashtable(ht, ht->buckets_size / 2);
+    bool inserted;
+    hashtable_pair *pair = find_or_insert(ht, key, key_size, init_value, value_size, HASH_KEY(ht, key), &inserted);
+    if (pair == NULL)
+        return false;
 
+    if (!inserted)
+        update(pair->value, pair->value_size, context);
     return true;
 }
 
-void **hashtable_keyset(const hashtable *ht)
+void *hashtable_get_or_insert(hashtable *ht,
+                              const void *key, const size_t key_size,
+                              const void *init_value, const size_t value_size,
+                              bool *inserted)
 {
-    if (ht == NULL || ht->pair_number == 0)
+    if (ht == NULL || key == NULL || key_size == 0 || value_size == 0)
+        return NULL;
+    if (ht->key_size != 0 && key_size != ht->key_size)
         return NULL;
 
-    void **keyset = malloc((ht->pair_number + 1) * sizeof(void *));
-    if (keyset == NULL)
+    bool was_inserted;
+    hashtable_pair *pair = find_or_insert(ht, key, key_size, init_value, value_size, HASH_KEY(ht, key), &was_inserted);
+    if (pair == NULL)
         return NULL;
 
-    size_t index = 0;
-    for (size_t i = 0; i < ht->buckets_size; i++)
+    if (inserted != NULL)
+        *inserted = was_inserted;
+    return pair->value;
+}
+
+size_t hashtable_put_many(hashtable *ht, const hashtable_entry *entries, const size_t n)
+{
+    if (ht == NULL || entries == NULL)
+        return 0;
+
+    size_t hashes[HASHTABLE_BATCH_SIZE];
+    hashtable_pair **slots[HASHTABLE_BATCH_SIZE];
+    for (size_t start = 0; start < n; start += HASHTABLE_BATCH_SIZE)
     {
-        hashtable_pair *current = ht->buckets[i];
-        while (current != NULL)
+        size_t batch = n - start < HASHTABLE_BATCH_SIZE ? n - start : HASHTABLE_BATCH_SIZE;
+        const hashtable_entry *group = entries + start;
+
+        /* a seeded hash reads `key_size` bytes, a key of another size is never hashed */
+        for (size_t i = 0; i < batch; i++)
+            hashes[i] = valid_entry(ht, &group[i]) ? HASH_KEY(ht, group[i].key) : 0;
+        prefetch_group(ht, hashes, slots, batch);
+
+        /* inserting may resize, the prefetched slots are only a hint from here on */
+        for (size_t i = 0; i < batch; i++)
         {
-            keyset[index++] = current->key;
-            current = current->next;
+            if (!valid_entry(ht, &group[i]) ||
+                !put_hashed(ht, group[i].key, group[i].key_size, group[i].value, group[i].value_size, hashes[i], 0))
+                return start + i;
         }
     }
-    keyset[index] = NULL;
 
-    return keyset;
+    return n;
 }
 
-bool hashtable_size(const hashtable *ht, size_t *size)
+bool hashtable_build_with(hashtable *ht, const hashtable_entry *entries, const size_t n,
+                          const hashtable_executor *executor)
 {
-    if (ht == NULL || size == NULL)
+    if (ht == NULL || (entries == NULL && n > 0))
         return false;
-    *size = ht->pair_number;
-    return true;
-}
+    if (executor == NULL || executor->run == NULL || executor->parts == 0 || ht->timers != NULL)
+    {
+        /* the timing wheel is shared by every bucket, it can't be updated from several threads */
+        for (size_t i = 0; i < n; i++)
+            if (!valid_entry(ht, &entries[i]))
+                return false;
+        return hashtable_put_many(ht, entries, n) == n;
+    }
 
-void hashtable_destroy(hashtable *ht)
-{
-    if (ht == NULL)
-        return;
+    /* grow once and for all, every thread then owns a fixed range of buckets */
+    if (ht->old_buckets != NULL)
+        rehash_step(ht, SIZE_MAX);
+    size_t buckets_size = buckets_for(ht, ht->pair_number + n);
+    if (buckets_size == 0 || (buckets_size > ht->buckets_size && !resize_hashtable(ht, buckets_size)))
+        return false;
+    if (ht->old_buckets != NULL)
+        rehash_step(ht, SIZE_MAX);
 
-    for (size_t i = 0; i < ht->buckets_size; i++)
+    build_context context = { .ht = ht, .entries = entries, .n = n, .slices = executor->parts };
+    while ((ht->buckets_size >> context.range_shift) > context.slices)
+        context.range_shift++;
+    context.ranges = ((ht->buckets_size - 1) >> context.range_shift) + 1;
+    atomic_init(&context.failed, false);
+
+    context.hashes = malloc((n + 1) * sizeof(size_t));
+    context.order = malloc((n + 1) * sizeof(size_t));
+    context.positions = calloc(context.slices * context.ranges, sizeof(size_t));
+    context.inserted = calloc(context.ranges, sizeof(size_t));
+    bool built = false;
+    if (context.hashes != NULL && context.order != NULL && context.positions != NULL && context.inserted != NULL)
     {
-        hashtable_pair *current = ht->buckets[i];
-        while (current != NULL)
+        executor->run(executor->backend, context.slices, hash_entries, &context);
+        if (!atomic_load(&context.failed))
         {
-            hashtable_pair *to_free = current;
-            current = current->next;
-            free_hashtable_pair(to_free);
+            /* exclusive prefix sum, range major: the entries of range r start after every lower range */
+            size_t position = 0;
+            for (size_t r = 0; r < context.ranges; r++)
+                for (size_t slice = 0; slice < context.slices; slice++)
+                {
+                    size_t count = context.positions[slice * context.ranges + r];
+                    context.positions[slice * context.ranges + r] = position;
+                    position += count;
+                }
+
+            executor->run(executor->backend, context.slices, scatter_entries, &context);
+            executor->run(executor->backend, context.ranges, link_entries, &context);
+
+            for (size_t r = 0; r < context.ranges; r++)
+                ht->pair_number += context.inserted[r];
+            built = !atomic_load(&context.failed);
         }
     }
-    free(ht->buckets);
-    free(ht);
+
+    free(context.hashes);
+    free(context.order);
+    free(context.positions);
+    free(context.inserted);
+    return built;
 }
 
-size_t hash_string(void *key)
+void *hashtable_get(const hashtable *ht, const void *key)
 {
-    const char *str = (const char *)key;
-    size_t hash = 5381;
-    int c;
+    if (ht == NULL || key == NULL)
+        return NULL;
 
-    while ((c = *str++))
-        hash = ((hash << 5) + hash) + c;
+    hashtable_pair *pair = find_hashtable_pair(ht, key);
+    if (pair == NULL)
+        return NULL;
 
-    return hash;
+    void *value_copy = malloc(pair->value_size);
+    if (value_copy == NULL)
+        return NULL;
+    memcpy(value_copy, pair->value, pair->value_size);
+    return value_copy;
 }
 
-size_t hash_int(void *key)
+const void *hashtable_get_ref(const hashtable *ht, const void *key, size_t *value_size)
 {
-    return *(int *)key;
+    if (ht == NULL || key == NULL)
+        return NULL;
+
+    hashtable_pair *pair = find_hashtable_pair(ht, key);
+    if (pair == NULL)
+        return NULL;
+
+    if (value_size != NULL)
+        *value_size = pair->value_size;
+    return pair->value;
 }
 
-size_t hash_double(void *key)
+bool hashtable_get_into(const hashtable *ht, const void *key,
+                        void *buffer, const size_t buffer_size, size_t *value_size)
 {
-    double d = *(double *)key;
-    size_t hash = 0;
-    unsigned char *p = (unsigned char *)&d;
+    if (ht == NULL || key == NULL)
+        return false;
 
-    for (size_t i = 0; i < sizeof(double); i++)
-        hash = hash * 31 + p[i];
+    hashtable_pair *pair = find_hashtable_pair(ht, key);
+    if (pair == NULL)
+        return false;
 
-    return hash;
-}
+    if (value_size != NULL)
+        *value_size = pair->value_size;
+    if (buffer == NULL || buffer_size < pair->value_size)
+        return false;
 
-size_t compare_string(const void *key1, const void *key2)
-{
-    return strcmp((const char *)key1, (const char *)key2);
+    memcpy(buffer, pair->value, pair->value_size);
+    return true;
 }
 
-size_t compare_int(const void *key1, const void *key2)
+hashtable_pair *hashtable_get_pair(const hashtable *ht, const void *key)
 {
-    int int1 = *(const int *)key1;
-    int int2 = *(const int *)key2;
+    if (ht == NULL || key == NULL)
+        return NULL;
 
-    return (int1 < int2) ? -1 : (int1 > int2) ? 1 : 0;
+    return find_hashtable_pair(ht, key);
 }
 
-size_t compare_uint8_t(const void *key1, const void *key2)
+size_t hashtable_get_many(const hashtable *ht, const void *const *keys, const size_t n,
+                          const void **values, size_t *value_sizes)
 {
-    uint8_t int1 = *(const uint8_t *)key1;
-    uint8_t int2 = *(const uint8_t *)key2;
+    if (ht == NULL || keys == NULL || values == NULL)
+        return 0;
 
-    return (int1 < int2) ? -1 : (int1 > int2) ? 1 : 0;
-}
+    size_t found = 0;
+    size_t hashes[HASHTABLE_BATCH_SIZE];
+    hashtable_pair **slots[HASHTABLE_BATCH_SIZE];
+    for (size_t start = 0; start < n; start += HASHTABLE_BATCH_SIZE)
+    {
+        size_t batch = n - start < HASHTABLE_BATCH_SIZE ? n - start : HASHTABLE_BATCH_SIZE;
+        const void *const *group = keys + start;
 
-size_t compare_uint16_t(const void *key1, const void *key2)
-{
-    uint16_t int1 = *(const uint16_t *)key1;
-    uint16_t int2 = *(const uint16_t *)key2;
+        /* hash the whole group, then pull in bucket slots and chain heads before walking any chain */
+        for (size_t i = 0; i < batch; i++)
+            hashes[i] = group[i] == NULL ? 0 : HASH_KEY(ht, group[i]);
+        prefetch_group(ht, hashes, slots, batch);
 
-    return (int1 < int2) ? -1 : (int1 > int2) ? 1 : 0;
-}
+        for (size_t i = 0; i < batch; i++)
+        {
+            hashtable_pair *pair = NULL;
+            if (group[i] != NULL && ht->old_buckets == NULL)
+            {
+                pair = *slots[i];
+                while (pair != NULL && (pair->hash != hashes[i] || !KEYS_EQUAL(ht, pair->key, group[i])))
+                    pair = pair->next;
+            }
+            else if (group[i] != NULL)
+            {
+                hashtable_pair **link = find_hashtable_link(ht, group[i], hashes[i]);
+                pair = link == NULL ? NULL : *link;
+            }
+            if (pair != NULL && pair_expired(ht, pair))
+                pair = NULL;
 
-size_t compare_uint32_t(const void *key1, const void *key2)
-{
-    uint32_t int1 = *(const uint32_t *)key1;
-    uint32_t int2 = *(const uint32_t *)key2;
+            values[start + i] = pair == NULL ? NULL : pair->value;
+            if (value_sizes != NULL)
+                value_sizes[start + i] = pair == NULL ? 0 : pair->value_size;
+            found += pair != NULL;
+            COUNT_LOOKUP(ht, pair != NULL);
+        }
+    }
 
-    return (int1 < int2) ? -1 : (int1 > int2) ? 1 : 0;
+    return found;
 }
 
-size_t compare_uint64_t(const void *key1, const void *key2)
+bool hashtable_remove(hashtable *ht, const void *key)
 {
-    uint64_t int1 = *(const uint64_t *)key1;
-    uint64_t int2 = *(const uint64_t *)key2;
+    if (ht == NULL || key == NULL)
+        return false;
 
-    return (int1 < int2) ? -1 : (int1 > int2) ? 1 : 0;
-}
+    if (ht->old_buckets != NULL)
+        rehash_step(ht, HASHTABLE_REHASH_STEP);
 
-size_t compare_double(const void *key1, const void *key2)
-{
-    double double1 = *(const double *)key1;
-    double double2 = *(const double *)key2;
+    hashtable_pair **link = find_hashtable_link(ht, key, HASH_KEY(ht, key));
+    if (link != NULL)
+        unlink_pair(ht, link);
 
-    return (double1 < double2) ? -1 : (double1 > double2) ? 1 : 0;
+    /* after the removal, `key` may point into an expired pair */
+    if (ht->timers != NULL)
+        reclaim_expired(ht, HASHTABLE_EXPIRE_STEP);
+
+    if (ht->pair_number < ht->shrink_threshold && ht->buckets_size > ht->min_buckets_size)
+        return resize_hashtable(ht, ht->buckets_size / 2);
+
+    return true;
 }
 
-hashtable_pair *create_hashtable_pair(const void *key, const size_t key_size,
-                                      const void *value, const size_t value_size)
+bool hashtable_take(hashtable *ht, const void *key,
+                    void **key_out, size_t *key_size,
+                    void **value_out, size_t *value_size)
 {
-    hashtable_pair *pair = malloc(sizeof(hashtable_pair));
-    if (pair == NULL) return NULL;
+    if (ht == NULL || key == NULL)
+        return false;
+
+    if (ht->old_buckets != NULL)
+        rehash_step(ht, HASHTABLE_REHASH_STEP);
+
+    hashtable_pair **link = find_hashtable_link(ht, key, HASH_KEY(ht, key));
+    if (link == NULL || pair_expired(ht, *link))
+        return false;
+    hashtable_pair *pair = *link;
 
-    pair->key = malloc(key_size);
-    if (pair->key == NULL)
+    /* only what lives inside the pair is copied, before anything is unlinked */
+    void *taken_key = pair->key, *taken_value = pair->value;
+    if (key_out != NULL && !KEY_ADOPTED(pair))
     {
-        free(pair);
-        return NULL;
+        taken_key = malloc(pair->key_size);
+        if (taken_key == NULL)
+            return false;
+        memcpy(taken_key, pair->key, pair->key_size);
     }
-    memcpy(pair->key, key, key_size);
-    pair->key_size = key_size;
-
-    pair->value = malloc(value_size);
-    if (pair->value == NULL)
+    if (value_out != NULL && VALUE_INLINE(pair))
     {
-        free(pair->key);
-        free(pair);
-        return NULL;
+        taken_value = malloc(pair->value_size);
+        if (taken_value == NULL)
+        {
+            if (taken_key != pair->key)
+                free(taken_key);
+            return false;
+        }
+        memcpy(taken_value, pair->value, pair->value_size);
     }
-    memcpy(pair->value, value, value_size);
-    pair->value_size = value_size;
 
-    pair->next = NULL;
-
-    return pair;
-}
+    if (key_out != NULL)
+        *key_out = taken_key;
+    else if (KEY_ADOPTED(pair))
+        release_key(ht, pair->key);
+    if (value_out != NULL)
+        *value_out = taken_value;
+    else
+        release_value(ht, pair);
+    if (key_size != NULL)
+        *key_size = pair->key_size;
+    if (value_size != NULL)
+        *value_size = pair->value_size;
 
-void free_hashtable_pair(hashtable_pair *pair)
-{
-    if (pair == NULL)
-        return;
-    free(pair->key);
-    free(pair->value);
+    *link = pair->next;
+    if (pair->timer != NULL)
+        cancel_timer(ht, pair);
     free(pair);
+    ht->pair_number--;
+
+    /* after the removal, `key` may point into an expired pair */
+    if (ht->timers != NULL)
+        reclaim_expired(ht, HASHTABLE_EXPIRE_STEP);
+
+    /* the pair is handed over, a failed shrink only leaves the table emptier than its load factor */
+    if (ht->pair_number < ht->shrink_threshold && ht->buckets_size > ht->min_buckets_size)
+        resize_hashtable(ht, ht->buckets_size / 2);
+
+    return true;
 }
 
-static bool resize_hashtable(hashtable *ht, const size_t new_size)
+void **hashtable_keyset(const hashtable *ht)
 {
-    // controls on parameters are done by the caller (hashtable_put and hashtable_remove)
+    if (ht == NULL || ht->pair_number == 0)
+        return NULL;
 
-    hashtable_pair **new_buckets = calloc(new_size, sizeof(hashtable_pair *));
-    if (new_buckets == NULL)
-        return false;
+    void **keyset = malloc((ht->pair_number + 1) * sizeof(void *));
+    if (keyset == NULL)
+        return NULL;
 
+    size_t index = 0;
     for (size_t i = 0; i < ht->buckets_size; i++)
+        for (hashtable_pair *current = ht->buckets[i]; current != NULL; current = current->next)
+            if (!pair_expired(ht, current))
+                keyset[index++] = current->key;
+    for (size_t i = ht->rehash_index; i < ht->old_buckets_size; i++)
+        for (hashtable_pair *current = ht->old_buckets[i]; current != NULL; current = current->next)
+            if (!pair_expired(ht, current))
+                keyset[index++] = current->key;
+    keyset[index] = NULL;
+
+    return keyset;
+}
+
+size_t hashtable_scan(const hashtable *ht, size_t cursor, const size_t count,
+                      void (*function)(const hashtable_entry *entry, void *context), void *context)
+{
+    if (ht == NULL || function == NULL)
+        return 0;
+
+    size_t visited = 0;
+    do
     {
-        hashtable_pair *current = ht->buckets[i];
-        while (current != NULL)
+        if (ht->old_buckets == NULL)
         {
-            hashtable_pair *next_pair = current->next;
-            size_t new_index = ht->hash_function(current->key) % new_size;
-            current->next = new_buckets[new_index];
-            new_buckets[new_index] = current;
-            current = next_pair;
+            size_t mask = ht->buckets_size - 1;
+            visited += scan_bucket(ht, ht->buckets[cursor & mask], function, context);
+            cursor = next_cursor(cursor, mask);
+            continue;
         }
-    }
 
-    free(ht->buckets);
-    ht->buckets = new_buckets;
-    ht->buckets_size = new_size;
+        /**
+         * during a migration visit the bucket of the smaller array, then every
+         * bucket of the bigger one its pairs can be rehashed into
+         */
+        hashtable_pair **small = ht->buckets, **large = ht->old_buckets;
+        size_t small_mask = ht->buckets_size - 1, large_mask = ht->old_buckets_size - 1;
+        if (small_mask > large_mask)
+        {
+            small = ht->old_buckets;
+            large = ht->buckets;
+            small_mask = ht->old_buckets_size - 1;
+            large_mask = ht->buckets_size - 1;
+        }
 
-    return true;
+        visited += scan_bucket(ht, small[cursor & small_mask], function, context);
+        do
+        {
+            visited += scan_bucket(ht, large[cursor & large_mask], function, context);
+            cursor = next_cursor(cursor, large_mask);
+        } while (cursor & (small_mask ^ large_mask));
+    } while (cursor != 0 && visited < count);
+
+    return cursor;
+}
+
+bool hashtable_size(const hashtable *ht, size_t *size)
+{
+    if (ht == NULL || size == NULL)
+        return false;
+    *size = ht->pair_number;
+    return true;
+}
+
+bool hashtable_set_incremental_resize(hashtable *ht, const bool enabled)
+{
+    if (ht == NULL)
+        return false;
+
+    ht->incremental_resize = enabled;
+    if (!enabled && ht->old_buckets != NULL)
+        rehash_step(ht, SIZE_MAX);
+    return true;
+}
+
+bool hashtable_set_executor(hashtable *ht, const hashtable_executor *executor)
+{
+    if (ht == NULL || (executor != NULL && (executor->run == NULL || executor->parts == 0)))
+        return false;
+
+    ht->executor = executor != NULL ? *executor : (hashtable_executor){ 0 };
+    return true;
+}
+
+bool hashtable_reserve(hashtable *ht, const size_t capacity)
+{
+    if (ht == NULL)
+        return false;
+
+    size_t buckets_size = buckets_for(ht, capacity);
+    if (buckets_size == 0)
+        return false;
+
+    if (buckets_size > ht->buckets_size && !resize_hashtable(ht, buckets_size))
+        return false;
+    if (buckets_size > ht->min_buckets_size)
+        ht->min_buckets_size = buckets_size;
+    return true;
+}
+
+bool hashtable_shrink_to_fit(hashtable *ht)
+{
+    if (ht == NULL)
+        return false;
+
+    ht->min_buckets_size = INITIAL_BUCKETS_SIZE;
+    size_t buckets_size = buckets_for(ht, ht->pair_number);
+    if (buckets_size < ht->buckets_size)
+        return resize_hashtable(ht, buckets_size);
+    return true;
+}
+
+bool hashtable_set_load_factors(hashtable *ht, const double grow_load_factor, const double shrink_load_factor)
+{
+    if (ht == NULL || !(grow_load_factor > 0) || !(shrink_load_factor >= 0) ||
+        !(shrink_load_factor < grow_load_factor / 2))
+        return false;
+
+    ht->grow_load_factor = grow_load_factor;
+    ht->shrink_load_factor = shrink_load_factor;
+    update_thresholds(ht);
+    return true;
+}
+
+size_t hashtable_expire(hashtable *ht, const size_t max_pairs)
+{
+    if (ht == NULL || ht->timers == NULL)
+        return 0;
+
+    size_t reclaimed = reclaim_expired(ht, max_pairs);
+    if (ht->pair_number < ht->shrink_threshold && ht->buckets_size > ht->min_buckets_size)
+        resize_hashtable(ht, ht->buckets_size / 2);
+    return reclaimed;
+}
+
+bool hashtable_pair_expired(const hashtable *ht, const hashtable_pair *pair)
+{
+    if (ht == NULL || pair == NULL)
+        return false;
+    return pair_expired(ht, pair);
+}
+
+bool hashtable_set_clock(hashtable *ht, uint64_t (*clock)(void))
+{
+    if (ht == NULL || ht->timers != NULL)
+        return false;
+
+    ht->clock = clock;
+    return true;
+}
+
+bool hashtable_stats(const hashtable *ht, hashtable_statistics *stats)
+{
+    if (ht == NULL || stats == NULL)
+        return false;
+
+    memset(stats, 0, sizeof(hashtable_statistics));
+    stats->pair_number = ht->pair_number;
+    stats->resizes = ht->resizes;
+    stats->rehashed_pairs = ht->rehashed_pairs;
+    stats->rehash_nanoseconds = ht->rehash_nanoseconds;
+    stats->hits = ht->hits;
+    stats->misses = ht->misses;
+    stats->expired_pairs = ht->expired_pairs;
+    stats->table_bytes = sizeof(hashtable);
+    stats->timer_bytes = ht->timers != NULL ? sizeof(hashtable_timer_wheel) : 0;
+
+    hashtable_pair **arrays[] = { ht->buckets, ht->old_buckets };
+    size_t sizes[] = { ht->buckets_size, ht->old_buckets == NULL ? 0 : ht->old_buckets_size };
+    for (size_t a = 0; a < 2; a++)
+    {
+        stats->buckets_size += sizes[a];
+        for (size_t i = 0; i < sizes[a]; i++)
+        {
+            size_t length = 0;
+            for (const hashtable_pair *pair = arrays[a][i]; pair != NULL; pair = pair->next, length++)
+            {
+                stats->pair_bytes += sizeof(hashtable_pair);
+                stats->key_bytes += KEY_ADOPTED(pair) ? 0 : PAIR_ALIGN(pair->key_size);
+                stats->value_bytes += pair->value_capacity;
+                stats->external_values += !VALUE_INLINE(pair);
+                stats->adopted_bytes += (KEY_ADOPTED(pair) ? pair->key_size : 0) +
+                                        (VALUE_ADOPTED(pair) ? pair->value_size : 0);
+                stats->timer_bytes += pair->timer != NULL ? sizeof(hashtable_timer) : 0;
+            }
+
+            stats->chain_histogram[length < HASHTABLE_STATS_HISTOGRAM_SIZE ? length : HASHTABLE_STATS_HISTOGRAM_SIZE - 1]++;
+            if (length > stats->max_chain_length)
+                stats->max_chain_length = length;
+        }
+    }
+
+    stats->load_factor = (double)ht->pair_number / ht->buckets_size;
+    stats->bucket_bytes = stats->buckets_size * sizeof(hashtable_pair *);
+    stats->total_bytes = stats->table_bytes + stats->bucket_bytes + stats->pair_bytes +
+                         stats->key_bytes + stats->value_bytes + stats->timer_bytes;
+    return true;
+}
+
+void hashtable_destroy(hashtable *ht)
+{
+    if (ht == NULL)
+        return;
+
+    free_buckets(ht, ht->buckets, ht->buckets_size);
+    free_buckets(ht, ht->old_buckets, ht->old_buckets_size);
+    free(ht->timers);
+    free(ht);
+}
+
+/**
+ * wyhash: the input is consumed 8 bytes at a time and folded with 64x64->128
+ * bit multiplications, keys up to 16 bytes are read with a few overlapping loads
+ */
+static inline uint64_t wymix(const uint64_t a, const uint64_t b)
+{
+#if defined(__SIZEOF_INT128__)
+    __uint128_t r = (__uint128_t)a * b;
+    return (uint64_t)r ^ (uint64_t)(r >> 64);
+#else
+    uint64_t ha = a >> 32, hb = b >> 32, la = (uint32_t)a, lb = (uint32_t)b;
+    uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+    uint64_t t = rl + (rm0 << 32), c = t < rl;
+    uint64_t lo = t + (rm1 << 32);
+    c += lo < t;
+    uint64_t hi = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+    return lo ^ hi;
+#endif
+}
+
+static inline uint64_t read64(const unsigned char *p)
+{
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint64_t read32(const unsigned char *p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+size_t hash_bytes(const void *key, const size_t key_size, const uint64_t seed)
+{
+    static const uint64_t secret[4] = { 0xa0761d6478bd642full, 0xe7037ed1a0b428dbull,
+                                        0x8ebc6af09c88c6e3ull, 0x589965cc75374cc3ull };
+    const unsigned char *p = key;
+    size_t length = key_size != 0 ? key_size : strlen(key);
+    uint64_t state = seed ^ wymix(seed ^ secret[0], secret[1]);
+    uint64_t a, b;
+
+    if (length <= 16)
+    {
+        if (length >= 4)
+        {
+            size_t middle = (length >> 3) << 2;
+            a = (read32(p) << 32) | read32(p + middle);
+            b = (read32(p + length - 4) << 32) | read32(p + length - 4 - middle);
+        }
+        else if (length > 0)
+        {
+            a = ((uint64_t)p[0] << 16) | ((uint64_t)p[length >> 1] << 8) | p[length - 1];
+            b = 0;
+        }
+        else
+            a = b = 0;
+    }
+    else
+    {
+        size_t i = length;
+        if (i > 48)
+        {
+            uint64_t state1 = state, state2 = state;
+            do
+            {
+                state = wymix(read64(p) ^ secret[1], read64(p + 8) ^ state);
+                state1 = wymix(read64(p + 16) ^ secret[2], read64(p + 24) ^ state1);
+                state2 = wymix(read64(p + 32) ^ secret[3], read64(p + 40) ^ state2);
+                p += 48;
+                i -= 48;
+            } while (i > 48);
+            state ^= state1 ^ state2;
+        }
+        while (i > 16)
+        {
+            state = wymix(read64(p) ^ secret[1], read64(p + 8) ^ state);
+            p += 16;
+            i -= 16;
+        }
+        a = read64(p + i - 16);
+        b = read64(p + i - 8);
+    }
+
+    return wymix(secret[1] ^ length, wymix(a ^ secret[1], b ^ state));
+}
+
+uint64_t hash_fmix64(uint64_t key)
+{
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdull;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ull;
+    key ^= key >> 33;
+    return key;
+}
+
+size_t hash_string(void *key)
+{
+    return hash_bytes(key, 0, 0);
+}
+
+size_t hash_hashtable_string(void *key)
+{
+    return ((const hashtable_string *)key)->hash;
+}
+
+hashtable_string hashtable_string_make(const char *data, const size_t length)
+{
+    /* hash_bytes reads up to the NUL when given no length */
+    return (hashtable_string){ data, length, hash_bytes(length == 0 ? "" : data, length, 0) };
+}
+
+size_t hash_int(void *key)
+{
+    return hash_fmix64((uint64_t)*(int *)key);
+}
+
+size_t hash_uint64_t(void *key)
+{
+    return hash_fmix64(*(uint64_t *)key);
+}
+
+size_t hash_double(void *key)
+{
+    double d = *(double *)key;
+    if (d == 0.0)
+        d = 0.0; // -0.0 compares equal to 0.0, it must hash the same
+
+    uint64_t bits;
+    memcpy(&bits, &d, sizeof(bits));
+    return hash_fmix64(bits);
+}
+
+size_t compare_string(const void *key1, const void *key2)
+{
+    return strcmp((const char *)key1, (const char *)key2);
+}
+
+size_t compare_int(const void *key1, const void *key2)
+{
+    int int1 = *(const int *)key1;
+    int int2 = *(const int *)key2;
+
+    return (int1 < int2) ? -1 : (int1 > int2) ? 1 : 0;
+}
+
+size_t compare_uint8_t(const void *key1, const void *key2)
+{
+    uint8_t int1 = *(const uint8_t *)key1;
+    uint8_t int2 = *(const uint8_t *)key2;
+
+    return (int1 < int2) ? -1 : (int1 > int2) ? 1 : 0;
+}
+
+size_t compare_uint16_t(const void *key1, const void *key2)
+{
+    uint16_t int1 = *(const uint16_t *)key1;
+    uint16_t int2 = *(const uint16_t *)key2;
+
+    return (int1 < int2) ? -1 : (int1 > int2) ? 1 : 0;
+}
+
+size_t compare_uint32_t(const void *key1, const void *key2)
+{
+    uint32_t int1 = *(const uint32_t *)key1;
+    uint32_t int2 = *(const uint32_t *)key2;
+
+    return (int1 < int2) ? -1 : (int1 > int2) ? 1 : 0;
+}
+
+size_t compare_uint64_t(const void *key1, const void *key2)
+{
+    uint64_t int1 = *(const uint64_t *)key1;
+    uint64_t int2 = *(const uint64_t *)key2;
+
+    return (int1 < int2) ? -1 : (int1 > int2) ? 1 : 0;
+}
+
+size_t compare_double(const void *key1, const void *key2)
+{
+    double double1 = *(const double *)key1;
+    double double2 = *(const double *)key2;
+
+    return (double1 < double2) ? -1 : (double1 > double2) ? 1 : 0;
+}
+
+size_t compare_bytes(const void *key1, const void *key2, const size_t key_size)
+{
+    if (key_size == 0)
+        return strcmp((const char *)key1, (const char *)key2);
+    return memcmp(key1, key2, key_size);
+}
+
+size_t compare_hashtable_string(const void *key1, const void *key2)
+{
+    const hashtable_string *string1 = key1, *string2 = key2;
+    if (string1->length != string2->length)
+        return 1;
+    if (string1->data == string2->data)
+        return 0;
+    return memcmp(string1->data, string2->data, string1->length) != 0;
+}
+
+hashtable_pair *create_hashtable_pair(const void *key, const size_t key_size,
+                                      const void *value, const size_t value_size,
+                                      const size_t hash)
+{
+    size_t value_capacity = PAIR_ALIGN(value_size);
+    hashtable_pair *pair = malloc(sizeof(hashtable_pair) + PAIR_ALIGN(key_size) + value_capacity);
+    if (pair == NULL) return NULL;
+
+    pair->key = pair->data;
+    memcpy(pair->key, key, key_size);
+    pair->key_size = key_size;
+
+    pair->value = PAIR_INLINE_VALUE(pair);
+    if (value != NULL)
+        memcpy(pair->value, value, value_size);
+    else
+        memset(pair->value, 0, value_size);
+    pair->value_size = value_size;
+    pair->value_capacity = value_capacity;
+
+    pair->hash = hash;
+    pair->next = NULL;
+    pair->timer = NULL;
+
+    return pair;
+}
+
+void free_hashtable_pair(const hashtable *ht, hashtable_pair *pair)
+{
+    if (pair == NULL)
+        return;
+    if (KEY_ADOPTED(pair))
+        release_key(ht, pair->key);
+    release_value(ht, pair);
+    free(pair->timer); // already unlinked, or the whole table is being freed
+    free(pair);
+}
+
+static void release_key(const hashtable *ht, void *key)
+{
+    if (ht->key_destructor != NULL)
+        ht->key_destructor(key);
+    else
+        free(key);
+}
+
+/* frees the value of `pair` wherever it's stored, an inline value goes with the pair */
+static void release_value(const hashtable *ht, hashtable_pair *pair)
+{
+    if (VALUE_ADOPTED(pair))
+    {
+        if (ht->value_destructor != NULL)
+            ht->value_destructor(pair->value);
+        else
+            free(pair->value);
+    }
+    else if (!VALUE_INLINE(pair))
+        free(pair->value);
+}
+
+/* the checks of `hashtable_put` for an entry of a batch */
+static bool valid_entry(const hashtable *ht, const hashtable_entry *entry)
+{
+    return entry->key != NULL && entry->key_size != 0 && entry->value != NULL && entry->value_size != 0 &&
+           (ht->key_size == 0 || entry->key_size == ht->key_size);
+}
+
+static bool update_hashtable_pair(const hashtable *ht, hashtable_pair *pair, const void *value, const size_t value_size)
+{
+    if (VALUE_ADOPTED(pair))
+    {
+        /* the size of an adopted buffer is unknown, the copy goes to a buffer of the table */
+        void *new_value = malloc(value_size);
+        if (new_value == NULL)
+            return false;
+        if (value != NULL)
+            memcpy(new_value, value, value_size);
+        else
+            memset(new_value, 0, value_size);
+        release_value(ht, pair);
+        pair->value = new_value;
+        pair->value_size = pair->value_capacity = value_size;
+        return true;
+    }
+
+    if (value_size > pair->value_capacity)
+    {
+        /* the pair can't be reallocated without invalidating its key, move only the value */
+        bool is_inline = VALUE_INLINE(pair);
+        void *new_value = is_inline ? malloc(value_size) : realloc(pair->value, value_size);
+        if (new_value == NULL)
+            return false;
+        pair->value = new_value;
+        pair->value_capacity = value_size;
+    }
+
+    if (value != NULL)
+        memmove(pair->value, value, value_size);
+    else
+        memset(pair->value, 0, value_size);
+    pair->value_size = value_size;
+    return true;
+}
+
+/* `expires_at` is 0 for a persistent pair */
+static bool put_hashed(hashtable *ht,
+                       const void *key, const size_t key_size,
+                       const void *value, const size_t value_size,
+                       const size_t hash, const uint64_t expires_at)
+{
+    if (ht->old_buckets != NULL)
+        rehash_step(ht, HASHTABLE_REHASH_STEP);
+
+    hashtable_pair **link = find_hashtable_link(ht, key, hash);
+    if (link != NULL)
+    {
+        hashtable_pair *pair = *link;
+        if (!update_hashtable_pair(ht, pair, value, value_size))
+            return false;
+        if (expires_at != 0)
+            return schedule_pair(ht, pair, expires_at);
+        if (pair->timer != NULL)
+            cancel_timer(ht, pair);
+        return true;
+    }
+
+    hashtable_pair *new_pair = create_hashtable_pair(key, key_size, value, value_size, hash);
+    if (new_pair == NULL)
+        return false;
+    if (expires_at != 0 && !schedule_pair(ht, new_pair, expires_at))
+    {
+        free_hashtable_pair(ht, new_pair);
+        return false;
+    }
+
+    size_t index = BUCKET_INDEX(hash, ht->buckets_size);
+    new_pair->next = ht->buckets[index];
+    ht->buckets[index] = new_pair;
+    ht->pair_number++;
+
+    /* after the insertion, `key` may point into an expired pair */
+    if (ht->timers != NULL)
+        reclaim_expired(ht, HASHTABLE_EXPIRE_STEP);
+
+    if (ht->pair_number > ht->grow_threshold)
+        return resize_hashtable(ht, ht->buckets_size * 2);
+
+    return true;
+}
+
+/**
+ * the pair holding `key`, inserted with `init_value` (zeroed when NULL) if it's missing.
+ * An expired pair is reused as if it was missing, and becomes persistent.
+ */
+static hashtable_pair *find_or_insert(hashtable *ht,
+                                      const void *key, const size_t key_size,
+                                      const void *init_value, const size_t value_size,
+                                      const size_t hash, bool *inserted)
+{
+    if (ht->old_buckets != NULL)
+        rehash_step(ht, HASHTABLE_REHASH_STEP);
+
+    hashtable_pair **link = find_hashtable_link(ht, key, hash);
+    if (link != NULL && !pair_expired(ht, *link))
+    {
+        *inserted = false;
+        return *link;
+    }
+
+    *inserted = true;
+    if (link != NULL)
+    {
+        if (!update_hashtable_pair(ht, *link, init_value, value_size))
+            return NULL;
+        cancel_timer(ht, *link);
+        return *link;
+    }
+
+    hashtable_pair *new_pair = create_hashtable_pair(key, key_size, init_value, value_size, hash);
+    if (new_pair == NULL)
+        return NULL;
+
+    size_t index = BUCKET_INDEX(hash, ht->buckets_size);
+    new_pair->next = ht->buckets[index];
+    ht->buckets[index] = new_pair;
+    ht->pair_number++;
+
+    if (ht->timers != NULL)
+        reclaim_expired(ht, HASHTABLE_EXPIRE_STEP);
+
+    /* a failed grow leaves the table valid, only fuller than its load factor */
+    if (ht->pair_number > ht->grow_threshold)
+        resize_hashtable(ht, ht->buckets_size * 2);
+
+    return new_pair;
+}
+
+/* removes the pair `link` points to, with its timer */
+static void unlink_pair(hashtable *ht, hashtable_pair **link)
+{
+    hashtable_pair *pair = *link;
+    *link = pair->next;
+    if (pair->timer != NULL)
+        cancel_timer(ht, pair);
+    free_hashtable_pair(ht, pair);
+    ht->pair_number--;
+}
+
+/**
+ * group prefetching: issues the loads of every bucket slot of the group,
+ * then of every chain head, so the misses of the group overlap. Slots of
+ * buckets still waiting for an incremental migration are only prefetched.
+ */
+static void prefetch_group(const hashtable *ht, const size_t *hashes, hashtable_pair ***slots, const size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        slots[i] = &ht->buckets[BUCKET_INDEX(hashes[i], ht->buckets_size)];
+        __builtin_prefetch(slots[i]);
+        if (ht->old_buckets != NULL)
+            __builtin_prefetch(&ht->old_buckets[BUCKET_INDEX(hashes[i], ht->old_buckets_size)]);
+    }
+
+    for (size_t i = 0; i < n; i++)
+        __builtin_prefetch(*slots[i]);
+}
+
+static size_t scan_bucket(const hashtable *ht, const hashtable_pair *current,
+                          void (*function)(const hashtable_entry *entry, void *context), void *context)
+{
+    size_t visited = 0;
+    for (; current != NULL; current = current->next, visited++)
+    {
+        if (pair_expired(ht, current))
+            continue;
+        hashtable_entry entry = { current->key, current->key_size, current->value, current->value_size };
+        function(&entry, context);
+    }
+    return visited;
+}
+
+/**
+ * increments the cursor starting from its highest masked bit: the buckets a
+ * bucket splits into (or merges from) when the size doubles (or halves) are
+ * visited one right after the other, whatever the size was when scanned
+ */
+static size_t next_cursor(const size_t cursor, const size_t mask)
+{
+    uint64_t v = cursor | ~mask;
+
+    v = ((v >> 1) & 0x5555555555555555ull) | ((v & 0x5555555555555555ull) << 1);
+    v = ((v >> 2) & 0x3333333333333333ull) | ((v & 0x3333333333333333ull) << 2);
+    v = ((v >> 4) & 0x0F0F0F0F0F0F0F0Full) | ((v & 0x0F0F0F0F0F0F0F0Full) << 4);
+    v = __builtin_bswap64(v) + 1;
+    v = ((v >> 1) & 0x5555555555555555ull) | ((v & 0x5555555555555555ull) << 1);
+    v = ((v >> 2) & 0x3333333333333333ull) | ((v & 0x3333333333333333ull) << 2);
+    v = ((v >> 4) & 0x0F0F0F0F0F0F0F0Full) | ((v & 0x0F0F0F0F0F0F0F0Full) << 4);
+
+    return __builtin_bswap64(v);
+}
+
+static hashtable *allocate_hashtable(const size_t buckets_size)
+{
+    hashtable *ht = malloc(sizeof(hashtable));
+    if (ht == NULL) return NULL;
+
+    ht->buckets_size = buckets_size;
+    ht->pair_number = 0;
+    ht->hash_function = NULL;
+    ht->compare_key_function = NULL;
+    ht->seeded_hash_function = NULL;
+    ht->sized_compare_key_function = NULL;
+    ht->key_size = 0;
+    ht->seed = 0;
+    ht->old_buckets = NULL;
+    ht->old_buckets_size = ht->rehash_index = 0;
+    ht->incremental_resize = false;
+    ht->min_buckets_size = INITIAL_BUCKETS_SIZE;
+    ht->grow_load_factor = HASHTABLE_GROW_LOAD_FACTOR;
+    ht->shrink_load_factor = HASHTABLE_SHRINK_LOAD_FACTOR;
+    ht->executor = (hashtable_executor){ 0 };
+    ht->resizes = ht->rehashed_pairs = 0;
+    ht->rehash_nanoseconds = 0;
+    ht->hits = ht->misses = 0;
+    ht->timers = NULL;
+    ht->clock = NULL;
+    ht->expired_pairs = 0;
+    ht->key_destructor = ht->value_destructor = NULL;
+    update_thresholds(ht);
+
+    ht->buckets = calloc(ht->buckets_size, sizeof(hashtable_pair *));
+    if (ht->buckets == NULL)
+    {
+        free(ht);
+        return NULL;
+    }
+
+    return ht;
+}
+
+/**
+ * smallest power of two number of buckets, at least INITIAL_BUCKETS_SIZE, that
+ * holds `capacity` pairs without going above the grow load factor of `ht`
+ * (the default one when `ht` is NULL), 0 if it doesn't fit in a size_t
+ */
+static size_t buckets_for(const hashtable *ht, const size_t capacity)
+{
+    double load_factor = ht != NULL ? ht->grow_load_factor : HASHTABLE_GROW_LOAD_FACTOR;
+    size_t buckets_size = INITIAL_BUCKETS_SIZE;
+
+    while (buckets_size * load_factor < capacity)
+    {
+        if (buckets_size > SIZE_MAX / 2 / sizeof(hashtable_pair *))
+            return 0;
+        buckets_size *= 2;
+    }
+    return buckets_size;
+}
+
+/* thresholds are compared against on every put/remove, the floating point math only runs on resize */
+static void update_thresholds(hashtable *ht)
+{
+    double grow = ht->buckets_size * ht->grow_load_factor;
+    double shrink = ht->buckets_size * ht->shrink_load_factor;
+
+    ht->grow_threshold = grow >= (double)SIZE_MAX ? SIZE_MAX : (size_t)grow;
+    ht->shrink_threshold = (size_t)shrink;
+    if (ht->shrink_threshold < shrink)
+        ht->shrink_threshold++;
+}
+
+static uint64_t monotonic_nanoseconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static uint64_t random_seed(const void *salt)
+{
+    uint64_t seed;
+    if (getrandom(&seed, sizeof(seed), GRND_NONBLOCK) == sizeof(seed))
+        return seed;
+
+    /* no entropy available yet, better than a constant. Tables may be created from several threads */
+    static _Atomic uint64_t counter = 0;
+    uint64_t count = atomic_fetch_add(&counter, 1) + 1;
+    return hash_fmix64((uint64_t)(uintptr_t)salt ^ (uint64_t)time(NULL) ^ count * 0x9E3779B97F4A7C15ull);
+}
+
+/* expired pairs are left in place for `reclaim_expired`, lookups just skip them */
+static hashtable_pair *find_hashtable_pair(const hashtable *ht, const void *key)
+{
+    hashtable_pair **link = find_hashtable_link(ht, key, HASH_KEY(ht, key));
+    hashtable_pair *pair = link == NULL || pair_expired(ht, *link) ? NULL : *link;
+    COUNT_LOOKUP(ht, pair != NULL);
+    return pair;
+}
+
+/**
+ * returns the address of the bucket head or `next` field pointing to the
+ * pair holding `key`, NULL if the key is not in the hashtable
+ */
+static hashtable_pair **find_hashtable_link(const hashtable *ht, const void *key, const size_t hash)
+{
+    if (ht->old_buckets != NULL && BUCKET_INDEX(hash, ht->old_buckets_size) >= ht->rehash_index)
+    {
+        /* not migrated yet, but the key may also have been inserted after the resize */
+        hashtable_pair **link = &ht->old_buckets[BUCKET_INDEX(hash, ht->old_buckets_size)];
+        for (; *link != NULL; link = &(*link)->next)
+            if ((*link)->hash == hash && KEYS_EQUAL(ht, (*link)->key, key))
+                return link;
+    }
+
+    hashtable_pair **link = &ht->buckets[BUCKET_INDEX(hash, ht->buckets_size)];
+    for (; *link != NULL; link = &(*link)->next)
+        if ((*link)->hash == hash && KEYS_EQUAL(ht, (*link)->key, key))
+            return link;
+
+    return NULL;
+}
+
+static bool resize_hashtable(hashtable *ht, const size_t new_size)
+{
+    // controls on parameters are done by the caller, new_size is a power of two
+
+    /* only one migration at a time */
+    if (ht->old_buckets != NULL)
+        rehash_step(ht, SIZE_MAX);
+
+    hashtable_pair **new_buckets = calloc(new_size, sizeof(hashtable_pair *));
+    if (new_buckets == NULL)
+        return false;
+
+    ht->old_buckets = ht->buckets;
+    ht->old_buckets_size = ht->buckets_size;
+    ht->rehash_index = 0;
+    ht->buckets = new_buckets;
+    ht->buckets_size = new_size;
+    update_thresholds(ht);
+
+    ht->resizes++;
+    if (ht->executor.run != NULL && !ht->incremental_resize && ht->old_buckets_size >= HASHTABLE_PARALLEL_REHASH_MIN)
+    {
+        uint64_t start = monotonic_nanoseconds();
+        ht->executor.run(ht->executor.backend, ht->executor.parts, rehash_range, ht);
+        ht->rehashed_pairs += ht->pair_number;
+        ht->rehash_nanoseconds += monotonic_nanoseconds() - start;
+        free(ht->old_buckets);
+        ht->old_buckets = NULL;
+        ht->old_buckets_size = 0;
+        return true;
+    }
+
+    rehash_step(ht, ht->incremental_resize ? HASHTABLE_REHASH_STEP : SIZE_MAX);
+
+    return true;
+}
+
+/**
+ * moves the chains of up to `steps` non empty old buckets into the new
+ * buckets, visiting at most 10 empty buckets per step so a sparse old
+ * array can't turn a single call into a full scan
+ */
+static void rehash_step(hashtable *ht, const size_t steps)
+{
+    size_t remaining = steps;
+    size_t empty_visits = steps > SIZE_MAX / 10 ? SIZE_MAX : steps * 10;
+    bool timed = TIME_REHASH_STEP(steps);
+    uint64_t start = timed ? monotonic_nanoseconds() : 0;
+
+    while (remaining > 0 && ht->rehash_index < ht->old_buckets_size)
+    {
+        hashtable_pair *current = ht->old_buckets[ht->rehash_index];
+        ht->old_buckets[ht->rehash_index++] = NULL;
+        if (current == NULL)
+        {
+            if (--empty_visits == 0)
+                break;
+            continue;
+        }
+
+        while (current != NULL)
+        {
+            hashtable_pair *next_pair = current->next;
+            size_t new_index = BUCKET_INDEX(current->hash, ht->buckets_size);
+            current->next = ht->buckets[new_index];
+            ht->buckets[new_index] = current;
+            current = next_pair;
+            ht->rehashed_pairs++;
+        }
+        remaining--;
+    }
+
+    if (timed)
+        ht->rehash_nanoseconds += monotonic_nanoseconds() - start;
+    if (ht->rehash_index == ht->old_buckets_size)
+    {
+        free(ht->old_buckets);
+        ht->old_buckets = NULL;
+        ht->old_buckets_size = ht->rehash_index = 0;
+    }
+}
+
+/* hashes a slice of the entries and counts how many go to every bucket range */
+static void hash_entries(void *contextp, const size_t part, const size_t parts)
+{
+    build_context *context = contextp;
+    const hashtable *ht = context->ht;
+    size_t *positions = &context->positions[part * context->ranges];
+
+    for (size_t i = part * context->n / parts; i < (part + 1) * context->n / parts; i++)
+    {
+        const hashtable_entry *entry = &context->entries[i];
+        if (!valid_entry(ht, entry))
+        {
+            atomic_store(&context->failed, true);
+            return;
+        }
+
+        context->hashes[i] = HASH_KEY(ht, entry->key);
+        positions[BUCKET_INDEX(context->hashes[i], ht->buckets_size) >> context->range_shift]++;
+    }
+}
+
+/* slices are scattered in order, so every range keeps the entries in input order */
+static void scatter_entries(void *contextp, const size_t part, const size_t parts)
+{
+    build_context *context = contextp;
+    size_t *positions = &context->positions[part * context->ranges];
+
+    for (size_t i = part * context->n / parts; i < (part + 1) * context->n / parts; i++)
+        context->order[positions[BUCKET_INDEX(context->hashes[i], context->ht->buckets_size) >> context->range_shift]++] = i;
+}
+
+static void link_entries(void *contextp, const size_t part, const size_t parts)
+{
+    (void)parts;
+    build_context *context = contextp;
+    hashtable *ht = context->ht;
+
+    /* after the scatter positions[s][r] is the end of slice s in range r, the last slice ends the range */
+    const size_t *last_slice = &context->positions[(context->slices - 1) * context->ranges];
+    size_t start = part == 0 ? 0 : last_slice[part - 1];
+    size_t end = last_slice[part];
+
+    for (size_t k = start; k < end; k++)
+    {
+        const hashtable_entry *entry = &context->entries[context->order[k]];
+        size_t hash = context->hashes[context->order[k]];
+
+        hashtable_pair **link = find_hashtable_link(ht, entry->key, hash);
+        if (link != NULL)
+        {
+            if (!update_hashtable_pair(ht, *link, entry->value, entry->value_size))
+                atomic_store(&context->failed, true);
+            continue;
+        }
+
+        hashtable_pair *new_pair = create_hashtable_pair(entry->key, entry->key_size, entry->value, entry->value_size, hash);
+        if (new_pair == NULL)
+        {
+            atomic_store(&context->failed, true);
+            continue;
+        }
+
+        size_t index = BUCKET_INDEX(hash, ht->buckets_size);
+        new_pair->next = ht->buckets[index];
+        ht->buckets[index] = new_pair;
+        context->inserted[part]++;
+    }
+}
+
+/**
+ * moves the chains of a range of buckets: growing, the pairs of old bucket i can only go
+ * to new buckets congruent to i, shrinking, new bucket j only receives old buckets
+ * congruent to j, so splitting the larger side of the modulo keeps the parts disjoint
+ */
+static void rehash_range(void *htp, const size_t part, const size_t parts)
+{
+    hashtable *ht = htp;
+    bool growing = ht->buckets_size >= ht->old_buckets_size;
+    size_t smaller = growing ? ht->old_buckets_size : ht->buckets_size;
+    size_t start = part * smaller / parts, end = (part + 1) * smaller / parts;
+
+    for (size_t i = start; i < end; i++)
+        for (size_t old = i; old < ht->old_buckets_size; old += growing ? ht->old_buckets_size : ht->buckets_size)
+        {
+            hashtable_pair *current = ht->old_buckets[old];
+            ht->old_buckets[old] = NULL;
+            while (current != NULL)
+            {
+                hashtable_pair *next_pair = current->next;
+                size_t new_index = BUCKET_INDEX(current->hash, ht->buckets_size);
+                current->next = ht->buckets[new_index];
+                ht->buckets[new_index] = current;
+                current = next_pair;
+            }
+        }
+}
+
+static void free_buckets(const hashtable *ht, hashtable_pair **buckets, const size_t buckets_size)
+{
+    if (buckets == NULL)
+        return;
+
+    for (size_t i = 0; i < buckets_size; i++)
+    {
+        hashtable_pair *current = buckets[i];
+        while (current != NULL)
+        {
+            hashtable_pair *to_free = current;
+            current = current->next;
+            free_hashtable_pair(ht, to_free);
+        }
+    }
+    free(buckets);
+}
+
+static uint64_t now_milliseconds(const hashtable *ht)
+{
+    return ht->clock != NULL ? ht->clock() : monotonic_nanoseconds() / 1000000;
+}
+
+static bool pair_expired(const hashtable *ht, const hashtable_pair *pair)
+{
+    return pair->timer != NULL && pair->timer->expires_at <= now_milliseconds(ht);
+}
+
+/* gives the pair a timer, or moves the one it has, the wheel must exist */
+static bool schedule_pair(hashtable *ht, hashtable_pair *pair, const uint64_t expires_at)
+{
+    if (pair->timer == NULL)
+    {
+        pair->timer = malloc(sizeof(hashtable_timer));
+        if (pair->timer == NULL)
+            return false;
+        pair->timer->pair = pair;
+    }
+    else
+        unlink_timer(ht->timers, pair->timer);
+
+    pair->timer->expires_at = expires_at;
+    place_timer(ht->timers, pair->timer);
+    return true;
+}
+
+static void cancel_timer(hashtable *ht, hashtable_pair *pair)
+{
+    unlink_timer(ht->timers, pair->timer);
+    free(pair->timer);
+    pair->timer = NULL;
+}
+
+static void link_timer(hashtable_timer_wheel *wheel, hashtable_timer *timer, const size_t level, const size_t slot)
+{
+    hashtable_timer **head = level == TIMER_LEVELS ? &wheel->expired : &wheel->slots[level][slot];
+    timer->level = (unsigned char)level;
+    timer->slot = (unsigned char)slot;
+    timer->prev = NULL;
+    timer->next = *head;
+    if (*head != NULL)
+        (*head)->prev = timer;
+    *head = timer;
+    if (level < TIMER_LEVELS)
+        wheel->occupied[level] |= 1ull << slot;
+}
+
+static void unlink_timer(hashtable_timer_wheel *wheel, hashtable_timer *timer)
+{
+    hashtable_timer **head = timer->level == TIMER_LEVELS ? &wheel->expired : &wheel->slots[timer->level][timer->slot];
+    if (timer->prev != NULL)
+        timer->prev->next = timer->next;
+    else
+        *head = timer->next;
+    if (timer->next != NULL)
+        timer->next->prev = timer->prev;
+    if (timer->level < TIMER_LEVELS && *head == NULL)
+        wheel->occupied[timer->level] &= ~(1ull << timer->slot);
+}
+
+/**
+ * the lowest level whose slots are wide enough to reach the expiry from the current
+ * tick, the slot is picked from the expiry bits of that level: it comes around
+ * before the timer is due and the timer then goes down to a lower level
+ */
+static void place_timer(hashtable_timer_wheel *wheel, hashtable_timer *timer)
+{
+    if (timer->expires_at <= wheel->tick)
+    {
+        link_timer(wheel, timer, TIMER_LEVELS, 0);
+        return;
+    }
+
+    uint64_t when = timer->expires_at - wheel->tick < TIMER_SPAN(TIMER_LEVELS)
+                    ? timer->expires_at
+                    : wheel->tick + TIMER_SPAN(TIMER_LEVELS) - 1;
+    size_t level = 0;
+    while (level < TIMER_LEVELS - 1 && when - wheel->tick >= TIMER_SPAN(level + 1))
+        level++;
+    link_timer(wheel, timer, level, (when >> (TIMER_SLOT_BITS * level)) & (TIMER_SLOTS - 1));
+}
+
+/**
+ * moves the tick up to `now`, stopping only on ticks where something happens: the
+ * next occupied slot of level 0 or the next turn of the lowest occupied level.
+ * On every turn of a level its current slot is emptied into the levels below, highest
+ * level first, then the level 0 slot of the tick is emptied into the expired list.
+ */
+static void advance_wheel(hashtable_timer_wheel *wheel, const uint64_t now)
+{
+    while (wheel->tick < now)
+    {
+        size_t position = wheel->tick & (TIMER_SLOTS - 1);
+        uint64_t ahead = position == TIMER_SLOTS - 1 ? 0 : wheel->occupied[0] >> (position + 1) << (position + 1);
+        uint64_t next;
+        if (ahead != 0)
+            next = (wheel->tick & ~(uint64_t)(TIMER_SLOTS - 1)) + (uint64_t)__builtin_ctzll(ahead);
+        else
+        {
+            size_t level = 1;
+            if (wheel->occupied[0] == 0)
+                while (level < TIMER_LEVELS && wheel->occupied[level] == 0)
+                    level++;
+            if (level == TIMER_LEVELS)
+            {
+                wheel->tick = now;
+                return;
+            }
+            next = (wheel->tick | (TIMER_SPAN(level) - 1)) + 1;
+        }
+
+        if (next > now)
+        {
+            wheel->tick = now;
+            return;
+        }
+
+        wheel->tick = next;
+        for (size_t level = TIMER_LEVELS; level-- > 0;)
+        {
+            if ((next & (TIMER_SPAN(level) - 1)) != 0)
+                continue;
+
+            size_t slot = (next >> (TIMER_SLOT_BITS * level)) & (TIMER_SLOTS - 1);
+            hashtable_timer *timer = wheel->slots[level][slot];
+            wheel->slots[level][slot] = NULL;
+            wheel->occupied[level] &= ~(1ull << slot);
+            while (timer != NULL)
+            {
+                hashtable_timer *next_timer = timer->next;
+                place_timer(wheel, timer);
+                timer = next_timer;
+            }
+        }
+    }
+}
+
+/* frees up to `max_pairs` pairs of the expired list, after bringing the wheel to now */
+static size_t reclaim_expired(hashtable *ht, const size_t max_pairs)
+{
+    hashtable_timer_wheel *wheel = ht->timers;
+    advance_wheel(wheel, now_milliseconds(ht));
+
+    size_t reclaimed = 0;
+    while (reclaimed < max_pairs && wheel->expired != NULL)
+    {
+        hashtable_pair *pair = wheel->expired->pair;
+        unlink_pair(ht, find_hashtable_link(ht, pair->key, pair->hash));
+        reclaimed++;
+    }
+
+    ht->expired_pairs += reclaimed;
+    return reclaimed;
 }
@@ -2,18 +2,82 @@
 #define HASHTABLE_H
 
 #include <stddef.h>
+#include <stdint.h>
 
 #define INITIAL_BUCKETS_SIZE 16
 
+/**
+ * default load factors: grow above 0.75 and shrink below 0.25, a resize lands at
+ * 0.375 or 0.5 so put/remove can't thrash. Tables can override them with
+ * `hashtable_set_load_factors`.
+ */
+#define HASHTABLE_GROW_LOAD_FACTOR   0.75
+#define HASHTABLE_SHRINK_LOAD_FACTOR 0.25
+
+/* old buckets migrated per put/remove while an incremental resize is in progress */
+#define HASHTABLE_REHASH_STEP 4
+
+/* keys hashed and prefetched together by the batched operations */
+#define HASHTABLE_BATCH_SIZE 16
+
+/* chain lengths counted one by one by `hashtable_stats`, longer chains share the last entry */
+#define HASHTABLE_STATS_HISTOGRAM_SIZE 16
+
+/* resizes from fewer buckets than this stay on the calling thread, even with an executor */
+#define HASHTABLE_PARALLEL_REHASH_MIN 65536
+
+/* expired pairs reclaimed after every put/remove on a table with expiring pairs */
+#define HASHTABLE_EXPIRE_STEP 4
+
+/**
+ * every pair is a single allocation: the header is followed by the key and
+ * the value, each padded to pointer alignment. `key` and `value` point into
+ * `data`, except when an update outgrows `value_capacity`: the value is then
+ * moved to its own buffer while the pair itself never moves.
+ * `hash` caches the full hash of the key: resizes never call the hash
+ * function again and chain walks only compare keys whose hash matches.
+ * `timer` is NULL unless the pair was stored with `hashtable_put_ttl`.
+ * A key or value adopted with `hashtable_put_owned` is the caller's buffer instead:
+ * such a pair has no `data` for its key, and `value_capacity` is 0 for its value.
+ */
 typedef struct hashtable_pair
 {
-    void                  *key;
-    size_t                 key_size;
-    void                  *value;
-    size_t                 value_size;
-    struct hashtable_pair *next;
+    void                   *key;
+    size_t                  key_size;
+    void                   *value;
+    size_t                  value_size;
+    struct hashtable_pair  *next;
+    size_t                  hash;
+    size_t                  value_capacity;
+    struct hashtable_timer *timer;
+    unsigned char           data[];
 } hashtable_pair;
 
+/**
+ * runs `function` once for every part from 0 to `parts - 1`, possibly on other
+ * threads, and returns once all of them finished. `backend` is passed back to `run`
+ * as is, `parts` is how many parts the work is split into.
+ * `hashtable_parallel.h` builds one on a threadpool.
+ */
+typedef struct hashtable_executor
+{
+    void  (*run)(void *backend, const size_t parts,
+                 void (*function)(void *context, const size_t part, const size_t parts), void *context);
+    void   *backend;
+    size_t  parts;
+} hashtable_executor;
+
+/**
+ * while an incremental resize is in progress `buckets` is already the new
+ * array and `old_buckets` holds the pairs that haven't been migrated yet,
+ * every old bucket below `rehash_index` is empty.
+ * Bucket sizes are always powers of two, a key goes to bucket `hash & (size - 1)`.
+ * The thresholds are the pair counts that trigger a resize, recomputed from the
+ * load factors whenever `buckets_size` changes.
+ * `timers` is the timing wheel of the expiring pairs, allocated by the first
+ * `hashtable_put_ttl`.
+ * The destructors release the keys and values adopted by `hashtable_put_owned`.
+ */
 typedef struct hashtable
 {
     hashtable_pair **buckets;
@@ -21,8 +85,84 @@ typedef struct hashtable
     size_t           pair_number;
     size_t         (*hash_function)(void *key);
     size_t         (*compare_key_function)(const void *key1, const void *key2);
+    size_t         (*seeded_hash_function)(const void *key, const size_t key_size, const uint64_t seed);
+    size_t         (*sized_compare_key_function)(const void *key1, const void *key2, const size_t key_size);
+    size_t           key_size; // 0 for variable size keys
+    uint64_t         seed;
+    hashtable_pair **old_buckets;
+    size_t           old_buckets_size;
+    size_t           rehash_index;
+    bool             incremental_resize;
+    size_t           min_buckets_size; // automatic shrinking stops here
+    double           grow_load_factor;
+    double           shrink_load_factor;
+    size_t           grow_threshold;   // grow when pair_number > grow_threshold
+    size_t           shrink_threshold; // shrink when pair_number < shrink_threshold
+    hashtable_executor executor;       // rehashes large resizes in parallel when `run` is set
+    size_t           resizes;
+    size_t           rehashed_pairs;
+    uint64_t         rehash_nanoseconds;
+    size_t           hits;             // lookups, only counted when compiled with HASHTABLE_STATS
+    size_t           misses;
+    struct hashtable_timer_wheel *timers;
+    uint64_t       (*clock)(void);     // milliseconds, the monotonic clock when NULL
+    size_t           expired_pairs;
+    void           (*key_destructor)(void *key);     // free when NULL
+    void           (*value_destructor)(void *value); // free when NULL
 } hashtable;
 
+/**
+ * filled by `hashtable_stats`. Bucket counts cover the old buckets too while an
+ * incremental resize is in progress. Memory is what the hashtable asked malloc for,
+ * without the allocator overhead: `value_bytes` counts the capacity of every value,
+ * the inline space left behind by values that grew out of their pair is not included.
+ */
+typedef struct hashtable_statistics
+{
+    size_t   pair_number;
+    size_t   buckets_size;
+    double   load_factor;
+    size_t   chain_histogram[HASHTABLE_STATS_HISTOGRAM_SIZE]; // buckets per chain length
+    size_t   max_chain_length;
+    size_t   resizes;
+    size_t   rehashed_pairs;
+    uint64_t rehash_nanoseconds;
+    size_t   hits;
+    size_t   misses;
+    size_t   expired_pairs;   // reclaimed after their TTL
+    size_t   table_bytes;     // the hashtable struct
+    size_t   bucket_bytes;
+    size_t   pair_bytes;      // pair headers
+    size_t   key_bytes;       // including padding
+    size_t   value_bytes;     // including padding
+    size_t   external_values; // values stored outside of their pair
+    size_t   adopted_bytes;   // keys and values adopted by `hashtable_put_owned`, not in the total
+    size_t   timer_bytes;     // the timing wheel and the timers of expiring pairs
+    size_t   total_bytes;
+} hashtable_statistics;
+
+typedef struct hashtable_entry
+{
+    const void *key;
+    size_t      key_size;
+    const void *value;
+    size_t      value_size;
+} hashtable_entry;
+
+/**
+ * a length prefixed string key, for tables using `hash_hashtable_string` and
+ * `compare_hashtable_string`. Pairs store the struct, not the bytes, which must
+ * outlive them. `hash` is computed once by `hashtable_string_make`, and comparisons
+ * check the length and the pointer before reading any byte.
+ * Strings interned in a `string_pool` are stored with this header too.
+ */
+typedef struct hashtable_string
+{
+    const char *data;
+    size_t      length;
+    size_t      hash;
+} hashtable_string;
+
 /**
  * @brief creates a new empty hashtable specifying hash and key comparison functions.
  * Allocated memory from the hashtable must be freed with `hashtable_destroy`.
@@ -34,6 +174,36 @@ typedef struct hashtable
 hashtable *hashtable_create(size_t (*hash_function)(void *key),
                             size_t (*compare_key_function)(const void *key1, const void *key2));
 
+/**
+ * @brief creates a new empty hashtable sized to hold `capacity` pairs without resizing.
+ * The table won't shrink below that size until `hashtable_shrink_to_fit` is called.
+ * Allocated memory from the hashtable must be freed with `hashtable_destroy`.
+ *
+ * @param hash_function pointer to the hash function
+ * @param compare_key_function pointer to the key comparison function
+ * @param capacity number of pairs expected
+ * @return hashtable* pointer to the newly created hashtable
+ */
+hashtable *hashtable_create_with_capacity(size_t (*hash_function)(void *key),
+                                          size_t (*compare_key_function)(const void *key1, const void *key2),
+                                          const size_t capacity);
+
+/**
+ * @brief creates a new empty hashtable whose hash function is keyed with a random
+ * per-table seed, so colliding keys can't be precomputed from outside the process.
+ * The callbacks receive the key size: use `hash_bytes` and `compare_bytes` for binary
+ * keys, no custom callbacks needed.
+ * Allocated memory from the hashtable must be freed with `hashtable_destroy`.
+ *
+ * @param hash_function pointer to the seeded hash function
+ * @param compare_key_function pointer to the key comparison function
+ * @param key_size size in bytes of every key, 0 for NUL terminated string keys
+ * @return hashtable* pointer to the newly created hashtable
+ */
+hashtable *hashtable_create_seeded(size_t (*hash_function)(const void *key, const size_t key_size, const uint64_t seed),
+                                   size_t (*compare_key_function)(const void *key1, const void *key2, const size_t key_size),
+                                   const size_t key_size);
+
 /**
  * @brief inserts a new pair into the hashtable.
  * If the key already exists, its value is updated.
@@ -50,6 +220,168 @@ bool hashtable_put(hashtable *ht,
                    const void *key, const size_t key_size,
                    const void *value, const size_t value_size);
 
+/**
+ * @brief same as `hashtable_put`, the pair expires `ttl` milliseconds from now.
+ * Expired pairs are invisible to every lookup right away, their memory is reclaimed
+ * by `hashtable_expire` and a few at a time by every put and remove, until then they
+ * still count in `hashtable_size`. A later `hashtable_put` of the same key makes the
+ * pair persistent again. Snapshots and frozen copies leave out the pairs already
+ * expired and keep the others without their expiry.
+ *
+ * @param ht pointer to the hashtable you want to insert the pair into
+ * @param key pointer to the first byte of the key
+ * @param key_size size of the key in bytes
+ * @param value pointer to the first byte of the value
+ * @param value_size size of the value in bytes
+ * @param ttl time to live in milliseconds, more than 0
+ * @return true if the pair was successfully inserted or updated
+ * @return false if an error occurred (e.g., memory allocation failure)
+ */
+bool hashtable_put_ttl(hashtable *ht,
+                       const void *key, const size_t key_size,
+                       const void *value, const size_t value_size,
+                       const uint64_t ttl);
+
+/**
+ * @brief same as `hashtable_put`, but `key` and `value` are adopted instead of copied:
+ * on success the hashtable owns both buffers and releases them with its destructors
+ * (`free` by default, see `hashtable_set_destructors`) when the pair is removed,
+ * overwritten, expires or the hashtable is destroyed. If the key was already
+ * present, its stored key is kept and `key` is released right away.
+ * On failure nothing is adopted and the caller still owns both buffers.
+ *
+ * @param ht pointer to the hashtable you want to insert the pair into
+ * @param key pointer to the key buffer, must not be modified while adopted
+ * @param key_size size of the key in bytes
+ * @param value pointer to the value buffer
+ * @param value_size size of the value in bytes
+ * @return true if the pair was successfully inserted or updated
+ * @return false if an error occurred (e.g., memory allocation failure)
+ */
+bool hashtable_put_owned(hashtable *ht,
+                         void *key, const size_t key_size,
+                         void *value, const size_t value_size);
+
+/**
+ * @brief sets the functions releasing the keys and values adopted by `hashtable_put_owned`.
+ * Keys and values copied by the other puts are never passed to them.
+ *
+ * @param ht pointer to the hashtable
+ * @param key_destructor function releasing an adopted key, NULL for `free`
+ * @param value_destructor function releasing an adopted value, NULL for `free`
+ * @return true if the destructors were set
+ * @return false if an error occurred (e.g., invalid hashtable pointer)
+ */
+bool hashtable_set_destructors(hashtable *ht, void (*key_destructor)(void *key), void (*value_destructor)(void *value));
+
+/**
+ * @brief read-modify-write with a single lookup: if the key is missing, a copy of
+ * `init_value` is inserted, otherwise `update` is called on the stored value, which
+ * it modifies in place. Nothing is allocated when the key exists.
+ * `update` must not use the hashtable.
+ *
+ * @param ht pointer to the hashtable
+ * @param key pointer to the first byte of the key
+ * @param key_size size of the key in bytes
+ * @param init_value pointer to the value inserted for a missing key, NULL to insert zeroed bytes
+ * @param value_size size of the inserted value in bytes
+ * @param update function called with the stored value and its size when the key exists
+ * @param context pointer passed to `update`
+ * @return true if the value was inserted or updated
+ * @return false if an error occurred (e.g., memory allocation failure)
+ */
+bool hashtable_upsert(hashtable *ht,
+                      const void *key, const size_t key_size,
+                      const void *init_value, const size_t value_size,
+                      void (*update)(void *value, const size_t value_size, void *context), void *context);
+
+/**
+ * @brief returns a mutable pointer to the value of the key, inserting a copy of
+ * `init_value` first if the key is missing, with a single lookup. A value that already
+ * exists keeps its size, check it with `hashtable_get_ref` if it can differ.
+ * The pointer is borrowed like with `hashtable_get_ref` and can be written until
+ * the next `hashtable_put`, `hashtable_remove` or `hashtable_destroy`.
+ *
+ * @param ht pointer to the hashtable
+ * @param key pointer to the first byte of the key
+ * @param key_size size of the key in bytes
+ * @param init_value pointer to the value inserted for a missing key, NULL to insert zeroed bytes
+ * @param value_size size of the inserted value in bytes
+ * @param inserted pointer to a variable set to true if the key was inserted, can be NULL
+ * @return void* pointer to the stored value, NULL if an error occurred
+ */
+void *hashtable_get_or_insert(hashtable *ht,
+                              const void *key, const size_t key_size,
+                              const void *init_value, const size_t value_size,
+                              bool *inserted);
+
+/**
+ * @brief frees up to `max_pairs` expired pairs. Expiring pairs are kept in a
+ * hierarchical timing wheel, so the cost is proportional to the pairs that expire,
+ * not to the size of the table: call it periodically with a small `max_pairs` to
+ * reclaim memory in bounded slices.
+ *
+ * @param ht pointer to the hashtable
+ * @param max_pairs maximum number of pairs to free
+ * @return size_t number of pairs freed
+ */
+size_t hashtable_expire(hashtable *ht, const size_t max_pairs);
+
+/**
+ * @brief tells whether a pair stored with `hashtable_put_ttl` has expired. Expired
+ * pairs stay in their bucket until they are reclaimed, code walking the buckets
+ * itself skips them with this like the lookups do.
+ *
+ * @param ht pointer to the hashtable holding the pair
+ * @param pair pointer to the pair
+ * @return true if the pair has expired
+ * @return false if it hasn't or has no expiry
+ */
+bool hashtable_pair_expired(const hashtable *ht, const hashtable_pair *pair);
+
+/**
+ * @brief replaces the clock used for expiration, in milliseconds. Only allowed before
+ * the first `hashtable_put_ttl`, mostly useful to control time in tests.
+ *
+ * @param ht pointer to the hashtable
+ * @param clock function returning the current time in milliseconds, NULL for the monotonic clock
+ * @return true if the clock was set
+ * @return false if an error occurred (e.g., the table already has expiring pairs)
+ */
+bool hashtable_set_clock(hashtable *ht, uint64_t (*clock)(void));
+
+/**
+ * @brief inserts or updates every entry of an array, like calling `hashtable_put` on each.
+ * Keys are hashed and their buckets prefetched `HASHTABLE_BATCH_SIZE` at a time, so
+ * the cache misses of a group overlap instead of being paid one after another.
+ *
+ * @param ht pointer to the hashtable you want to insert the pairs into
+ * @param entries array of pairs to insert
+ * @param n number of entries in the array
+ * @return size_t number of entries stored, the index of the first failing entry if lower than n
+ */
+size_t hashtable_put_many(hashtable *ht, const hashtable_entry *entries, const size_t n);
+
+/**
+ * @brief inserts or updates every entry of an array split across the parts of
+ * `executor`, with the same result as `hashtable_put_many`: a key repeated in the
+ * array keeps the value of its last entry. The table is grown once for all the
+ * entries, then every part hashes a slice of the array and links the pairs of its
+ * own range of buckets, so no bucket is ever touched by two threads and no lock is
+ * taken. Tables with expiring pairs are always built on the calling thread.
+ * `hashtable_build_parallel` runs it on a threadpool.
+ *
+ * @param ht pointer to the hashtable you want to insert the pairs into
+ * @param entries array of pairs to insert
+ * @param n number of entries in the array
+ * @param executor runs the parts of the build, NULL to build on the calling thread
+ * @return true if every entry was stored
+ * @return false if an entry is invalid (nothing is stored) or an allocation failed
+ * (some entries may have been stored)
+ */
+bool hashtable_build_with(hashtable *ht, const hashtable_entry *entries, const size_t n,
+                          const hashtable_executor *executor);
+
 /**
  * @brief retrieves the value associated with the given key.
  * The returned pointer must be freed by the caller.
@@ -60,6 +392,62 @@ bool hashtable_put(hashtable *ht,
  */
 void *hashtable_get(const hashtable *ht, const void *key);
 
+/**
+ * @brief looks up an array of keys, with the same prefetching as `hashtable_put_many`.
+ * The values are borrowed like with `hashtable_get_ref`.
+ *
+ * @param ht pointer to the hashtable you want to retrieve the values from
+ * @param keys array of pointers to the keys
+ * @param n number of keys in the array
+ * @param values array of n pointers filled with the stored values, NULL for missing keys
+ * @param value_sizes array of n sizes filled with the size of the values, can be NULL
+ * @return size_t number of keys found
+ */
+size_t hashtable_get_many(const hashtable *ht, const void *const *keys, const size_t n,
+                          const void **values, size_t *value_sizes);
+
+/**
+ * @brief retrieves a read only pointer to the value stored in the hashtable,
+ * without allocating or copying.
+ * The pointer is borrowed from the hashtable: it stays valid only until the next
+ * `hashtable_put`, `hashtable_remove` or `hashtable_destroy` on the same hashtable
+ * (any of them may update, free or move the stored pair) and must not be freed.
+ *
+ * @param ht pointer to the hashtable you want to retrieve the value from
+ * @param key pointer to the first byte of the key
+ * @param value_size pointer to a variable where the size of the value will be stored, can be NULL
+ * @return const void* pointer to the stored value, or NULL if the key does not exist
+ */
+const void *hashtable_get_ref(const hashtable *ht, const void *key, size_t *value_size);
+
+/**
+ * @brief copies the value associated with the given key into a caller provided buffer.
+ * If the buffer is too small nothing is copied, but the required size is still
+ * reported through `value_size`.
+ *
+ * @param ht pointer to the hashtable you want to retrieve the value from
+ * @param key pointer to the first byte of the key
+ * @param buffer pointer to the memory the value will be copied into
+ * @param buffer_size size of the buffer in bytes
+ * @param value_size pointer to a variable where the size of the value will be stored, can be NULL
+ * @return true if the value was copied into the buffer
+ * @return false if the key does not exist or the buffer is too small
+ */
+bool hashtable_get_into(const hashtable *ht, const void *key,
+                        void *buffer, const size_t buffer_size, size_t *value_size);
+
+/**
+ * @brief returns the pair holding the given key, for modules built on top of the
+ * hashtable that need to keep track of pairs. A pair never moves until it's removed,
+ * resizes only relink it. The value may be written in place, the key and the hash
+ * must not be modified.
+ *
+ * @param ht pointer to the hashtable you want to retrieve the pair from
+ * @param key pointer to the first byte of the key
+ * @return hashtable_pair* pointer to the pair, or NULL if the key does not exist
+ */
+hashtable_pair *hashtable_get_pair(const hashtable *ht, const void *key);
+
 
 /**
  * @brief removes the pair associated with the given key from the hashtable.
@@ -71,16 +459,56 @@ void *hashtable_get(const hashtable *ht, const void *key);
  */
 bool hashtable_remove(hashtable *ht, const void *key);
 
+/**
+ * @brief removes the pair associated with the given key and hands its key and value
+ * to the caller instead of freeing them. Buffers adopted with `hashtable_put_owned`
+ * are returned as they were given, without copy; keys and values stored inside
+ * their pair are copied to new buffers, to be freed with `free`.
+ * Passing NULL for `key_out` or `value_out` releases that buffer as `hashtable_remove` would.
+ *
+ * @param ht pointer to the hashtable you want to remove the pair from
+ * @param key pointer to the first byte of the key
+ * @param key_out pointer to a variable where the key buffer will be stored, can be NULL
+ * @param key_size pointer to a variable where the size of the key will be stored, can be NULL
+ * @param value_out pointer to a variable where the value buffer will be stored, can be NULL
+ * @param value_size pointer to a variable where the size of the value will be stored, can be NULL
+ * @return true if the pair was removed and handed over
+ * @return false if the key does not exist in the hashtable or an error occurred
+ */
+bool hashtable_take(hashtable *ht, const void *key,
+                    void **key_out, size_t *key_size,
+                    void **value_out, size_t *value_size);
+
 
 /**
- * @brief returns an array of pointers to the keys stored in the hashtable.
- * The returned array must be freed by the caller.
+ * @brief returns an array of pointers to the keys stored in the hashtable, ended by
+ * NULL and without the expired ones. The returned array must be freed by the caller.
  *
  * @param ht pointer to the hashtable you want to get the keys from
  * @return void** array of pointers to the keys stored in the hashtable
  */
 void **hashtable_keyset(const hashtable *ht);
 
+/**
+ * @brief visits the pairs of the hashtable a few buckets at a time, without allocating.
+ * Start with a cursor of 0 and pass the returned cursor to the next call until it is 0
+ * again. The cursor walks the buckets in reverse binary order, so it stays valid when
+ * the hashtable is resized between calls: every pair present for the whole scan is
+ * visited at least once, pairs may be visited twice if the table shrinks.
+ * Expired pairs are skipped, though they count toward `count`.
+ * The hashtable must not be modified from inside `function`, entry pointers are
+ * borrowed like with `hashtable_get_ref`.
+ *
+ * @param ht pointer to the hashtable you want to scan
+ * @param cursor 0 to start a new scan, or the value returned by the previous call
+ * @param count minimum number of pairs to visit before returning, unless the scan completes
+ * @param function function called with every visited pair
+ * @param context pointer passed untouched to `function`
+ * @return size_t cursor for the next call, 0 when the scan is complete
+ */
+size_t hashtable_scan(const hashtable *ht, size_t cursor, const size_t count,
+                      void (*function)(const hashtable_entry *entry, void *context), void *context);
+
 /**
  * @brief returns the number of pairs in the hashtable.
  *
@@ -91,6 +519,87 @@ void **hashtable_keyset(const hashtable *ht);
  */
 bool hashtable_size(const hashtable *ht, size_t *size);
 
+/**
+ * @brief enables or disables incremental resizing.
+ * When enabled, a resize only allocates the new buckets and every following
+ * `hashtable_put` and `hashtable_remove` migrates `HASHTABLE_REHASH_STEP` old buckets,
+ * so no single operation pays for rehashing the whole table. Disabling it
+ * completes any migration in progress.
+ *
+ * @param ht pointer to the hashtable
+ * @param enabled true to migrate incrementally, false to rehash all at once
+ * @return true if the mode was set
+ * @return false if an error occurred (e.g., invalid hashtable pointer)
+ */
+bool hashtable_set_incremental_resize(hashtable *ht, const bool enabled);
+
+/**
+ * @brief rehashes resizes of at least `HASHTABLE_PARALLEL_REHASH_MIN` buckets on the
+ * parts of `executor`, each part moving the chains of its own range of buckets.
+ * Incremental resizes are not affected. The executor is copied, whatever its
+ * backend points to must outlive the hashtable, or be unset with NULL first.
+ * The put or remove that triggers the resize waits for every part, it must not
+ * run where `run` can't make progress without it.
+ * `hashtable_set_threadpool` sets one running on a threadpool.
+ *
+ * @param ht pointer to the hashtable
+ * @param executor runs the parts of the rehashes, NULL to rehash on the calling thread
+ * @return true if the executor was set
+ * @return false if an error occurred (e.g., invalid hashtable pointer)
+ */
+bool hashtable_set_executor(hashtable *ht, const hashtable_executor *executor);
+
+/**
+ * @brief grows the hashtable so that it can hold `capacity` pairs without resizing,
+ * use it before bulk loads. The table won't shrink below that size until
+ * `hashtable_shrink_to_fit` is called.
+ *
+ * @param ht pointer to the hashtable
+ * @param capacity number of pairs the hashtable must hold
+ * @return true if the hashtable can hold `capacity` pairs
+ * @return false if an error occurred (e.g., memory allocation failure)
+ */
+bool hashtable_reserve(hashtable *ht, const size_t capacity);
+
+/**
+ * @brief shrinks the buckets to the smallest size that holds the current pairs
+ * and drops any size reserved with `hashtable_reserve` or `hashtable_create_with_capacity`.
+ *
+ * @param ht pointer to the hashtable
+ * @return true if the hashtable was shrunk or was already minimal
+ * @return false if an error occurred (e.g., memory allocation failure)
+ */
+bool hashtable_shrink_to_fit(hashtable *ht);
+
+/**
+ * @brief sets the load factors that trigger a resize of this hashtable.
+ * Lower grow factors give shorter chains, higher ones use less memory. The shrink
+ * factor must stay below half of the grow factor, so a table that has just been
+ * resized is never beyond the opposite threshold.
+ *
+ * @param ht pointer to the hashtable
+ * @param grow_load_factor grow when pairs / buckets goes above this value
+ * @param shrink_load_factor shrink when pairs / buckets goes below this value, 0 never shrinks
+ * @return true if the load factors were set
+ * @return false if the load factors are invalid
+ */
+bool hashtable_set_load_factors(hashtable *ht, const double grow_load_factor, const double shrink_load_factor);
+
+/**
+ * @brief collects the shape, counters and memory footprint of the hashtable.
+ * Walks every bucket and pair, so it costs as much as a full scan. Hits and misses
+ * stay 0 unless the library is compiled with `-DHASHTABLE_STATS`: counting them
+ * makes every lookup write to the hashtable. Without it `rehash_nanoseconds` only
+ * covers the resizes rehashed all at once, timing incremental steps would read the
+ * clock on every put and remove.
+ *
+ * @param ht pointer to the hashtable
+ * @param stats pointer to the structure to fill
+ * @return true if the statistics were collected
+ * @return false if an error occurred (e.g., invalid hashtable pointer)
+ */
+bool hashtable_stats(const hashtable *ht, hashtable_statistics *stats);
+
 /**
  * @brief destroys the hashtable and frees all allocated memory.
  *
@@ -101,7 +610,17 @@ void hashtable_destroy(hashtable *ht);
 /* ========== DEFAULT HASH FUNCTIONS ========== */
 size_t hash_string(void *key);
 size_t hash_int(void *key);
+size_t hash_uint64_t(void *key);
 size_t hash_double(void *key);
+
+/* word at a time, seeded hash of `key_size` bytes (strlen(key) bytes when key_size is 0) */
+size_t hash_bytes(const void *key, const size_t key_size, const uint64_t seed);
+/* murmur3 64 bit finalizer, spreads integer keys over every bit */
+uint64_t hash_fmix64(uint64_t key);
+/* the hash cached in a `hashtable_string`, nothing is read from its bytes */
+size_t hash_hashtable_string(void *key);
+/* a `hashtable_string` with the `length` bytes at `data` and their `hash_bytes` with seed 0 */
+hashtable_string hashtable_string_make(const char *data, const size_t length);
 /* ============================================ */
 
 /* ========== DEFAULT KEY COMPARISON FUNCTIONS ========== */
@@ -112,6 +631,11 @@ size_t compare_uint16_t(const void *key1, const void *key2);
 size_t compare_uint32_t(const void *key1, const void *key2);
 size_t compare_uint64_t(const void *key1, const void *key2);
 size_t compare_double(const void *key1, const void *key2);
+
+/* memcmp of `key_size` bytes (strcmp when key_size is 0), matches `hash_bytes` */
+size_t compare_bytes(const void *key1, const void *key2, const size_t key_size);
+/* lengths, then pointers (interned strings are equal only if identical), then memcmp */
+size_t compare_hashtable_string(const void *key1, const void *key2);
 /* ====================================================== */
 
 #endif // HASHTABLE_H
@@ -0,0 +1,282 @@
+#include "hashtable_cache.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define INITIAL_RING_CAPACITY 16
+
+/* the ring index stored before every value */
+#define RING_INDEX(pair) (*(size_t *)(pair)->value)
+
+static hashtable_cache *allocate_cache(hashtable *table, const size_t max_bytes);
+static size_t entry_charge(const size_t key_size, const size_t value_size);
+static size_t pair_charge(const hashtable_pair *pair);
+static bool reserve_scratch(hashtable_cache *cache, const size_t size);
+static void evict(hashtable_cache *cache, const size_t incoming_bytes, const hashtable_pair *keep);
+static void remove_slot(hashtable_cache *cache, const size_t index, const bool evicted);
+
+hashtable_cache *hashtable_cache_create(size_t (*hash_function)(void *key),
+                                        size_t (*compare_key_function)(const void *key1, const void *key2),
+                                        const size_t max_bytes)
+{
+    if (hash_function == NULL || compare_key_function == NULL)
+        return NULL;
+
+    return allocate_cache(hashtable_create(hash_function, compare_key_function), max_bytes);
+}
+
+hashtable_cache *hashtable_cache_create_seeded(size_t (*hash_function)(const void *key, const size_t key_size, const uint64_t seed),
+                                               size_t (*compare_key_function)(const void *key1, const void *key2, const size_t key_size),
+                                               const size_t key_size, const size_t max_bytes)
+{
+    if (hash_function == NULL || compare_key_function == NULL)
+        return NULL;
+
+    return allocate_cache(hashtable_create_seeded(hash_function, compare_key_function, key_size), max_bytes);
+}
+
+bool hashtable_cache_set_eviction_callback(hashtable_cache *cache,
+                                           void (*callback)(const void *key, const size_t key_size,
+                                                            const void *value, const size_t value_size, void *context),
+                                           void *context)
+{
+    if (cache == NULL)
+        return false;
+
+    cache->eviction_callback = callback;
+    cache->eviction_context = context;
+    return true;
+}
+
+bool hashtable_cache_put(hashtable_cache *cache,
+                         const void *key, const size_t key_size,
+                         const void *value, const size_t value_size)
+{
+    if (cache == NULL || key == NULL || key_size == 0 || value == NULL || value_size == 0)
+        return false;
+    if (cache->max_bytes < HASHTABLE_CACHE_ENTRY_OVERHEAD ||
+        key_size > cache->max_bytes - HASHTABLE_CACHE_ENTRY_OVERHEAD ||
+        value_size > cache->max_bytes - HASHTABLE_CACHE_ENTRY_OVERHEAD - key_size)
+        return false;
+    if (!reserve_scratch(cache, sizeof(size_t) + value_size))
+        return false;
+
+    size_t charge = entry_charge(key_size, value_size);
+    hashtable_pair *pair = hashtable_get_pair(cache->table, key);
+    if (pair != NULL)
+    {
+        /* the pair being updated is skipped by the hand, its old size no longer counts */
+        size_t old_charge = pair_charge(pair);
+        cache->used_bytes -= old_charge;
+        evict(cache, charge, pair);
+
+        size_t index = RING_INDEX(pair);
+        memcpy(cache->scratch, &index, sizeof(size_t));
+        memcpy(cache->scratch + sizeof(size_t), value, value_size);
+        if (!hashtable_put(cache->table, key, key_size, cache->scratch, sizeof(size_t) + value_size))
+        {
+            cache->used_bytes += old_charge;
+            return false;
+        }
+
+        cache->ring[index].referenced = true;
+        cache->used_bytes += charge;
+        return true;
+    }
+
+    evict(cache, charge, NULL);
+
+    size_t index = cache->table->pair_number;
+    if (index == cache->ring_capacity)
+    {
+        size_t new_capacity = cache->ring_capacity * 2;
+        hashtable_cache_slot *new_ring = realloc(cache->ring, new_capacity * sizeof(hashtable_cache_slot));
+        if (new_ring == NULL)
+            return false;
+        cache->ring = new_ring;
+        cache->ring_capacity = new_capacity;
+    }
+
+    memcpy(cache->scratch, &index, sizeof(size_t));
+    memcpy(cache->scratch + sizeof(size_t), value, value_size);
+    if (!hashtable_put(cache->table, key, key_size, cache->scratch, sizeof(size_t) + value_size))
+        return false;
+
+    /* new pairs start unreferenced, a key seen only once is the first to go */
+    cache->ring[index] = (hashtable_cache_slot){ hashtable_get_pair(cache->table, key), false };
+    cache->used_bytes += charge;
+    return true;
+}
+
+const void *hashtable_cache_get(hashtable_cache *cache, const void *key, size_t *value_size)
+{
+    if (cache == NULL || key == NULL)
+        return NULL;
+
+    hashtable_pair *pair = hashtable_get_pair(cache->table, key);
+    if (pair == NULL)
+    {
+        cache->misses++;
+        return NULL;
+    }
+
+    cache->hits++;
+    cache->ring[RING_INDEX(pair)].referenced = true;
+    if (value_size != NULL)
+        *value_size = pair->value_size - sizeof(size_t);
+    return (const unsigned char *)pair->value + sizeof(size_t);
+}
+
+bool hashtable_cache_remove(hashtable_cache *cache, const void *key)
+{
+    if (cache == NULL || key == NULL)
+        return false;
+
+    hashtable_pair *pair = hashtable_get_pair(cache->table, key);
+    if (pair == NULL)
+        return false;
+
+    remove_slot(cache, RING_INDEX(pair), false);
+    return true;
+}
+
+bool hashtable_cache_set_max_bytes(hashtable_cache *cache, const size_t max_bytes)
+{
+    if (cache == NULL)
+        return false;
+
+    cache->max_bytes = max_bytes;
+    evict(cache, 0, NULL);
+    return true;
+}
+
+bool hashtable_cache_size(const hashtable_cache *cache, size_t *size)
+{
+    if (cache == NULL || size == NULL)
+        return false;
+    *size = cache->table->pair_number;
+    return true;
+}
+
+bool hashtable_cache_stats(const hashtable_cache *cache, hashtable_cache_statistics *stats)
+{
+    if (cache == NULL || stats == NULL)
+        return false;
+
+    *stats = (hashtable_cache_statistics){
+        .pair_number = cache->table->pair_number,
+        .used_bytes = cache->used_bytes,
+        .max_bytes = cache->max_bytes,
+        .hits = cache->hits,
+        .misses = cache->misses,
+        .evictions = cache->evictions,
+    };
+    return true;
+}
+
+void hashtable_cache_destroy(hashtable_cache *cache)
+{
+    if (cache == NULL)
+        return;
+
+    hashtable_destroy(cache->table);
+    free(cache->ring);
+    free(cache->scratch);
+    free(cache);
+}
+
+static hashtable_cache *allocate_cache(hashtable *table, const size_t max_bytes)
+{
+    if (table == NULL)
+        return NULL;
+
+    hashtable_cache *cache = calloc(1, sizeof(hashtable_cache));
+    hashtable_cache_slot *ring = malloc(INITIAL_RING_CAPACITY * sizeof(hashtable_cache_slot));
+    if (cache == NULL || ring == NULL)
+    {
+        hashtable_destroy(table);
+        free(cache);
+        free(ring);
+        return NULL;
+    }
+
+    cache->table = table;
+    cache->ring = ring;
+    cache->ring_capacity = INITIAL_RING_CAPACITY;
+    cache->max_bytes = max_bytes;
+
+    return cache;
+}
+
+static size_t entry_charge(const size_t key_size, const size_t value_size)
+{
+    return key_size + value_size + HASHTABLE_CACHE_ENTRY_OVERHEAD;
+}
+
+static size_t pair_charge(const hashtable_pair *pair)
+{
+    return entry_charge(pair->key_size, pair->value_size - sizeof(size_t));
+}
+
+static bool reserve_scratch(hashtable_cache *cache, const size_t size)
+{
+    if (size <= cache->scratch_size)
+        return true;
+
+    unsigned char *new_scratch = realloc(cache->scratch, size);
+    if (new_scratch == NULL)
+        return false;
+    cache->scratch = new_scratch;
+    cache->scratch_size = size;
+    return true;
+}
+
+/**
+ * CLOCK: the hand sweeps the ring, clearing reference bits, and evicts the first
+ * pair it finds unreferenced, until `incoming_bytes` more fit in the budget.
+ * A pair hit since the last sweep survives one more turn. `keep` is never evicted.
+ */
+static void evict(hashtable_cache *cache, const size_t incoming_bytes, const hashtable_pair *keep)
+{
+    while (cache->used_bytes + incoming_bytes > cache->max_bytes &&
+           cache->table->pair_number > (keep != NULL ? 1 : 0))
+    {
+        if (cache->hand >= cache->table->pair_number)
+            cache->hand = 0;
+
+        hashtable_cache_slot *slot = &cache->ring[cache->hand];
+        if (slot->referenced || slot->pair == keep)
+        {
+            slot->referenced = false;
+            cache->hand++;
+            continue;
+        }
+
+        /* the last slot moves under the hand, it's looked at next */
+        remove_slot(cache, cache->hand, true);
+    }
+}
+
+static void remove_slot(hashtable_cache *cache, const size_t index, const bool evicted)
+{
+    hashtable_pair *pair = cache->ring[index].pair;
+    size_t last = cache->table->pair_number - 1;
+
+    if (evicted)
+    {
+        cache->evictions++;
+        if (cache->eviction_callback != NULL)
+            cache->eviction_callback(pair->key, pair->key_size,
+                                     (const unsigned char *)pair->value + sizeof(size_t),
+                                     pair->value_size - sizeof(size_t), cache->eviction_context);
+    }
+
+    if (index != last)
+    {
+        cache->ring[index] = cache->ring[last];
+        RING_INDEX(cache->ring[index].pair) = index;
+    }
+
+    cache->used_bytes -= pair_charge(pair);
+    hashtable_remove(cache->table, pair->key);
+}
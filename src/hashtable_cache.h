@@ -0,0 +1,176 @@
+#ifndef HASHTABLE_CACHE_H
+#define HASHTABLE_CACHE_H
+
+#include "hashtable.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * bytes charged for every entry on top of its key and value: the pair header,
+ * the ring index stored before the value, the ring slot and a bucket pointer.
+ * Allocator overhead is not counted.
+ */
+#define HASHTABLE_CACHE_ENTRY_OVERHEAD (sizeof(hashtable_pair) + sizeof(size_t) + \
+                                        sizeof(hashtable_cache_slot) + sizeof(hashtable_pair *))
+
+/* one slot of the CLOCK ring per entry, `referenced` is set by every hit and cleared by the hand */
+typedef struct hashtable_cache_slot
+{
+    hashtable_pair *pair;
+    bool            referenced;
+} hashtable_cache_slot;
+
+/**
+ * every value stored in `table` is prefixed by the index of the entry's ring slot,
+ * so a hit sets its reference bit without searching the ring. The ring is kept
+ * dense: removing an entry moves the last slot into its place.
+ */
+typedef struct hashtable_cache
+{
+    hashtable            *table;
+    hashtable_cache_slot *ring;
+    size_t                ring_capacity;
+    size_t                hand;
+    size_t                max_bytes;
+    size_t                used_bytes;
+    unsigned char        *scratch;          // prefix and value of the pair being stored
+    size_t                scratch_size;
+    void                (*eviction_callback)(const void *key, const size_t key_size,
+                                             const void *value, const size_t value_size, void *context);
+    void                 *eviction_context;
+    size_t                hits;
+    size_t                misses;
+    size_t                evictions;
+} hashtable_cache;
+
+typedef struct hashtable_cache_statistics
+{
+    size_t pair_number;
+    size_t used_bytes;
+    size_t max_bytes;
+    size_t hits;
+    size_t misses;
+    size_t evictions;
+} hashtable_cache_statistics;
+
+/**
+ * @brief creates a new empty cache holding at most `max_bytes`, counted as the key
+ * and value sizes plus `HASHTABLE_CACHE_ENTRY_OVERHEAD` per entry. When a put would
+ * go over the budget, entries are evicted in approximate LRU order with the CLOCK
+ * algorithm, in O(1) amortized time.
+ * Allocated memory from the cache must be freed with `hashtable_cache_destroy`.
+ *
+ * @param hash_function pointer to the hash function
+ * @param compare_key_function pointer to the key comparison function
+ * @param max_bytes memory budget of the cache
+ * @return hashtable_cache* pointer to the newly created cache
+ */
+hashtable_cache *hashtable_cache_create(size_t (*hash_function)(void *key),
+                                        size_t (*compare_key_function)(const void *key1, const void *key2),
+                                        const size_t max_bytes);
+
+/**
+ * @brief same as `hashtable_cache_create`, with a seeded table like `hashtable_create_seeded`.
+ *
+ * @param hash_function pointer to the seeded hash function
+ * @param compare_key_function pointer to the key comparison function
+ * @param key_size size in bytes of every key, 0 for NUL terminated string keys
+ * @param max_bytes memory budget of the cache
+ * @return hashtable_cache* pointer to the newly created cache
+ */
+hashtable_cache *hashtable_cache_create_seeded(size_t (*hash_function)(const void *key, const size_t key_size, const uint64_t seed),
+                                               size_t (*compare_key_function)(const void *key1, const void *key2, const size_t key_size),
+                                               const size_t key_size, const size_t max_bytes);
+
+/**
+ * @brief sets the function called with every evicted pair before it's freed.
+ * Pairs removed with `hashtable_cache_remove` or freed by `hashtable_cache_destroy`
+ * are not reported. The callback must not use the cache.
+ *
+ * @param cache pointer to the cache
+ * @param callback function receiving the evicted key and value, NULL to disable it
+ * @param context pointer passed to every call of the callback
+ * @return true if the callback was set
+ * @return false if an error occurred (e.g., invalid cache pointer)
+ */
+bool hashtable_cache_set_eviction_callback(hashtable_cache *cache,
+                                           void (*callback)(const void *key, const size_t key_size,
+                                                            const void *value, const size_t value_size, void *context),
+                                           void *context);
+
+/**
+ * @brief inserts or updates a pair, evicting other pairs until it fits in the budget.
+ *
+ * @param cache pointer to the cache you want to insert the pair into
+ * @param key pointer to the first byte of the key
+ * @param key_size size of the key in bytes
+ * @param value pointer to the first byte of the value
+ * @param value_size size of the value in bytes
+ * @return true if the pair was stored
+ * @return false if an error occurred (e.g., the pair alone is larger than the budget)
+ */
+bool hashtable_cache_put(hashtable_cache *cache,
+                         const void *key, const size_t key_size,
+                         const void *value, const size_t value_size);
+
+/**
+ * @brief retrieves a read only pointer to the cached value and marks the pair as
+ * recently used. The pointer is borrowed like with `hashtable_get_ref`: it stays
+ * valid only until the next put, remove or destroy on the same cache.
+ *
+ * @param cache pointer to the cache you want to retrieve the value from
+ * @param key pointer to the first byte of the key
+ * @param value_size pointer to a variable where the size of the value will be stored, can be NULL
+ * @return const void* pointer to the cached value, or NULL if the key is not cached
+ */
+const void *hashtable_cache_get(hashtable_cache *cache, const void *key, size_t *value_size);
+
+/**
+ * @brief removes the pair associated with the given key, without calling the eviction callback.
+ *
+ * @param cache pointer to the cache you want to remove the pair from
+ * @param key pointer to the first byte of the key
+ * @return true if the pair was removed
+ * @return false if the key is not cached
+ */
+bool hashtable_cache_remove(hashtable_cache *cache, const void *key);
+
+/**
+ * @brief changes the memory budget, evicting pairs until the cache fits in it.
+ *
+ * @param cache pointer to the cache
+ * @param max_bytes new memory budget
+ * @return true if the budget was changed
+ * @return false if an error occurred (e.g., invalid cache pointer)
+ */
+bool hashtable_cache_set_max_bytes(hashtable_cache *cache, const size_t max_bytes);
+
+/**
+ * @brief returns the number of cached pairs.
+ *
+ * @param cache pointer to the cache you want to get the size of
+ * @param size pointer to a variable where the size will be stored
+ * @return true if the size was successfully retrieved
+ * @return false if an error occurred (e.g., invalid cache pointer)
+ */
+bool hashtable_cache_size(const hashtable_cache *cache, size_t *size);
+
+/**
+ * @brief fills `stats` with the size, memory use and counters of the cache.
+ *
+ * @param cache pointer to the cache to inspect
+ * @param stats pointer to the statistics to fill
+ * @return true if the statistics were filled
+ * @return false if an error occurred (e.g., invalid cache pointer)
+ */
+bool hashtable_cache_stats(const hashtable_cache *cache, hashtable_cache_statistics *stats);
+
+/**
+ * @brief frees the cache and every cached pair, without calling the eviction callback.
+ *
+ * @param cache pointer to the cache to destroy
+ */
+void hashtable_cache_destroy(hashtable_cache *cache);
+
+#endif // HASHTABLE_CACHE_H
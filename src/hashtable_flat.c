@@ -0,0 +1,355 @@
+#include "hashtable_flat.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define H1(hash) ((hash) >> 7)
+#define H2(hash) ((int8_t)((hash) & 0x7F))
+
+#define IS_INLINE(key_size, value_size) ((key_size) + (value_size) <= HASHTABLE_FLAT_INLINE_SIZE)
+
+static bool allocate_slots(hashtable_flat *ht, const size_t capacity);
+static bool rehash_hashtable_flat(hashtable_flat *ht, const size_t new_capacity);
+static size_t find_slot(const hashtable_flat *ht, const void *key, const size_t hash);
+static size_t find_free_slot(const hashtable_flat *ht, const size_t hash);
+static void set_ctrl(hashtable_flat *ht, const size_t index, const int8_t ctrl);
+static bool resize_slot_value(hashtable_flat_slot *slot, const size_t value_size);
+
+static inline unsigned char *slot_data(hashtable_flat_slot *slot)
+{
+    return IS_INLINE(slot->key_size, slot->value_size) ? slot->inline_data : slot->data;
+}
+
+/**
+ * bitmasks of the positions in the 16 control bytes starting at `ctrl`
+ * that are equal to `value` or that are empty/deleted (sign bit set)
+ */
+static inline uint32_t group_match(const int8_t *ctrl, const int8_t value)
+{
+#if defined(__SSE2__)
+    __m128i group = _mm_loadu_si128((const __m128i *)ctrl);
+    return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(value)));
+#else
+    uint32_t mask = 0;
+    for (int i = 0; i < HASHTABLE_FLAT_GROUP_WIDTH; i++)
+        mask |= (uint32_t)(ctrl[i] == value) << i;
+    return mask;
+#endif
+}
+
+static inline uint32_t group_match_free(const int8_t *ctrl)
+{
+#if defined(__SSE2__)
+    return (uint32_t)_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)ctrl));
+#else
+    uint32_t mask = 0;
+    for (int i = 0; i < HASHTABLE_FLAT_GROUP_WIDTH; i++)
+        mask |= (uint32_t)(ctrl[i] < 0) << i;
+    return mask;
+#endif
+}
+
+hashtable_flat *hashtable_flat_create(size_t (*hash_function)(void *key),
+                                      size_t (*compare_key_function)(const void *key1, const void *key2))
+{
+    if (hash_function == NULL || compare_key_function == NULL)
+        return NULL;
+
+    hashtable_flat *ht = malloc(sizeof(hashtable_flat));
+    if (ht == NULL) return NULL;
+
+    ht->pair_number = 0;
+    ht->hash_function = hash_function;
+    ht->compare_key_function = compare_key_function;
+
+    if (!allocate_slots(ht, HASHTABLE_FLAT_INITIAL_CAPACITY))
+    {
+        free(ht);
+        return NULL;
+    }
+
+    return ht;
+}
+
+bool hashtable_flat_put(hashtable_flat *ht,
+                        const void *key, const size_t key_size,
+                        const void *value, const size_t value_size)
+{
+    if (ht == NULL || key == NULL || key_size == 0 || value == NULL || value_size == 0)
+        return false;
+
+    size_t hash = ht->hash_function((void *)key);
+    size_t index = find_slot(ht, key, hash);
+    if (index != SIZE_MAX)
+    {
+        hashtable_flat_slot *current = &ht->slots[index];
+        if (current->value_size != value_size && !resize_slot_value(current, value_size))
+            return false;
+        memcpy(slot_data(current) + current->key_size, value, value_size);
+        return true;
+    }
+
+    /* allocated before anything changes, a failure leaves the table as it was */
+    unsigned char *data = NULL;
+    if (!IS_INLINE(key_size, value_size))
+    {
+        data = malloc(key_size + value_size);
+        if (data == NULL)
+            return false;
+    }
+
+    index = find_free_slot(ht, hash);
+    if (ht->growth_left == 0 && ht->ctrl[index] == HASHTABLE_FLAT_CTRL_EMPTY)
+    {
+        /* only tombstones are wasting space: clean them up instead of growing */
+        size_t new_capacity = ht->pair_number * 2 < ht->capacity - ht->capacity / 8
+                            ? ht->capacity
+                            : ht->capacity * 2;
+        if (!rehash_hashtable_flat(ht, new_capacity))
+        {
+            free(data);
+            return false;
+        }
+        index = find_free_slot(ht, hash);
+    }
+
+    if (ht->ctrl[index] == HASHTABLE_FLAT_CTRL_EMPTY)
+        ht->growth_left--;
+    set_ctrl(ht, index, H2(hash));
+
+    hashtable_flat_slot *slot = &ht->slots[index];
+    slot->hash = hash;
+    slot->key_size = key_size;
+    slot->value_size = value_size;
+    if (data != NULL)
+        slot->data = data;
+    memcpy(slot_data(slot), key, key_size);
+    memcpy(slot_data(slot) + key_size, value, value_size);
+    ht->pair_number++;
+
+    return true;
+}
+
+void *hashtable_flat_get(const hashtable_flat *ht, const void *key)
+{
+    if (ht == NULL || key == NULL)
+        return NULL;
+
+    size_t index = find_slot(ht, key, ht->hash_function((void *)key));
+    if (index == SIZE_MAX)
+        return NULL;
+
+    hashtable_flat_slot *slot = &ht->slots[index];
+    void *value_copy = malloc(slot->value_size);
+    if (value_copy == NULL)
+        return NULL;
+    memcpy(value_copy, slot_data(slot) + slot->key_size, slot->value_size);
+    return value_copy;
+}
+
+bool hashtable_flat_remove(hashtable_flat *ht, const void *key)
+{
+    if (ht == NULL || key == NULL)
+        return false;
+
+    size_t index = find_slot(ht, key, ht->hash_function((void *)key));
+    if (index == SIZE_MAX)
+        return false;
+
+    hashtable_flat_slot *slot = &ht->slots[index];
+    if (!IS_INLINE(slot->key_size, slot->value_size))
+        free(slot->data);
+    set_ctrl(ht, index, HASHTABLE_FLAT_CTRL_DELETED);
+    ht->pair_number--;
+
+    if (ht->pair_number < ht->capacity / 4 && ht->capacity > HASHTABLE_FLAT_INITIAL_CAPACITY)
+        return rehash_hashtable_flat(ht, ht->capacity / 2);
+
+    return true;
+}
+
+void **hashtable_flat_keyset(const hashtable_flat *ht)
+{
+    if (ht == NULL || ht->pair_number == 0)
+        return NULL;
+
+    void **keyset = malloc((ht->pair_number + 1) * sizeof(void *));
+    if (keyset == NULL)
+        return NULL;
+
+    size_t index = 0;
+    for (size_t i = 0; i < ht->capacity; i++)
+        if (ht->ctrl[i] >= 0)
+            keyset[index++] = slot_data(&ht->slots[i]);
+    keyset[index] = NULL;
+
+    return keyset;
+}
+
+bool hashtable_flat_size(const hashtable_flat *ht, size_t *size)
+{
+    if (ht == NULL || size == NULL)
+        return false;
+    *size = ht->pair_number;
+    return true;
+}
+
+void hashtable_flat_destroy(hashtable_flat *ht)
+{
+    if (ht == NULL)
+        return;
+
+    for (size_t i = 0; i < ht->capacity; i++)
+        if (ht->ctrl[i] >= 0 && !IS_INLINE(ht->slots[i].key_size, ht->slots[i].value_size))
+            free(ht->slots[i].data);
+    free(ht->ctrl);
+    free(ht->slots);
+    free(ht);
+}
+
+static bool allocate_slots(hashtable_flat *ht, const size_t capacity)
+{
+    ht->ctrl = malloc(capacity + HASHTABLE_FLAT_GROUP_WIDTH);
+    if (ht->ctrl == NULL)
+        return false;
+
+    ht->slots = malloc(capacity * sizeof(hashtable_flat_slot));
+    if (ht->slots == NULL)
+    {
+        free(ht->ctrl);
+        return false;
+    }
+
+    memset(ht->ctrl, HASHTABLE_FLAT_CTRL_EMPTY, capacity + HASHTABLE_FLAT_GROUP_WIDTH);
+    ht->capacity = capacity;
+    ht->growth_left = capacity - capacity / 8; // max load factor of 7/8
+
+    return true;
+}
+
+static bool rehash_hashtable_flat(hashtable_flat *ht, const size_t new_capacity)
+{
+    // controls on parameters are done by the caller (hashtable_flat_put and hashtable_flat_remove)
+
+    int8_t *old_ctrl = ht->ctrl;
+    hashtable_flat_slot *old_slots = ht->slots;
+    size_t old_capacity = ht->capacity;
+
+    if (!allocate_slots(ht, new_capacity))
+    {
+        ht->ctrl = old_ctrl;
+        ht->slots = old_slots;
+        return false;
+    }
+
+    for (size_t i = 0; i < old_capacity; i++)
+    {
+        if (old_ctrl[i] < 0)
+            continue;
+
+        /* out of line bytes move with their pointer */
+        size_t index = find_free_slot(ht, old_slots[i].hash);
+        set_ctrl(ht, index, H2(old_slots[i].hash));
+        ht->slots[index] = old_slots[i];
+    }
+    ht->growth_left -= ht->pair_number;
+
+    free(old_ctrl);
+    free(old_slots);
+
+    return true;
+}
+
+/**
+ * probes the groups of the sequence starting at the home position of
+ * `hash` and returns the index of the slot holding `key`, SIZE_MAX if the
+ * key is not present. An empty control byte in a group ends the probe.
+ */
+static size_t find_slot(const hashtable_flat *ht, const void *key, const size_t hash)
+{
+    size_t mask = ht->capacity - 1;
+    size_t position = H1(hash) & mask;
+    int8_t tag = H2(hash);
+
+    for (size_t step = HASHTABLE_FLAT_GROUP_WIDTH; ; step += HASHTABLE_FLAT_GROUP_WIDTH)
+    {
+        const int8_t *group = ht->ctrl + position;
+        uint32_t candidates = group_match(group, tag);
+        while (candidates != 0)
+        {
+            size_t index = (position + __builtin_ctz(candidates)) & mask;
+            hashtable_flat_slot *slot = &ht->slots[index];
+            if (slot->hash == hash && ht->compare_key_function(slot_data(slot), key) == 0)
+                return index;
+            candidates &= candidates - 1;
+        }
+
+        if (group_match(group, HASHTABLE_FLAT_CTRL_EMPTY) != 0)
+            return SIZE_MAX;
+
+        /* triangular probing visits every group once the table is a power of two */
+        position = (position + step) & mask;
+    }
+}
+
+static size_t find_free_slot(const hashtable_flat *ht, const size_t hash)
+{
+    size_t mask = ht->capacity - 1;
+    size_t position = H1(hash) & mask;
+
+    for (size_t step = HASHTABLE_FLAT_GROUP_WIDTH; ; step += HASHTABLE_FLAT_GROUP_WIDTH)
+    {
+        uint32_t free_slots = group_match_free(ht->ctrl + position);
+        if (free_slots != 0)
+            return (position + __builtin_ctz(free_slots)) & mask;
+        position = (position + step) & mask;
+    }
+}
+
+static void set_ctrl(hashtable_flat *ht, const size_t index, const int8_t ctrl)
+{
+    ht->ctrl[index] = ctrl;
+    /* the first group is mirrored after the end so unaligned group loads never wrap */
+    if (index < HASHTABLE_FLAT_GROUP_WIDTH)
+        ht->ctrl[ht->capacity + index] = ctrl;
+}
+
+/**
+ * gives `slot` room for a value of `value_size` bytes, moving its key in or out
+ * of the slot when the pair stops or starts fitting. The old value is lost.
+ */
+static bool resize_slot_value(hashtable_flat_slot *slot, const size_t value_size)
+{
+    bool was_inline = IS_INLINE(slot->key_size, slot->value_size);
+    if (IS_INLINE(slot->key_size, value_size))
+    {
+        if (!was_inline)
+        {
+            unsigned char *data = slot->data; // shares its bytes with inline_data
+            memcpy(slot->inline_data, data, slot->key_size);
+            free(data);
+        }
+    }
+    else if (was_inline)
+    {
+        unsigned char *data = malloc(slot->key_size + value_size);
+        if (data == NULL)
+            return false;
+        memcpy(data, slot->inline_data, slot->key_size);
+        slot->data = data;
+    }
+    else
+    {
+        unsigned char *data = realloc(slot->data, slot->key_size + value_size);
+        if (data == NULL)
+            return false;
+        slot->data = data;
+    }
+
+    slot->value_size = value_size;
+    return true;
+}
@@ -0,0 +1,119 @@
+#ifndef HASHTABLE_FLAT_H
+#define HASHTABLE_FLAT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define HASHTABLE_FLAT_GROUP_WIDTH      16
+#define HASHTABLE_FLAT_INITIAL_CAPACITY 16
+#define HASHTABLE_FLAT_INLINE_SIZE      40 // key and value bytes kept in the slot, a slot is 64 bytes
+
+/* control byte values, a full slot stores the low 7 bits of the hash */
+#define HASHTABLE_FLAT_CTRL_EMPTY   ((int8_t)-128) // 0b10000000
+#define HASHTABLE_FLAT_CTRL_DELETED ((int8_t)-2)   // 0b11111110
+
+/**
+ * pairs live in the slot array itself: once the control bytes matched, the hash
+ * and, for pairs of up to `HASHTABLE_FLAT_INLINE_SIZE` bytes, the key and value
+ * are one load away. Only larger pairs keep their bytes in a separate allocation.
+ */
+typedef struct hashtable_flat_slot
+{
+    size_t hash;
+    size_t key_size;
+    size_t value_size;
+    union
+    {
+        unsigned char  inline_data[HASHTABLE_FLAT_INLINE_SIZE]; // key bytes followed by the value bytes
+        unsigned char *data;                                    // same layout, out of line
+    };
+} hashtable_flat_slot;
+
+typedef struct hashtable_flat
+{
+    int8_t               *ctrl;  // capacity + HASHTABLE_FLAT_GROUP_WIDTH control bytes
+    hashtable_flat_slot  *slots;
+    size_t                capacity;
+    size_t                pair_number;
+    size_t                growth_left;
+    size_t              (*hash_function)(void *key);
+    size_t              (*compare_key_function)(const void *key1, const void *key2);
+} hashtable_flat;
+
+/**
+ * @brief creates a new empty open addressing hashtable specifying hash and key
+ * comparison functions. Lookups probe the control bytes 16 at a time (with SSE2
+ * when available) and only read the slots whose 7 bit hash tag matches.
+ * Allocated memory from the hashtable must be freed with `hashtable_flat_destroy`.
+ *
+ * @param hash_function pointer to the hash function
+ * @param compare_key_function pointer to the key comparison function
+ * @return hashtable_flat* pointer to the newly created hashtable
+ */
+hashtable_flat *hashtable_flat_create(size_t (*hash_function)(void *key),
+                                      size_t (*compare_key_function)(const void *key1, const void *key2));
+
+/**
+ * @brief inserts a new pair into the hashtable.
+ * If the key already exists, its value is updated.
+ *
+ * @param ht pointer to the hashtable you want to insert the pair into
+ * @param key pointer to the first byte of the key
+ * @param key_size size of the key in bytes
+ * @param value pointer to the first byte of the value
+ * @param value_size size of the value in bytes
+ * @return true if the pair was successfully inserted or updated
+ * @return false if an error occurred (e.g., memory allocation failure)
+ */
+bool hashtable_flat_put(hashtable_flat *ht,
+                        const void *key, const size_t key_size,
+                        const void *value, const size_t value_size);
+
+/**
+ * @brief retrieves the value associated with the given key.
+ * The returned pointer must be freed by the caller.
+ *
+ * @param ht pointer to the hashtable you want to retrieve the value from
+ * @param key pointer to the first byte of the key
+ * @return void* pointer to the value associated with the key, or NULL if the key does not exist
+ */
+void *hashtable_flat_get(const hashtable_flat *ht, const void *key);
+
+/**
+ * @brief removes the pair associated with the given key from the hashtable.
+ *
+ * @param ht pointer to the hashtable you want to remove the pair from
+ * @param key pointer to the first byte of the key
+ * @return true if the pair was successfully removed
+ * @return false if the key does not exist in the hashtable
+ */
+bool hashtable_flat_remove(hashtable_flat *ht, const void *key);
+
+/**
+ * @brief returns a NULL terminated array of pointers to the keys stored in the hashtable.
+ * The returned array must be freed by the caller. Small keys are stored in the slots,
+ * the pointers are only valid until the next put or remove.
+ *
+ * @param ht pointer to the hashtable you want to get the keys from
+ * @return void** array of pointers to the keys stored in the hashtable
+ */
+void **hashtable_flat_keyset(const hashtable_flat *ht);
+
+/**
+ * @brief returns the number of pairs in the hashtable.
+ *
+ * @param ht pointer to the hashtable you want to get the size of
+ * @param size pointer to a variable where the size will be stored
+ * @return true if the size was successfully retrieved
+ * @return false if an error occurred (e.g., invalid hashtable pointer)
+ */
+bool hashtable_flat_size(const hashtable_flat *ht, size_t *size);
+
+/**
+ * @brief destroys the hashtable and frees all allocated memory.
+ *
+ * @param ht pointer to the hashtable to destroy
+ */
+void hashtable_flat_destroy(hashtable_flat *ht);
+
+#endif // HASHTABLE_FLAT_H
@@ -0,0 +1,554 @@
+#define _DEFAULT_SOURCE
+
+#include "hashtable_frozen.h"
+#include "mapped_file.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#define FROZEN_ALIGN(size) (((size) + 7) & ~(size_t)7)
+#define RECORD_SIZE(key_size, value_size) (2 * sizeof(uint64_t) + FROZEN_ALIGN(key_size) + FROZEN_ALIGN(value_size))
+#define FIXED_RECORD_SIZE(key_size, value_size) (FROZEN_ALIGN(key_size) + FROZEN_ALIGN(value_size))
+#define SLOTS_BYTES(size) FROZEN_ALIGN((size) * sizeof(uint32_t))
+
+/* a new pilot seed is tried when no pilot places a bucket, in practice the first one works */
+#define FREEZE_ATTEMPTS 8
+
+static bool search_pilots(const uint64_t *mixed, const size_t n, const size_t slots_size, const size_t buckets_size,
+                          uint32_t *pilots, uint32_t *remap, size_t *slots, bool *hopeless);
+static hashtable_frozen *build_image(const hashtable *ht, hashtable_pair **pairs, const size_t n, const size_t *slots,
+                                     const uint32_t *pilots, const uint32_t *remap, const size_t slots_size,
+                                     const size_t buckets_size, const uint64_t pilot_seed);
+static bool fixed_sizes(hashtable_pair **pairs, const size_t n);
+static size_t records_start(const hashtable_frozen_header *header);
+static void attach_image(hashtable_frozen *frozen, const unsigned char *image, const size_t image_size);
+static bool write_image(FILE *file, const void *frozenp);
+static hashtable_frozen *map_frozen(const char *path, const bool seeded);
+static uint64_t header_checksum(const hashtable_frozen_header *header);
+static uint64_t key_hash(const hashtable_frozen *frozen, const void *key);
+static size_t slot_for(const hashtable_frozen *frozen, const void *key);
+static const unsigned char *record_at(const hashtable_frozen *frozen, const size_t slot,
+                                      size_t *key_size, size_t *value_size);
+
+/* maps a 32 bit hash to [0, n) with a multiplication instead of a division */
+static inline size_t fastrange32(const uint32_t x, const size_t n)
+{
+    return (size_t)(((uint64_t)x * n) >> 32);
+}
+
+static inline size_t bucket_of(const uint64_t mixed, const size_t buckets_size)
+{
+    return fastrange32((uint32_t)(mixed >> 32), buckets_size);
+}
+
+static inline size_t slot_of(const uint64_t mixed, const uint32_t pilot, const size_t slots_size)
+{
+    return fastrange32((uint32_t)hash_fmix64(mixed ^ (pilot * 0x9E3779B97F4A7C15ull)), slots_size);
+}
+
+hashtable_frozen *hashtable_freeze(const hashtable *ht)
+{
+    if (ht == NULL)
+        return NULL;
+
+    /* expired pairs that haven't been reclaimed yet are left out */
+    hashtable_pair **pairs = malloc((ht->pair_number + 1) * sizeof(hashtable_pair *));
+    if (pairs == NULL)
+        return NULL;
+    size_t n = 0;
+    hashtable_pair **arrays[] = { ht->buckets, ht->old_buckets };
+    size_t sizes[] = { ht->buckets_size, ht->old_buckets == NULL ? 0 : ht->old_buckets_size };
+    for (size_t a = 0; a < 2; a++)
+        for (size_t i = 0; i < sizes[a]; i++)
+            for (hashtable_pair *pair = arrays[a][i]; pair != NULL; pair = pair->next)
+                if (!hashtable_pair_expired(ht, pair))
+                    pairs[n++] = pair;
+    if (n >= UINT32_MAX - n / HASHTABLE_FROZEN_SLACK)
+    {
+        free(pairs);
+        return NULL;
+    }
+
+    size_t slots_size = n + n / HASHTABLE_FROZEN_SLACK + 1;
+    size_t buckets_size = n / HASHTABLE_FROZEN_BUCKET_LOAD + 1;
+    uint64_t *mixed = malloc((n + 1) * sizeof(uint64_t));
+    size_t *slots = malloc((n + 1) * sizeof(size_t));
+    uint32_t *pilots = malloc(buckets_size * sizeof(uint32_t));
+    uint32_t *remap = calloc(slots_size - n, sizeof(uint32_t));
+    hashtable_frozen *frozen = NULL;
+
+    if (mixed != NULL && slots != NULL && pilots != NULL && remap != NULL)
+    {
+        bool hopeless = false;
+        for (uint64_t attempt = 0; attempt < FREEZE_ATTEMPTS && !hopeless; attempt++)
+        {
+            uint64_t pilot_seed = hash_fmix64(attempt + 1);
+            for (size_t i = 0; i < n; i++)
+                mixed[i] = hash_fmix64(pairs[i]->hash ^ pilot_seed);
+
+            if (search_pilots(mixed, n, slots_size, buckets_size, pilots, remap, slots, &hopeless))
+            {
+                frozen = build_image(ht, pairs, n, slots, pilots, remap, slots_size, buckets_size, pilot_seed);
+                break;
+            }
+        }
+    }
+
+    free(pairs);
+    free(mixed);
+    free(slots);
+    free(pilots);
+    free(remap);
+    return frozen;
+}
+
+const void *hashtable_frozen_get(const hashtable_frozen *frozen, const void *key, size_t *value_size)
+{
+    if (frozen == NULL || key == NULL || frozen->pair_number == 0)
+        return NULL;
+
+    size_t stored_key_size, stored_value_size;
+    const unsigned char *stored_key = record_at(frozen, slot_for(frozen, key), &stored_key_size, &stored_value_size);
+    if (stored_key == NULL)
+        return NULL;
+
+    bool equal = frozen->seeded_hash_function != NULL
+                 ? frozen->sized_compare_key_function(stored_key, key, frozen->key_size) == 0
+                 : frozen->compare_key_function(stored_key, key) == 0;
+    if (!equal)
+        return NULL;
+
+    if (value_size != NULL)
+        *value_size = stored_value_size;
+    return stored_key + FROZEN_ALIGN(stored_key_size);
+}
+
+bool hashtable_frozen_size(const hashtable_frozen *frozen, size_t *size)
+{
+    if (frozen == NULL || size == NULL)
+        return false;
+    *size = frozen->pair_number;
+    return true;
+}
+
+bool hashtable_frozen_save(const hashtable_frozen *frozen, const char *path)
+{
+    if (frozen == NULL || path == NULL)
+        return false;
+
+    return mapped_file_write(path, write_image, frozen);
+}
+
+hashtable_frozen *hashtable_frozen_open_mmap(const char *path,
+                                             size_t (*hash_function)(void *key),
+                                             size_t (*compare_key_function)(const void *key1, const void *key2))
+{
+    if (path == NULL || hash_function == NULL || compare_key_function == NULL)
+        return NULL;
+
+    hashtable_frozen *frozen = map_frozen(path, false);
+    if (frozen == NULL) return NULL;
+
+    frozen->hash_function = hash_function;
+    frozen->compare_key_function = compare_key_function;
+
+    return frozen;
+}
+
+hashtable_frozen *hashtable_frozen_open_mmap_seeded(const char *path,
+                                                    size_t (*hash_function)(const void *key, const size_t key_size, const uint64_t seed),
+                                                    size_t (*compare_key_function)(const void *key1, const void *key2, const size_t key_size))
+{
+    if (path == NULL || hash_function == NULL || compare_key_function == NULL)
+        return NULL;
+
+    hashtable_frozen *frozen = map_frozen(path, true);
+    if (frozen == NULL) return NULL;
+
+    frozen->seeded_hash_function = hash_function;
+    frozen->sized_compare_key_function = compare_key_function;
+
+    return frozen;
+}
+
+bool hashtable_frozen_verify(const hashtable_frozen *frozen)
+{
+    if (frozen == NULL)
+        return false;
+
+    const hashtable_frozen_header *header = (const hashtable_frozen_header *)frozen->image;
+    if (hash_bytes(header + 1, frozen->image_size - sizeof(hashtable_frozen_header), 0) != header->checksum)
+        return false;
+
+    size_t start = (size_t)(frozen->records - frozen->image);
+    if (frozen->offsets != NULL &&
+        (frozen->offsets[0] != start || frozen->offsets[frozen->pair_number] != frozen->image_size))
+        return false;
+
+    /* every extra slot sends its key below pair_number */
+    for (size_t i = 0; i < frozen->slots_size - frozen->pair_number; i++)
+        if (frozen->remap[i] >= frozen->pair_number && frozen->pair_number != 0)
+            return false;
+
+    /* every record fills the space up to the next one and its key hashes to its own slot */
+    for (size_t slot = 0; slot < frozen->pair_number; slot++)
+    {
+        size_t key_size, value_size;
+        const unsigned char *key = record_at(frozen, slot, &key_size, &value_size);
+        if (key == NULL)
+            return false;
+        if (frozen->offsets != NULL &&
+            frozen->offsets[slot] + RECORD_SIZE(key_size, value_size) != frozen->offsets[slot + 1])
+            return false;
+        if (slot_for(frozen, key) != slot)
+            return false;
+    }
+
+    return true;
+}
+
+void hashtable_frozen_destroy(hashtable_frozen *frozen)
+{
+    if (frozen == NULL)
+        return;
+
+    if (frozen->mapped)
+        munmap((void *)frozen->image, frozen->image_size);
+    else
+        free((void *)frozen->image);
+    free(frozen);
+}
+
+/**
+ * hash and displace: keys are spread over buckets, then every bucket, largest first,
+ * gets the first pilot that sends all of its keys to free slots. Large buckets are
+ * placed while most slots are free, the single key buckets left at the end only need
+ * one free slot each, and the extra slots keep some free until the very end. The keys
+ * placed in the extra slots are then moved to the holes below `n` through `remap`.
+ * `hopeless` is set when two keys have the same hash, no seed can separate them.
+ */
+static bool search_pilots(const uint64_t *mixed, const size_t n, const size_t slots_size, const size_t buckets_size,
+                          uint32_t *pilots, uint32_t *remap, size_t *slots, bool *hopeless)
+{
+    size_t *bucket_start = calloc(buckets_size + 1, sizeof(size_t));
+    size_t *keys = malloc((n + 1) * sizeof(size_t));
+    size_t *order = malloc(buckets_size * sizeof(size_t));
+    unsigned char *taken = calloc(slots_size, sizeof(unsigned char));
+    bool placed = bucket_start != NULL && keys != NULL && order != NULL && taken != NULL;
+
+    if (placed)
+    {
+        /* keys grouped by bucket, then buckets sorted by decreasing size, both counting sorts */
+        size_t max_bucket = 0;
+        for (size_t i = 0; i < n; i++)
+            bucket_start[bucket_of(mixed[i], buckets_size) + 1]++;
+        for (size_t b = 0; b < buckets_size; b++)
+        {
+            if (bucket_start[b + 1] > max_bucket)
+                max_bucket = bucket_start[b + 1];
+            bucket_start[b + 1] += bucket_start[b];
+        }
+        for (size_t i = 0; i < n; i++)
+            keys[bucket_start[bucket_of(mixed[i], buckets_size)]++] = i;
+        for (size_t b = buckets_size; b > 0; b--)
+            bucket_start[b] = bucket_start[b - 1];
+        bucket_start[0] = 0;
+
+        size_t *size_start = calloc(max_bucket + 2, sizeof(size_t));
+        placed = size_start != NULL;
+        if (placed)
+        {
+            for (size_t b = 0; b < buckets_size; b++)
+                size_start[max_bucket - (bucket_start[b + 1] - bucket_start[b]) + 1]++;
+            for (size_t s = 0; s <= max_bucket; s++)
+                size_start[s + 1] += size_start[s];
+            for (size_t b = 0; b < buckets_size; b++)
+                order[size_start[max_bucket - (bucket_start[b + 1] - bucket_start[b])]++] = b;
+            free(size_start);
+        }
+    }
+
+    uint64_t max_pilot = n < UINT32_MAX / 16 ? 16 * (uint64_t)n + 1024 : UINT32_MAX;
+    for (size_t o = 0; placed && o < buckets_size; o++)
+    {
+        size_t b = order[o];
+        size_t first = bucket_start[b], last = bucket_start[b + 1];
+        pilots[b] = 0;
+        if (first == last)
+            continue;
+
+        for (size_t i = first; i < last; i++)
+            for (size_t j = first; j < i; j++)
+                if (mixed[keys[i]] == mixed[keys[j]])
+                {
+                    *hopeless = true;
+                    placed = false;
+                }
+
+        bool found = false;
+        for (uint64_t pilot = 0; placed && !found && pilot < max_pilot; pilot++)
+        {
+            found = true;
+            for (size_t i = first; i < last && found; i++)
+            {
+                slots[keys[i]] = slot_of(mixed[keys[i]], (uint32_t)pilot, slots_size);
+                found = !taken[slots[keys[i]]];
+                for (size_t j = first; j < i && found; j++)
+                    found = slots[keys[j]] != slots[keys[i]];
+            }
+            if (found)
+                pilots[b] = (uint32_t)pilot;
+        }
+
+        placed = placed && found;
+        for (size_t i = first; placed && i < last; i++)
+            taken[slots[keys[i]]] = 1;
+    }
+
+    if (placed)
+    {
+        /* there are exactly as many holes below n as keys above it */
+        size_t hole = 0;
+        for (size_t s = n; s < slots_size; s++)
+        {
+            remap[s - n] = 0;
+            if (!taken[s])
+                continue;
+            while (taken[hole])
+                hole++;
+            remap[s - n] = (uint32_t)hole++;
+        }
+        for (size_t i = 0; i < n; i++)
+            if (slots[i] >= n)
+                slots[i] = remap[slots[i] - n];
+    }
+
+    free(bucket_start);
+    free(keys);
+    free(order);
+    free(taken);
+    return placed;
+}
+
+static hashtable_frozen *build_image(const hashtable *ht, hashtable_pair **pairs, const size_t n, const size_t *slots,
+                                     const uint32_t *pilots, const uint32_t *remap, const size_t slots_size,
+                                     const size_t buckets_size, const uint64_t pilot_seed)
+{
+    hashtable_pair **by_slot = malloc((n + 1) * sizeof(hashtable_pair *));
+    hashtable_frozen *frozen = malloc(sizeof(hashtable_frozen));
+    if (by_slot == NULL || frozen == NULL)
+    {
+        free(by_slot);
+        free(frozen);
+        return NULL;
+    }
+
+    bool fixed = fixed_sizes(pairs, n);
+    hashtable_frozen_header layout = {
+        .flags = (ht->seeded_hash_function != NULL ? HASHTABLE_FROZEN_SEEDED : 0) | (fixed ? HASHTABLE_FROZEN_FIXED : 0),
+        .pair_number = n,
+        .slots_size = slots_size,
+        .buckets_size = buckets_size,
+    };
+    size_t image_size = records_start(&layout);
+    for (size_t i = 0; i < n; i++)
+    {
+        by_slot[slots[i]] = pairs[i];
+        image_size += fixed ? FIXED_RECORD_SIZE(pairs[i]->key_size, pairs[i]->value_size)
+                            : RECORD_SIZE(pairs[i]->key_size, pairs[i]->value_size);
+    }
+
+    unsigned char *image = calloc(image_size, sizeof(unsigned char));
+    if (image == NULL)
+    {
+        free(by_slot);
+        free(frozen);
+        return NULL;
+    }
+
+    hashtable_frozen_header *header = (hashtable_frozen_header *)image;
+    unsigned char *position = image + sizeof(hashtable_frozen_header);
+    memcpy(position, pilots, buckets_size * sizeof(uint32_t));
+    position += SLOTS_BYTES(buckets_size);
+    memcpy(position, remap, (slots_size - n) * sizeof(uint32_t));
+    position += SLOTS_BYTES(slots_size - n);
+    uint64_t *offsets = fixed ? NULL : (uint64_t *)position;
+
+    position = image + records_start(&layout);
+    for (size_t slot = 0; slot < n; slot++)
+    {
+        const hashtable_pair *pair = by_slot[slot];
+        if (!fixed)
+        {
+            offsets[slot] = (uint64_t)(position - image);
+            ((uint64_t *)position)[0] = pair->key_size;
+            ((uint64_t *)position)[1] = pair->value_size;
+            position += 2 * sizeof(uint64_t);
+        }
+        memcpy(position, pair->key, pair->key_size);
+        position += FROZEN_ALIGN(pair->key_size);
+        memcpy(position, pair->value, pair->value_size);
+        position += FROZEN_ALIGN(pair->value_size);
+    }
+    if (!fixed)
+        offsets[n] = image_size;
+
+    *header = layout;
+    header->magic = HASHTABLE_FROZEN_MAGIC;
+    header->version = HASHTABLE_FROZEN_VERSION;
+    header->seed = ht->seed;
+    header->key_size = ht->key_size;
+    header->pilot_seed = pilot_seed;
+    header->record_key_size = fixed && n > 0 ? pairs[0]->key_size : 0;
+    header->record_value_size = fixed && n > 0 ? pairs[0]->value_size : 0;
+    header->image_size = image_size;
+    header->checksum = hash_bytes(header + 1, image_size - sizeof(hashtable_frozen_header), 0);
+    header->header_checksum = header_checksum(header);
+    free(by_slot);
+
+    attach_image(frozen, image, image_size);
+    frozen->mapped = false;
+    frozen->hash_function = ht->hash_function;
+    frozen->compare_key_function = ht->compare_key_function;
+    frozen->seeded_hash_function = ht->seeded_hash_function;
+    frozen->sized_compare_key_function = ht->sized_compare_key_function;
+
+    return frozen;
+}
+
+/* true if every key and every value have the same size, records can then drop their sizes and offsets */
+static bool fixed_sizes(hashtable_pair **pairs, const size_t n)
+{
+    for (size_t i = 1; i < n; i++)
+        if (pairs[i]->key_size != pairs[0]->key_size || pairs[i]->value_size != pairs[0]->value_size)
+            return false;
+    return true;
+}
+
+/* offset of the first record, after the pilots, the remapped slots and the offsets if any */
+static size_t records_start(const hashtable_frozen_header *header)
+{
+    size_t start = sizeof(hashtable_frozen_header) + SLOTS_BYTES(header->buckets_size) +
+                   SLOTS_BYTES(header->slots_size - header->pair_number);
+    if ((header->flags & HASHTABLE_FROZEN_FIXED) == 0)
+        start += (header->pair_number + 1) * sizeof(uint64_t);
+    return start;
+}
+
+/* points the frozen table into a validated image, the callbacks are left to the caller */
+static void attach_image(hashtable_frozen *frozen, const unsigned char *image, const size_t image_size)
+{
+    const hashtable_frozen_header *header = (const hashtable_frozen_header *)image;
+    bool fixed = (header->flags & HASHTABLE_FROZEN_FIXED) != 0;
+
+    frozen->image = image;
+    frozen->image_size = image_size;
+    frozen->pilots = (const uint32_t *)(header + 1);
+    frozen->remap = (const uint32_t *)((const unsigned char *)frozen->pilots + SLOTS_BYTES(header->buckets_size));
+    frozen->offsets = fixed ? NULL : (const uint64_t *)((const unsigned char *)frozen->remap +
+                                                        SLOTS_BYTES(header->slots_size - header->pair_number));
+    frozen->records = image + records_start(header);
+    frozen->record_key_size = header->record_key_size;
+    frozen->record_value_size = header->record_value_size;
+    frozen->buckets_size = header->buckets_size;
+    frozen->pair_number = header->pair_number;
+    frozen->slots_size = header->slots_size;
+    frozen->pilot_seed = header->pilot_seed;
+    frozen->key_size = header->key_size;
+    frozen->seed = header->seed;
+}
+
+static bool write_image(FILE *file, const void *frozenp)
+{
+    const hashtable_frozen *frozen = frozenp;
+    return fwrite(frozen->image, 1, frozen->image_size, file) == frozen->image_size;
+}
+
+static hashtable_frozen *map_frozen(const char *path, const bool seeded)
+{
+    size_t image_size;
+    const void *map = mapped_file_open(path, sizeof(hashtable_frozen_header), &image_size);
+    if (map == NULL)
+        return NULL;
+
+    /* sizes are bounded first so that computing the layout can't overflow */
+    const hashtable_frozen_header *header = map;
+    bool valid = header->magic == HASHTABLE_FROZEN_MAGIC &&
+                 header->version == HASHTABLE_FROZEN_VERSION &&
+                 header->header_checksum == header_checksum(header) &&
+                 header->image_size == image_size &&
+                 ((header->flags & HASHTABLE_FROZEN_SEEDED) != 0) == seeded &&
+                 header->pair_number < header->slots_size && header->slots_size <= UINT32_MAX &&
+                 header->buckets_size != 0 && header->buckets_size <= UINT32_MAX &&
+                 header->record_key_size <= image_size && header->record_value_size <= image_size &&
+                 records_start(header) <= image_size;
+    if (valid && (header->flags & HASHTABLE_FROZEN_FIXED) != 0)
+    {
+        size_t stride = FIXED_RECORD_SIZE(header->record_key_size, header->record_value_size);
+        size_t records_size = image_size - records_start(header);
+        valid = stride == 0 ? records_size == 0
+                            : records_size % stride == 0 && records_size / stride == header->pair_number;
+    }
+
+    hashtable_frozen *frozen = valid ? calloc(1, sizeof(hashtable_frozen)) : NULL;
+    if (frozen == NULL)
+    {
+        munmap((void *)map, image_size);
+        return NULL;
+    }
+
+    attach_image(frozen, map, image_size);
+    frozen->mapped = true;
+
+    return frozen;
+}
+
+static uint64_t header_checksum(const hashtable_frozen_header *header)
+{
+    return hash_bytes(header, offsetof(hashtable_frozen_header, header_checksum), 0);
+}
+
+static uint64_t key_hash(const hashtable_frozen *frozen, const void *key)
+{
+    return frozen->seeded_hash_function != NULL
+           ? frozen->seeded_hash_function(key, frozen->key_size, frozen->seed)
+           : frozen->hash_function((void *)key);
+}
+
+/* the only slot `key` can be in, pair_number or more if the image sends it out of range */
+static size_t slot_for(const hashtable_frozen *frozen, const void *key)
+{
+    uint64_t mixed = hash_fmix64(key_hash(frozen, key) ^ frozen->pilot_seed);
+    size_t slot = slot_of(mixed, frozen->pilots[bucket_of(mixed, frozen->buckets_size)], frozen->slots_size);
+    return slot < frozen->pair_number ? slot : frozen->remap[slot - frozen->pair_number];
+}
+
+/* the key of the record of `slot`, NULL if the record doesn't fit in the image */
+static const unsigned char *record_at(const hashtable_frozen *frozen, const size_t slot,
+                                      size_t *key_size, size_t *value_size)
+{
+    if (slot >= frozen->pair_number)
+        return NULL;
+
+    if (frozen->offsets == NULL)
+    {
+        *key_size = frozen->record_key_size;
+        *value_size = frozen->record_value_size;
+        return frozen->records + slot * FIXED_RECORD_SIZE(*key_size, *value_size);
+    }
+
+    size_t offset = frozen->offsets[slot];
+    if (offset > frozen->image_size || frozen->image_size - offset < 2 * sizeof(uint64_t))
+        return NULL;
+
+    const uint64_t *record = (const uint64_t *)(frozen->image + offset);
+    size_t left = frozen->image_size - offset - 2 * sizeof(uint64_t);
+    if (record[0] > left || record[1] > left || FROZEN_ALIGN(record[0]) + FROZEN_ALIGN(record[1]) > left)
+        return NULL;
+
+    *key_size = record[0];
+    *value_size = record[1];
+    return (const unsigned char *)(record + 2);
+}
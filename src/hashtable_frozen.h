@@ -0,0 +1,165 @@
+#ifndef HASHTABLE_FROZEN_H
+#define HASHTABLE_FROZEN_H
+
+#include "hashtable.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define HASHTABLE_FROZEN_MAGIC   0x4e5a524654484843ull // "CHHTFRZN" read in native byte order
+#define HASHTABLE_FROZEN_VERSION 1
+
+#define HASHTABLE_FROZEN_SEEDED 0x1 // frozen from a `hashtable_create_seeded` table
+#define HASHTABLE_FROZEN_FIXED  0x2 // every key and every value have the same size, records have a fixed stride
+
+/* average keys per displacement bucket, more keys per bucket means fewer pilots but a longer build */
+#define HASHTABLE_FROZEN_BUCKET_LOAD 3
+
+/**
+ * keys are placed in `pair_number + pair_number / HASHTABLE_FROZEN_SLACK + 1` slots, the
+ * keys landing past `pair_number` are remapped to the holes left below it. Without the
+ * extra slots the last keys would have to search for the very last free slots.
+ */
+#define HASHTABLE_FROZEN_SLACK 64
+
+/**
+ * the image is the header, one 32 bit pilot per displacement bucket, one 32 bit
+ * remapped slot per extra slot (both arrays padded to 8 bytes), then the records.
+ * With `HASHTABLE_FROZEN_FIXED` records are just the key and the value, each padded
+ * to 8 bytes, and the record of slot i is at a fixed stride. Otherwise
+ * `pair_number + 1` offsets come first and every record starts with the key size
+ * and the value size. Offsets are from the start of the image, which is the same
+ * in memory and on disk, so a saved image is served as is from the mapped file.
+ */
+typedef struct hashtable_frozen_header
+{
+    uint64_t magic;
+    uint32_t version;
+    uint32_t flags;
+    uint64_t seed;           // seed of the frozen hashtable's hash function
+    uint64_t key_size;
+    uint64_t pair_number;
+    uint64_t slots_size;     // pair_number + extra slots
+    uint64_t pilot_seed;     // mixed into the key hashes, changed when a build attempt fails
+    uint64_t buckets_size;
+    uint64_t record_key_size;   // size of every key with `HASHTABLE_FROZEN_FIXED`
+    uint64_t record_value_size; // size of every value with `HASHTABLE_FROZEN_FIXED`
+    uint64_t image_size;
+    uint64_t checksum;       // everything after the header
+    uint64_t header_checksum;
+} hashtable_frozen_header;
+
+typedef struct hashtable_frozen
+{
+    const unsigned char *image;
+    size_t               image_size;
+    bool                 mapped;
+    const uint32_t      *pilots;
+    const uint32_t      *remap;
+    const uint64_t      *offsets;    // NULL for fixed size records
+    const unsigned char *records;
+    size_t               record_key_size;
+    size_t               record_value_size;
+    size_t               buckets_size;
+    size_t               pair_number;
+    size_t               slots_size;
+    uint64_t             pilot_seed;
+    size_t             (*hash_function)(void *key);
+    size_t             (*compare_key_function)(const void *key1, const void *key2);
+    size_t             (*seeded_hash_function)(const void *key, const size_t key_size, const uint64_t seed);
+    size_t             (*sized_compare_key_function)(const void *key1, const void *key2, const size_t key_size);
+    size_t               key_size;
+    uint64_t             seed;
+} hashtable_frozen;
+
+/**
+ * @brief builds a read only copy of the hashtable indexed by a minimal perfect hash:
+ * every key maps to its own slot of a packed array, so a lookup reads one pilot and
+ * one record (plus one offset when sizes vary), hit or miss. The hashtable is left
+ * untouched and can be destroyed afterwards, its expired pairs are left out and the
+ * others lose their expiry. Fails when two different keys have the
+ * same full hash, they can't be told apart. Must be freed with `hashtable_frozen_destroy`.
+ *
+ * @param ht pointer to the hashtable to freeze
+ * @return hashtable_frozen* pointer to the frozen table, NULL on failure
+ */
+hashtable_frozen *hashtable_freeze(const hashtable *ht);
+
+/**
+ * @brief retrieves a read only pointer to the value stored in the frozen table.
+ * The pointer stays valid until `hashtable_frozen_destroy`.
+ *
+ * @param frozen pointer to the frozen table you want to retrieve the value from
+ * @param key pointer to the first byte of the key
+ * @param value_size pointer to a variable where the size of the value will be stored, can be NULL
+ * @return const void* pointer to the value, or NULL if the key does not exist
+ */
+const void *hashtable_frozen_get(const hashtable_frozen *frozen, const void *key, size_t *value_size);
+
+/**
+ * @brief returns the number of pairs in the frozen table.
+ *
+ * @param frozen pointer to the frozen table you want to get the size of
+ * @param size pointer to a variable where the size will be stored
+ * @return true if the size was successfully retrieved
+ * @return false if an error occurred (e.g., invalid frozen table pointer)
+ */
+bool hashtable_frozen_size(const hashtable_frozen *frozen, size_t *size);
+
+/**
+ * @brief writes the image of the frozen table to a file, written next to `path`
+ * and renamed over it once complete.
+ *
+ * @param frozen pointer to the frozen table to save
+ * @param path path of the file
+ * @return true if the file was written
+ * @return false if an error occurred (e.g., I/O failure)
+ */
+bool hashtable_frozen_save(const hashtable_frozen *frozen, const char *path);
+
+/**
+ * @brief maps a frozen table saved from a `hashtable_create` table, read only,
+ * with the same on demand loading as `hashtable_open_mmap`. Only the header is
+ * validated, use `hashtable_frozen_verify` to check the whole image.
+ * Must be freed with `hashtable_frozen_destroy`.
+ *
+ * @param path path of the file
+ * @param hash_function the hash function of the frozen hashtable
+ * @param compare_key_function the key comparison function of the frozen hashtable
+ * @return hashtable_frozen* pointer to the mapped table, NULL if it can't be mapped or is invalid
+ */
+hashtable_frozen *hashtable_frozen_open_mmap(const char *path,
+                                             size_t (*hash_function)(void *key),
+                                             size_t (*compare_key_function)(const void *key1, const void *key2));
+
+/**
+ * @brief same as `hashtable_frozen_open_mmap`, for a table frozen from a
+ * `hashtable_create_seeded` hashtable. The seed and the key size are read from the file.
+ *
+ * @param path path of the file
+ * @param hash_function the seeded hash function of the frozen hashtable
+ * @param compare_key_function the key comparison function of the frozen hashtable
+ * @return hashtable_frozen* pointer to the mapped table, NULL if it can't be mapped or is invalid
+ */
+hashtable_frozen *hashtable_frozen_open_mmap_seeded(const char *path,
+                                                    size_t (*hash_function)(const void *key, const size_t key_size, const uint64_t seed),
+                                                    size_t (*compare_key_function)(const void *key1, const void *key2, const size_t key_size));
+
+/**
+ * @brief reads the whole image and checks its checksum and structure.
+ *
+ * @param frozen pointer to the frozen table to verify
+ * @return true if the image is intact
+ * @return false if the image is corrupted
+ */
+bool hashtable_frozen_verify(const hashtable_frozen *frozen);
+
+/**
+ * @brief frees or unmaps the frozen table, every pointer returned by
+ * `hashtable_frozen_get` becomes invalid.
+ *
+ * @param frozen pointer to the frozen table to destroy
+ */
+void hashtable_frozen_destroy(hashtable_frozen *frozen);
+
+#endif // HASHTABLE_FROZEN_H
@@ -0,0 +1,100 @@
+#include "hashtable_parallel.h"
+
+#include <stdlib.h>
+#include <pthread.h>
+
+/* counts down once per finished part, the thread that started the parts waits for 0 */
+typedef struct
+{
+    pthread_mutex_t mutex;
+    pthread_cond_t  done_cond;
+    size_t          count;
+} latch;
+
+typedef struct
+{
+    void  (*function)(void *context, const size_t part, const size_t parts);
+    void   *context;
+    size_t  part;
+    size_t  parts;
+    latch  *done;
+} parallel_job;
+
+static hashtable_executor threadpool_executor(threadpool *tp);
+static void *run_parallel_job(void *argp);
+static void run_parallel(void *tpp, const size_t parts,
+                         void (*function)(void *context, const size_t part, const size_t parts), void *context);
+
+bool hashtable_build_parallel(hashtable *ht, const hashtable_entry *entries, const size_t n, threadpool *tp)
+{
+    if (tp == NULL)
+        return hashtable_build_with(ht, entries, n, NULL);
+
+    hashtable_executor executor = threadpool_executor(tp);
+    return hashtable_build_with(ht, entries, n, &executor);
+}
+
+bool hashtable_set_threadpool(hashtable *ht, threadpool *tp)
+{
+    if (tp == NULL)
+        return hashtable_set_executor(ht, NULL);
+
+    hashtable_executor executor = threadpool_executor(tp);
+    return hashtable_set_executor(ht, &executor);
+}
+
+static hashtable_executor threadpool_executor(threadpool *tp)
+{
+    return (hashtable_executor){ run_parallel, tp, tp->thread_number };
+}
+
+static void *run_parallel_job(void *argp)
+{
+    parallel_job *job = argp;
+    job->function(job->context, job->part, job->parts);
+
+    pthread_mutex_lock(&job->done->mutex);
+    if (--job->done->count == 0)
+        pthread_cond_signal(&job->done->done_cond);
+    pthread_mutex_unlock(&job->done->mutex);
+    return NULL;
+}
+
+/**
+ * calls `function` once for every part on the threads of `tp` and waits for all of them,
+ * parts that can't be handed to the threadpool run on the calling thread
+ */
+static void run_parallel(void *tpp, const size_t parts,
+                         void (*function)(void *context, const size_t part, const size_t parts), void *context)
+{
+    threadpool *tp = tpp;
+    parallel_job *jobs = malloc(parts * sizeof(parallel_job));
+    if (jobs == NULL)
+    {
+        for (size_t part = 0; part < parts; part++)
+            function(context, part, parts);
+        return;
+    }
+
+    latch done;
+    pthread_mutex_init(&done.mutex, NULL);
+    pthread_cond_init(&done.done_cond, NULL);
+    done.count = parts;
+
+    for (size_t part = 0; part < parts; part++)
+    {
+        jobs[part] = (parallel_job){ function, context, part, parts, &done };
+        struct task task = { run_parallel_job, &jobs[part] };
+        if (!threadpool_add(tp, &task))
+            run_parallel_job(&jobs[part]);
+    }
+
+    pthread_mutex_lock(&done.mutex);
+    while (done.count > 0)
+        pthread_cond_wait(&done.done_cond, &done.mutex);
+    pthread_mutex_unlock(&done.mutex);
+
+    pthread_mutex_destroy(&done.mutex);
+    pthread_cond_destroy(&done.done_cond);
+    free(jobs);
+}
@@ -0,0 +1,45 @@
+#ifndef HASHTABLE_PARALLEL_H
+#define HASHTABLE_PARALLEL_H
+
+#include "hashtable.h"
+#include "threadpool.h"
+
+#include <stddef.h>
+
+/**
+ * @brief inserts or updates every entry of an array using the threads of `tp`,
+ * with the same result as `hashtable_put_many`: a key repeated in the array keeps
+ * the value of its last entry. The table is grown once for all the entries, then
+ * every thread hashes a slice of the array and links the pairs of its own range of
+ * buckets, so no bucket is ever touched by two threads and no lock is taken.
+ * The calling thread waits for the whole build, `tp` must not be running tasks
+ * that wait on it. Tables with expiring pairs are always built on the calling thread.
+ *
+ * @param ht pointer to the hashtable you want to insert the pairs into
+ * @param entries array of pairs to insert
+ * @param n number of entries in the array
+ * @param tp threadpool running the build, NULL to build on the calling thread
+ * @return true if every entry was stored
+ * @return false if an entry is invalid (nothing is stored) or an allocation failed
+ * (some entries may have been stored)
+ */
+bool hashtable_build_parallel(hashtable *ht, const hashtable_entry *entries, const size_t n, threadpool *tp);
+
+/**
+ * @brief rehashes resizes of at least `HASHTABLE_PARALLEL_REHASH_MIN` buckets on the
+ * threads of `tp`, each thread moving the chains of its own range of buckets.
+ * Incremental resizes are not affected. The threadpool must outlive the hashtable,
+ * or be unset with NULL first.
+ * A put or remove that triggers such a resize waits for the threads of `tp`, like
+ * `hashtable_build_parallel`: run from a task of `tp` it deadlocks when no other
+ * thread of `tp` ever gets free, e.g. a pool of one thread or the others waiting on
+ * that task. `tp` must not be running tasks that modify the table.
+ *
+ * @param ht pointer to the hashtable
+ * @param tp threadpool running the rehashes, NULL to rehash on the calling thread
+ * @return true if the threadpool was set
+ * @return false if an error occurred (e.g., invalid hashtable pointer)
+ */
+bool hashtable_set_threadpool(hashtable *ht, threadpool *tp);
+
+#endif // HASHTABLE_PARALLEL_H
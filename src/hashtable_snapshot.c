@@ -0,0 +1,340 @@
+#define _DEFAULT_SOURCE
+
+#include "hashtable_snapshot.h"
+#include "mapped_file.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#define SNAPSHOT_ALIGN(size) (((size) + 7) & ~(size_t)7)
+#define ENTRY_SIZE(key_size, value_size) \
+    (sizeof(hashtable_snapshot_entry) + SNAPSHOT_ALIGN(key_size) + SNAPSHOT_ALIGN(value_size))
+
+/* what `hashtable_save` writes */
+typedef struct
+{
+    const hashtable  *ht;
+    hashtable_pair  **pairs;       // sorted by snapshot bucket
+    size_t            pair_number;
+} snapshot_source;
+
+static hashtable_pair **collect_pairs(const hashtable *ht, size_t *pair_number);
+static bool write_padded(FILE *file, const void *data, const size_t size, uint64_t *checksum);
+static bool write_snapshot(FILE *file, const void *sourcep);
+static hashtable_snapshot *map_snapshot(const char *path, const bool seeded);
+static uint64_t header_checksum(const hashtable_snapshot_header *header);
+static const hashtable_snapshot_entry *next_entry(const hashtable_snapshot *snapshot,
+                                                  size_t *position, const size_t end);
+
+bool hashtable_save(const hashtable *ht, const char *path)
+{
+    if (ht == NULL || path == NULL)
+        return false;
+
+    snapshot_source source = { .ht = ht };
+    source.pairs = collect_pairs(ht, &source.pair_number);
+    if (source.pairs == NULL)
+        return false;
+
+    bool saved = mapped_file_write(path, write_snapshot, &source);
+    free(source.pairs);
+    return saved;
+}
+
+hashtable_snapshot *hashtable_open_mmap(const char *path,
+                                        size_t (*hash_function)(void *key),
+                                        size_t (*compare_key_function)(const void *key1, const void *key2))
+{
+    if (path == NULL || hash_function == NULL || compare_key_function == NULL)
+        return NULL;
+
+    hashtable_snapshot *snapshot = map_snapshot(path, false);
+    if (snapshot == NULL) return NULL;
+
+    snapshot->hash_function = hash_function;
+    snapshot->compare_key_function = compare_key_function;
+
+    return snapshot;
+}
+
+hashtable_snapshot *hashtable_open_mmap_seeded(const char *path,
+                                               size_t (*hash_function)(const void *key, const size_t key_size, const uint64_t seed),
+                                               size_t (*compare_key_function)(const void *key1, const void *key2, const size_t key_size))
+{
+    if (path == NULL || hash_function == NULL || compare_key_function == NULL)
+        return NULL;
+
+    hashtable_snapshot *snapshot = map_snapshot(path, true);
+    if (snapshot == NULL) return NULL;
+
+    snapshot->seeded_hash_function = hash_function;
+    snapshot->sized_compare_key_function = compare_key_function;
+
+    return snapshot;
+}
+
+const void *hashtable_snapshot_get(const hashtable_snapshot *snapshot, const void *key, size_t *value_size)
+{
+    if (snapshot == NULL || key == NULL)
+        return NULL;
+
+    bool seeded = snapshot->seeded_hash_function != NULL;
+    uint64_t hash = seeded ? snapshot->seeded_hash_function(key, snapshot->key_size, snapshot->seed)
+                           : snapshot->hash_function((void *)key);
+
+    size_t bucket = hash & (snapshot->buckets_size - 1);
+    size_t position = snapshot->offsets[bucket];
+    size_t end = snapshot->offsets[bucket + 1];
+    if (position > end || end > snapshot->map_size)
+        return NULL;
+
+    const hashtable_snapshot_entry *entry;
+    while ((entry = next_entry(snapshot, &position, end)) != NULL)
+    {
+        if (entry->hash != hash)
+            continue;
+
+        const unsigned char *stored_key = (const unsigned char *)(entry + 1);
+        bool equal = seeded ? snapshot->sized_compare_key_function(stored_key, key, snapshot->key_size) == 0
+                            : snapshot->compare_key_function(stored_key, key) == 0;
+        if (equal)
+        {
+            if (value_size != NULL)
+                *value_size = entry->value_size;
+            return stored_key + SNAPSHOT_ALIGN(entry->key_size);
+        }
+    }
+
+    return NULL;
+}
+
+bool hashtable_snapshot_size(const hashtable_snapshot *snapshot, size_t *size)
+{
+    if (snapshot == NULL || size == NULL)
+        return false;
+    *size = snapshot->pair_number;
+    return true;
+}
+
+bool hashtable_snapshot_verify(const hashtable_snapshot *snapshot)
+{
+    if (snapshot == NULL)
+        return false;
+
+    const hashtable_snapshot_header *header = (const hashtable_snapshot_header *)snapshot->map;
+    uint64_t checksum = hash_bytes(snapshot->offsets, (snapshot->buckets_size + 1) * sizeof(uint64_t), 0);
+    size_t entries_start = sizeof(hashtable_snapshot_header) + (snapshot->buckets_size + 1) * sizeof(uint64_t);
+    size_t pair_number = 0;
+
+    if (snapshot->offsets[0] != entries_start || snapshot->offsets[snapshot->buckets_size] != snapshot->map_size)
+        return false;
+
+    for (size_t bucket = 0; bucket < snapshot->buckets_size; bucket++)
+    {
+        size_t position = snapshot->offsets[bucket];
+        size_t end = snapshot->offsets[bucket + 1];
+        if (position > end || end > snapshot->map_size)
+            return false;
+
+        const hashtable_snapshot_entry *entry;
+        while ((entry = next_entry(snapshot, &position, end)) != NULL)
+        {
+            // zero sizes would make hash_bytes fall back to strlen
+            if (entry->key_size == 0 || entry->value_size == 0 ||
+                (entry->hash & (snapshot->buckets_size - 1)) != bucket)
+                return false;
+
+            const unsigned char *stored_key = (const unsigned char *)(entry + 1);
+            checksum = hash_bytes(entry, sizeof(hashtable_snapshot_entry), checksum);
+            checksum = hash_bytes(stored_key, entry->key_size, checksum);
+            checksum = hash_bytes(stored_key + SNAPSHOT_ALIGN(entry->key_size), entry->value_size, checksum);
+            pair_number++;
+        }
+        // a truncated entry stops next_entry before the end of the bucket
+        if (position != end)
+            return false;
+    }
+
+    return pair_number == snapshot->pair_number && checksum == header->checksum;
+}
+
+void hashtable_snapshot_close(hashtable_snapshot *snapshot)
+{
+    if (snapshot == NULL)
+        return;
+
+    munmap((void *)snapshot->map, snapshot->map_size);
+    free(snapshot);
+}
+
+/**
+ * the pairs of `ht` that haven't expired, ordered by the bucket they go to in the
+ * snapshot, an array of at least one element so an empty table is not an error
+ */
+static hashtable_pair **collect_pairs(const hashtable *ht, size_t *pair_number)
+{
+    /* every pair is checked once, the clock may tick while the table is walked */
+    hashtable_pair **live = malloc((ht->pair_number + 1) * sizeof(hashtable_pair *));
+    if (live == NULL)
+        return NULL;
+
+    /* both arrays, an incremental resize may be in progress */
+    size_t n = 0;
+    hashtable_pair **arrays[] = { ht->buckets, ht->old_buckets };
+    size_t sizes[] = { ht->buckets_size, ht->old_buckets == NULL ? 0 : ht->old_buckets_size };
+    for (size_t a = 0; a < 2; a++)
+        for (size_t i = 0; i < sizes[a]; i++)
+            for (hashtable_pair *pair = arrays[a][i]; pair != NULL; pair = pair->next)
+                if (!hashtable_pair_expired(ht, pair))
+                    live[n++] = pair;
+
+    size_t buckets_size = 1;
+    while (buckets_size < n)
+        buckets_size *= 2;
+
+    hashtable_pair **pairs = malloc((n + 1) * sizeof(hashtable_pair *));
+    size_t *positions = calloc(buckets_size + 1, sizeof(size_t));
+    if (pairs == NULL || positions == NULL)
+    {
+        free(live);
+        free(pairs);
+        free(positions);
+        return NULL;
+    }
+
+    /* counting sort by snapshot bucket */
+    for (size_t i = 0; i < n; i++)
+        positions[(live[i]->hash & (buckets_size - 1)) + 1]++;
+    for (size_t bucket = 0; bucket < buckets_size; bucket++)
+        positions[bucket + 1] += positions[bucket];
+    for (size_t i = 0; i < n; i++)
+        pairs[positions[live[i]->hash & (buckets_size - 1)]++] = live[i];
+
+    *pair_number = n;
+    free(live);
+    free(positions);
+    return pairs;
+}
+
+static bool write_padded(FILE *file, const void *data, const size_t size, uint64_t *checksum)
+{
+    static const unsigned char padding[8] = {0};
+
+    *checksum = hash_bytes(data, size, *checksum);
+    return fwrite(data, 1, size, file) == size &&
+           fwrite(padding, 1, SNAPSHOT_ALIGN(size) - size, file) == SNAPSHOT_ALIGN(size) - size;
+}
+
+/* the header goes last, once the checksum of the rest is known */
+static bool write_snapshot(FILE *file, const void *sourcep)
+{
+    const snapshot_source *source = sourcep;
+    const hashtable *ht = source->ht;
+    hashtable_pair **pairs = source->pairs;
+    size_t pair_number = source->pair_number;
+
+    hashtable_snapshot_header header = {
+        .magic = HASHTABLE_SNAPSHOT_MAGIC,
+        .version = HASHTABLE_SNAPSHOT_VERSION,
+        .flags = ht->seeded_hash_function != NULL ? HASHTABLE_SNAPSHOT_SEEDED : 0,
+        .seed = ht->seed,
+        .key_size = ht->key_size,
+        .pair_number = pair_number,
+        .buckets_size = 1,
+    };
+    while (header.buckets_size < pair_number)
+        header.buckets_size *= 2;
+
+    uint64_t *offsets = malloc((header.buckets_size + 1) * sizeof(uint64_t));
+    if (offsets == NULL)
+        return false;
+
+    /* pairs are sorted by bucket, so every offset is the end of the previous buckets */
+    uint64_t position = sizeof(hashtable_snapshot_header) + (header.buckets_size + 1) * sizeof(uint64_t);
+    size_t p = 0;
+    for (size_t bucket = 0; bucket < header.buckets_size; bucket++)
+    {
+        offsets[bucket] = position;
+        for (; p < pair_number && (pairs[p]->hash & (header.buckets_size - 1)) == bucket; p++)
+            position += ENTRY_SIZE(pairs[p]->key_size, pairs[p]->value_size);
+    }
+    offsets[header.buckets_size] = header.file_size = position;
+
+    /* the checksum starts from 0 and is chained through the offsets and every entry field */
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                   write_padded(file, offsets, (header.buckets_size + 1) * sizeof(uint64_t), &header.checksum);
+    free(offsets);
+
+    for (size_t i = 0; written && i < pair_number; i++)
+    {
+        hashtable_snapshot_entry entry = { pairs[i]->hash, pairs[i]->key_size, pairs[i]->value_size };
+        written = write_padded(file, &entry, sizeof(entry), &header.checksum) &&
+                  write_padded(file, pairs[i]->key, pairs[i]->key_size, &header.checksum) &&
+                  write_padded(file, pairs[i]->value, pairs[i]->value_size, &header.checksum);
+    }
+
+    header.header_checksum = header_checksum(&header);
+    return written && fseek(file, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, file) == 1;
+}
+
+static hashtable_snapshot *map_snapshot(const char *path, const bool seeded)
+{
+    size_t map_size;
+    const void *map = mapped_file_open(path, sizeof(hashtable_snapshot_header), &map_size);
+    if (map == NULL)
+        return NULL;
+
+    const hashtable_snapshot_header *header = map;
+    size_t max_buckets = (map_size - sizeof(hashtable_snapshot_header)) / sizeof(uint64_t);
+    bool valid = header->magic == HASHTABLE_SNAPSHOT_MAGIC &&
+                 header->version == HASHTABLE_SNAPSHOT_VERSION &&
+                 header->header_checksum == header_checksum(header) &&
+                 header->file_size == map_size &&
+                 ((header->flags & HASHTABLE_SNAPSHOT_SEEDED) != 0) == seeded &&
+                 header->buckets_size != 0 && (header->buckets_size & (header->buckets_size - 1)) == 0 &&
+                 header->buckets_size < max_buckets;
+
+    hashtable_snapshot *snapshot = valid ? calloc(1, sizeof(hashtable_snapshot)) : NULL;
+    if (snapshot == NULL)
+    {
+        munmap((void *)map, map_size);
+        return NULL;
+    }
+
+    snapshot->map = map;
+    snapshot->map_size = map_size;
+    snapshot->offsets = (const uint64_t *)(header + 1);
+    snapshot->buckets_size = header->buckets_size;
+    snapshot->pair_number = header->pair_number;
+    snapshot->key_size = header->key_size;
+    snapshot->seed = header->seed;
+
+    return snapshot;
+}
+
+static uint64_t header_checksum(const hashtable_snapshot_header *header)
+{
+    return hash_bytes(header, offsetof(hashtable_snapshot_header, header_checksum), 0);
+}
+
+/**
+ * returns the entry at `position` and moves `position` past it,
+ * NULL once `end` is reached or if the entry doesn't fit before `end`
+ */
+static const hashtable_snapshot_entry *next_entry(const hashtable_snapshot *snapshot,
+                                                  size_t *position, const size_t end)
+{
+    if (end - *position < sizeof(hashtable_snapshot_entry))
+        return NULL;
+
+    const hashtable_snapshot_entry *entry = (const hashtable_snapshot_entry *)(snapshot->map + *position);
+    size_t left = end - *position - sizeof(hashtable_snapshot_entry);
+    if (entry->key_size > left || entry->value_size > left ||
+        SNAPSHOT_ALIGN(entry->key_size) + SNAPSHOT_ALIGN(entry->value_size) > left)
+        return NULL;
+
+    *position += ENTRY_SIZE(entry->key_size, entry->value_size);
+    return entry;
+}
@@ -0,0 +1,139 @@
+#ifndef HASHTABLE_SNAPSHOT_H
+#define HASHTABLE_SNAPSHOT_H
+
+#include "hashtable.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define HASHTABLE_SNAPSHOT_MAGIC   0x50414e5348544843ull // "CHTHSNAP" read in native byte order
+#define HASHTABLE_SNAPSHOT_VERSION 1
+
+#define HASHTABLE_SNAPSHOT_SEEDED 0x1 // saved from a `hashtable_create_seeded` table
+
+/**
+ * a snapshot file is the header, then `buckets_size + 1` offsets and then the
+ * entries grouped by bucket: the entries of bucket i go from offsets[i] to
+ * offsets[i + 1]. Offsets are from the start of the file, so the image can be
+ * mapped at any address. Every field is in native byte order, a file from a
+ * machine with a different byte order is rejected by the magic.
+ */
+typedef struct hashtable_snapshot_header
+{
+    uint64_t magic;
+    uint32_t version;
+    uint32_t flags;
+    uint64_t seed;
+    uint64_t key_size;
+    uint64_t pair_number;
+    uint64_t buckets_size;     // power of two
+    uint64_t file_size;
+    uint64_t checksum;         // offsets and entries, see `hashtable_snapshot_verify`
+    uint64_t header_checksum;  // every field above
+} hashtable_snapshot_header;
+
+/* followed by the key and the value, each padded to 8 bytes */
+typedef struct hashtable_snapshot_entry
+{
+    uint64_t hash;
+    uint64_t key_size;
+    uint64_t value_size;
+} hashtable_snapshot_entry;
+
+typedef struct hashtable_snapshot
+{
+    const unsigned char *map;
+    size_t               map_size;
+    const uint64_t      *offsets;
+    size_t               buckets_size;
+    size_t               pair_number;
+    size_t             (*hash_function)(void *key);
+    size_t             (*compare_key_function)(const void *key1, const void *key2);
+    size_t             (*seeded_hash_function)(const void *key, const size_t key_size, const uint64_t seed);
+    size_t             (*sized_compare_key_function)(const void *key1, const void *key2, const size_t key_size);
+    size_t               key_size;
+    uint64_t             seed;
+} hashtable_snapshot;
+
+/**
+ * @brief writes every pair of the hashtable to a snapshot file that can later be
+ * served with `hashtable_open_mmap`. The file is written next to `path` and renamed
+ * over it once complete, so readers never see a partial snapshot. Expired pairs
+ * are left out, the others are saved without their expiry.
+ *
+ * @param ht pointer to the hashtable to save
+ * @param path path of the snapshot file
+ * @return true if the snapshot was written
+ * @return false if an error occurred (e.g., I/O or memory allocation failure)
+ */
+bool hashtable_save(const hashtable *ht, const char *path);
+
+/**
+ * @brief maps a snapshot saved from a `hashtable_create` table, read only.
+ * Nothing is deserialized: lookups read the mapped file and pages are loaded
+ * on demand, processes opening the same file share them through the page cache.
+ * Only the header is validated, use `hashtable_snapshot_verify` to check the
+ * whole image. Must be closed with `hashtable_snapshot_close`.
+ *
+ * @param path path of the snapshot file
+ * @param hash_function the hash function of the saved hashtable
+ * @param compare_key_function the key comparison function of the saved hashtable
+ * @return hashtable_snapshot* pointer to the mapped snapshot, NULL if it can't be mapped or is invalid
+ */
+hashtable_snapshot *hashtable_open_mmap(const char *path,
+                                        size_t (*hash_function)(void *key),
+                                        size_t (*compare_key_function)(const void *key1, const void *key2));
+
+/**
+ * @brief same as `hashtable_open_mmap`, for a snapshot saved from a
+ * `hashtable_create_seeded` table. The seed and the key size are read from the file.
+ *
+ * @param path path of the snapshot file
+ * @param hash_function the seeded hash function of the saved hashtable
+ * @param compare_key_function the key comparison function of the saved hashtable
+ * @return hashtable_snapshot* pointer to the mapped snapshot, NULL if it can't be mapped or is invalid
+ */
+hashtable_snapshot *hashtable_open_mmap_seeded(const char *path,
+                                               size_t (*hash_function)(const void *key, const size_t key_size, const uint64_t seed),
+                                               size_t (*compare_key_function)(const void *key1, const void *key2, const size_t key_size));
+
+/**
+ * @brief retrieves a read only pointer to the value inside the mapped file.
+ * The pointer stays valid until `hashtable_snapshot_close`.
+ *
+ * @param snapshot pointer to the snapshot you want to retrieve the value from
+ * @param key pointer to the first byte of the key
+ * @param value_size pointer to a variable where the size of the value will be stored, can be NULL
+ * @return const void* pointer to the value, or NULL if the key does not exist
+ */
+const void *hashtable_snapshot_get(const hashtable_snapshot *snapshot, const void *key, size_t *value_size);
+
+/**
+ * @brief returns the number of pairs in the snapshot.
+ *
+ * @param snapshot pointer to the snapshot you want to get the size of
+ * @param size pointer to a variable where the size will be stored
+ * @return true if the size was successfully retrieved
+ * @return false if an error occurred (e.g., invalid snapshot pointer)
+ */
+bool hashtable_snapshot_size(const hashtable_snapshot *snapshot, size_t *size);
+
+/**
+ * @brief reads the whole image and checks its checksum and structure.
+ * This touches every page of the file, call it when the snapshot comes from an
+ * untrusted source rather than on every start.
+ *
+ * @param snapshot pointer to the snapshot to verify
+ * @return true if the image is intact
+ * @return false if the image is corrupted
+ */
+bool hashtable_snapshot_verify(const hashtable_snapshot *snapshot);
+
+/**
+ * @brief unmaps the snapshot, every pointer returned by `hashtable_snapshot_get` becomes invalid.
+ *
+ * @param snapshot pointer to the snapshot to close
+ */
+void hashtable_snapshot_close(hashtable_snapshot *snapshot);
+
+#endif // HASHTABLE_SNAPSHOT_H
@@ -0,0 +1,233 @@
+#ifndef HASHTABLE_TYPED_H
+#define HASHTABLE_TYPED_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#define HASHTABLE_TYPED_INITIAL_CAPACITY 16 // power of two
+
+/**
+ * control byte of a slot: 0 when empty, otherwise the high bit set and the top
+ * 7 bits of the hash, the low bits already select the slot
+ */
+#define HASHTABLE_TYPED_CTRL_EMPTY 0
+#define HASHTABLE_TYPED_CTRL(hash) ((unsigned char)(0x80 | ((hash) >> (sizeof(size_t) * 8 - 7))))
+
+/**
+ * ready made hash and equality functions for integer keys, `HASHTABLE_DECLARE`
+ * accepts function-like macros as well, so `HASHTABLE_TYPED_EQUAL` works for any
+ * key type comparable with `==`
+ */
+static inline size_t hashtable_typed_hash_int(const uint64_t key)
+{
+    // murmur3 64 bit finalizer
+    uint64_t k = key;
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdull;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53ull;
+    k ^= k >> 33;
+    return (size_t)k;
+}
+
+#define HASHTABLE_TYPED_EQUAL(key1, key2) ((key1) == (key2))
+
+/**
+ * @brief declares a hashtable type `name` mapping `key_t` to `value_t` and its
+ * functions, all `static inline` so the hash and equality functions are inlined
+ * into every operation. Keys and values are stored by value in a single open
+ * addressing array probed linearly, removals shift the following pairs back so
+ * the table never accumulates tombstones.
+ *
+ * The generated API, `value_t *` results are borrowed and valid until the next
+ * put/remove/destroy:
+ *   name  *name_create(void);
+ *   bool   name_reserve(name *ht, size_t capacity);
+ *   bool   name_put(name *ht, key_t key, value_t value);
+ *   value_t *name_get(const name *ht, key_t key);
+ *   bool   name_remove(name *ht, key_t key);
+ *   bool   name_size(const name *ht, size_t *size);
+ *   void   name_destroy(name *ht);
+ *
+ * @param name name of the generated type, prefix of the generated functions
+ * @param key_t key type
+ * @param value_t value type
+ * @param hash_fn `size_t hash_fn(key_t key)`, function or function-like macro
+ * @param eq_fn `bool eq_fn(key_t key1, key_t key2)`, function or function-like macro
+ */
+#define HASHTABLE_DECLARE(name, key_t, value_t, hash_fn, eq_fn)                                   \
+                                                                                                  \
+typedef struct name##_slot                                                                        \
+{                                                                                                 \
+    key_t   key;                                                                                  \
+    value_t value;                                                                                \
+} name##_slot;                                                                                    \
+                                                                                                  \
+typedef struct name                                                                               \
+{                                                                                                 \
+    unsigned char *ctrl;                                                                          \
+    name##_slot   *slots;                                                                         \
+    size_t         capacity;                                                                      \
+    size_t         pair_number;                                                                   \
+} name;                                                                                           \
+                                                                                                  \
+/* index of the slot holding `key`, or of the empty slot ending its probe sequence */             \
+static inline size_t name##_probe(const name *ht, const key_t key, const size_t hash)            \
+{                                                                                                 \
+    const size_t mask = ht->capacity - 1;                                                         \
+    const unsigned char tag = HASHTABLE_TYPED_CTRL(hash);                                         \
+    size_t index = hash & mask;                                                                   \
+                                                                                                  \
+    while (ht->ctrl[index] != HASHTABLE_TYPED_CTRL_EMPTY)                                         \
+    {                                                                                             \
+        if (ht->ctrl[index] == tag && eq_fn(ht->slots[index].key, key))                           \
+            return index;                                                                         \
+        index = (index + 1) & mask;                                                               \
+    }                                                                                             \
+    return index;                                                                                 \
+}                                                                                                 \
+                                                                                                  \
+static inline bool name##_rehash(name *ht, const size_t new_capacity)                            \
+{                                                                                                 \
+    unsigned char *new_ctrl = calloc(new_capacity, sizeof(unsigned char));                        \
+    name##_slot *new_slots = malloc(new_capacity * sizeof(name##_slot));                          \
+    if (new_ctrl == NULL || new_slots == NULL)                                                    \
+    {                                                                                             \
+        free(new_ctrl);                                                                           \
+        free(new_slots);                                                                          \
+        return false;                                                                             \
+    }                                                                                             \
+                                                                                                  \
+    name new_ht = { new_ctrl, new_slots, new_capacity, ht->pair_number };                        \
+    for (size_t i = 0; i < ht->capacity; i++)                                                     \
+    {                                                                                             \
+        if (ht->ctrl[i] == HASHTABLE_TYPED_CTRL_EMPTY)                                            \
+            continue;                                                                             \
+        size_t hash = hash_fn(ht->slots[i].key);                                                  \
+        size_t index = hash & (new_capacity - 1);                                                 \
+        while (new_ctrl[index] != HASHTABLE_TYPED_CTRL_EMPTY)                                     \
+            index = (index + 1) & (new_capacity - 1);                                             \
+        new_ctrl[index] = HASHTABLE_TYPED_CTRL(hash);                                             \
+        new_slots[index] = ht->slots[i];                                                          \
+    }                                                                                             \
+                                                                                                  \
+    free(ht->ctrl);                                                                               \
+    free(ht->slots);                                                                              \
+    *ht = new_ht;                                                                                 \
+    return true;                                                                                  \
+}                                                                                                 \
+                                                                                                  \
+static inline name *name##_create(void)                                                           \
+{                                                                                                 \
+    name *ht = malloc(sizeof(name));                                                              \
+    if (ht == NULL) return NULL;                                                                  \
+                                                                                                  \
+    *ht = (name){ NULL, NULL, 0, 0 };                                                             \
+    if (!name##_rehash(ht, HASHTABLE_TYPED_INITIAL_CAPACITY))                                     \
+    {                                                                                             \
+        free(ht);                                                                                 \
+        return NULL;                                                                              \
+    }                                                                                             \
+    return ht;                                                                                    \
+}                                                                                                 \
+                                                                                                  \
+/* keeps the load factor at or below 3/4, linear probing degrades quickly above it */            \
+static inline bool name##_reserve(name *ht, const size_t capacity)                                \
+{                                                                                                 \
+    if (ht == NULL)                                                                               \
+        return false;                                                                             \
+                                                                                                  \
+    size_t new_capacity = ht->capacity;                                                           \
+    while (capacity > new_capacity / 4 * 3)                                                       \
+    {                                                                                             \
+        if (new_capacity > SIZE_MAX / 2 / sizeof(name##_slot))                                    \
+            return false;                                                                         \
+        new_capacity *= 2;                                                                        \
+    }                                                                                             \
+    return new_capacity == ht->capacity || name##_rehash(ht, new_capacity);                       \
+}                                                                                                 \
+                                                                                                  \
+static inline bool name##_put(name *ht, const key_t key, const value_t value)                     \
+{                                                                                                 \
+    if (ht == NULL)                                                                               \
+        return false;                                                                             \
+                                                                                                  \
+    size_t hash = hash_fn(key);                                                                   \
+    size_t index = name##_probe(ht, key, hash);                                                   \
+    if (ht->ctrl[index] != HASHTABLE_TYPED_CTRL_EMPTY)                                            \
+    {                                                                                             \
+        ht->slots[index].value = value;                                                           \
+        return true;                                                                              \
+    }                                                                                             \
+                                                                                                  \
+    if (ht->pair_number + 1 > ht->capacity / 4 * 3)                                               \
+    {                                                                                             \
+        if (!name##_reserve(ht, ht->pair_number + 1))                                             \
+            return false;                                                                         \
+        index = name##_probe(ht, key, hash);                                                      \
+    }                                                                                             \
+                                                                                                  \
+    ht->ctrl[index] = HASHTABLE_TYPED_CTRL(hash);                                                 \
+    ht->slots[index] = (name##_slot){ key, value };                                               \
+    ht->pair_number++;                                                                            \
+    return true;                                                                                  \
+}                                                                                                 \
+                                                                                                  \
+static inline value_t *name##_get(const name *ht, const key_t key)                                \
+{                                                                                                 \
+    if (ht == NULL)                                                                               \
+        return NULL;                                                                              \
+                                                                                                  \
+    size_t index = name##_probe(ht, key, hash_fn(key));                                           \
+    if (ht->ctrl[index] == HASHTABLE_TYPED_CTRL_EMPTY)                                            \
+        return NULL;                                                                              \
+    return &ht->slots[index].value;                                                               \
+}                                                                                                 \
+                                                                                                  \
+static inline bool name##_remove(name *ht, const key_t key)                                       \
+{                                                                                                 \
+    if (ht == NULL)                                                                               \
+        return false;                                                                             \
+                                                                                                  \
+    const size_t mask = ht->capacity - 1;                                                         \
+    size_t hole = name##_probe(ht, key, hash_fn(key));                                            \
+    if (ht->ctrl[hole] == HASHTABLE_TYPED_CTRL_EMPTY)                                             \
+        return false;                                                                             \
+                                                                                                  \
+    /* backward shift: move back every following pair that may fill the hole */                  \
+    for (size_t index = (hole + 1) & mask; ht->ctrl[index] != HASHTABLE_TYPED_CTRL_EMPTY;         \
+         index = (index + 1) & mask)                                                              \
+    {                                                                                             \
+        size_t home = hash_fn(ht->slots[index].key) & mask;                                       \
+        if (((index - home) & mask) >= ((index - hole) & mask))                                   \
+        {                                                                                         \
+            ht->ctrl[hole] = ht->ctrl[index];                                                     \
+            ht->slots[hole] = ht->slots[index];                                                   \
+            hole = index;                                                                         \
+        }                                                                                         \
+    }                                                                                             \
+                                                                                                  \
+    ht->ctrl[hole] = HASHTABLE_TYPED_CTRL_EMPTY;                                                  \
+    ht->pair_number--;                                                                            \
+    return true;                                                                                  \
+}                                                                                                 \
+                                                                                                  \
+static inline bool name##_size(const name *ht, size_t *size)                                      \
+{                                                                                                 \
+    if (ht == NULL || size == NULL)                                                               \
+        return false;                                                                             \
+    *size = ht->pair_number;                                                                      \
+    return true;                                                                                  \
+}                                                                                                 \
+                                                                                                  \
+static inline void name##_destroy(name *ht)                                                       \
+{                                                                                                 \
+    if (ht == NULL)                                                                               \
+        return;                                                                                   \
+    free(ht->ctrl);                                                                               \
+    free(ht->slots);                                                                              \
+    free(ht);                                                                                     \
+}
+
+#endif // HASHTABLE_TYPED_H
@@ -0,0 +1,87 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+/**
+ * file helpers shared by the modules that write an image to disk and serve it
+ * mapped read only (`hashtable_snapshot`, `hashtable_frozen`). Header only, the
+ * including translation unit must define `_DEFAULT_SOURCE` for `madvise`.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/**
+ * @brief writes a file through `write` without ever exposing a partial one: the
+ * content goes to `path` followed by ".tmp", is synced, and then renamed over `path`.
+ *
+ * @param path path of the file to write
+ * @param write writes the whole content to `file`, returns false on failure
+ * @param context pointer passed untouched to `write`
+ * @return true if the file was written and renamed
+ * @return false if an error occurred, `path` is left as it was
+ */
+static inline bool mapped_file_write(const char *path, bool (*write)(FILE *file, const void *context),
+                                     const void *context)
+{
+    size_t path_length = strlen(path);
+    char *temporary_path = malloc(path_length + sizeof(".tmp"));
+    if (temporary_path == NULL)
+        return false;
+    memcpy(temporary_path, path, path_length);
+    memcpy(temporary_path + path_length, ".tmp", sizeof(".tmp"));
+
+    bool saved = false;
+    FILE *file = fopen(temporary_path, "wb");
+    if (file != NULL)
+    {
+        saved = write(file, context) && fflush(file) == 0 && fsync(fileno(file)) == 0;
+        saved = fclose(file) == 0 && saved;
+        saved = saved && rename(temporary_path, path) == 0;
+        if (!saved)
+            remove(temporary_path);
+    }
+
+    free(temporary_path);
+    return saved;
+}
+
+/**
+ * @brief maps a whole file read only, for random lookups.
+ *
+ * @param path path of the file to map
+ * @param min_size files smaller than this are rejected
+ * @param size pointer to a variable where the size of the mapping will be stored
+ * @return const void* start of the mapping, to be released with `munmap`, or NULL
+ * if the file can't be opened or mapped or is too small
+ */
+static inline const void *mapped_file_open(const char *path, const size_t min_size, size_t *size)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd == -1)
+        return NULL;
+
+    struct stat st;
+    if (fstat(fd, &st) == -1 || (size_t)st.st_size < min_size)
+    {
+        close(fd);
+        return NULL;
+    }
+
+    void *map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd); // the mapping keeps the file referenced
+    if (map == MAP_FAILED)
+        return NULL;
+
+    /* lookups jump around the file, readahead would only load useless pages */
+    madvise(map, st.st_size, MADV_RANDOM);
+
+    *size = st.st_size;
+    return map;
+}
+
+#endif // MAPPED_FILE_H
@@ -0,0 +1,343 @@
+#include "priority_queue.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define POSITION_NONE SIZE_MAX
+
+#define ELEMENT(pq, index) ((pq)->elements + (index) * (pq)->elem_size)
+#define PARENT(pq, index) (((index) - 1) >> (pq)->arity_shift)
+#define FIRST_CHILD(pq, index) (((index) << (pq)->arity_shift) + 1)
+
+static priority_queue *create_priority_queue(const size_t elem_size, const size_t arity,
+                                             int (*compare)(const void *elem1, const void *elem2),
+                                             const bool tracked);
+static bool reserve(priority_queue *pq, const size_t capacity);
+static bool grow_array(size_t **array, const size_t capacity);
+static size_t take_handle(priority_queue *pq);
+static void release_handle(priority_queue *pq, const size_t handle);
+static void append(priority_queue *pq, const void *elem, priority_queue_handle *handle);
+static void move_element(priority_queue *pq, const size_t to, const size_t from);
+static size_t sift_up(priority_queue *pq, size_t index);
+static void sift_down(priority_queue *pq, size_t index);
+static void remove_at(priority_queue *pq, const size_t index, void *out);
+
+priority_queue *priority_queue_create(const size_t elem_size, const size_t arity,
+                                      int (*compare)(const void *elem1, const void *elem2))
+{
+    return create_priority_queue(elem_size, arity, compare, false);
+}
+
+priority_queue *priority_queue_create_tracked(const size_t elem_size, const size_t arity,
+                                              int (*compare)(const void *elem1, const void *elem2))
+{
+    return create_priority_queue(elem_size, arity, compare, true);
+}
+
+bool priority_queue_push(priority_queue *pq, const void *elem, priority_queue_handle *handle)
+{
+    if (pq == NULL || elem == NULL || (handle != NULL && pq->handles == NULL))
+        return false;
+    if (pq->size == pq->capacity && !reserve(pq, pq->capacity * 2))
+        return false;
+
+    append(pq, elem, handle);
+    sift_up(pq, pq->size - 1);
+    return true;
+}
+
+bool priority_queue_push_n(priority_queue *pq, const void *elems, const size_t n, priority_queue_handle *handles)
+{
+    if (pq == NULL || (elems == NULL && n > 0) || (handles != NULL && pq->handles == NULL))
+        return false;
+    if (n > SIZE_MAX / 2 - pq->size)
+        return false;
+
+    size_t capacity = pq->capacity;
+    while (capacity < pq->size + n)
+        capacity *= 2;
+    if (capacity != pq->capacity && !reserve(pq, capacity))
+        return false;
+
+    size_t old_size = pq->size;
+    for (size_t i = 0; i < n; i++)
+        append(pq, (const unsigned char *)elems + i * pq->elem_size, handles != NULL ? &handles[i] : NULL);
+
+    if (n >= old_size)
+    {
+        /* Floyd's construction: sift down every parent, from the last one up to the root */
+        for (size_t i = pq->size > 1 ? PARENT(pq, pq->size - 1) + 1 : 0; i-- > 0;)
+            sift_down(pq, i);
+    }
+    else
+    {
+        for (size_t i = old_size; i < pq->size; i++)
+            sift_up(pq, i);
+    }
+    return true;
+}
+
+const void *priority_queue_peek(const priority_queue *pq)
+{
+    if (pq == NULL || pq->size == 0)
+        return NULL;
+    return pq->elements;
+}
+
+bool priority_queue_pop(priority_queue *pq, void *out)
+{
+    if (pq == NULL || out == NULL || pq->size == 0)
+        return false;
+
+    remove_at(pq, 0, out);
+    return true;
+}
+
+size_t priority_queue_pop_n(priority_queue *pq, void *out, const size_t max_n)
+{
+    if (pq == NULL || out == NULL)
+        return 0;
+
+    size_t count = max_n < pq->size ? max_n : pq->size;
+    for (size_t i = 0; i < count; i++)
+        remove_at(pq, 0, (unsigned char *)out + i * pq->elem_size);
+    return count;
+}
+
+bool priority_queue_update(priority_queue *pq, const priority_queue_handle handle, const void *elem)
+{
+    if (pq == NULL || elem == NULL || pq->handles == NULL || handle >= pq->handle_number ||
+        pq->positions[handle] == POSITION_NONE)
+        return false;
+
+    size_t index = pq->positions[handle];
+    bool earlier = pq->compare(elem, ELEMENT(pq, index)) < 0;
+    memcpy(ELEMENT(pq, index), elem, pq->elem_size);
+    if (earlier)
+        sift_up(pq, index);
+    else
+        sift_down(pq, index);
+    return true;
+}
+
+bool priority_queue_remove(priority_queue *pq, const priority_queue_handle handle, void *out)
+{
+    if (pq == NULL || pq->handles == NULL || handle >= pq->handle_number || pq->positions[handle] == POSITION_NONE)
+        return false;
+
+    remove_at(pq, pq->positions[handle], out);
+    return true;
+}
+
+bool priority_queue_size(const priority_queue *pq, size_t *size)
+{
+    if (pq == NULL || size == NULL)
+        return false;
+    *size = pq->size;
+    return true;
+}
+
+void priority_queue_destroy(priority_queue *pq)
+{
+    if (pq == NULL)
+        return;
+
+    free(pq->block);
+    free(pq->scratch);
+    free(pq->handles);
+    free(pq->positions);
+    free(pq->free_handles);
+    free(pq);
+}
+
+static priority_queue *create_priority_queue(const size_t elem_size, const size_t arity,
+                                             int (*compare)(const void *elem1, const void *elem2),
+                                             const bool tracked)
+{
+    if (elem_size == 0 || compare == NULL || arity < 2 || arity > PRIORITY_QUEUE_MAX_ARITY || (arity & (arity - 1)) != 0)
+        return NULL;
+
+    priority_queue *pq = calloc(1, sizeof(priority_queue));
+    if (pq == NULL)
+        return NULL;
+
+    pq->elem_size = elem_size;
+    pq->arity = arity;
+    pq->arity_shift = __builtin_ctzll(arity);
+    pq->compare = compare;
+    pq->scratch = malloc(elem_size);
+    if (pq->scratch == NULL || !reserve(pq, PRIORITY_QUEUE_INITIAL_CAPACITY))
+    {
+        free(pq->scratch);
+        free(pq);
+        return NULL;
+    }
+
+    if (tracked)
+    {
+        pq->handles = malloc(pq->capacity * sizeof(size_t));
+        pq->positions = malloc(pq->capacity * sizeof(size_t));
+        pq->free_handles = malloc(pq->capacity * sizeof(size_t));
+        if (pq->handles == NULL || pq->positions == NULL || pq->free_handles == NULL)
+        {
+            priority_queue_destroy(pq);
+            return NULL;
+        }
+    }
+    return pq;
+}
+
+/* the elements move to a new cache aligned block, the handle arrays grow alongside */
+static bool reserve(priority_queue *pq, const size_t capacity)
+{
+    if (capacity > (SIZE_MAX / 2 - pq->arity) / pq->elem_size)
+        return false;
+
+    size_t padding = (pq->arity - 1) * pq->elem_size;
+    size_t block_size = padding + capacity * pq->elem_size;
+    block_size = (block_size + PRIORITY_QUEUE_CACHE_LINE - 1) & ~(size_t)(PRIORITY_QUEUE_CACHE_LINE - 1);
+    unsigned char *block = aligned_alloc(PRIORITY_QUEUE_CACHE_LINE, block_size);
+    if (block == NULL)
+        return false;
+
+    /* an array already grown only has unused room at its end if a later one fails */
+    if (pq->handles != NULL &&
+        (!grow_array(&pq->handles, capacity) || !grow_array(&pq->positions, capacity) ||
+         !grow_array(&pq->free_handles, capacity)))
+    {
+        free(block);
+        return false;
+    }
+
+    if (pq->block != NULL)
+        memcpy(block + padding, pq->elements, pq->size * pq->elem_size);
+    free(pq->block);
+    pq->block = block;
+    pq->elements = block + padding;
+    pq->capacity = capacity;
+    return true;
+}
+
+static bool grow_array(size_t **array, const size_t capacity)
+{
+    size_t *grown = realloc(*array, capacity * sizeof(size_t));
+    if (grown == NULL)
+        return false;
+    *array = grown;
+    return true;
+}
+
+/* a free handle, there are always enough since live handles never outnumber the capacity */
+static size_t take_handle(priority_queue *pq)
+{
+    if (pq->free_handle_number > 0)
+        return pq->free_handles[--pq->free_handle_number];
+    return pq->handle_number++;
+}
+
+static void release_handle(priority_queue *pq, const size_t handle)
+{
+    pq->positions[handle] = POSITION_NONE;
+    pq->free_handles[pq->free_handle_number++] = handle;
+}
+
+/* copies the element after the last one, the heap order is restored by the caller */
+static void append(priority_queue *pq, const void *elem, priority_queue_handle *handle)
+{
+    memcpy(ELEMENT(pq, pq->size), elem, pq->elem_size);
+    if (pq->handles != NULL)
+    {
+        size_t new_handle = take_handle(pq);
+        pq->handles[pq->size] = new_handle;
+        pq->positions[new_handle] = pq->size;
+        if (handle != NULL)
+            *handle = new_handle;
+    }
+    pq->size++;
+}
+
+static void move_element(priority_queue *pq, const size_t to, const size_t from)
+{
+    memcpy(ELEMENT(pq, to), ELEMENT(pq, from), pq->elem_size);
+    if (pq->handles != NULL)
+    {
+        pq->handles[to] = pq->handles[from];
+        pq->positions[pq->handles[to]] = to;
+    }
+}
+
+/**
+ * the element at `index` is held in `scratch` while the ones it passes shift
+ * into the hole it leaves, it's copied once at its final index which is returned
+ */
+static size_t sift_up(priority_queue *pq, size_t index)
+{
+    if (index == 0 || pq->compare(ELEMENT(pq, index), ELEMENT(pq, PARENT(pq, index))) >= 0)
+        return index;
+
+    memcpy(pq->scratch, ELEMENT(pq, index), pq->elem_size);
+    size_t handle = pq->handles != NULL ? pq->handles[index] : 0;
+    do
+    {
+        size_t parent = PARENT(pq, index);
+        move_element(pq, index, parent);
+        index = parent;
+    } while (index > 0 && pq->compare(pq->scratch, ELEMENT(pq, PARENT(pq, index))) < 0);
+
+    memcpy(ELEMENT(pq, index), pq->scratch, pq->elem_size);
+    if (pq->handles != NULL)
+    {
+        pq->handles[index] = handle;
+        pq->positions[handle] = index;
+    }
+    return index;
+}
+
+static void sift_down(priority_queue *pq, size_t index)
+{
+    memcpy(pq->scratch, ELEMENT(pq, index), pq->elem_size);
+    size_t handle = pq->handles != NULL ? pq->handles[index] : 0;
+
+    while (true)
+    {
+        size_t first = FIRST_CHILD(pq, index);
+        if (first >= pq->size)
+            break;
+
+        /* the siblings are contiguous, usually in one cache line */
+        size_t last = first + pq->arity < pq->size ? first + pq->arity : pq->size;
+        size_t best = first;
+        for (size_t child = first + 1; child < last; child++)
+            if (pq->compare(ELEMENT(pq, child), ELEMENT(pq, best)) < 0)
+                best = child;
+
+        if (pq->compare(ELEMENT(pq, best), pq->scratch) >= 0)
+            break;
+        move_element(pq, index, best);
+        index = best;
+    }
+
+    memcpy(ELEMENT(pq, index), pq->scratch, pq->elem_size);
+    if (pq->handles != NULL)
+    {
+        pq->handles[index] = handle;
+        pq->positions[handle] = index;
+    }
+}
+
+/* the last element fills the hole and moves up or down from there */
+static void remove_at(priority_queue *pq, const size_t index, void *out)
+{
+    if (out != NULL)
+        memcpy(out, ELEMENT(pq, index), pq->elem_size);
+    if (pq->handles != NULL)
+        release_handle(pq, pq->handles[index]);
+
+    pq->size--;
+    if (index == pq->size)
+        return;
+
+    move_element(pq, index, pq->size);
+    if (sift_up(pq, index) == index)
+        sift_down(pq, index);
+}
@@ -0,0 +1,161 @@
+#ifndef PRIORITY_QUEUE_H
+#define PRIORITY_QUEUE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define PRIORITY_QUEUE_INITIAL_CAPACITY 16
+#define PRIORITY_QUEUE_CACHE_LINE       64
+#define PRIORITY_QUEUE_MAX_ARITY        16
+
+typedef size_t priority_queue_handle;
+
+/**
+ * an implicit d-ary heap of fixed size elements stored inline: the children of
+ * element `i` are `d * i + 1` to `d * i + d`. The array starts `d - 1` elements
+ * before a cache line boundary, so every group of siblings starts on a multiple of
+ * `d * elem_size`: when that divides the line size, a sift down reads a single
+ * line per level.
+ *
+ * A queue created with `priority_queue_create_tracked` gives every element a
+ * handle: `handles` maps a heap index to its handle, and `positions` a handle to
+ * its heap index, SIZE_MAX when the handle is free.
+ */
+typedef struct priority_queue
+{
+    unsigned char *block;        // allocation holding `elements`
+    unsigned char *elements;
+    size_t         elem_size;
+    size_t         size;
+    size_t         capacity;
+    size_t         arity;        // power of two
+    unsigned int   arity_shift;
+    int          (*compare)(const void *elem1, const void *elem2);
+    unsigned char *scratch;      // the element being sifted
+    size_t        *handles;      // NULL when not tracked
+    size_t        *positions;
+    size_t        *free_handles;
+    size_t         free_handle_number;
+    size_t         handle_number;  // handles given out at least once
+} priority_queue;
+
+/**
+ * @brief creates a new empty priority queue of elements of `elem_size` bytes.
+ * Allocated memory from the queue must be freed with `priority_queue_destroy`.
+ *
+ * @param elem_size size of every element in bytes
+ * @param arity number of children of every node, a power of two from 2 to
+ * `PRIORITY_QUEUE_MAX_ARITY`: 4 or 8 keep the tree shallow while the siblings
+ * compared at each level share a cache line, 2 is a binary heap
+ * @param compare returns a negative value if `elem1` comes out before `elem2`,
+ * positive if after, 0 if they are equivalent, like `qsort`: a min-heap
+ * @return priority_queue* pointer to the newly created queue, or NULL if an error occurred
+ */
+priority_queue *priority_queue_create(const size_t elem_size, const size_t arity,
+                                      int (*compare)(const void *elem1, const void *elem2));
+
+/**
+ * @brief same as `priority_queue_create`, every pushed element also gets a handle
+ * that stays valid until the element leaves the queue, to update or remove it
+ * wherever it moved to.
+ */
+priority_queue *priority_queue_create_tracked(const size_t elem_size, const size_t arity,
+                                              int (*compare)(const void *elem1, const void *elem2));
+
+/**
+ * @brief inserts a copy of an element.
+ *
+ * @param pq pointer to the queue
+ * @param elem pointer to the `elem_size` bytes to insert
+ * @param handle pointer to a variable where the handle of the element will be
+ * stored, can be NULL. Only allowed with a tracked queue
+ * @return true if the element was inserted
+ * @return false if an error occurred (e.g., memory allocation failure)
+ */
+bool priority_queue_push(priority_queue *pq, const void *elem, priority_queue_handle *handle);
+
+/**
+ * @brief inserts copies of `n` consecutive elements. When they are at least as
+ * many as the elements already queued the whole heap is rebuilt bottom up in
+ * linear time, so pushing an array into an empty queue heapifies it.
+ *
+ * @param pq pointer to the queue
+ * @param elems pointer to `n` elements of `elem_size` bytes
+ * @param n number of elements to insert
+ * @param handles pointer to `n` variables where the handles will be stored, can
+ * be NULL. Only allowed with a tracked queue
+ * @return true if every element was inserted
+ * @return false if an error occurred, nothing was inserted
+ */
+bool priority_queue_push_n(priority_queue *pq, const void *elems, const size_t n, priority_queue_handle *handles);
+
+/**
+ * @brief returns the element that comes out first, without removing it.
+ *
+ * @param pq pointer to the queue
+ * @return const void* pointer to the element, valid until the queue is modified,
+ * or NULL if the queue is empty
+ */
+const void *priority_queue_peek(const priority_queue *pq);
+
+/**
+ * @brief removes the element that comes out first, copying it into caller storage.
+ *
+ * @param pq pointer to the queue
+ * @param out pointer to a buffer of at least `elem_size` bytes
+ * @return true if an element was removed
+ * @return false if the queue is empty or an argument is invalid
+ */
+bool priority_queue_pop(priority_queue *pq, void *out);
+
+/**
+ * @brief removes up to `max_n` elements in order, copying them into caller storage.
+ *
+ * @param pq pointer to the queue
+ * @param out pointer to a buffer of at least `max_n * elem_size` bytes
+ * @param max_n maximum number of elements to remove
+ * @return size_t number of elements removed
+ */
+size_t priority_queue_pop_n(priority_queue *pq, void *out, const size_t max_n);
+
+/**
+ * @brief replaces the element of a handle and moves it to its new place, up when
+ * it now comes out earlier (decrease-key in a min-heap) or down when later.
+ *
+ * @param pq pointer to the tracked queue
+ * @param handle handle of the element, as returned by the push
+ * @param elem pointer to the `elem_size` bytes of the new element
+ * @return true if the element was updated
+ * @return false if the handle isn't in the queue or an argument is invalid
+ */
+bool priority_queue_update(priority_queue *pq, const priority_queue_handle handle, const void *elem);
+
+/**
+ * @brief removes the element of a handle wherever it is in the queue.
+ *
+ * @param pq pointer to the tracked queue
+ * @param handle handle of the element
+ * @param out pointer to a buffer of at least `elem_size` bytes, can be NULL
+ * @return true if the element was removed
+ * @return false if the handle isn't in the queue or an argument is invalid
+ */
+bool priority_queue_remove(priority_queue *pq, const priority_queue_handle handle, void *out);
+
+/**
+ * @brief returns the number of elements in the queue.
+ *
+ * @param pq pointer to the queue
+ * @param size pointer to a variable where the size will be stored
+ * @return true if the size was successfully retrieved
+ * @return false if an error occurred (e.g., invalid queue pointer)
+ */
+bool priority_queue_size(const priority_queue *pq, size_t *size);
+
+/**
+ * @brief frees the queue and its elements.
+ *
+ * @param pq pointer to the queue to destroy
+ */
+void priority_queue_destroy(priority_queue *pq);
+
+#endif // PRIORITY_QUEUE_H
@@ -1,8 +1,15 @@
 #include "queue.h"
 
 #include <string.h>
+#include <stdint.h>
+
+#define RING_SLOT(q, index) ((q)->ring + ((index) & ((q)->capacity - 1)) * (q)->elem_size)
+#define MPMC_CELL(q, position) ((q)->cells + ((position) & ((q)->capacity - 1)) * (q)->cell_size)
+#define MPMC_SEQUENCE(cell) ((_Atomic size_t *)(cell))
+#define MPMC_DATA(cell) ((cell) + sizeof(_Atomic size_t))
 
 void free_nodes(queue_node *);
+static bool grow_ring(queue *q);
 
 queue *queue_create()
 {
@@ -11,6 +18,31 @@ queue *queue_create()
 
     q->head = q->tail = NULL;
     q->size = 0;
+    q->ring = NULL;
+    q->elem_size = q->capacity = q->first = 0;
+
+    return q;
+}
+
+queue *queue_create_fixed(const size_t elem_size, const size_t capacity_hint)
+{
+    if (elem_size == 0) return NULL;
+
+    size_t capacity = QUEUE_FIXED_MIN_CAPACITY;
+    while (capacity < capacity_hint && capacity <= SIZE_MAX / 2 / elem_size)
+        capacity *= 2;
+
+    queue *q = queue_create();
+    if (q == NULL) return NULL;
+
+    q->ring = malloc(capacity * elem_size);
+    if (q->ring == NULL)
+    {
+        free(q);
+        return NULL;
+    }
+    q->elem_size = elem_size;
+    q->capacity = capacity;
 
     return q;
 }
@@ -20,6 +52,16 @@ bool queue_enque(queue *q, const void *data, const size_t size)
     if (q == NULL || data == NULL || size <= 0)
         return false;
 
+    if (q->ring != NULL)
+    {
+        if (size != q->elem_size) return false;
+        if (q->size == q->capacity && !grow_ring(q)) return false;
+
+        memcpy(RING_SLOT(q, q->first + q->size), data, size);
+        q->size++;
+        return true;
+    }
+
     queue_node *new_node = malloc(sizeof(queue_node));
     if (new_node == NULL) return false;
 
@@ -44,8 +86,26 @@ void *queue_deque(queue *q)
     if (q == NULL || q->size <= 0)
         return NULL;
 
-    void *out = malloc(q->head->size);
+    void *out = malloc(q->ring != NULL ? q->elem_size : q->head->size);
     if (out == NULL) return NULL;
+    queue_deque_into(q, out);
+
+    return out;
+}
+
+bool queue_deque_into(queue *q, void *out)
+{
+    if (q == NULL || out == NULL || q->size <= 0)
+        return false;
+
+    if (q->ring != NULL)
+    {
+        memcpy(out, RING_SLOT(q, q->first), q->elem_size);
+        q->first = (q->first + 1) & (q->capacity - 1);
+        q->size--;
+        return true;
+    }
+
     memcpy(out, q->head->data, q->head->size);
 
     queue_node *tmp = q->head;
@@ -57,7 +117,7 @@ void *queue_deque(queue *q)
     free(tmp);
     q->size--;
 
-    return out;
+    return true;
 }
 
 int queue_size(const queue *q)
@@ -71,9 +131,143 @@ void queue_destroy(queue *q)
     if (q == NULL) return;
 
     free_nodes(q->head);
+    free(q->ring);
+    free(q);
+}
+
+mpmc_queue *mpmc_queue_create(const size_t elem_size, const size_t capacity)
+{
+    if (elem_size == 0 || capacity == 0) return NULL;
+
+    /* the sequence of the next cell stays aligned */
+    size_t cell_size = (sizeof(_Atomic size_t) + elem_size + alignof(_Atomic size_t) - 1) & ~(alignof(_Atomic size_t) - 1);
+    if (cell_size < elem_size || capacity > SIZE_MAX / 2 / cell_size) return NULL;
+
+    /* at least 2 cells, with one the sequence of a full cell and of a free one are the same */
+    size_t ring_capacity = 2;
+    while (ring_capacity < capacity)
+        ring_capacity *= 2;
+
+    mpmc_queue *q = aligned_alloc(alignof(mpmc_queue), sizeof(mpmc_queue));
+    if (q == NULL) return NULL;
+
+    q->cells = malloc(ring_capacity * cell_size);
+    if (q->cells == NULL)
+    {
+        free(q);
+        return NULL;
+    }
+    q->cell_size = cell_size;
+    q->elem_size = elem_size;
+    q->capacity = ring_capacity;
+    for (size_t i = 0; i < ring_capacity; i++)
+        atomic_init(MPMC_SEQUENCE(q->cells + i * cell_size), i);
+    atomic_init(&q->enque_position, 0);
+    atomic_init(&q->deque_position, 0);
+
+    return q;
+}
+
+bool mpmc_queue_try_enque(mpmc_queue *q, const void *data)
+{
+    if (q == NULL || data == NULL)
+        return false;
+
+    size_t position = atomic_load_explicit(&q->enque_position, memory_order_relaxed);
+    unsigned char *cell;
+    for (;;)
+    {
+        cell = MPMC_CELL(q, position);
+        size_t sequence = atomic_load_explicit(MPMC_SEQUENCE(cell), memory_order_acquire);
+        intptr_t difference = (intptr_t)sequence - (intptr_t)position;
+
+        if (difference == 0)
+        {
+            /* the cell is free, a failed CAS reloads `position` */
+            if (atomic_compare_exchange_weak_explicit(&q->enque_position, &position, position + 1,
+                                                      memory_order_relaxed, memory_order_relaxed))
+                break;
+        }
+        else if (difference < 0)
+            return false; // the cell still holds the element from one lap ago
+        else
+            position = atomic_load_explicit(&q->enque_position, memory_order_relaxed);
+    }
+
+    memcpy(MPMC_DATA(cell), data, q->elem_size);
+    atomic_store_explicit(MPMC_SEQUENCE(cell), position + 1, memory_order_release);
+    return true;
+}
+
+bool mpmc_queue_try_deque(mpmc_queue *q, void *out)
+{
+    if (q == NULL || out == NULL)
+        return false;
+
+    size_t position = atomic_load_explicit(&q->deque_position, memory_order_relaxed);
+    unsigned char *cell;
+    for (;;)
+    {
+        cell = MPMC_CELL(q, position);
+        size_t sequence = atomic_load_explicit(MPMC_SEQUENCE(cell), memory_order_acquire);
+        intptr_t difference = (intptr_t)sequence - (intptr_t)(position + 1);
+
+        if (difference == 0)
+        {
+            if (atomic_compare_exchange_weak_explicit(&q->deque_position, &position, position + 1,
+                                                      memory_order_relaxed, memory_order_relaxed))
+                break;
+        }
+        else if (difference < 0)
+            return false; // nothing was enqueued at this position yet
+        else
+            position = atomic_load_explicit(&q->deque_position, memory_order_relaxed);
+    }
+
+    memcpy(out, MPMC_DATA(cell), q->elem_size);
+    /* free for the enqueue one lap later */
+    atomic_store_explicit(MPMC_SEQUENCE(cell), position + q->capacity, memory_order_release);
+    return true;
+}
+
+int mpmc_queue_size(mpmc_queue *q)
+{
+    if (q == NULL) return -1;
+
+    size_t deque_position = atomic_load_explicit(&q->deque_position, memory_order_acquire);
+    size_t enque_position = atomic_load_explicit(&q->enque_position, memory_order_acquire);
+    /* read first, `deque_position` is never ahead, but enqueues after it was read can go past the capacity */
+    size_t size = enque_position - deque_position;
+    return size > q->capacity ? (int)q->capacity : (int)size;
+}
+
+void mpmc_queue_destroy(mpmc_queue *q)
+{
+    if (q == NULL) return;
+
+    free(q->cells);
     free(q);
 }
 
+/* the elements are moved to the start of a ring twice as large, `first` becomes 0 */
+static bool grow_ring(queue *q)
+{
+    if (q->capacity > SIZE_MAX / 2 / q->elem_size) return false;
+
+    unsigned char *new_ring = malloc(q->capacity * 2 * q->elem_size);
+    if (new_ring == NULL) return false;
+
+    size_t until_end = q->capacity - q->first;
+    memcpy(new_ring, q->ring + q->first * q->elem_size, until_end * q->elem_size);
+    memcpy(new_ring + until_end * q->elem_size, q->ring, q->first * q->elem_size);
+
+    free(q->ring);
+    q->ring = new_ring;
+    q->capacity *= 2;
+    q->first = 0;
+    return true;
+}
+
 void free_nodes(queue_node *n)
 {
     if (n == NULL) return;
@@ -2,6 +2,12 @@
 #define __QUEUE_H__
 
 #include <stdlib.h>
+#include <stdalign.h>
+#include <stdatomic.h>
+
+/* smallest ring allocated by `queue_create_fixed` */
+#define QUEUE_FIXED_MIN_CAPACITY 16
+#define QUEUE_CACHE_LINE         64
 
 typedef struct node
 {
@@ -10,13 +16,43 @@ typedef struct node
     struct node *next;
 } queue_node;
 
+/**
+ * a queue is either a linked list of nodes, or a ring of fixed size elements
+ * stored inline when `ring` is not NULL. The ring holds `size` elements starting
+ * at index `first` and wrapping around, it doubles when full.
+ */
 typedef struct
 {
-    queue_node *head;
-    queue_node *tail;
-    size_t      size;
+    queue_node    *head;
+    queue_node    *tail;
+    size_t         size;
+    unsigned char *ring;
+    size_t         elem_size;
+    size_t         capacity;  // power of two
+    size_t         first;
 } queue;
 
+/**
+ * a bounded ring of fixed size elements any number of threads can enqueue to and
+ * dequeue from without locks. Every cell carries a sequence number: cell `i` is
+ * free for the enqueue at position `pos` when its sequence is `pos`, and holds the
+ * element for the dequeue at position `pos` when it's `pos + 1`. A thread claims a
+ * position with one CAS on its side's counter, then copies the element in place.
+ */
+typedef struct
+{
+    unsigned char *cells;      // `capacity` cells of `cell_size` bytes: the sequence, then the element
+    size_t         cell_size;
+    size_t         elem_size;
+    size_t         capacity;   // power of two
+
+    alignas(QUEUE_CACHE_LINE)
+    _Atomic size_t enque_position;
+
+    alignas(QUEUE_CACHE_LINE)
+    _Atomic size_t deque_position;
+} mpmc_queue;
+
 /**
  * @brief creates a new queue object
  *
@@ -24,6 +60,17 @@ typedef struct
  */
 queue *queue_create();
 
+/**
+ * @brief creates a new queue of elements of `elem_size` bytes, stored one after
+ * the other in a growable circular array: enqueuing and dequeuing an element is
+ * a memcpy, without allocation unless the ring has to grow.
+ *
+ * @param elem_size size of every element, the size passed to `queue_enque` must match it
+ * @param capacity_hint number of elements the ring holds before its first growth
+ * @return queue* pointer to the newly allocated queue
+ */
+queue *queue_create_fixed(const size_t elem_size, const size_t capacity_hint);
+
 /**
  * @brief insert a new generic element in the queue
  *
@@ -45,6 +92,17 @@ bool queue_enque(queue *q, const void *data, const size_t size);
  */
 void *queue_deque(queue *q);
 
+/**
+ * @brief removes the first element of the queue copying it into caller storage
+ *
+ * @param q pointer to the queue you want to get the data from
+ * @param out pointer to a buffer large enough for the element: `elem_size`
+ * bytes for a fixed queue, the size it was enqueued with otherwise
+ * @return true on success
+ * @return false if the queue is empty or an argument is invalid
+ */
+bool queue_deque_into(queue *q, void *out);
+
 /**
  * @brief returns the number of elements in the queue
  *
@@ -60,4 +118,53 @@ int queue_size(const queue *q);
  */
 void queue_destroy(queue *q);
 
+/**
+ * @brief creates a new bounded queue of elements of `elem_size` bytes that can be
+ * shared by many producer and consumer threads. Memory is allocated once, enqueuing
+ * and dequeuing never allocate. Must be freed with `mpmc_queue_destroy`.
+ *
+ * @param elem_size size of every element in bytes
+ * @param capacity number of elements the queue holds, rounded up to a power of two
+ * @return mpmc_queue* pointer to the newly allocated queue, NULL on failure
+ */
+mpmc_queue *mpmc_queue_create(const size_t elem_size, const size_t capacity);
+
+/**
+ * @brief copies an element at the end of the queue without blocking.
+ * Safe to call from any thread.
+ *
+ * @param q pointer to the queue
+ * @param data pointer to the `elem_size` bytes to enqueue
+ * @return true on success
+ * @return false if the queue is full or an argument is invalid
+ */
+bool mpmc_queue_try_enque(mpmc_queue *q, const void *data);
+
+/**
+ * @brief removes the first element of the queue copying it into caller storage,
+ * without blocking. Safe to call from any thread.
+ *
+ * @param q pointer to the queue
+ * @param out pointer to a buffer of at least `elem_size` bytes
+ * @return true on success
+ * @return false if the queue is empty or an argument is invalid
+ */
+bool mpmc_queue_try_deque(mpmc_queue *q, void *out);
+
+/**
+ * @brief returns the number of elements in the queue. With other threads
+ * running the result is a snapshot that may already be outdated.
+ *
+ * @param q pointer to the queue
+ * @return int -1 if the pointer is null, the size of the queue otherwise
+ */
+int mpmc_queue_size(mpmc_queue *q);
+
+/**
+ * @brief free the memory allocated by the queue. No other thread may be using it.
+ *
+ * @param q pointer to the queue you want to free
+ */
+void mpmc_queue_destroy(mpmc_queue *q);
+
 #endif
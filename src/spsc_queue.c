@@ -0,0 +1,130 @@
+#include "spsc_queue.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+static void copy_into_ring(spsc_queue *q, const size_t index, const void *elems, const size_t n);
+static void copy_from_ring(const spsc_queue *q, const size_t index, void *out, const size_t n);
+
+spsc_queue *spsc_queue_create(const size_t elem_size, const size_t capacity)
+{
+    if (elem_size == 0 || capacity == 0 || capacity > SIZE_MAX / 2 / elem_size)
+        return NULL;
+
+    size_t ring_capacity = 1;
+    while (ring_capacity < capacity)
+        ring_capacity *= 2;
+
+    spsc_queue *q = aligned_alloc(alignof(spsc_queue), sizeof(spsc_queue));
+    if (q == NULL)
+        return NULL;
+
+    q->ring = malloc(ring_capacity * elem_size);
+    if (q->ring == NULL)
+    {
+        free(q);
+        return NULL;
+    }
+    q->elem_size = elem_size;
+    q->capacity = ring_capacity;
+    atomic_init(&q->tail, 0);
+    atomic_init(&q->head, 0);
+    q->cached_head = q->cached_tail = 0;
+
+    return q;
+}
+
+bool spsc_push(spsc_queue *q, const void *elem)
+{
+    return spsc_push_n(q, elem, 1) == 1;
+}
+
+size_t spsc_push_n(spsc_queue *q, const void *elems, const size_t n)
+{
+    if (q == NULL || elems == NULL || n == 0)
+        return 0;
+
+    size_t tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    size_t free_slots = q->capacity - (tail - q->cached_head);
+    if (free_slots < n)
+    {
+        /* the slots the consumer released are ready to be overwritten */
+        q->cached_head = atomic_load_explicit(&q->head, memory_order_acquire);
+        free_slots = q->capacity - (tail - q->cached_head);
+    }
+
+    size_t count = n < free_slots ? n : free_slots;
+    if (count == 0)
+        return 0;
+
+    copy_into_ring(q, tail, elems, count);
+    atomic_store_explicit(&q->tail, tail + count, memory_order_release);
+    return count;
+}
+
+bool spsc_pop(spsc_queue *q, void *out)
+{
+    return spsc_pop_n(q, out, 1) == 1;
+}
+
+size_t spsc_pop_n(spsc_queue *q, void *out, const size_t max_n)
+{
+    if (q == NULL || out == NULL || max_n == 0)
+        return 0;
+
+    size_t head = atomic_load_explicit(&q->head, memory_order_relaxed);
+    size_t available = q->cached_tail - head;
+    if (available < max_n)
+    {
+        /* the elements the producer published are fully written */
+        q->cached_tail = atomic_load_explicit(&q->tail, memory_order_acquire);
+        available = q->cached_tail - head;
+    }
+
+    size_t count = max_n < available ? max_n : available;
+    if (count == 0)
+        return 0;
+
+    copy_from_ring(q, head, out, count);
+    atomic_store_explicit(&q->head, head + count, memory_order_release);
+    return count;
+}
+
+bool spsc_queue_size(spsc_queue *q, size_t *size)
+{
+    if (q == NULL || size == NULL)
+        return false;
+
+    size_t head = atomic_load_explicit(&q->head, memory_order_acquire);
+    size_t tail = atomic_load_explicit(&q->tail, memory_order_acquire);
+    /* `head` was read first, it can only be behind `tail` */
+    *size = tail - head;
+    return true;
+}
+
+void spsc_queue_destroy(spsc_queue *q)
+{
+    if (q == NULL)
+        return;
+
+    free(q->ring);
+    free(q);
+}
+
+/* `n` elements starting at slot `index`, in two copies when they wrap around the end of the ring */
+static void copy_into_ring(spsc_queue *q, const size_t index, const void *elems, const size_t n)
+{
+    size_t slot = index & (q->capacity - 1);
+    size_t first = n < q->capacity - slot ? n : q->capacity - slot;
+    memcpy(q->ring + slot * q->elem_size, elems, first * q->elem_size);
+    memcpy(q->ring, (const unsigned char *)elems + first * q->elem_size, (n - first) * q->elem_size);
+}
+
+static void copy_from_ring(const spsc_queue *q, const size_t index, void *out, const size_t n)
+{
+    size_t slot = index & (q->capacity - 1);
+    size_t first = n < q->capacity - slot ? n : q->capacity - slot;
+    memcpy(out, q->ring + slot * q->elem_size, first * q->elem_size);
+    memcpy((unsigned char *)out + first * q->elem_size, q->ring, (n - first) * q->elem_size);
+}
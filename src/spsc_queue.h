@@ -0,0 +1,104 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <stddef.h>
+#include <stdalign.h>
+#include <stdatomic.h>
+
+#define SPSC_QUEUE_CACHE_LINE 64
+
+/**
+ * a bounded ring of fixed size elements shared by exactly one producer thread
+ * and one consumer thread, without locks. `head` and `tail` count every element
+ * ever popped and pushed, the slot of an index is `index & (capacity - 1)`.
+ * Each side owns the cache line of its index, and keeps there its last read of
+ * the other side's index: it only loads the remote line again when the cached
+ * value says the ring looks full (producer) or empty (consumer).
+ */
+typedef struct spsc_queue
+{
+    unsigned char *ring;
+    size_t         elem_size;
+    size_t         capacity;     // power of two
+
+    alignas(SPSC_QUEUE_CACHE_LINE)
+    _Atomic size_t tail;         // written by the producer only
+    size_t         cached_head;  // producer's copy of `head`
+
+    alignas(SPSC_QUEUE_CACHE_LINE)
+    _Atomic size_t head;         // written by the consumer only
+    size_t         cached_tail;  // consumer's copy of `tail`
+} spsc_queue;
+
+/**
+ * @brief creates a new empty queue of elements of `elem_size` bytes.
+ * Allocated memory from the queue must be freed with `spsc_queue_destroy`.
+ *
+ * @param elem_size size of every element in bytes
+ * @param capacity number of elements the queue holds, rounded up to a power of two
+ * @return spsc_queue* pointer to the newly created queue, or NULL if an error occurred
+ */
+spsc_queue *spsc_queue_create(const size_t elem_size, const size_t capacity);
+
+/**
+ * @brief copies one element at the end of the queue. Producer thread only.
+ *
+ * @param q pointer to the queue
+ * @param elem pointer to the `elem_size` bytes to push
+ * @return true if the element was pushed
+ * @return false if the queue is full or an argument is invalid
+ */
+bool spsc_push(spsc_queue *q, const void *elem);
+
+/**
+ * @brief copies up to `n` consecutive elements at the end of the queue and
+ * publishes them to the consumer at once. Producer thread only.
+ *
+ * @param q pointer to the queue
+ * @param elems pointer to `n` elements of `elem_size` bytes
+ * @param n number of elements to push
+ * @return size_t number of elements pushed, less than `n` when the queue fills up
+ */
+size_t spsc_push_n(spsc_queue *q, const void *elems, const size_t n);
+
+/**
+ * @brief removes the first element of the queue copying it into caller storage.
+ * Consumer thread only.
+ *
+ * @param q pointer to the queue
+ * @param out pointer to a buffer of at least `elem_size` bytes
+ * @return true if an element was popped
+ * @return false if the queue is empty or an argument is invalid
+ */
+bool spsc_pop(spsc_queue *q, void *out);
+
+/**
+ * @brief removes up to `max_n` elements from the front of the queue, copying
+ * them into caller storage and releasing their slots at once. Consumer thread only.
+ *
+ * @param q pointer to the queue
+ * @param out pointer to a buffer of at least `max_n * elem_size` bytes
+ * @param max_n maximum number of elements to pop
+ * @return size_t number of elements popped, 0 if the queue is empty
+ */
+size_t spsc_pop_n(spsc_queue *q, void *out, const size_t max_n);
+
+/**
+ * @brief returns the number of elements in the queue.
+ * While the other thread is running the result may already be outdated.
+ *
+ * @param q pointer to the queue
+ * @param size pointer to a variable where the size will be stored
+ * @return true if the size was successfully retrieved
+ * @return false if an error occurred (e.g., invalid queue pointer)
+ */
+bool spsc_queue_size(spsc_queue *q, size_t *size);
+
+/**
+ * @brief frees the queue and its ring. Neither thread may be using it.
+ *
+ * @param q pointer to the queue to destroy
+ */
+void spsc_queue_destroy(spsc_queue *q);
+
+#endif // SPSC_QUEUE_H
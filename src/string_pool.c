@@ -0,0 +1,185 @@
+#include "string_pool.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* a record is its header, the bytes and the NUL, padded so the next header is aligned */
+#define RECORD_SIZE(length) ((sizeof(hashtable_string) + (length) + 1 + sizeof(void *) - 1) & ~(sizeof(void *) - 1))
+
+static size_t find_slot(const string_pool *pool, const hashtable_string *string);
+static bool grow_index(string_pool *pool);
+static void *allocate_record(string_pool *pool, const size_t size);
+
+string_pool *string_pool_create(void)
+{
+    string_pool *pool = calloc(1, sizeof(string_pool));
+    if (pool == NULL)
+        return NULL;
+
+    pool->slots = calloc(STRING_POOL_INITIAL_SLOTS, sizeof(hashtable_string *));
+    if (pool->slots == NULL)
+    {
+        free(pool);
+        return NULL;
+    }
+    pool->slots_size = STRING_POOL_INITIAL_SLOTS;
+
+    return pool;
+}
+
+const hashtable_string *string_pool_intern(string_pool *pool, const char *data, const size_t length)
+{
+    if (pool == NULL || data == NULL || length > SIZE_MAX / 2)
+        return NULL;
+
+    hashtable_string string = hashtable_string_make(data, length);
+    size_t index = find_slot(pool, &string);
+    if (pool->slots[index] != NULL)
+        return pool->slots[index];
+
+    /* the index grows before the copy, so a failure leaves nothing behind */
+    if (pool->string_number + 1 > pool->slots_size * STRING_POOL_LOAD_FACTOR)
+    {
+        if (!grow_index(pool))
+            return NULL;
+        index = find_slot(pool, &string);
+    }
+
+    hashtable_string *record = allocate_record(pool, RECORD_SIZE(length));
+    if (record == NULL)
+        return NULL;
+    char *copy = (char *)(record + 1);
+    memcpy(copy, data, length);
+    copy[length] = '\0';
+    *record = (hashtable_string){ copy, length, string.hash };
+
+    pool->slots[index] = record;
+    pool->string_number++;
+    pool->string_bytes += RECORD_SIZE(length);
+    return record;
+}
+
+const hashtable_string *string_pool_find(const string_pool *pool, const char *data, const size_t length)
+{
+    if (pool == NULL || data == NULL)
+        return NULL;
+
+    hashtable_string string = hashtable_string_make(data, length);
+    return pool->slots[find_slot(pool, &string)];
+}
+
+bool string_pool_size(const string_pool *pool, size_t *size)
+{
+    if (pool == NULL || size == NULL)
+        return false;
+    *size = pool->string_number;
+    return true;
+}
+
+bool string_pool_stats(const string_pool *pool, string_pool_statistics *stats)
+{
+    if (pool == NULL || stats == NULL)
+        return false;
+
+    *stats = (string_pool_statistics){
+        .string_number = pool->string_number,
+        .string_bytes = pool->string_bytes,
+        .block_bytes = pool->block_bytes,
+        .index_bytes = pool->slots_size * sizeof(hashtable_string *),
+    };
+    stats->total_bytes = sizeof(string_pool) + stats->index_bytes + stats->block_bytes;
+    return true;
+}
+
+void string_pool_destroy(string_pool *pool)
+{
+    if (pool == NULL)
+        return;
+
+    while (pool->blocks != NULL)
+    {
+        string_pool_block *next = pool->blocks->next;
+        free(pool->blocks);
+        pool->blocks = next;
+    }
+    free(pool->slots);
+    free(pool);
+}
+
+size_t hash_interned_string(void *key)
+{
+    return (*(const hashtable_string **)key)->hash;
+}
+
+size_t compare_interned_string(const void *key1, const void *key2)
+{
+    return *(const hashtable_string *const *)key1 != *(const hashtable_string *const *)key2;
+}
+
+/* the slot holding `string`, or the empty slot where it would go */
+static size_t find_slot(const string_pool *pool, const hashtable_string *string)
+{
+    size_t mask = pool->slots_size - 1;
+    size_t index = string->hash & mask;
+    while (pool->slots[index] != NULL &&
+           (pool->slots[index]->hash != string->hash || compare_hashtable_string(pool->slots[index], string) != 0))
+        index = (index + 1) & mask;
+    return index;
+}
+
+static bool grow_index(string_pool *pool)
+{
+    size_t new_size = pool->slots_size * 2;
+    hashtable_string **new_slots = calloc(new_size, sizeof(hashtable_string *));
+    if (new_slots == NULL)
+        return false;
+
+    /* the strings are distinct, each one goes to the first empty slot of its probe sequence */
+    for (size_t i = 0; i < pool->slots_size; i++)
+    {
+        if (pool->slots[i] == NULL)
+            continue;
+        size_t index = pool->slots[i]->hash & (new_size - 1);
+        while (new_slots[index] != NULL)
+            index = (index + 1) & (new_size - 1);
+        new_slots[index] = pool->slots[i];
+    }
+
+    free(pool->slots);
+    pool->slots = new_slots;
+    pool->slots_size = new_size;
+    return true;
+}
+
+static void *allocate_record(string_pool *pool, const size_t size)
+{
+    string_pool_block *block = pool->blocks;
+    if (block != NULL && block->capacity - block->used >= size)
+    {
+        void *record = block->data + block->used;
+        block->used += size;
+        return record;
+    }
+
+    /* a string longer than a quarter of a block doesn't waste the rest of the current one */
+    bool dedicated = size > STRING_POOL_BLOCK_SIZE / 4;
+    size_t capacity = dedicated ? size : STRING_POOL_BLOCK_SIZE;
+    string_pool_block *new_block = malloc(sizeof(string_pool_block) + capacity);
+    if (new_block == NULL)
+        return NULL;
+    new_block->used = size;
+    new_block->capacity = capacity;
+
+    if (dedicated && block != NULL)
+    {
+        new_block->next = block->next;
+        block->next = new_block;
+    }
+    else
+    {
+        new_block->next = block;
+        pool->blocks = new_block;
+    }
+    pool->block_bytes += capacity;
+    return new_block->data;
+}
@@ -0,0 +1,113 @@
+#ifndef STRING_POOL_H
+#define STRING_POOL_H
+
+#include "hashtable.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* bytes of every block the strings are copied into, strings over a quarter of it get a block of their own */
+#define STRING_POOL_BLOCK_SIZE 65536
+#define STRING_POOL_INITIAL_SLOTS 64
+
+/* the index grows above this load factor, linear probing stays short below it */
+#define STRING_POOL_LOAD_FACTOR 0.75
+
+typedef struct string_pool_block
+{
+    struct string_pool_block *next;
+    size_t                    used;
+    size_t                    capacity;
+    char                      data[];
+} string_pool_block;
+
+/**
+ * every distinct string is stored once into blocks that never move, as a
+ * `hashtable_string` header followed by its NUL terminated bytes: an interned
+ * string stays valid until the pool is destroyed, and its address identifies it.
+ * `slots` is an open addressing index with linear probing, NULL when empty.
+ */
+typedef struct string_pool
+{
+    hashtable_string **slots;
+    size_t             slots_size;    // power of two
+    size_t             string_number;
+    size_t             string_bytes;  // headers, bytes and NUL terminators, padded
+    string_pool_block *blocks;        // the block being filled comes first
+    size_t             block_bytes;
+} string_pool;
+
+typedef struct string_pool_statistics
+{
+    size_t string_number;
+    size_t string_bytes;
+    size_t block_bytes;  // string bytes plus the unused end of the blocks
+    size_t index_bytes;
+    size_t total_bytes;  // the pool struct, the index and the blocks
+} string_pool_statistics;
+
+/**
+ * @brief creates a new empty string pool.
+ * Allocated memory from the pool must be freed with `string_pool_destroy`.
+ *
+ * @return string_pool* pointer to the newly created pool
+ */
+string_pool *string_pool_create(void);
+
+/**
+ * @brief returns the interned copy of the `length` bytes at `data`, copying them
+ * into the pool the first time they are seen. Two equal strings are always interned
+ * at the same address: a hashtable keyed by these pointers, with `hash_interned_string`
+ * and `compare_interned_string`, stores 8 bytes per key and compares keys by address.
+ *
+ * @param pool pointer to the pool
+ * @param data pointer to the first byte of the string, doesn't need to be NUL terminated
+ * @param length length of the string in bytes
+ * @return const hashtable_string* the interned string, or NULL if an error occurred
+ */
+const hashtable_string *string_pool_intern(string_pool *pool, const char *data, const size_t length);
+
+/**
+ * @brief looks up the interned copy of a string without adding it.
+ *
+ * @param pool pointer to the pool
+ * @param data pointer to the first byte of the string
+ * @param length length of the string in bytes
+ * @return const hashtable_string* the interned string, or NULL if it's not interned
+ */
+const hashtable_string *string_pool_find(const string_pool *pool, const char *data, const size_t length);
+
+/**
+ * @brief returns the number of distinct strings in the pool.
+ *
+ * @param pool pointer to the pool
+ * @param size pointer to a variable where the size will be stored
+ * @return true if the size was successfully retrieved
+ * @return false if an error occurred (e.g., invalid pool pointer)
+ */
+bool string_pool_size(const string_pool *pool, size_t *size);
+
+/**
+ * @brief fills `stats` with the number of strings and the memory of the pool.
+ *
+ * @param pool pointer to the pool to inspect
+ * @param stats pointer to the statistics to fill
+ * @return true if the statistics were filled
+ * @return false if an error occurred (e.g., invalid pool pointer)
+ */
+bool string_pool_stats(const string_pool *pool, string_pool_statistics *stats);
+
+/**
+ * @brief frees the pool and every interned string.
+ *
+ * @param pool pointer to the pool to destroy
+ */
+void string_pool_destroy(string_pool *pool);
+
+/* ========== INTERNED KEY FUNCTIONS ========== */
+/* keys are `const hashtable_string *` returned by one pool: the cached hash, and address equality */
+size_t hash_interned_string(void *key);
+size_t compare_interned_string(const void *key1, const void *key2);
+/* ============================================ */
+
+#endif // STRING_POOL_H
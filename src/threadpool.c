@@ -11,7 +11,7 @@ threadpool *threadpool_create(const size_t thread_number)
     threadpool *tp = malloc(sizeof(threadpool));
     if (tp == NULL) return NULL;
 
-    tp->tasks = queue_create();
+    tp->tasks = queue_create_fixed(sizeof(struct task), thread_number);
     if (tp->tasks == NULL) return NULL;
 
     pthread_mutex_init(&tp->queue_mutex, NULL);
@@ -60,9 +60,10 @@ bool threadpool_add(threadpool *tp, const struct task *task)
 
     /* add task to queue */
     pthread_mutex_lock(&tp->queue_mutex);
-    if (queue_enque(tp->tasks, task, sizeof(struct task)) == false)
-        return false;
+    bool added = queue_enque(tp->tasks, task, sizeof(struct task));
     pthread_mutex_unlock(&tp->queue_mutex);
+    if (!added)
+        return false;
 
     /* notify waiting threads */
     pthread_cond_broadcast(&tp->new_task_cond);
@@ -102,19 +103,19 @@ void *thread_routine(void *poolp)
          * if we get past the loop it means that there is a taks to
          * do and we have the lock.
          */
-        struct task *task = queue_deque(pool->tasks);
+        struct task task;
+        bool dequeued = queue_deque_into(pool->tasks, &task);
         pthread_mutex_unlock(&pool->queue_mutex);
 
-        if (task != NULL)
+        if (dequeued)
         {
             pthread_mutex_lock(&pool->queue_mutex);
             pool->started++;
             pthread_mutex_unlock(&pool->queue_mutex);
-            task->function(task->argp);
+            task.function(task.argp);
             pthread_mutex_lock(&pool->queue_mutex);
             pool->terminated++;
             pthread_mutex_unlock(&pool->queue_mutex);
-            free(task);
         }
     }
 
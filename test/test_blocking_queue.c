@@ -0,0 +1,231 @@
+#ifdef TEST
+
+#define _DEFAULT_SOURCE
+
+#include "unity.h"
+
+#include "blocking_queue.h"
+#include "queue.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define PRODUCERS             4
+#define CONSUMERS             4
+#define MESSAGES_PER_PRODUCER 20000
+
+/* =================== UTILITIES =================== */
+struct pipeline_args
+{
+    blocking_queue *q;
+    int             id;
+    size_t          received;
+    uint64_t        checksum;
+    int             errors;
+};
+
+static uint64_t elapsed_milliseconds(const struct timespec *start)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)(now.tv_sec - start->tv_sec) * 1000 + (now.tv_nsec - start->tv_nsec) / 1000000;
+}
+
+void *batch_producer(void *argp)
+{
+    // Enqueues `id * MESSAGES_PER_PRODUCER + i` in batches of 16
+    struct pipeline_args *args = argp;
+    int batch[16];
+    for (int i = 0; i < MESSAGES_PER_PRODUCER; i += 16)
+    {
+        for (int j = 0; j < 16; j++)
+            batch[j] = args->id * MESSAGES_PER_PRODUCER + i + j;
+        if (blocking_queue_enque_batch(args->q, batch, 16) != 16)
+            args->errors++;
+    }
+    return NULL;
+}
+
+void *batch_consumer(void *argp)
+{
+    // Drains batches until the queue is closed and empty, the values of one producer must come in order
+    struct pipeline_args *args = argp;
+    int last[PRODUCERS] = {-1, -1, -1, -1};
+    int batch[32];
+    size_t count;
+    while ((count = blocking_queue_deque_batch(args->q, batch, 32, BLOCKING_QUEUE_NO_TIMEOUT)) > 0)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            int producer = batch[i] / MESSAGES_PER_PRODUCER;
+            if (batch[i] <= last[producer])
+                args->errors++;
+            last[producer] = batch[i];
+            args->checksum += batch[i];
+        }
+        args->received += count;
+    }
+    if (!blocking_queue_drained(args->q))
+        args->errors++;
+    return NULL;
+}
+
+void *single_consumer(void *argp)
+{
+    // Blocks on an empty queue until an element arrives
+    struct pipeline_args *args = argp;
+    int value;
+    if (blocking_queue_deque(args->q, &value))
+    {
+        args->received = 1;
+        args->checksum = value;
+    }
+    return NULL;
+}
+/* ================================================ */
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+void test_blocking_queue_InvalidArgumentsShouldFail(void)
+{
+    int value = 0;
+    TEST_ASSERT_NULL(blocking_queue_create(0, 16));
+    TEST_ASSERT_FALSE(blocking_queue_enque(NULL, &value));
+    TEST_ASSERT_FALSE(blocking_queue_deque(NULL, &value));
+    TEST_ASSERT_EQUAL(0, blocking_queue_deque_batch(NULL, &value, 1, 0));
+    TEST_ASSERT_EQUAL_INT(-1, blocking_queue_size(NULL));
+    TEST_ASSERT_FALSE(blocking_queue_drained(NULL));
+
+    blocking_queue *q = blocking_queue_create(sizeof(int), 0);
+    TEST_ASSERT_NOT_NULL(q);
+    TEST_ASSERT_FALSE(blocking_queue_enque(q, NULL));
+    TEST_ASSERT_FALSE(blocking_queue_deque_timed(q, NULL, 0));
+    TEST_ASSERT_EQUAL(0, blocking_queue_deque_batch(q, &value, 0, 0));
+
+    blocking_queue_destroy(q);
+}
+
+void test_blocking_queue_ShouldTimeOutAndDrainAfterClose(void)
+{
+    blocking_queue *q = blocking_queue_create(sizeof(int), 0);
+    TEST_ASSERT_NOT_NULL(q);
+
+    int value;
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    TEST_ASSERT_FALSE(blocking_queue_deque_timed(q, &value, 0));
+    TEST_ASSERT_FALSE(blocking_queue_deque_timed(q, &value, 30));
+    TEST_ASSERT_TRUE(elapsed_milliseconds(&start) >= 30);
+    TEST_ASSERT_FALSE(blocking_queue_drained(q));
+
+    /* a batch takes what is there, up to `max_n` */
+    int values[5] = {1, 2, 3, 4, 5};
+    TEST_ASSERT_EQUAL(5, blocking_queue_enque_batch(q, values, 5));
+    TEST_ASSERT_EQUAL_INT(5, blocking_queue_size(q));
+    int out[8];
+    TEST_ASSERT_EQUAL(3, blocking_queue_deque_batch(q, out, 3, 0));
+    for (int i = 0; i < 3; i++)
+        TEST_ASSERT_EQUAL_INT(values[i], out[i]);
+
+    /* closed, the remaining elements can still be dequeued */
+    blocking_queue_close(q);
+    blocking_queue_close(q);
+    TEST_ASSERT_FALSE(blocking_queue_enque(q, &value));
+    TEST_ASSERT_FALSE(blocking_queue_drained(q));
+    TEST_ASSERT_EQUAL(2, blocking_queue_deque_batch(q, out, 8, BLOCKING_QUEUE_NO_TIMEOUT));
+    TEST_ASSERT_EQUAL_INT(4, out[0]);
+    TEST_ASSERT_EQUAL_INT(5, out[1]);
+    TEST_ASSERT_TRUE(blocking_queue_drained(q));
+    TEST_ASSERT_FALSE(blocking_queue_deque(q, &value));
+
+    blocking_queue_destroy(q);
+}
+
+void test_blocking_queue_ShouldWakeABlockedConsumer(void)
+{
+    blocking_queue *q = blocking_queue_create(sizeof(int), 0);
+    TEST_ASSERT_NOT_NULL(q);
+
+    /* the consumer is asleep long before the element arrives */
+    struct pipeline_args args = { .q = q };
+    pthread_t consumer_thread;
+    TEST_ASSERT_EQUAL(0, pthread_create(&consumer_thread, NULL, single_consumer, &args));
+    struct timespec pause = { 0, 20000000 };
+    nanosleep(&pause, NULL);
+    pthread_mutex_lock(&q->lock);
+    TEST_ASSERT_EQUAL(1, q->consumers.waiting);
+    pthread_mutex_unlock(&q->lock);
+
+    int value = 42;
+    TEST_ASSERT_TRUE(blocking_queue_enque(q, &value));
+    pthread_join(consumer_thread, NULL);
+    TEST_ASSERT_EQUAL(1, args.received);
+    TEST_ASSERT_EQUAL(42, args.checksum);
+
+    /* closing wakes a consumer waiting on an empty queue */
+    args.received = 0;
+    TEST_ASSERT_EQUAL(0, pthread_create(&consumer_thread, NULL, single_consumer, &args));
+    nanosleep(&pause, NULL);
+    blocking_queue_close(q);
+    pthread_join(consumer_thread, NULL);
+    TEST_ASSERT_EQUAL(0, args.received);
+
+    blocking_queue_destroy(q);
+}
+
+void test_blocking_queue_BoundedQueueShouldApplyBackpressure(void)
+{
+    blocking_queue *q = blocking_queue_create(sizeof(int), 8);
+    TEST_ASSERT_NOT_NULL(q);
+
+    struct pipeline_args producers[PRODUCERS], consumers[CONSUMERS];
+    pthread_t producer_threads[PRODUCERS], consumer_threads[CONSUMERS];
+    for (int i = 0; i < CONSUMERS; i++)
+    {
+        consumers[i] = (struct pipeline_args){ .q = q, .id = i };
+        TEST_ASSERT_EQUAL(0, pthread_create(&consumer_threads[i], NULL, batch_consumer, &consumers[i]));
+    }
+    for (int i = 0; i < PRODUCERS; i++)
+    {
+        producers[i] = (struct pipeline_args){ .q = q, .id = i };
+        TEST_ASSERT_EQUAL(0, pthread_create(&producer_threads[i], NULL, batch_producer, &producers[i]));
+    }
+
+    int errors = 0;
+    for (int i = 0; i < PRODUCERS; i++)
+    {
+        pthread_join(producer_threads[i], NULL);
+        errors += producers[i].errors;
+    }
+    TEST_ASSERT_TRUE(blocking_queue_size(q) <= 8);
+    blocking_queue_close(q);
+
+    size_t received = 0;
+    uint64_t checksum = 0;
+    for (int i = 0; i < CONSUMERS; i++)
+    {
+        pthread_join(consumer_threads[i], NULL);
+        errors += consumers[i].errors;
+        received += consumers[i].received;
+        checksum += consumers[i].checksum;
+    }
+
+    uint64_t total = (uint64_t)PRODUCERS * MESSAGES_PER_PRODUCER;
+    TEST_ASSERT_EQUAL_INT(0, errors);
+    TEST_ASSERT_EQUAL(total, received);
+    TEST_ASSERT_EQUAL(total * (total - 1) / 2, checksum);
+    /* the ring was sized for the bound and never grew */
+    TEST_ASSERT_EQUAL(QUEUE_FIXED_MIN_CAPACITY, q->items->capacity);
+
+    blocking_queue_destroy(q);
+}
+
+#endif // TEST
@@ -0,0 +1,195 @@
+#ifdef TEST
+
+#include "unity.h"
+
+#include "concurrent_hashtable.h"
+#include <string.h>
+#include <stdlib.h>
+
+#define KEYS_PER_THREAD 2000
+#define OPS_PER_THREAD  20000
+
+/* =================== UTILITIES =================== */
+size_t simple_hash_function(void *key)
+{
+    // Spread consecutive keys over every stripe
+    return (size_t)(*(int *)key) * 0x9E3779B97F4A7C15ull;
+}
+
+size_t simple_compare_key_function(const void *key1, const void *key2)
+{
+    // Simple key comparison function for testing purposes
+    return (*(int *)key1) - (*(int *)key2);
+}
+
+struct versioned_value
+{
+    int key;
+    int version;
+};
+
+struct worker_args
+{
+    concurrent_hashtable *ht;
+    int                   first_key;
+    int                   thread_number;
+    int                   errors;
+};
+
+/**
+ * 80/20 get/put mix: every thread updates its own keys and reads everybody's,
+ * a value must always belong to the key it was found with
+ */
+void *mixed_worker(void *argp)
+{
+    struct worker_args *args = argp;
+    unsigned int seed = (unsigned int)args->first_key + 1;
+
+    for (int i = 0; i < OPS_PER_THREAD; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        if ((seed >> 16) % 10 < 8)
+        {
+            int key = (int)((seed >> 8) % (unsigned int)(KEYS_PER_THREAD * args->thread_number));
+            struct versioned_value value;
+            size_t value_size;
+            if (concurrent_hashtable_get(args->ht, &key, &value, sizeof(value), &value_size) &&
+                (value_size != sizeof(value) || value.key != key))
+                args->errors++;
+        }
+        else
+        {
+            int key = args->first_key + (int)((seed >> 8) % KEYS_PER_THREAD);
+            struct versioned_value value = { key, i };
+            if (!concurrent_hashtable_put(args->ht, &key, sizeof(key), &value, sizeof(value)))
+                args->errors++;
+        }
+    }
+
+    /* remove half of our keys */
+    for (int key = args->first_key; key < args->first_key + KEYS_PER_THREAD; key += 2)
+        concurrent_hashtable_remove(args->ht, &key);
+
+    return NULL;
+}
+/* ================================================ */
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+void test_concurrent_hashtable_CreationWithInvalidPointersFunctionShouldReturnNull(void)
+{
+    TEST_ASSERT_NULL(concurrent_hashtable_create(NULL, NULL));
+    TEST_ASSERT_NULL(concurrent_hashtable_create(simple_hash_function, NULL));
+    TEST_ASSERT_NULL(concurrent_hashtable_create(NULL, simple_compare_key_function));
+}
+
+void test_concurrent_hashtable_PutGetRemoveShouldWorkCorrectly(void)
+{
+    concurrent_hashtable *ht = concurrent_hashtable_create(simple_hash_function, simple_compare_key_function);
+    TEST_ASSERT_NOT_NULL(ht);
+
+    int key = 1;
+    int value = 10;
+    TEST_ASSERT_FALSE(concurrent_hashtable_put(ht, &key, 0, &value, sizeof(value)));
+    TEST_ASSERT_TRUE(concurrent_hashtable_put(ht, &key, sizeof(key), &value, sizeof(value)));
+
+    int retrieved_value = 0;
+    size_t value_size = 0;
+    TEST_ASSERT_TRUE(concurrent_hashtable_get(ht, &key, &retrieved_value, sizeof(retrieved_value), &value_size));
+    TEST_ASSERT_EQUAL_INT(10, retrieved_value);
+    TEST_ASSERT_EQUAL(sizeof(int), value_size);
+
+    char buffer[32];
+    TEST_ASSERT_TRUE(concurrent_hashtable_put(ht, &key, sizeof(key), "updated value", strlen("updated value") + 1));
+    TEST_ASSERT_FALSE(concurrent_hashtable_get(ht, &key, &retrieved_value, sizeof(retrieved_value), &value_size));
+    TEST_ASSERT_EQUAL(strlen("updated value") + 1, value_size);
+    TEST_ASSERT_TRUE(concurrent_hashtable_get(ht, &key, buffer, sizeof(buffer), NULL));
+    TEST_ASSERT_EQUAL_STRING("updated value", buffer);
+
+    size_t size;
+    TEST_ASSERT_TRUE(concurrent_hashtable_size(ht, &size));
+    TEST_ASSERT_EQUAL(1, size);
+
+    TEST_ASSERT_TRUE(concurrent_hashtable_remove(ht, &key));
+    TEST_ASSERT_FALSE(concurrent_hashtable_remove(ht, &key));
+    TEST_ASSERT_FALSE(concurrent_hashtable_get(ht, &key, buffer, sizeof(buffer), NULL));
+    TEST_ASSERT_TRUE(concurrent_hashtable_size(ht, &size));
+    TEST_ASSERT_EQUAL(0, size);
+
+    concurrent_hashtable_destroy(ht);
+}
+
+void test_concurrent_hashtable_ResizeShouldKeepAllPairs(void)
+{
+    concurrent_hashtable *ht = concurrent_hashtable_create(simple_hash_function, simple_compare_key_function);
+    TEST_ASSERT_NOT_NULL(ht);
+
+    const int count = 8 * CONCURRENT_HASHTABLE_INITIAL_SIZE;
+    for (int i = 0; i < count; i++)
+        TEST_ASSERT_TRUE(concurrent_hashtable_put(ht, &i, sizeof(i), &i, sizeof(i)));
+    TEST_ASSERT_TRUE(atomic_load(&ht->buckets)->size > CONCURRENT_HASHTABLE_INITIAL_SIZE);
+    /* every stripe was migrated to the newest buckets */
+    for (size_t i = 0; i < CONCURRENT_HASHTABLE_STRIPES; i++)
+        TEST_ASSERT_EQUAL_PTR(atomic_load(&ht->buckets), atomic_load(&ht->stripes[i].buckets));
+
+    for (int i = 0; i < count; i++)
+    {
+        int retrieved_value = -1;
+        TEST_ASSERT_TRUE(concurrent_hashtable_get(ht, &i, &retrieved_value, sizeof(retrieved_value), NULL));
+        TEST_ASSERT_EQUAL_INT(i, retrieved_value);
+    }
+
+    concurrent_hashtable_destroy(ht);
+}
+
+void test_concurrent_hashtable_ShouldStayConsistentAcrossThreadCounts(void)
+{
+    const int thread_counts[] = {1, 2, 4, 8};
+
+    for (size_t t = 0; t < sizeof(thread_counts) / sizeof(thread_counts[0]); t++)
+    {
+        int thread_number = thread_counts[t];
+        concurrent_hashtable *ht = concurrent_hashtable_create(simple_hash_function, simple_compare_key_function);
+        TEST_ASSERT_NOT_NULL(ht);
+
+        pthread_t threads[8];
+        struct worker_args args[8];
+        for (int i = 0; i < thread_number; i++)
+        {
+            args[i] = (struct worker_args){ ht, i * KEYS_PER_THREAD, thread_number, 0 };
+            pthread_create(&threads[i], NULL, mixed_worker, &args[i]);
+        }
+        for (int i = 0; i < thread_number; i++)
+        {
+            pthread_join(threads[i], NULL);
+            TEST_ASSERT_EQUAL_INT(0, args[i].errors);
+        }
+
+        /* only odd keys that were written at least once are left */
+        size_t size, expected = 0;
+        for (int key = 0; key < KEYS_PER_THREAD * thread_number; key++)
+        {
+            struct versioned_value value;
+            bool found = concurrent_hashtable_get(ht, &key, &value, sizeof(value), NULL);
+            if (key % 2 == 0)
+                TEST_ASSERT_FALSE(found);
+            else if (found)
+            {
+                TEST_ASSERT_EQUAL_INT(key, value.key);
+                expected++;
+            }
+        }
+        TEST_ASSERT_TRUE(concurrent_hashtable_size(ht, &size));
+        TEST_ASSERT_EQUAL(expected, size);
+
+        concurrent_hashtable_destroy(ht);
+    }
+}
+
+#endif // TEST
@@ -27,6 +27,69 @@ size_t simple_compare_key_function(const void *key1, const void *key2)
     return (*(int *)key1) - (*(int *)key2);
 }
 
+static size_t hash_calls = 0;
+static size_t compare_calls = 0;
+
+size_t counting_hash_function(void *key)
+{
+    hash_calls++;
+    return simple_hash_function(key);
+}
+
+size_t counting_compare_key_function(const void *key1, const void *key2)
+{
+    compare_calls++;
+    return simple_compare_key_function(key1, key2);
+}
+
+void add_to_counter(void *value, const size_t value_size, void *context)
+{
+    // Adds the int pointed to by the context to the stored int
+    TEST_ASSERT_EQUAL(sizeof(int), value_size);
+    *(int *)value += *(const int *)context;
+}
+
+static size_t released_buffers = 0;
+
+void counting_free(void *buffer)
+{
+    // Destructor counting the adopted buffers released by the table
+    released_buffers++;
+    free(buffer);
+}
+
+int *new_int(const int value)
+{
+    int *buffer = malloc(sizeof(int));
+    TEST_ASSERT_NOT_NULL(buffer);
+    *buffer = value;
+    return buffer;
+}
+
+static uint64_t fake_milliseconds = 0;
+
+uint64_t fake_clock(void)
+{
+    // Time only moves when a test says so
+    return fake_milliseconds;
+}
+
+void count_scanned_key(const hashtable_entry *entry, void *context)
+{
+    // Counts how many times every int key was visited by hashtable_scan
+    int *seen = context;
+    TEST_ASSERT_EQUAL(sizeof(int), entry->key_size);
+    TEST_ASSERT_EQUAL_INT(*(const int *)entry->key * 10, *(const int *)entry->value);
+    seen[*(const int *)entry->key]++;
+}
+
+void count_visit(const hashtable_entry *entry, void *context)
+{
+    // Counts the pairs visited by hashtable_scan
+    (void)entry;
+    (*(size_t *)context)++;
+}
+
 void print_hashtable(const hashtable *ht)
 {
     for (size_t i = 0; i < ht->buckets_size; i++)
@@ -157,6 +220,39 @@ void test_hashtable_PutWithValidArgumentsShouldReturnTrue(void)
     hashtable_destroy(ht);
 }
 
+void test_hashtable_PairShouldStoreKeyAndValueInline(void)
+{
+    hashtable *ht = hashtable_create(simple_hash_function, simple_compare_key_function);
+    TEST_ASSERT_NOT_NULL(ht);
+
+    int key = 1;
+    long value = 10;
+    hashtable_put(ht, &key, sizeof(key), &value, sizeof(value));
+
+    hashtable_pair *pair = ht->buckets[1 % ht->buckets_size];
+    TEST_ASSERT_EQUAL_PTR(pair->data, pair->key);
+    TEST_ASSERT_TRUE((unsigned char *)pair->value > pair->data);
+    TEST_ASSERT_TRUE((unsigned char *)pair->value < pair->data + 2 * sizeof(long));
+
+    /* a value that fits is overwritten in place */
+    void *inline_value = pair->value;
+    int smaller = 20;
+    TEST_ASSERT_TRUE(hashtable_put(ht, &key, sizeof(key), &smaller, sizeof(smaller)));
+    TEST_ASSERT_EQUAL_PTR(inline_value, pair->value);
+    TEST_ASSERT_EQUAL_INT(20, *(int *)pair->value);
+    TEST_ASSERT_EQUAL(sizeof(int), pair->value_size);
+
+    /* a bigger value moves out of the pair, the pair and its key stay put */
+    char bigger[64] = "a value that doesn't fit inline";
+    TEST_ASSERT_TRUE(hashtable_put(ht, &key, sizeof(key), bigger, sizeof(bigger)));
+    TEST_ASSERT_EQUAL_PTR(pair, ht->buckets[1 % ht->buckets_size]);
+    TEST_ASSERT_EQUAL_PTR(pair->data, pair->key);
+    TEST_ASSERT_EQUAL_STRING(bigger, (char *)pair->value);
+    TEST_ASSERT_EQUAL(sizeof(bigger), pair->value_size);
+
+    hashtable_destroy(ht);
+}
+
 void test_hashtable_ResizeShouldWorkCorrectly(void)
 {
     /* this function also test the get and remove functions actually */
@@ -200,6 +296,793 @@ void test_hashtable_ResizeShouldWorkCorrectly(void)
     hashtable_destroy(ht);
 }
 
+void test_hashtable_CachedHashShouldAvoidRehashingAndComparing(void)
+{
+    hashtable *ht = hashtable_create(counting_hash_function, counting_compare_key_function);
+    TEST_ASSERT_NOT_NULL(ht);
+    hash_calls = compare_calls = 0;
+
+    /* several resizes happen, the hash function still runs once per put */
+    const int count = 200;
+    for (int i = 0; i < count; i++)
+        hashtable_put(ht, &i, sizeof(i), &i, sizeof(i));
+    TEST_ASSERT_TRUE(ht->buckets_size > INITIAL_BUCKETS_SIZE);
+    TEST_ASSERT_EQUAL(count, hash_calls);
+    /* every key is new and hashes are distinct: no comparison was needed */
+    TEST_ASSERT_EQUAL(0, compare_calls);
+
+    hashtable_pair *pair = ht->buckets[7 % ht->buckets_size];
+    while (pair != NULL && *(int *)pair->key != 7)
+        pair = pair->next;
+    TEST_ASSERT_NOT_NULL(pair);
+    TEST_ASSERT_EQUAL(7, pair->hash);
+
+    int key = 7;
+    int *retrieved_value = hashtable_get(ht, &key);
+    TEST_ASSERT_NOT_NULL(retrieved_value);
+    free(retrieved_value);
+    TEST_ASSERT_EQUAL(1, compare_calls);
+
+    hashtable_destroy(ht);
+}
+
+void test_hashtable_UpsertShouldUpdateInPlaceWithOneLookup(void)
+{
+    hashtable *ht = hashtable_create(counting_hash_function, counting_compare_key_function);
+    TEST_ASSERT_NOT_NULL(ht);
+
+    int one = 1;
+    TEST_ASSERT_FALSE(hashtable_upsert(NULL, &one, sizeof(one), &one, sizeof(one), add_to_counter, &one));
+    TEST_ASSERT_FALSE(hashtable_upsert(ht, &one, sizeof(one), &one, sizeof(one), NULL, &one));
+
+    /* counts of 50 keys seen 1 to 4 times, interleaved */
+    for (int round = 0; round < 4; round++)
+        for (int key = 0; key < 50; key++)
+            if (key % 4 >= round)
+                TEST_ASSERT_TRUE(hashtable_upsert(ht, &key, sizeof(key), &one, sizeof(one), add_to_counter, &one));
+
+    for (int key = 0; key < 50; key++)
+    {
+        size_t value_size = 0;
+        const int *count = hashtable_get_ref(ht, &key, &value_size);
+        TEST_ASSERT_NOT_NULL(count);
+        TEST_ASSERT_EQUAL(sizeof(int), value_size);
+        TEST_ASSERT_EQUAL_INT(key % 4 + 1, *count);
+    }
+
+    /* an existing key costs one hash and one comparison, and keeps its pair */
+    int key = 7;
+    const void *before = hashtable_get_ref(ht, &key, NULL);
+    hash_calls = compare_calls = 0;
+    TEST_ASSERT_TRUE(hashtable_upsert(ht, &key, sizeof(key), &one, sizeof(one), add_to_counter, &one));
+    TEST_ASSERT_EQUAL(1, hash_calls);
+    TEST_ASSERT_EQUAL(1, compare_calls);
+    TEST_ASSERT_EQUAL_PTR(before, hashtable_get_ref(ht, &key, NULL));
+
+    hashtable_destroy(ht);
+}
+
+void test_hashtable_GetOrInsertShouldReturnAWritableValue(void)
+{
+    hashtable *ht = hashtable_create(simple_hash_function, simple_compare_key_function);
+    TEST_ASSERT_NOT_NULL(ht);
+
+    int key = 3;
+    bool inserted = false;
+    TEST_ASSERT_NULL(hashtable_get_or_insert(ht, &key, sizeof(key), NULL, 0, &inserted));
+
+    long *total = hashtable_get_or_insert(ht, &key, sizeof(key), NULL, sizeof(long), &inserted);
+    TEST_ASSERT_NOT_NULL(total);
+    TEST_ASSERT_TRUE(inserted);
+    TEST_ASSERT_EQUAL(0, *total);
+    *total += 40;
+
+    long init = 100;
+    total = hashtable_get_or_insert(ht, &key, sizeof(key), &init, sizeof(init), &inserted);
+    TEST_ASSERT_NOT_NULL(total);
+    TEST_ASSERT_FALSE(inserted);
+    *total += 2;
+
+    long stored = 0;
+    TEST_ASSERT_TRUE(hashtable_get_into(ht, &key, &stored, sizeof(stored), NULL));
+    TEST_ASSERT_EQUAL(42, stored);
+
+    /* an expired pair is replaced by the initial value */
+    fake_milliseconds = 0;
+    TEST_ASSERT_TRUE(hashtable_set_clock(ht, fake_clock));
+    int other = 4;
+    TEST_ASSERT_TRUE(hashtable_put_ttl(ht, &other, sizeof(other), &init, sizeof(init), 10));
+    fake_milliseconds = 10;
+    total = hashtable_get_or_insert(ht, &other, sizeof(other), NULL, sizeof(long), &inserted);
+    TEST_ASSERT_NOT_NULL(total);
+    TEST_ASSERT_TRUE(inserted);
+    TEST_ASSERT_EQUAL(0, *total);
+    fake_milliseconds = 1000000;
+    TEST_ASSERT_NOT_NULL(hashtable_get_ref(ht, &other, NULL));
+
+    hashtable_destroy(ht);
+}
+
+void test_hashtable_PutOwnedShouldAdoptBuffersWithoutCopy(void)
+{
+    hashtable *ht = hashtable_create(simple_hash_function, simple_compare_key_function);
+    TEST_ASSERT_NOT_NULL(ht);
+    TEST_ASSERT_FALSE(hashtable_set_destructors(NULL, NULL, NULL));
+    TEST_ASSERT_TRUE(hashtable_set_destructors(ht, counting_free, counting_free));
+    released_buffers = 0;
+
+    int key = 5;
+    TEST_ASSERT_FALSE(hashtable_put_owned(ht, &key, sizeof(key), NULL, sizeof(int)));
+
+    int *owned_key = new_int(1), *owned_value = new_int(10);
+    TEST_ASSERT_TRUE(hashtable_put_owned(ht, owned_key, sizeof(int), owned_value, sizeof(int)));
+    TEST_ASSERT_EQUAL_PTR(owned_value, hashtable_get_ref(ht, owned_key, NULL));
+    TEST_ASSERT_EQUAL_PTR(owned_key, hashtable_get_pair(ht, owned_key)->key);
+
+    /* an existing key keeps its stored key, the new key and the old value are released */
+    int *second_value = new_int(20);
+    TEST_ASSERT_TRUE(hashtable_put_owned(ht, new_int(1), sizeof(int), second_value, sizeof(int)));
+    TEST_ASSERT_EQUAL(2, released_buffers);
+    TEST_ASSERT_EQUAL_PTR(second_value, hashtable_get_ref(ht, owned_key, NULL));
+
+    /* a copying put replaces the adopted value, and adopting over a copied pair works too */
+    int copied = 30;
+    TEST_ASSERT_TRUE(hashtable_put(ht, owned_key, sizeof(int), &copied, sizeof(copied)));
+    TEST_ASSERT_EQUAL(3, released_buffers);
+    TEST_ASSERT_EQUAL_INT(30, *(const int *)hashtable_get_ref(ht, owned_key, NULL));
+    TEST_ASSERT_TRUE(hashtable_put(ht, &key, sizeof(key), &copied, sizeof(copied)));
+    TEST_ASSERT_TRUE(hashtable_put_owned(ht, new_int(5), sizeof(int), new_int(50), sizeof(int)));
+    TEST_ASSERT_EQUAL(4, released_buffers);
+    TEST_ASSERT_EQUAL_INT(50, *(const int *)hashtable_get_ref(ht, &key, NULL));
+
+    hashtable_statistics stats;
+    TEST_ASSERT_TRUE(hashtable_stats(ht, &stats));
+    TEST_ASSERT_EQUAL(2 * sizeof(int), stats.adopted_bytes);
+    TEST_ASSERT_EQUAL(2, stats.external_values);
+
+    /* removals and destroy release what's adopted, resizes only relink it */
+    for (int i = 100; i < 200; i++)
+        TEST_ASSERT_TRUE(hashtable_put_owned(ht, new_int(i), sizeof(int), new_int(-i), sizeof(int)));
+    for (int i = 100; i < 150; i++)
+        TEST_ASSERT_TRUE(hashtable_remove(ht, &i));
+    TEST_ASSERT_EQUAL(4 + 100, released_buffers);
+    for (int i = 150; i < 200; i++)
+        TEST_ASSERT_EQUAL_INT(-i, *(const int *)hashtable_get_ref(ht, &i, NULL));
+
+    hashtable_destroy(ht);
+    TEST_ASSERT_EQUAL(4 + 100 + 100 + 2, released_buffers);
+}
+
+void test_hashtable_TakeShouldHandBuffersBack(void)
+{
+    hashtable *ht = hashtable_create(simple_hash_function, simple_compare_key_function);
+    TEST_ASSERT_NOT_NULL(ht);
+    TEST_ASSERT_TRUE(hashtable_set_destructors(ht, counting_free, counting_free));
+    released_buffers = 0;
+
+    /* adopted buffers come back as they were given */
+    int *owned_key = new_int(1), *owned_value = new_int(10);
+    TEST_ASSERT_TRUE(hashtable_put_owned(ht, owned_key, sizeof(int), owned_value, sizeof(int)));
+    void *key_out = NULL, *value_out = NULL;
+    size_t key_size = 0, value_size = 0;
+    TEST_ASSERT_TRUE(hashtable_take(ht, owned_key, &key_out, &key_size, &value_out, &value_size));
+    TEST_ASSERT_EQUAL_PTR(owned_key, key_out);
+    TEST_ASSERT_EQUAL_PTR(owned_value, value_out);
+    TEST_ASSERT_EQUAL(sizeof(int), key_size);
+    TEST_ASSERT_EQUAL(sizeof(int), value_size);
+    TEST_ASSERT_EQUAL(0, released_buffers);
+    TEST_ASSERT_NULL(hashtable_get_ref(ht, owned_key, NULL));
+    TEST_ASSERT_FALSE(hashtable_take(ht, owned_key, NULL, NULL, NULL, NULL));
+    free(owned_key);
+    free(owned_value);
+
+    /* copied pairs come back as new buffers */
+    int key = 2;
+    const char *value = "copied value";
+    TEST_ASSERT_TRUE(hashtable_put(ht, &key, sizeof(key), value, strlen(value) + 1));
+    TEST_ASSERT_TRUE(hashtable_take(ht, &key, &key_out, NULL, &value_out, &value_size));
+    TEST_ASSERT_EQUAL_INT(2, *(int *)key_out);
+    TEST_ASSERT_EQUAL_STRING(value, value_out);
+    TEST_ASSERT_EQUAL(strlen(value) + 1, value_size);
+    free(key_out);
+    free(value_out);
+
+    /* what isn't taken is released */
+    TEST_ASSERT_TRUE(hashtable_put_owned(ht, new_int(3), sizeof(int), new_int(30), sizeof(int)));
+    key = 3;
+    TEST_ASSERT_TRUE(hashtable_take(ht, &key, NULL, NULL, &value_out, NULL));
+    TEST_ASSERT_EQUAL(1, released_buffers);
+    TEST_ASSERT_EQUAL_INT(30, *(int *)value_out);
+    free(value_out);
+
+    size_t size;
+    TEST_ASSERT_TRUE(hashtable_size(ht, &size));
+    TEST_ASSERT_EQUAL(0, size);
+    hashtable_destroy(ht);
+    TEST_ASSERT_EQUAL(1, released_buffers);
+}
+
+void test_hashtable_IncrementalResizeShouldMigrateInSteps(void)
+{
+    hashtable *ht = hashtable_create(simple_hash_function, simple_compare_key_function);
+    TEST_ASSERT_NOT_NULL(ht);
+    TEST_ASSERT_TRUE(hashtable_set_incremental_resize(ht, true));
+
+    const int count = 1000;
+    bool migration_seen = false;
+    for (int i = 0; i < count; i++)
+    {
+        int value = i * 10;
+        TEST_ASSERT_TRUE(hashtable_put(ht, &i, sizeof(i), &value, sizeof(value)));
+        if (ht->old_buckets != NULL)
+        {
+            migration_seen = true;
+            TEST_ASSERT_TRUE(ht->rehash_index < ht->old_buckets_size);
+        }
+    }
+    TEST_ASSERT_TRUE(migration_seen);
+    TEST_ASSERT_EQUAL(count, ht->pair_number);
+
+    /* keys are found whether they have been migrated or not */
+    for (int i = 0; i < count; i++)
+    {
+        int *retrieved_value = hashtable_get(ht, &i);
+        TEST_ASSERT_NOT_NULL(retrieved_value);
+        TEST_ASSERT_EQUAL_INT(i * 10, *retrieved_value);
+        free(retrieved_value);
+    }
+
+    void **keyset = hashtable_keyset(ht);
+    TEST_ASSERT_NOT_NULL(keyset);
+    size_t keys = 0;
+    while (keyset[keys] != NULL)
+        keys++;
+    TEST_ASSERT_EQUAL(count, keys);
+    free(keyset);
+
+    for (int i = 0; i < count; i++)
+        TEST_ASSERT_TRUE(hashtable_remove(ht, &i));
+    TEST_ASSERT_EQUAL(0, ht->pair_number);
+    TEST_ASSERT_EQUAL(INITIAL_BUCKETS_SIZE, ht->buckets_size);
+
+    /* disabling the mode completes the pending migration */
+    TEST_ASSERT_TRUE(hashtable_set_incremental_resize(ht, false));
+    TEST_ASSERT_NULL(ht->old_buckets);
+
+    hashtable_destroy(ht);
+}
+
+void test_hashtable_ResizeShouldNotThrashAroundThreshold(void)
+{
+    hashtable *ht = hashtable_create(simple_hash_function, simple_compare_key_function);
+    TEST_ASSERT_NOT_NULL(ht);
+
+    /* cross the grow threshold, then keep inserting and removing around it */
+    int grow_at = INITIAL_BUCKETS_SIZE * HASHTABLE_GROW_LOAD_FACTOR + 1;
+    for (int i = 0; i < grow_at; i++)
+        hashtable_put(ht, &i, sizeof(i), &i, sizeof(i));
+    size_t grown_size = ht->buckets_size;
+    TEST_ASSERT_EQUAL(2 * INITIAL_BUCKETS_SIZE, grown_size);
+
+    for (int round = 0; round < 10; round++)
+    {
+        int key = grow_at - 1;
+        TEST_ASSERT_TRUE(hashtable_remove(ht, &key));
+        TEST_ASSERT_EQUAL(grown_size, ht->buckets_size);
+        TEST_ASSERT_TRUE(hashtable_put(ht, &key, sizeof(key), &key, sizeof(key)));
+        TEST_ASSERT_EQUAL(grown_size, ht->buckets_size);
+    }
+
+    hashtable_destroy(ht);
+}
+
+void test_hashtable_ReserveShouldAvoidResizes(void)
+{
+    TEST_ASSERT_NULL(hashtable_create_with_capacity(NULL, simple_compare_key_function, 100));
+
+    hashtable *ht = hashtable_create_with_capacity(simple_hash_function, simple_compare_key_function, 1000);
+    TEST_ASSERT_NOT_NULL(ht);
+    TEST_ASSERT_EQUAL(2048, ht->buckets_size);
+
+    for (int i = 0; i < 1000; i++)
+        TEST_ASSERT_TRUE(hashtable_put(ht, &i, sizeof(i), &i, sizeof(i)));
+    TEST_ASSERT_EQUAL(2048, ht->buckets_size);
+
+    /* reserved buckets are kept even when the table empties */
+    for (int i = 0; i < 1000; i++)
+        TEST_ASSERT_TRUE(hashtable_remove(ht, &i));
+    TEST_ASSERT_EQUAL(2048, ht->buckets_size);
+
+    TEST_ASSERT_TRUE(hashtable_reserve(ht, 4000));
+    TEST_ASSERT_EQUAL(8192, ht->buckets_size);
+    TEST_ASSERT_TRUE(hashtable_reserve(ht, 10));
+    TEST_ASSERT_EQUAL(8192, ht->buckets_size);
+
+    for (int i = 0; i < 100; i++)
+        TEST_ASSERT_TRUE(hashtable_put(ht, &i, sizeof(i), &i, sizeof(i)));
+    TEST_ASSERT_TRUE(hashtable_shrink_to_fit(ht));
+    TEST_ASSERT_EQUAL(256, ht->buckets_size);
+    for (int i = 0; i < 100; i++)
+    {
+        const int *value = hashtable_get_ref(ht, &i, NULL);
+        TEST_ASSERT_NOT_NULL(value);
+        TEST_ASSERT_EQUAL_INT(i, *value);
+    }
+
+    /* after shrink_to_fit removals shrink the table again */
+    for (int i = 0; i < 100; i++)
+        TEST_ASSERT_TRUE(hashtable_remove(ht, &i));
+    TEST_ASSERT_EQUAL(INITIAL_BUCKETS_SIZE, ht->buckets_size);
+
+    hashtable_destroy(ht);
+}
+
+void test_hashtable_LoadFactorsShouldControlResizes(void)
+{
+    hashtable *ht = hashtable_create(simple_hash_function, simple_compare_key_function);
+    TEST_ASSERT_NOT_NULL(ht);
+
+    TEST_ASSERT_FALSE(hashtable_set_load_factors(NULL, 1.0, 0.1));
+    TEST_ASSERT_FALSE(hashtable_set_load_factors(ht, 0.0, 0.0));
+    TEST_ASSERT_FALSE(hashtable_set_load_factors(ht, 1.0, 0.5));
+    TEST_ASSERT_FALSE(hashtable_set_load_factors(ht, 1.0, -0.1));
+
+    TEST_ASSERT_TRUE(hashtable_set_load_factors(ht, 2.0, 0.0));
+    for (int i = 0; i < 32; i++)
+        TEST_ASSERT_TRUE(hashtable_put(ht, &i, sizeof(i), &i, sizeof(i)));
+    TEST_ASSERT_EQUAL(INITIAL_BUCKETS_SIZE, ht->buckets_size);
+
+    int key = 32;
+    TEST_ASSERT_TRUE(hashtable_put(ht, &key, sizeof(key), &key, sizeof(key)));
+    TEST_ASSERT_EQUAL(2 * INITIAL_BUCKETS_SIZE, ht->buckets_size);
+
+    /* a shrink load factor of 0 never shrinks */
+    for (int i = 0; i <= 32; i++)
+        TEST_ASSERT_TRUE(hashtable_remove(ht, &i));
+    TEST_ASSERT_EQUAL(2 * INITIAL_BUCKETS_SIZE, ht->buckets_size);
+
+    hashtable_destroy(ht);
+}
+
+void test_hashtable_GetRefShouldBorrowStoredValue(void)
+{
+    hashtable *ht = hashtable_create(simple_hash_function, simple_compare_key_function);
+    TEST_ASSERT_NOT_NULL(ht);
+
+    int key = 1;
+    int value = 10;
+    hashtable_put(ht, &key, sizeof(key), &value, sizeof(value));
+
+    size_t value_size = 0;
+    const int *borrowed = hashtable_get_ref(ht, &key, &value_size);
+    TEST_ASSERT_NOT_NULL(borrowed);
+    TEST_ASSERT_EQUAL_PTR(ht->buckets[1 % ht->buckets_size]->value, borrowed);
+    TEST_ASSERT_EQUAL_INT(10, *borrowed);
+    TEST_ASSERT_EQUAL(sizeof(int), value_size);
+
+    int missing = 2;
+    TEST_ASSERT_NULL(hashtable_get_ref(ht, &missing, &value_size));
+    TEST_ASSERT_NULL(hashtable_get_ref(NULL, &key, &value_size));
+    TEST_ASSERT_NOT_NULL(hashtable_get_ref(ht, &key, NULL));
+
+    hashtable_destroy(ht);
+}
+
+void test_hashtable_GetIntoShouldCopyIntoCallerBuffer(void)
+{
+    hashtable *ht = hashtable_create(simple_hash_function, simple_compare_key_function);
+    TEST_ASSERT_NOT_NULL(ht);
+
+    int key = 1;
+    char *value = "some value";
+    hashtable_put(ht, &key, sizeof(key), value, strlen(value) + 1);
+
+    char small[4];
+    size_t value_size = 0;
+    TEST_ASSERT_FALSE(hashtable_get_into(ht, &key, small, sizeof(small), &value_size));
+    TEST_ASSERT_EQUAL(strlen(value) + 1, value_size);
+
+    char buffer[32];
+    TEST_ASSERT_TRUE(hashtable_get_into(ht, &key, buffer, sizeof(buffer), &value_size));
+    TEST_ASSERT_EQUAL_STRING("some value", buffer);
+
+    int missing = 2;
+    TEST_ASSERT_FALSE(hashtable_get_into(ht, &missing, buffer, sizeof(buffer), NULL));
+
+    hashtable_destroy(ht);
+}
+
+void test_hashtable_BatchedPutAndGetShouldMatchSingleOperations(void)
+{
+    hashtable *ht = hashtable_create(simple_hash_function, simple_compare_key_function);
+    TEST_ASSERT_NOT_NULL(ht);
+
+    /* not a multiple of the batch size, and crossing several resizes */
+    enum { COUNT = 3 * HASHTABLE_BATCH_SIZE + 5 };
+    int keys[COUNT], values[COUNT];
+    hashtable_entry entries[COUNT];
+    for (int i = 0; i < COUNT; i++)
+    {
+        keys[i] = i;
+        values[i] = i * 10;
+        entries[i] = (hashtable_entry){ &keys[i], sizeof(int), &values[i], sizeof(int) };
+    }
+    TEST_ASSERT_EQUAL(COUNT, hashtable_put_many(ht, entries, COUNT));
+    TEST_ASSERT_EQUAL(COUNT, ht->pair_number);
+
+    int missing = COUNT + 1;
+    const void *lookups[COUNT + 1];
+    const void *found[COUNT + 1];
+    size_t sizes[COUNT + 1];
+    for (int i = 0; i < COUNT; i++)
+        lookups[i] = &keys[i];
+    lookups[COUNT] = &missing;
+
+    TEST_ASSERT_EQUAL(COUNT, hashtable_get_many(ht, lookups, COUNT + 1, found, sizes));
+    for (int i = 0; i < COUNT; i++)
+    {
+        TEST_ASSERT_NOT_NULL(found[i]);
+        TEST_ASSERT_EQUAL_INT(i * 10, *(const int *)found[i]);
+        TEST_ASSERT_EQUAL(sizeof(int), sizes[i]);
+    }
+    TEST_ASSERT_NULL(found[COUNT]);
+    TEST_ASSERT_EQUAL(0, sizes[COUNT]);
+
+    /* an invalid entry stops the batch and reports its index */
+    entries[2].value_size = 0;
+    TEST_ASSERT_EQUAL(2, hashtable_put_many(ht, entries, COUNT));
+
+    hashtable_destroy(ht);
+}
+
+void test_hashtable_ScanShouldVisitEveryPairOnce(void)
+{
+    hashtable *ht = hashtable_create(simple_hash_function, simple_compare_key_function);
+    TEST_ASSERT_NOT_NULL(ht);
+
+    enum { COUNT = 100 };
+    int seen[COUNT] = {0};
+    TEST_ASSERT_EQUAL(0, hashtable_scan(ht, 0, 1, count_scanned_key, seen));
+
+    for (int i = 0; i < COUNT; i++)
+    {
+        int value = i * 10;
+        hashtable_put(ht, &i, sizeof(i), &value, sizeof(value));
+    }
+
+    size_t cursor = 0, calls = 0;
+    do
+    {
+        cursor = hashtable_scan(ht, cursor, 1, count_scanned_key, seen);
+        calls++;
+    } while (cursor != 0);
+    TEST_ASSERT_TRUE(calls > 1);
+
+    for (int i = 0; i < COUNT; i++)
+        TEST_ASSERT_EQUAL_INT(1, seen[i]);
+
+    hashtable_destroy(ht);
+}
+
+void test_hashtable_ScanShouldSurviveResizesBetweenCalls(void)
+{
+    const bool modes[] = {false, true};
+    for (size_t m = 0; m < 2; m++)
+    {
+        hashtable *ht = hashtable_create(simple_hash_function, simple_compare_key_function);
+        TEST_ASSERT_NOT_NULL(ht);
+        hashtable_set_incremental_resize(ht, modes[m]);
+
+        enum { COUNT = 400 };
+        int seen[COUNT] = {0};
+        for (int i = 0; i < COUNT / 4; i++)
+        {
+            int value = i * 10;
+            hashtable_put(ht, &i, sizeof(i), &value, sizeof(value));
+        }
+
+        /* grow while scanning, then shrink back */
+        size_t cursor = hashtable_scan(ht, 0, 8, count_scanned_key, seen);
+        for (int i = COUNT / 4; i < COUNT; i++)
+        {
+            int value = i * 10;
+            hashtable_put(ht, &i, sizeof(i), &value, sizeof(value));
+            if (i % 40 == 0)
+                cursor = hashtable_scan(ht, cursor, 8, count_scanned_key, seen);
+        }
+        for (int i = COUNT / 4; i < COUNT; i++)
+        {
+            hashtable_remove(ht, &i);
+            if (i % 40 == 0 && cursor != 0)
+                cursor = hashtable_scan(ht, cursor, 8, count_scanned_key, seen);
+        }
+        while (cursor != 0)
+            cursor = hashtable_scan(ht, cursor, 8, count_scanned_key, seen);
+
+        /* keys present from start to end are visited at least once */
+        for (int i = 0; i < COUNT / 4; i++)
+            TEST_ASSERT_TRUE(seen[i] >= 1);
+
+        hashtable_destroy(ht);
+    }
+}
+
+void test_hashtable_SeededTableShouldWorkWithBinaryKeys(void)
+{
+    TEST_ASSERT_NULL(hashtable_create_seeded(NULL, compare_bytes, 0));
+    TEST_ASSERT_NULL(hashtable_create_seeded(hash_bytes, NULL, 0));
+
+    struct { uint32_t id; unsigned char tag[12]; } key;
+    hashtable *ht = hashtable_create_seeded(hash_bytes, compare_bytes, sizeof(key));
+    TEST_ASSERT_NOT_NULL(ht);
+
+    for (uint32_t i = 0; i < 200; i++)
+    {
+        memset(&key, 0, sizeof(key));
+        key.id = i;
+        key.tag[11] = (unsigned char)i;
+        TEST_ASSERT_TRUE(hashtable_put(ht, &key, sizeof(key), &i, sizeof(i)));
+    }
+    TEST_ASSERT_FALSE(hashtable_put(ht, &key, sizeof(key) - 1, &key, sizeof(key)));
+
+    /* a short key in a batch is rejected before any of its bytes are hashed */
+    uint32_t value = key.id;
+    unsigned char *short_key = malloc(2);
+    TEST_ASSERT_NOT_NULL(short_key);
+    short_key[0] = short_key[1] = 0xAB;
+    hashtable_entry batch[] = { { &key, sizeof(key), &value, sizeof(value) },
+                                { short_key, 2, &value, sizeof(value) } };
+    TEST_ASSERT_EQUAL(1, hashtable_put_many(ht, batch, 2));
+    free(short_key);
+
+    for (uint32_t i = 0; i < 200; i++)
+    {
+        memset(&key, 0, sizeof(key));
+        key.id = i;
+        key.tag[11] = (unsigned char)i;
+        const uint32_t *value = hashtable_get_ref(ht, &key, NULL);
+        TEST_ASSERT_NOT_NULL(value);
+        TEST_ASSERT_EQUAL_UINT32(i, *value);
+    }
+
+    /* only the last byte differs */
+    key.tag[11]++;
+    TEST_ASSERT_NULL(hashtable_get_ref(ht, &key, NULL));
+
+    hashtable_destroy(ht);
+}
+
+void test_hashtable_SeededTableShouldWorkWithStringKeys(void)
+{
+    hashtable *ht = hashtable_create_seeded(hash_bytes, compare_bytes, 0);
+    TEST_ASSERT_NOT_NULL(ht);
+
+    const char *keys[] = {"", "a", "ab", "abcd", "abcdefgh", "a key longer than sixteen bytes",
+                          "a key that is long enough to go through the forty eight byte loop"};
+    const size_t count = sizeof(keys) / sizeof(keys[0]);
+    for (size_t i = 0; i < count; i++)
+        TEST_ASSERT_TRUE(hashtable_put(ht, keys[i], strlen(keys[i]) + 1, &i, sizeof(i)));
+
+    for (size_t i = 0; i < count; i++)
+    {
+        char copy[128];
+        strcpy(copy, keys[i]);
+        const size_t *value = hashtable_get_ref(ht, copy, NULL);
+        TEST_ASSERT_NOT_NULL(value);
+        TEST_ASSERT_EQUAL(i, *value);
+    }
+    TEST_ASSERT_NULL(hashtable_get_ref(ht, "abc", NULL));
+
+    hashtable_destroy(ht);
+}
+
+void test_hashtable_HashFunctionsShouldDependOnSeedAndWholeKey(void)
+{
+    const char key[] = "0123456789abcdefghijklmnopqrstuvwxyz0123456789abcdefghijklmnopqrstuvwxyz";
+
+    TEST_ASSERT_EQUAL(hash_bytes(key, sizeof(key), 1), hash_bytes(key, sizeof(key), 1));
+    TEST_ASSERT_NOT_EQUAL(hash_bytes(key, sizeof(key), 1), hash_bytes(key, sizeof(key), 2));
+    TEST_ASSERT_EQUAL(hash_bytes(key, 0, 7), hash_bytes(key, strlen(key), 7));
+    for (size_t length = 1; length < sizeof(key); length++)
+        TEST_ASSERT_NOT_EQUAL(hash_bytes(key, length, 0), hash_bytes(key, length - 1, 0));
+
+    hashtable *ht1 = hashtable_create_seeded(hash_bytes, compare_bytes, 0);
+    hashtable *ht2 = hashtable_create_seeded(hash_bytes, compare_bytes, 0);
+    TEST_ASSERT_NOT_NULL(ht1);
+    TEST_ASSERT_NOT_NULL(ht2);
+    TEST_ASSERT_NOT_EQUAL(ht1->seed, ht2->seed);
+    hashtable_destroy(ht1);
+    hashtable_destroy(ht2);
+
+    /* strided integers must not collide in the low bits */
+    size_t low_bits = 0;
+    for (int i = 0; i < 16; i++)
+    {
+        int strided = i * 1024;
+        low_bits |= (size_t)1 << (hash_int(&strided) & 63);
+    }
+    TEST_ASSERT_TRUE(__builtin_popcountll(low_bits) > 8);
+
+    double zero = 0.0, negative_zero = -0.0;
+    TEST_ASSERT_EQUAL(hash_double(&zero), hash_double(&negative_zero));
+    uint64_t big = 1ull << 40;
+    TEST_ASSERT_NOT_EQUAL(0, hash_uint64_t(&big) & 0xFFFF);
+
+    TEST_ASSERT_EQUAL(0, compare_bytes("abc", "abc", 0));
+    TEST_ASSERT_NOT_EQUAL(0, compare_bytes("abc", "abd", 3));
+    TEST_ASSERT_EQUAL(0, compare_bytes("abc", "abd", 2));
+}
+
+void test_hashtable_StatsShouldDescribeTheTable(void)
+{
+    hashtable_statistics stats;
+    TEST_ASSERT_FALSE(hashtable_stats(NULL, &stats));
+
+    hashtable *ht = hashtable_create(simple_hash_function, simple_compare_key_function);
+    TEST_ASSERT_NOT_NULL(ht);
+    TEST_ASSERT_FALSE(hashtable_stats(ht, NULL));
+
+    /* keys 0, 16, 32 share bucket 0, keys 1 and 2 get a bucket each */
+    int keys[] = {0, 16, 32, 1, 2};
+    for (int i = 0; i < 5; i++)
+        TEST_ASSERT_TRUE(hashtable_put(ht, &keys[i], sizeof(int), &keys[i], sizeof(int)));
+    char big_value[64] = "this value doesn't fit in the pair anymore";
+    TEST_ASSERT_TRUE(hashtable_put(ht, &keys[4], sizeof(int), big_value, sizeof(big_value)));
+
+    TEST_ASSERT_TRUE(hashtable_stats(ht, &stats));
+    TEST_ASSERT_EQUAL(5, stats.pair_number);
+    TEST_ASSERT_EQUAL(INITIAL_BUCKETS_SIZE, stats.buckets_size);
+    TEST_ASSERT_EQUAL(INITIAL_BUCKETS_SIZE - 3, stats.chain_histogram[0]);
+    TEST_ASSERT_EQUAL(2, stats.chain_histogram[1]);
+    TEST_ASSERT_EQUAL(0, stats.chain_histogram[2]);
+    TEST_ASSERT_EQUAL(1, stats.chain_histogram[3]);
+    TEST_ASSERT_EQUAL(3, stats.max_chain_length);
+    TEST_ASSERT_EQUAL(0, stats.resizes);
+    TEST_ASSERT_EQUAL(1, stats.external_values);
+    TEST_ASSERT_EQUAL(5 * sizeof(hashtable_pair), stats.pair_bytes);
+    TEST_ASSERT_EQUAL(INITIAL_BUCKETS_SIZE * sizeof(hashtable_pair *), stats.bucket_bytes);
+    TEST_ASSERT_TRUE(stats.value_bytes >= 4 * sizeof(int) + sizeof(big_value));
+    TEST_ASSERT_EQUAL(stats.table_bytes + stats.bucket_bytes + stats.pair_bytes + stats.key_bytes + stats.value_bytes,
+                      stats.total_bytes);
+
+    for (int i = 100; i < 200; i++)
+        TEST_ASSERT_TRUE(hashtable_put(ht, &i, sizeof(i), &i, sizeof(i)));
+    TEST_ASSERT_NOT_NULL(hashtable_get_ref(ht, &keys[0], NULL));
+    int missing = 99;
+    TEST_ASSERT_NULL(hashtable_get_ref(ht, &missing, NULL));
+
+    TEST_ASSERT_TRUE(hashtable_stats(ht, &stats));
+    TEST_ASSERT_EQUAL(4, stats.resizes);
+    TEST_ASSERT_TRUE(stats.rehashed_pairs >= 12 + 24 + 48 + 96);
+#ifdef HASHTABLE_STATS
+    TEST_ASSERT_EQUAL(1, stats.hits);
+    TEST_ASSERT_EQUAL(1, stats.misses);
+#else
+    TEST_ASSERT_EQUAL(0, stats.hits + stats.misses);
+#endif
+
+    hashtable_destroy(ht);
+}
+
+void test_hashtable_PutTtlShouldExpirePairs(void)
+{
+    hashtable *ht = hashtable_create(simple_hash_function, simple_compare_key_function);
+    TEST_ASSERT_NOT_NULL(ht);
+    fake_milliseconds = 1000;
+    TEST_ASSERT_TRUE(hashtable_set_clock(ht, fake_clock));
+
+    int keys[3] = {1, 2, 3};
+    int value = 10;
+    TEST_ASSERT_FALSE(hashtable_put_ttl(ht, &keys[0], sizeof(int), &value, sizeof(value), 0));
+    TEST_ASSERT_TRUE(hashtable_put_ttl(ht, &keys[0], sizeof(int), &value, sizeof(value), 100));
+    TEST_ASSERT_TRUE(hashtable_put_ttl(ht, &keys[1], sizeof(int), &value, sizeof(value), 100));
+    TEST_ASSERT_TRUE(hashtable_put_ttl(ht, &keys[2], sizeof(int), &value, sizeof(value), 100));
+    TEST_ASSERT_FALSE(hashtable_set_clock(ht, NULL));
+
+    /* key 2 becomes persistent, key 3 gets a longer TTL */
+    TEST_ASSERT_TRUE(hashtable_put(ht, &keys[1], sizeof(int), &value, sizeof(value)));
+    TEST_ASSERT_TRUE(hashtable_put_ttl(ht, &keys[2], sizeof(int), &value, sizeof(value), 500));
+
+    fake_milliseconds = 1099;
+    TEST_ASSERT_NOT_NULL(hashtable_get_ref(ht, &keys[0], NULL));
+    TEST_ASSERT_EQUAL(0, hashtable_expire(ht, SIZE_MAX));
+
+    /* expired pairs disappear from lookups before they are reclaimed */
+    fake_milliseconds = 1100;
+    TEST_ASSERT_NULL(hashtable_get_ref(ht, &keys[0], NULL));
+    const void *keys_to_get[3] = {&keys[0], &keys[1], &keys[2]};
+    const void *values[3];
+    TEST_ASSERT_EQUAL(2, hashtable_get_many(ht, keys_to_get, 3, values, NULL));
+    TEST_ASSERT_NULL(values[0]);
+    size_t size;
+    TEST_ASSERT_TRUE(hashtable_size(ht, &size));
+    TEST_ASSERT_EQUAL(3, size);
+
+    /* and from the sweeps */
+    size_t visited = 0, cursor = 0;
+    do
+        cursor = hashtable_scan(ht, cursor, 1, count_visit, &visited);
+    while (cursor != 0);
+    TEST_ASSERT_EQUAL(2, visited);
+    void **keyset = hashtable_keyset(ht);
+    TEST_ASSERT_NOT_NULL(keyset);
+    for (size_t i = 0; keyset[i] != NULL; i++)
+        TEST_ASSERT_NOT_EQUAL(keys[0], *(int *)keyset[i]);
+    TEST_ASSERT_NULL(keyset[2]);
+    free(keyset);
+
+    TEST_ASSERT_EQUAL(1, hashtable_expire(ht, SIZE_MAX));
+    TEST_ASSERT_TRUE(hashtable_size(ht, &size));
+    TEST_ASSERT_EQUAL(2, size);
+
+    fake_milliseconds = 100000;
+    TEST_ASSERT_NULL(hashtable_get_ref(ht, &keys[2], NULL));
+    TEST_ASSERT_NOT_NULL(hashtable_get_ref(ht, &keys[1], NULL));
+
+    /* a put reclaims a few expired pairs on its way */
+    int other = 4;
+    TEST_ASSERT_TRUE(hashtable_put(ht, &other, sizeof(int), &value, sizeof(value)));
+    TEST_ASSERT_TRUE(hashtable_size(ht, &size));
+    TEST_ASSERT_EQUAL(2, size);
+
+    hashtable_statistics stats;
+    TEST_ASSERT_TRUE(hashtable_stats(ht, &stats));
+    TEST_ASSERT_EQUAL(2, stats.expired_pairs);
+    TEST_ASSERT_TRUE(stats.timer_bytes > 0);
+
+    hashtable_destroy(ht);
+}
+
+void test_hashtable_ExpireShouldReclaimExactlyTheDuePairs(void)
+{
+    hashtable *ht = hashtable_create(simple_hash_function, simple_compare_key_function);
+    TEST_ASSERT_NOT_NULL(ht);
+    fake_milliseconds = 12345;
+    TEST_ASSERT_TRUE(hashtable_set_clock(ht, fake_clock));
+
+    /* TTLs spread over every level of the wheel and past its 4.6 hours */
+    const int count = 3000;
+    uint64_t *ttls = malloc(count * sizeof(uint64_t));
+    TEST_ASSERT_NOT_NULL(ttls);
+    for (int i = 0; i < count; i++)
+    {
+        ttls[i] = 1 + ((uint64_t)i * i * 7919) % 40000000;
+        TEST_ASSERT_TRUE(hashtable_put_ttl(ht, &i, sizeof(i), &i, sizeof(i), ttls[i]));
+    }
+
+    uint64_t start = fake_milliseconds, elapsed = 0, step = 1;
+    size_t reclaimed = 0;
+    while (reclaimed < (size_t)count)
+    {
+        elapsed += step;
+        step = step * 3 / 2 + 1;
+        fake_milliseconds = start + elapsed;
+
+        /* bounded slices */
+        size_t slice;
+        while ((slice = hashtable_expire(ht, 16)) > 0)
+        {
+            TEST_ASSERT_TRUE(slice <= 16);
+            reclaimed += slice;
+        }
+
+        size_t due = 0;
+        for (int i = 0; i < count; i++)
+        {
+            due += ttls[i] <= elapsed;
+            TEST_ASSERT_EQUAL(ttls[i] > elapsed, hashtable_get_ref(ht, &i, NULL) != NULL);
+        }
+        TEST_ASSERT_EQUAL(due, reclaimed);
+
+        size_t size;
+        TEST_ASSERT_TRUE(hashtable_size(ht, &size));
+        TEST_ASSERT_EQUAL(count - reclaimed, size);
+    }
+
+    free(ttls);
+    hashtable_destroy(ht);
+}
+
 void test_hashtable_KeysetShouldReturnAllKeys(void)
 {
     hashtable *ht = hashtable_create(simple_hash_function, simple_compare_key_function);
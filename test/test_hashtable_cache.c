@@ -0,0 +1,201 @@
+#ifdef TEST
+
+#include "unity.h"
+
+#include "hashtable_cache.h"
+#include "hashtable.h"
+#include <string.h>
+#include <stdlib.h>
+
+/* room for `n` pairs of int keys and int values */
+#define BUDGET_FOR(n) ((n) * (2 * sizeof(int) + HASHTABLE_CACHE_ENTRY_OVERHEAD))
+
+/* =================== UTILITIES =================== */
+size_t simple_hash_function(void *key)
+{
+    // Simple hash function for testing purposes
+    return (size_t)(*(int *)key);
+}
+
+size_t simple_compare_key_function(const void *key1, const void *key2)
+{
+    // Simple key comparison function for testing purposes
+    return (*(int *)key1) - (*(int *)key2);
+}
+
+typedef struct
+{
+    size_t calls;
+    int    last_key;
+    int    last_value;
+} eviction_log;
+
+void log_eviction(const void *key, const size_t key_size, const void *value, const size_t value_size, void *context)
+{
+    eviction_log *log = context;
+    TEST_ASSERT_EQUAL(sizeof(int), key_size);
+    TEST_ASSERT_EQUAL(sizeof(int), value_size);
+    log->calls++;
+    log->last_key = *(const int *)key;
+    log->last_value = *(const int *)value;
+}
+/* ================================================ */
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+void test_hashtable_cache_InvalidArgumentsShouldFail(void)
+{
+    TEST_ASSERT_NULL(hashtable_cache_create(NULL, simple_compare_key_function, BUDGET_FOR(4)));
+    TEST_ASSERT_NULL(hashtable_cache_create(simple_hash_function, NULL, BUDGET_FOR(4)));
+    TEST_ASSERT_FALSE(hashtable_cache_put(NULL, "key", 4, "value", 6));
+    TEST_ASSERT_NULL(hashtable_cache_get(NULL, "key", NULL));
+    TEST_ASSERT_FALSE(hashtable_cache_remove(NULL, "key"));
+    TEST_ASSERT_FALSE(hashtable_cache_set_max_bytes(NULL, 0));
+
+    hashtable_cache *cache = hashtable_cache_create(simple_hash_function, simple_compare_key_function, BUDGET_FOR(1));
+    TEST_ASSERT_NOT_NULL(cache);
+
+    /* a pair larger than the whole budget is rejected */
+    int key = 1;
+    char value[64] = {0};
+    TEST_ASSERT_FALSE(hashtable_cache_put(cache, &key, sizeof(key), value, sizeof(value)));
+    TEST_ASSERT_FALSE(hashtable_cache_put(cache, &key, sizeof(key), value, 0));
+    TEST_ASSERT_FALSE(hashtable_cache_remove(cache, &key));
+
+    hashtable_cache_destroy(cache);
+}
+
+void test_hashtable_cache_ShouldStoreUpdateAndRemove(void)
+{
+    hashtable_cache *cache = hashtable_cache_create(simple_hash_function, simple_compare_key_function, BUDGET_FOR(8));
+    TEST_ASSERT_NOT_NULL(cache);
+
+    for (int i = 0; i < 8; i++)
+    {
+        int value = i * 10;
+        TEST_ASSERT_TRUE(hashtable_cache_put(cache, &i, sizeof(i), &value, sizeof(value)));
+    }
+
+    int key = 3, value = 33;
+    TEST_ASSERT_TRUE(hashtable_cache_put(cache, &key, sizeof(key), &value, sizeof(value)));
+
+    size_t size, value_size = 0;
+    TEST_ASSERT_TRUE(hashtable_cache_size(cache, &size));
+    TEST_ASSERT_EQUAL(8, size);
+    const int *stored = hashtable_cache_get(cache, &key, &value_size);
+    TEST_ASSERT_NOT_NULL(stored);
+    TEST_ASSERT_EQUAL_INT(33, *stored);
+    TEST_ASSERT_EQUAL(sizeof(int), value_size);
+
+    TEST_ASSERT_TRUE(hashtable_cache_remove(cache, &key));
+    TEST_ASSERT_NULL(hashtable_cache_get(cache, &key, NULL));
+    for (int i = 0; i < 8; i++)
+    {
+        if (i == 3)
+            continue;
+        stored = hashtable_cache_get(cache, &i, NULL);
+        TEST_ASSERT_NOT_NULL(stored);
+        TEST_ASSERT_EQUAL_INT(i * 10, *stored);
+    }
+
+    hashtable_cache_statistics stats;
+    TEST_ASSERT_TRUE(hashtable_cache_stats(cache, &stats));
+    TEST_ASSERT_EQUAL(7, stats.pair_number);
+    TEST_ASSERT_EQUAL(BUDGET_FOR(7), stats.used_bytes);
+    TEST_ASSERT_EQUAL(8, stats.hits);
+    TEST_ASSERT_EQUAL(1, stats.misses);
+    TEST_ASSERT_EQUAL(0, stats.evictions);
+
+    hashtable_cache_destroy(cache);
+}
+
+void test_hashtable_cache_ShouldEvictUnreferencedPairsFirst(void)
+{
+    hashtable_cache *cache = hashtable_cache_create(simple_hash_function, simple_compare_key_function, BUDGET_FOR(4));
+    TEST_ASSERT_NOT_NULL(cache);
+    eviction_log log = {0};
+    TEST_ASSERT_TRUE(hashtable_cache_set_eviction_callback(cache, log_eviction, &log));
+
+    for (int i = 0; i < 4; i++)
+    {
+        int value = -i;
+        TEST_ASSERT_TRUE(hashtable_cache_put(cache, &i, sizeof(i), &value, sizeof(value)));
+    }
+
+    /* 0, 1 and 3 are hit, 2 is the only pair the hand finds unreferenced */
+    int hot[] = {0, 1, 3};
+    for (int i = 0; i < 3; i++)
+        TEST_ASSERT_NOT_NULL(hashtable_cache_get(cache, &hot[i], NULL));
+
+    int key = 4, value = -4;
+    TEST_ASSERT_TRUE(hashtable_cache_put(cache, &key, sizeof(key), &value, sizeof(value)));
+    TEST_ASSERT_EQUAL(1, log.calls);
+    TEST_ASSERT_EQUAL_INT(2, log.last_key);
+    TEST_ASSERT_EQUAL_INT(-2, log.last_value);
+    TEST_ASSERT_NULL(hashtable_cache_get(cache, &log.last_key, NULL));
+    for (int i = 0; i < 3; i++)
+        TEST_ASSERT_NOT_NULL(hashtable_cache_get(cache, &hot[i], NULL));
+
+    /* a smaller budget evicts down to it */
+    TEST_ASSERT_TRUE(hashtable_cache_set_max_bytes(cache, BUDGET_FOR(2)));
+    size_t size;
+    TEST_ASSERT_TRUE(hashtable_cache_size(cache, &size));
+    TEST_ASSERT_EQUAL(2, size);
+    TEST_ASSERT_EQUAL(3, log.calls);
+
+    hashtable_cache_statistics stats;
+    TEST_ASSERT_TRUE(hashtable_cache_stats(cache, &stats));
+    TEST_ASSERT_EQUAL(3, stats.evictions);
+    TEST_ASSERT_EQUAL(BUDGET_FOR(2), stats.used_bytes);
+
+    hashtable_cache_destroy(cache);
+}
+
+void test_hashtable_cache_MemoryShouldStayWithinBudget(void)
+{
+    const size_t budget = BUDGET_FOR(100);
+    hashtable_cache *cache = hashtable_cache_create_seeded(hash_bytes, compare_bytes, sizeof(int), budget);
+    TEST_ASSERT_NOT_NULL(cache);
+
+    /* an unbounded stream of keys, with values of varying size and a few hot keys */
+    char value[40];
+    memset(value, 'v', sizeof(value));
+    for (int i = 0; i < 20000; i++)
+    {
+        TEST_ASSERT_TRUE(hashtable_cache_put(cache, &i, sizeof(i), value, 1 + i % sizeof(value)));
+        int hot = i % 8;
+        if (i >= 8)
+            TEST_ASSERT_NOT_NULL(hashtable_cache_get(cache, &hot, NULL));
+
+        hashtable_cache_statistics stats;
+        TEST_ASSERT_TRUE(hashtable_cache_stats(cache, &stats));
+        TEST_ASSERT_TRUE(stats.used_bytes <= budget);
+    }
+
+    /* values growing in place still respect the budget */
+    char large[400];
+    memset(large, 'l', sizeof(large));
+    for (int i = 0; i < 8; i++)
+        TEST_ASSERT_TRUE(hashtable_cache_put(cache, &i, sizeof(i), large, sizeof(large)));
+
+    hashtable_cache_statistics stats;
+    TEST_ASSERT_TRUE(hashtable_cache_stats(cache, &stats));
+    TEST_ASSERT_TRUE(stats.used_bytes <= budget);
+    TEST_ASSERT_TRUE(stats.pair_number >= 1);
+    TEST_ASSERT_EQUAL(20000 - stats.pair_number, stats.evictions);
+
+    size_t value_size = 0;
+    int key = 7;
+    TEST_ASSERT_NOT_NULL(hashtable_cache_get(cache, &key, &value_size));
+    TEST_ASSERT_EQUAL(sizeof(large), value_size);
+
+    hashtable_cache_destroy(cache);
+}
+
+#endif // TEST
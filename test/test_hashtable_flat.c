@@ -0,0 +1,241 @@
+#ifdef TEST
+
+#include "unity.h"
+
+#include "hashtable_flat.h"
+#include <string.h>
+#include <stdlib.h>
+
+/* =================== UTILITIES =================== */
+size_t simple_hash_function(void *key)
+{
+    // Simple hash function for testing purposes
+    return (*(int *)key);
+}
+
+size_t constant_hash_function(void *key)
+{
+    // Every key collides on both the home group and the control tag
+    (void)key;
+    return 42;
+}
+
+size_t simple_compare_key_function(const void *key1, const void *key2)
+{
+    // Simple key comparison function for testing purposes
+    return (*(int *)key1) - (*(int *)key2);
+}
+/* ================================================ */
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+void test_hashtable_flat_CreationWithInvalidPointersFunctionShouldReturnNull(void)
+{
+    TEST_ASSERT_NULL(hashtable_flat_create(NULL, NULL));
+    TEST_ASSERT_NULL(hashtable_flat_create(simple_hash_function, NULL));
+    TEST_ASSERT_NULL(hashtable_flat_create(NULL, simple_compare_key_function));
+}
+
+void test_hashtable_flat_CreationWithValidPointersFunctionShouldReturnNotNull(void)
+{
+    hashtable_flat *ht = hashtable_flat_create(simple_hash_function, simple_compare_key_function);
+    TEST_ASSERT_NOT_NULL(ht);
+
+    TEST_ASSERT_NOT_NULL(ht->ctrl);
+    TEST_ASSERT_NOT_NULL(ht->slots);
+    TEST_ASSERT_EQUAL(HASHTABLE_FLAT_INITIAL_CAPACITY, ht->capacity);
+    TEST_ASSERT_EQUAL(0, ht->pair_number);
+    for (size_t i = 0; i < ht->capacity + HASHTABLE_FLAT_GROUP_WIDTH; i++)
+        TEST_ASSERT_EQUAL_INT(HASHTABLE_FLAT_CTRL_EMPTY, ht->ctrl[i]);
+
+    hashtable_flat_destroy(ht);
+}
+
+void test_hashtable_flat_PutWithInvalidArgumentsShouldReturnFalse(void)
+{
+    int key = 1;
+    int value = 10;
+    hashtable_flat *ht = hashtable_flat_create(simple_hash_function, simple_compare_key_function);
+    TEST_ASSERT_NOT_NULL(ht);
+
+    TEST_ASSERT_FALSE(hashtable_flat_put(NULL, &key, sizeof(key), &value, sizeof(value)));
+    TEST_ASSERT_FALSE(hashtable_flat_put(ht, NULL, sizeof(key), &value, sizeof(value)));
+    TEST_ASSERT_FALSE(hashtable_flat_put(ht, &key, 0, &value, sizeof(value)));
+    TEST_ASSERT_FALSE(hashtable_flat_put(ht, &key, sizeof(key), NULL, sizeof(value)));
+    TEST_ASSERT_FALSE(hashtable_flat_put(ht, &key, sizeof(key), &value, 0));
+    TEST_ASSERT_EQUAL(0, ht->pair_number);
+
+    hashtable_flat_destroy(ht);
+}
+
+void test_hashtable_flat_PutShouldInsertAndUpdate(void)
+{
+    int key = 1;
+    int value = 10;
+    hashtable_flat *ht = hashtable_flat_create(simple_hash_function, simple_compare_key_function);
+    TEST_ASSERT_NOT_NULL(ht);
+
+    TEST_ASSERT_TRUE(hashtable_flat_put(ht, &key, sizeof(key), &value, sizeof(value)));
+    TEST_ASSERT_EQUAL(1, ht->pair_number);
+
+    int *retrieved_value = hashtable_flat_get(ht, &key);
+    TEST_ASSERT_NOT_NULL(retrieved_value);
+    TEST_ASSERT_EQUAL_INT(10, *retrieved_value);
+    free(retrieved_value);
+
+    TEST_ASSERT_TRUE(hashtable_flat_put(ht, &key, sizeof(key), "updated value", strlen("updated value") + 1));
+    TEST_ASSERT_EQUAL(1, ht->pair_number);
+
+    char *retrieved_string = hashtable_flat_get(ht, &key);
+    TEST_ASSERT_NOT_NULL(retrieved_string);
+    TEST_ASSERT_EQUAL_STRING("updated value", retrieved_string);
+    free(retrieved_string);
+
+    int missing = 2;
+    TEST_ASSERT_NULL(hashtable_flat_get(ht, &missing));
+
+    hashtable_flat_destroy(ht);
+}
+
+void test_hashtable_flat_LargePairsShouldMoveOutOfTheSlot(void)
+{
+    hashtable_flat *ht = hashtable_flat_create(simple_hash_function, simple_compare_key_function);
+    TEST_ASSERT_NOT_NULL(ht);
+
+    char large[HASHTABLE_FLAT_INLINE_SIZE * 2];
+    memset(large, 'x', sizeof(large) - 1);
+    large[sizeof(large) - 1] = '\0';
+
+    /* inline, then out of line, then back inline, across a rehash */
+    for (int i = 0; i < 100; i++)
+        TEST_ASSERT_TRUE(hashtable_flat_put(ht, &i, sizeof(i), &i, sizeof(i)));
+    for (int i = 0; i < 100; i += 2)
+        TEST_ASSERT_TRUE(hashtable_flat_put(ht, &i, sizeof(i), large, sizeof(large)));
+    for (int i = 100; i < 200; i++)
+        TEST_ASSERT_TRUE(hashtable_flat_put(ht, &i, sizeof(i), large, sizeof(large)));
+    for (int i = 0; i < 100; i += 4)
+        TEST_ASSERT_TRUE(hashtable_flat_put(ht, &i, sizeof(i), "small", sizeof("small")));
+
+    for (int i = 0; i < 200; i++)
+    {
+        char *retrieved_value = hashtable_flat_get(ht, &i);
+        TEST_ASSERT_NOT_NULL(retrieved_value);
+        if (i < 100 && i % 4 == 0)
+            TEST_ASSERT_EQUAL_STRING("small", retrieved_value);
+        else if (i < 100 && i % 2 == 1)
+            TEST_ASSERT_EQUAL_INT(i, *(int *)retrieved_value);
+        else
+            TEST_ASSERT_EQUAL_STRING(large, retrieved_value);
+        free(retrieved_value);
+    }
+
+    for (int i = 0; i < 150; i++)
+        TEST_ASSERT_TRUE(hashtable_flat_remove(ht, &i));
+    TEST_ASSERT_EQUAL(50, ht->pair_number);
+    hashtable_flat_destroy(ht);
+}
+
+void test_hashtable_flat_ResizeShouldWorkCorrectly(void)
+{
+    hashtable_flat *ht = hashtable_flat_create(simple_hash_function, simple_compare_key_function);
+    TEST_ASSERT_NOT_NULL(ht);
+
+    const int count = 1000;
+    for (int i = 0; i < count; i++)
+    {
+        int value = i * 10;
+        TEST_ASSERT_TRUE(hashtable_flat_put(ht, &i, sizeof(i), &value, sizeof(value)));
+    }
+    TEST_ASSERT_EQUAL(count, ht->pair_number);
+    TEST_ASSERT_TRUE(ht->capacity > HASHTABLE_FLAT_INITIAL_CAPACITY);
+
+    for (int i = 0; i < count; i++)
+    {
+        int *retrieved_value = hashtable_flat_get(ht, &i);
+        TEST_ASSERT_NOT_NULL(retrieved_value);
+        TEST_ASSERT_EQUAL_INT(i * 10, *retrieved_value);
+        free(retrieved_value);
+    }
+
+    for (int i = 0; i < count - 2; i++)
+        TEST_ASSERT_TRUE(hashtable_flat_remove(ht, &i));
+    TEST_ASSERT_EQUAL(2, ht->pair_number);
+    TEST_ASSERT_EQUAL(HASHTABLE_FLAT_INITIAL_CAPACITY, ht->capacity);
+
+    for (int i = count - 2; i < count; i++)
+    {
+        int *retrieved_value = hashtable_flat_get(ht, &i);
+        TEST_ASSERT_NOT_NULL(retrieved_value);
+        TEST_ASSERT_EQUAL_INT(i * 10, *retrieved_value);
+        free(retrieved_value);
+    }
+
+    hashtable_flat_destroy(ht);
+}
+
+void test_hashtable_flat_CollidingKeysShouldProbeAcrossGroups(void)
+{
+    hashtable_flat *ht = hashtable_flat_create(constant_hash_function, simple_compare_key_function);
+    TEST_ASSERT_NOT_NULL(ht);
+
+    /* more keys than a single group can hold, all with the same tag */
+    const int count = 3 * HASHTABLE_FLAT_GROUP_WIDTH;
+    for (int i = 0; i < count; i++)
+        TEST_ASSERT_TRUE(hashtable_flat_put(ht, &i, sizeof(i), &i, sizeof(i)));
+
+    int removed = 5;
+    TEST_ASSERT_TRUE(hashtable_flat_remove(ht, &removed));
+    TEST_ASSERT_FALSE(hashtable_flat_remove(ht, &removed));
+    TEST_ASSERT_NULL(hashtable_flat_get(ht, &removed));
+
+    /* keys placed after the tombstone must still be reachable */
+    for (int i = 0; i < count; i++)
+    {
+        if (i == removed)
+            continue;
+        int *retrieved_value = hashtable_flat_get(ht, &i);
+        TEST_ASSERT_NOT_NULL(retrieved_value);
+        TEST_ASSERT_EQUAL_INT(i, *retrieved_value);
+        free(retrieved_value);
+    }
+
+    hashtable_flat_destroy(ht);
+}
+
+void test_hashtable_flat_KeysetShouldReturnAllKeys(void)
+{
+    hashtable_flat *ht = hashtable_flat_create(simple_hash_function, simple_compare_key_function);
+    TEST_ASSERT_NOT_NULL(ht);
+
+    int keys[5] = {1, 2, 3, 4, 5};
+    char *values[5] = {"one", "two", "three", "four", "five"};
+    for (int i = 0; i < 5; i++)
+        hashtable_flat_put(ht, &keys[i], sizeof(keys[i]), values[i], strlen(values[i]) + 1);
+
+    void **keyset = hashtable_flat_keyset(ht);
+    TEST_ASSERT_NOT_NULL(keyset);
+
+    int found = 0, sum = 0;
+    for (size_t i = 0; keyset[i] != NULL; i++)
+    {
+        found++;
+        sum += *(int *)keyset[i];
+    }
+    TEST_ASSERT_EQUAL_INT(5, found);
+    TEST_ASSERT_EQUAL_INT(15, sum);
+
+    size_t size;
+    TEST_ASSERT_TRUE(hashtable_flat_size(ht, &size));
+    TEST_ASSERT_EQUAL(5, size);
+
+    free(keyset);
+    hashtable_flat_destroy(ht);
+}
+
+#endif // TEST
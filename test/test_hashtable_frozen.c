@@ -0,0 +1,221 @@
+#ifdef TEST
+
+#include "unity.h"
+
+#include "hashtable_frozen.h"
+#include "hashtable.h"
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#define FROZEN_PATH "test_hashtable_frozen.bin"
+
+/* =================== UTILITIES =================== */
+size_t simple_hash_function(void *key)
+{
+    // Simple hash function for testing purposes
+    return (size_t)(*(int *)key);
+}
+
+size_t simple_compare_key_function(const void *key1, const void *key2)
+{
+    // Simple key comparison function for testing purposes
+    return (*(int *)key1) - (*(int *)key2);
+}
+
+size_t colliding_hash_function(void *key)
+{
+    // Every key gets the same hash, they can't be frozen
+    (void)key;
+    return 42;
+}
+
+static uint64_t fake_milliseconds = 0;
+
+uint64_t fake_clock(void)
+{
+    // Time only moves when a test says so
+    return fake_milliseconds;
+}
+/* ================================================ */
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+    remove(FROZEN_PATH);
+}
+
+void test_hashtable_frozen_InvalidArgumentsShouldFail(void)
+{
+    TEST_ASSERT_NULL(hashtable_freeze(NULL));
+    TEST_ASSERT_NULL(hashtable_frozen_get(NULL, "key", NULL));
+    TEST_ASSERT_FALSE(hashtable_frozen_save(NULL, FROZEN_PATH));
+    TEST_ASSERT_NULL(hashtable_frozen_open_mmap("missing_frozen.bin", simple_hash_function, simple_compare_key_function));
+    TEST_ASSERT_FALSE(hashtable_frozen_verify(NULL));
+
+    hashtable *ht = hashtable_create(colliding_hash_function, simple_compare_key_function);
+    TEST_ASSERT_NOT_NULL(ht);
+    for (int i = 0; i < 3; i++)
+        TEST_ASSERT_TRUE(hashtable_put(ht, &i, sizeof(i), &i, sizeof(i)));
+    TEST_ASSERT_NULL(hashtable_freeze(ht));
+    hashtable_destroy(ht);
+}
+
+void test_hashtable_frozen_EveryKeyShouldGetItsOwnSlot(void)
+{
+    hashtable *ht = hashtable_create(simple_hash_function, simple_compare_key_function);
+    TEST_ASSERT_NOT_NULL(ht);
+
+    const int count = 5000;
+    char value[32];
+    for (int i = 0; i < count; i++)
+    {
+        snprintf(value, sizeof(value), "value %d", i);
+        TEST_ASSERT_TRUE(hashtable_put(ht, &i, sizeof(i), value, strlen(value) + 1));
+    }
+
+    hashtable_frozen *frozen = hashtable_freeze(ht);
+    hashtable_destroy(ht);
+    TEST_ASSERT_NOT_NULL(frozen);
+    TEST_ASSERT_TRUE(hashtable_frozen_verify(frozen));
+
+    size_t size;
+    TEST_ASSERT_TRUE(hashtable_frozen_size(frozen, &size));
+    TEST_ASSERT_EQUAL(count, size);
+
+    for (int i = 0; i < count; i++)
+    {
+        size_t value_size = 0;
+        const char *stored = hashtable_frozen_get(frozen, &i, &value_size);
+        snprintf(value, sizeof(value), "value %d", i);
+        TEST_ASSERT_NOT_NULL(stored);
+        TEST_ASSERT_EQUAL_STRING(value, stored);
+        TEST_ASSERT_EQUAL(strlen(value) + 1, value_size);
+    }
+    for (int i = count; i < 2 * count; i++)
+        TEST_ASSERT_NULL(hashtable_frozen_get(frozen, &i, NULL));
+
+    hashtable_frozen_destroy(frozen);
+}
+
+void test_hashtable_frozen_ExpiredPairsShouldNotBeFrozen(void)
+{
+    hashtable *ht = hashtable_create(simple_hash_function, simple_compare_key_function);
+    TEST_ASSERT_NOT_NULL(ht);
+    fake_milliseconds = 1000;
+    TEST_ASSERT_TRUE(hashtable_set_clock(ht, fake_clock));
+
+    /* even keys expire and aren't reclaimed before the freeze */
+    for (int i = 0; i < 100; i++)
+        TEST_ASSERT_TRUE(i % 2 == 0 ? hashtable_put_ttl(ht, &i, sizeof(i), &i, sizeof(i), 50)
+                                    : hashtable_put(ht, &i, sizeof(i), &i, sizeof(i)));
+    fake_milliseconds = 1050;
+    hashtable_frozen *frozen = hashtable_freeze(ht);
+    hashtable_destroy(ht);
+    TEST_ASSERT_NOT_NULL(frozen);
+    TEST_ASSERT_TRUE(hashtable_frozen_verify(frozen));
+
+    size_t size;
+    TEST_ASSERT_TRUE(hashtable_frozen_size(frozen, &size));
+    TEST_ASSERT_EQUAL(50, size);
+    for (int i = 0; i < 100; i++)
+    {
+        const int *stored = hashtable_frozen_get(frozen, &i, NULL);
+        if (i % 2 == 0)
+            TEST_ASSERT_NULL(stored);
+        else
+        {
+            TEST_ASSERT_NOT_NULL(stored);
+            TEST_ASSERT_EQUAL_INT(i, *stored);
+        }
+    }
+    hashtable_frozen_destroy(frozen);
+}
+
+void test_hashtable_frozen_EmptyTableShouldFreeze(void)
+{
+    hashtable *ht = hashtable_create(simple_hash_function, simple_compare_key_function);
+    TEST_ASSERT_NOT_NULL(ht);
+    hashtable_frozen *frozen = hashtable_freeze(ht);
+    hashtable_destroy(ht);
+    TEST_ASSERT_NOT_NULL(frozen);
+
+    int key = 1;
+    TEST_ASSERT_NULL(hashtable_frozen_get(frozen, &key, NULL));
+    TEST_ASSERT_TRUE(hashtable_frozen_verify(frozen));
+    hashtable_frozen_destroy(frozen);
+}
+
+void test_hashtable_frozen_SaveAndOpenShouldServeTheSameImage(void)
+{
+    hashtable *ht = hashtable_create_seeded(hash_bytes, compare_bytes, 0);
+    TEST_ASSERT_NOT_NULL(ht);
+
+    const char *keys[] = {"alpha", "beta", "gamma", "delta", "a key longer than sixteen bytes"};
+    for (size_t i = 0; i < 5; i++)
+        TEST_ASSERT_TRUE(hashtable_put(ht, keys[i], strlen(keys[i]) + 1, &i, sizeof(i)));
+
+    hashtable_frozen *frozen = hashtable_freeze(ht);
+    hashtable_destroy(ht);
+    TEST_ASSERT_NOT_NULL(frozen);
+    TEST_ASSERT_TRUE(hashtable_frozen_save(frozen, FROZEN_PATH));
+    hashtable_frozen_destroy(frozen);
+
+    TEST_ASSERT_NULL(hashtable_frozen_open_mmap(FROZEN_PATH, simple_hash_function, simple_compare_key_function));
+    frozen = hashtable_frozen_open_mmap_seeded(FROZEN_PATH, hash_bytes, compare_bytes);
+    TEST_ASSERT_NOT_NULL(frozen);
+    TEST_ASSERT_TRUE(frozen->mapped);
+    TEST_ASSERT_TRUE(hashtable_frozen_verify(frozen));
+
+    for (size_t i = 0; i < 5; i++)
+    {
+        const size_t *value = hashtable_frozen_get(frozen, keys[i], NULL);
+        TEST_ASSERT_NOT_NULL(value);
+        TEST_ASSERT_EQUAL(i, *value);
+    }
+    TEST_ASSERT_NULL(hashtable_frozen_get(frozen, "epsilon", NULL));
+
+    hashtable_frozen_destroy(frozen);
+}
+
+void test_hashtable_frozen_FixedSizePairsShouldUseFixedRecords(void)
+{
+    hashtable *ht = hashtable_create(simple_hash_function, simple_compare_key_function);
+    TEST_ASSERT_NOT_NULL(ht);
+
+    const int count = 3000;
+    for (int i = 0; i < count; i++)
+    {
+        long value = -i;
+        TEST_ASSERT_TRUE(hashtable_put(ht, &i, sizeof(i), &value, sizeof(value)));
+    }
+
+    hashtable_frozen *frozen = hashtable_freeze(ht);
+    hashtable_destroy(ht);
+    TEST_ASSERT_NOT_NULL(frozen);
+    TEST_ASSERT_NULL(frozen->offsets);
+    TEST_ASSERT_TRUE(hashtable_frozen_save(frozen, FROZEN_PATH));
+    hashtable_frozen_destroy(frozen);
+
+    frozen = hashtable_frozen_open_mmap(FROZEN_PATH, simple_hash_function, simple_compare_key_function);
+    TEST_ASSERT_NOT_NULL(frozen);
+    TEST_ASSERT_TRUE(hashtable_frozen_verify(frozen));
+
+    for (int i = 0; i < count; i++)
+    {
+        size_t value_size = 0;
+        const long *value = hashtable_frozen_get(frozen, &i, &value_size);
+        TEST_ASSERT_NOT_NULL(value);
+        TEST_ASSERT_EQUAL(-i, *value);
+        TEST_ASSERT_EQUAL(sizeof(long), value_size);
+    }
+    for (int i = count; i < 2 * count; i++)
+        TEST_ASSERT_NULL(hashtable_frozen_get(frozen, &i, NULL));
+
+    hashtable_frozen_destroy(frozen);
+}
+
+#endif // TEST
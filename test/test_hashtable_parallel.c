@@ -0,0 +1,125 @@
+#ifdef TEST
+
+#include "unity.h"
+
+#include "hashtable_parallel.h"
+#include "hashtable.h"
+#include "threadpool.h"
+#include "queue.h"
+#include <stdlib.h>
+
+/* =================== UTILITIES =================== */
+size_t simple_hash_function(void *key)
+{
+    // Simple hash function for testing purposes
+    return (*(int *)key);
+}
+
+size_t simple_compare_key_function(const void *key1, const void *key2)
+{
+    // Simple key comparison function for testing purposes
+    return (*(int *)key1) - (*(int *)key2);
+}
+/* ================================================ */
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+void test_hashtable_parallel_BuildParallelShouldMatchPutMany(void)
+{
+    enum { COUNT = 20000 };
+    int *keys = malloc(COUNT * sizeof(int));
+    int *values = malloc(COUNT * sizeof(int));
+    hashtable_entry *entries = malloc(COUNT * sizeof(hashtable_entry));
+    TEST_ASSERT_NOT_NULL(keys);
+    TEST_ASSERT_NOT_NULL(values);
+    TEST_ASSERT_NOT_NULL(entries);
+
+    /* every key appears twice, the last value must win like with sequential puts */
+    for (int i = 0; i < COUNT; i++)
+    {
+        keys[i] = i % (COUNT / 2);
+        values[i] = i;
+        entries[i] = (hashtable_entry){ &keys[i], sizeof(int), &values[i], sizeof(int) };
+    }
+
+    threadpool *tp = threadpool_create(4);
+    TEST_ASSERT_NOT_NULL(tp);
+    hashtable *ht = hashtable_create(simple_hash_function, simple_compare_key_function);
+    TEST_ASSERT_NOT_NULL(ht);
+
+    int key = -1, value = -1;
+    TEST_ASSERT_TRUE(hashtable_put(ht, &key, sizeof(key), &value, sizeof(value)));
+    TEST_ASSERT_TRUE(hashtable_build_parallel(ht, entries, COUNT, tp));
+
+    size_t size;
+    TEST_ASSERT_TRUE(hashtable_size(ht, &size));
+    TEST_ASSERT_EQUAL(COUNT / 2 + 1, size);
+    for (int i = -1; i < COUNT / 2; i++)
+    {
+        const int *stored = hashtable_get_ref(ht, &i, NULL);
+        TEST_ASSERT_NOT_NULL(stored);
+        TEST_ASSERT_EQUAL_INT(i == -1 ? -1 : i + COUNT / 2, *stored);
+    }
+
+    /* an invalid entry fails the build before anything is stored */
+    hashtable *empty = hashtable_create(simple_hash_function, simple_compare_key_function);
+    TEST_ASSERT_NOT_NULL(empty);
+    entries[COUNT - 1].value = NULL;
+    TEST_ASSERT_FALSE(hashtable_build_parallel(empty, entries, COUNT, tp));
+    TEST_ASSERT_FALSE(hashtable_build_parallel(empty, entries, COUNT, NULL));
+    TEST_ASSERT_EQUAL(0, empty->pair_number);
+
+    hashtable_destroy(empty);
+    hashtable_destroy(ht);
+    threadpool_destroy(tp, false);
+    free(entries);
+    free(values);
+    free(keys);
+}
+
+void test_hashtable_parallel_ParallelRehashShouldKeepAllPairs(void)
+{
+    const int count = HASHTABLE_PARALLEL_REHASH_MIN;
+    threadpool *tp = threadpool_create(4);
+    TEST_ASSERT_NOT_NULL(tp);
+    hashtable *ht = hashtable_create(simple_hash_function, simple_compare_key_function);
+    TEST_ASSERT_NOT_NULL(ht);
+    TEST_ASSERT_TRUE(hashtable_set_threadpool(ht, tp));
+
+    for (int i = 0; i < count; i++)
+        TEST_ASSERT_TRUE(hashtable_put(ht, &i, sizeof(i), &i, sizeof(i)));
+    TEST_ASSERT_EQUAL(2 * HASHTABLE_PARALLEL_REHASH_MIN, ht->buckets_size);
+    TEST_ASSERT_NULL(ht->old_buckets);
+
+    /* shrinking back below the minimum goes through a parallel rehash too */
+    for (int i = 0; i < count - 100; i++)
+        TEST_ASSERT_TRUE(hashtable_remove(ht, &i));
+    TEST_ASSERT_TRUE(ht->buckets_size < HASHTABLE_PARALLEL_REHASH_MIN);
+
+    size_t size;
+    TEST_ASSERT_TRUE(hashtable_size(ht, &size));
+    TEST_ASSERT_EQUAL(100, size);
+    for (int i = 0; i < count; i++)
+    {
+        const int *stored = hashtable_get_ref(ht, &i, NULL);
+        if (i < count - 100)
+            TEST_ASSERT_NULL(stored);
+        else
+        {
+            TEST_ASSERT_NOT_NULL(stored);
+            TEST_ASSERT_EQUAL_INT(i, *stored);
+        }
+    }
+
+    TEST_ASSERT_TRUE(hashtable_set_threadpool(ht, NULL));
+    hashtable_destroy(ht);
+    threadpool_destroy(tp, false);
+}
+
+#endif // TEST
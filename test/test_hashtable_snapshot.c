@@ -0,0 +1,215 @@
+#ifdef TEST
+
+#include "unity.h"
+
+#include "hashtable_snapshot.h"
+#include "hashtable.h"
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#define SNAPSHOT_PATH "test_hashtable_snapshot.bin"
+
+/* =================== UTILITIES =================== */
+size_t simple_hash_function(void *key)
+{
+    // Simple hash function for testing purposes
+    return (size_t)(*(int *)key);
+}
+
+size_t simple_compare_key_function(const void *key1, const void *key2)
+{
+    // Simple key comparison function for testing purposes
+    return (*(int *)key1) - (*(int *)key2);
+}
+
+static uint64_t fake_milliseconds = 0;
+
+uint64_t fake_clock(void)
+{
+    // Time only moves when a test says so
+    return fake_milliseconds;
+}
+
+/* flips one byte of the snapshot file */
+void corrupt_snapshot(const long offset)
+{
+    FILE *file = fopen(SNAPSHOT_PATH, "r+b");
+    TEST_ASSERT_NOT_NULL(file);
+    TEST_ASSERT_EQUAL_INT(0, fseek(file, offset, SEEK_SET));
+    int byte = fgetc(file);
+    TEST_ASSERT_EQUAL_INT(0, fseek(file, offset, SEEK_SET));
+    fputc(byte ^ 0xFF, file);
+    fclose(file);
+}
+/* ================================================ */
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+    remove(SNAPSHOT_PATH);
+}
+
+void test_hashtable_snapshot_InvalidArgumentsShouldFail(void)
+{
+    TEST_ASSERT_FALSE(hashtable_save(NULL, SNAPSHOT_PATH));
+    TEST_ASSERT_NULL(hashtable_open_mmap(NULL, simple_hash_function, simple_compare_key_function));
+    TEST_ASSERT_NULL(hashtable_open_mmap(SNAPSHOT_PATH, NULL, simple_compare_key_function));
+    TEST_ASSERT_NULL(hashtable_open_mmap("missing_snapshot.bin", simple_hash_function, simple_compare_key_function));
+    TEST_ASSERT_NULL(hashtable_snapshot_get(NULL, "key", NULL));
+    TEST_ASSERT_FALSE(hashtable_snapshot_verify(NULL));
+}
+
+void test_hashtable_snapshot_ShouldServeEverySavedPair(void)
+{
+    hashtable *ht = hashtable_create(simple_hash_function, simple_compare_key_function);
+    TEST_ASSERT_NOT_NULL(ht);
+    TEST_ASSERT_TRUE(hashtable_set_incremental_resize(ht, true));
+
+    /* values of different sizes, saved in the middle of an incremental resize */
+    char value[64];
+    for (int i = 0; i < 800; i++)
+    {
+        snprintf(value, sizeof(value), "value %d", i);
+        TEST_ASSERT_TRUE(hashtable_put(ht, &i, sizeof(i), value, strlen(value) + 1));
+    }
+    TEST_ASSERT_NOT_NULL(ht->old_buckets);
+    TEST_ASSERT_TRUE(hashtable_save(ht, SNAPSHOT_PATH));
+    hashtable_destroy(ht);
+
+    hashtable_snapshot *snapshot = hashtable_open_mmap(SNAPSHOT_PATH, simple_hash_function, simple_compare_key_function);
+    TEST_ASSERT_NOT_NULL(snapshot);
+    TEST_ASSERT_TRUE(hashtable_snapshot_verify(snapshot));
+
+    size_t size;
+    TEST_ASSERT_TRUE(hashtable_snapshot_size(snapshot, &size));
+    TEST_ASSERT_EQUAL(800, size);
+
+    for (int i = 0; i < 800; i++)
+    {
+        size_t value_size = 0;
+        const char *stored = hashtable_snapshot_get(snapshot, &i, &value_size);
+        snprintf(value, sizeof(value), "value %d", i);
+        TEST_ASSERT_NOT_NULL(stored);
+        TEST_ASSERT_EQUAL_STRING(value, stored);
+        TEST_ASSERT_EQUAL(strlen(value) + 1, value_size);
+    }
+    int missing = 800;
+    TEST_ASSERT_NULL(hashtable_snapshot_get(snapshot, &missing, NULL));
+
+    /* a seeded open doesn't match a snapshot of a plain table */
+    TEST_ASSERT_NULL(hashtable_open_mmap_seeded(SNAPSHOT_PATH, hash_bytes, compare_bytes));
+
+    hashtable_snapshot_close(snapshot);
+}
+
+void test_hashtable_snapshot_SeededTableShouldKeepItsSeed(void)
+{
+    hashtable *ht = hashtable_create_seeded(hash_bytes, compare_bytes, 0);
+    TEST_ASSERT_NOT_NULL(ht);
+
+    const char *keys[] = {"alpha", "beta", "gamma", "a key longer than sixteen bytes"};
+    for (size_t i = 0; i < 4; i++)
+        TEST_ASSERT_TRUE(hashtable_put(ht, keys[i], strlen(keys[i]) + 1, &i, sizeof(i)));
+    TEST_ASSERT_TRUE(hashtable_save(ht, SNAPSHOT_PATH));
+    hashtable_destroy(ht);
+
+    TEST_ASSERT_NULL(hashtable_open_mmap(SNAPSHOT_PATH, simple_hash_function, simple_compare_key_function));
+    hashtable_snapshot *snapshot = hashtable_open_mmap_seeded(SNAPSHOT_PATH, hash_bytes, compare_bytes);
+    TEST_ASSERT_NOT_NULL(snapshot);
+
+    for (size_t i = 0; i < 4; i++)
+    {
+        const size_t *value = hashtable_snapshot_get(snapshot, keys[i], NULL);
+        TEST_ASSERT_NOT_NULL(value);
+        TEST_ASSERT_EQUAL(i, *value);
+    }
+    TEST_ASSERT_NULL(hashtable_snapshot_get(snapshot, "delta", NULL));
+
+    hashtable_snapshot_close(snapshot);
+}
+
+void test_hashtable_snapshot_ExpiredPairsShouldNotBeSaved(void)
+{
+    hashtable *ht = hashtable_create(simple_hash_function, simple_compare_key_function);
+    TEST_ASSERT_NOT_NULL(ht);
+    fake_milliseconds = 1000;
+    TEST_ASSERT_TRUE(hashtable_set_clock(ht, fake_clock));
+
+    /* even keys expire and aren't reclaimed before the save */
+    for (int i = 0; i < 100; i++)
+        TEST_ASSERT_TRUE(i % 2 == 0 ? hashtable_put_ttl(ht, &i, sizeof(i), &i, sizeof(i), 50)
+                                    : hashtable_put(ht, &i, sizeof(i), &i, sizeof(i)));
+    fake_milliseconds = 1050;
+    TEST_ASSERT_TRUE(hashtable_save(ht, SNAPSHOT_PATH));
+    hashtable_destroy(ht);
+
+    hashtable_snapshot *snapshot = hashtable_open_mmap(SNAPSHOT_PATH, simple_hash_function, simple_compare_key_function);
+    TEST_ASSERT_NOT_NULL(snapshot);
+    TEST_ASSERT_TRUE(hashtable_snapshot_verify(snapshot));
+    size_t size;
+    TEST_ASSERT_TRUE(hashtable_snapshot_size(snapshot, &size));
+    TEST_ASSERT_EQUAL(50, size);
+    for (int i = 0; i < 100; i++)
+    {
+        const int *stored = hashtable_snapshot_get(snapshot, &i, NULL);
+        if (i % 2 == 0)
+            TEST_ASSERT_NULL(stored);
+        else
+        {
+            TEST_ASSERT_NOT_NULL(stored);
+            TEST_ASSERT_EQUAL_INT(i, *stored);
+        }
+    }
+    hashtable_snapshot_close(snapshot);
+}
+
+void test_hashtable_snapshot_EmptyTableShouldRoundTrip(void)
+{
+    hashtable *ht = hashtable_create(simple_hash_function, simple_compare_key_function);
+    TEST_ASSERT_NOT_NULL(ht);
+    TEST_ASSERT_TRUE(hashtable_save(ht, SNAPSHOT_PATH));
+    hashtable_destroy(ht);
+
+    hashtable_snapshot *snapshot = hashtable_open_mmap(SNAPSHOT_PATH, simple_hash_function, simple_compare_key_function);
+    TEST_ASSERT_NOT_NULL(snapshot);
+    TEST_ASSERT_TRUE(hashtable_snapshot_verify(snapshot));
+
+    int key = 1;
+    TEST_ASSERT_NULL(hashtable_snapshot_get(snapshot, &key, NULL));
+    hashtable_snapshot_close(snapshot);
+}
+
+void test_hashtable_snapshot_CorruptionShouldBeDetected(void)
+{
+    hashtable *ht = hashtable_create(simple_hash_function, simple_compare_key_function);
+    TEST_ASSERT_NOT_NULL(ht);
+    for (int i = 0; i < 100; i++)
+        TEST_ASSERT_TRUE(hashtable_put(ht, &i, sizeof(i), &i, sizeof(i)));
+    TEST_ASSERT_TRUE(hashtable_save(ht, SNAPSHOT_PATH));
+
+    /* a damaged header is rejected on open */
+    corrupt_snapshot(offsetof(hashtable_snapshot_header, pair_number));
+    TEST_ASSERT_NULL(hashtable_open_mmap(SNAPSHOT_PATH, simple_hash_function, simple_compare_key_function));
+
+    /* a damaged value is only found by verify */
+    TEST_ASSERT_TRUE(hashtable_save(ht, SNAPSHOT_PATH));
+    hashtable_destroy(ht);
+
+    FILE *file = fopen(SNAPSHOT_PATH, "rb");
+    TEST_ASSERT_NOT_NULL(file);
+    fseek(file, 0, SEEK_END);
+    long file_size = ftell(file);
+    fclose(file);
+    corrupt_snapshot(file_size - 8);
+
+    hashtable_snapshot *snapshot = hashtable_open_mmap(SNAPSHOT_PATH, simple_hash_function, simple_compare_key_function);
+    TEST_ASSERT_NOT_NULL(snapshot);
+    TEST_ASSERT_FALSE(hashtable_snapshot_verify(snapshot));
+    hashtable_snapshot_close(snapshot);
+}
+
+#endif // TEST
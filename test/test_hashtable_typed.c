@@ -0,0 +1,177 @@
+#ifdef TEST
+
+#include "unity.h"
+
+#include "hashtable_typed.h"
+#include <string.h>
+#include <stdlib.h>
+
+/* =================== UTILITIES =================== */
+struct point
+{
+    int x;
+    int y;
+};
+
+HASHTABLE_DECLARE(point_map, uint64_t, struct point, hashtable_typed_hash_int, HASHTABLE_TYPED_EQUAL)
+
+size_t collide_hash(const int key)
+{
+    // Every key in the same slot to exercise probing and backward shifts
+    (void)key;
+    return 7;
+}
+
+bool int_equal(const int key1, const int key2)
+{
+    return key1 == key2;
+}
+
+HASHTABLE_DECLARE(colliding_map, int, int, collide_hash, int_equal)
+/* ================================================ */
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+void test_hashtable_typed_PutGetRemoveShouldWorkCorrectly(void)
+{
+    point_map *ht = point_map_create();
+    TEST_ASSERT_NOT_NULL(ht);
+
+    TEST_ASSERT_FALSE(point_map_put(NULL, 1, (struct point){ 1, 2 }));
+    TEST_ASSERT_NULL(point_map_get(NULL, 1));
+
+    TEST_ASSERT_TRUE(point_map_put(ht, 1, (struct point){ 1, 2 }));
+    struct point *point = point_map_get(ht, 1);
+    TEST_ASSERT_NOT_NULL(point);
+    TEST_ASSERT_EQUAL_INT(1, point->x);
+    TEST_ASSERT_EQUAL_INT(2, point->y);
+
+    TEST_ASSERT_TRUE(point_map_put(ht, 1, (struct point){ 3, 4 }));
+    TEST_ASSERT_EQUAL_INT(3, point_map_get(ht, 1)->x);
+    TEST_ASSERT_NULL(point_map_get(ht, 2));
+
+    size_t size;
+    TEST_ASSERT_TRUE(point_map_size(ht, &size));
+    TEST_ASSERT_EQUAL(1, size);
+
+    TEST_ASSERT_TRUE(point_map_remove(ht, 1));
+    TEST_ASSERT_FALSE(point_map_remove(ht, 1));
+    TEST_ASSERT_NULL(point_map_get(ht, 1));
+    TEST_ASSERT_TRUE(point_map_size(ht, &size));
+    TEST_ASSERT_EQUAL(0, size);
+
+    point_map_destroy(ht);
+}
+
+void test_hashtable_typed_ResizeAndReserveShouldKeepAllPairs(void)
+{
+    point_map *ht = point_map_create();
+    TEST_ASSERT_NOT_NULL(ht);
+
+    TEST_ASSERT_TRUE(point_map_reserve(ht, 1000));
+    size_t reserved_capacity = ht->capacity;
+    TEST_ASSERT_TRUE(reserved_capacity / 4 * 3 >= 1000);
+
+    for (uint64_t i = 0; i < 1000; i++)
+        TEST_ASSERT_TRUE(point_map_put(ht, i << 32, (struct point){ (int)i, -(int)i }));
+    TEST_ASSERT_EQUAL(reserved_capacity, ht->capacity);
+
+    for (uint64_t i = 1000; i < 10000; i++)
+        TEST_ASSERT_TRUE(point_map_put(ht, i << 32, (struct point){ (int)i, -(int)i }));
+    TEST_ASSERT_TRUE(ht->capacity > reserved_capacity);
+
+    for (uint64_t i = 0; i < 10000; i++)
+    {
+        struct point *point = point_map_get(ht, i << 32);
+        TEST_ASSERT_NOT_NULL(point);
+        TEST_ASSERT_EQUAL_INT((int)i, point->x);
+    }
+
+    point_map_destroy(ht);
+}
+
+void test_hashtable_typed_RemoveShouldKeepProbeSequencesIntact(void)
+{
+    colliding_map *ht = colliding_map_create();
+    TEST_ASSERT_NOT_NULL(ht);
+
+    /* one long cluster wrapping around the end of the array */
+    for (int i = 0; i < 12; i++)
+        TEST_ASSERT_TRUE(colliding_map_put(ht, i, i * 10));
+
+    for (int i = 0; i < 12; i += 3)
+        TEST_ASSERT_TRUE(colliding_map_remove(ht, i));
+
+    for (int i = 0; i < 12; i++)
+    {
+        int *value = colliding_map_get(ht, i);
+        if (i % 3 == 0)
+            TEST_ASSERT_NULL(value);
+        else
+        {
+            TEST_ASSERT_NOT_NULL(value);
+            TEST_ASSERT_EQUAL_INT(i * 10, *value);
+        }
+    }
+
+    /* no tombstones left behind: the cluster is exactly as long as the remaining pairs */
+    size_t used = 0;
+    for (size_t i = 0; i < ht->capacity; i++)
+        used += ht->ctrl[i] != HASHTABLE_TYPED_CTRL_EMPTY;
+    TEST_ASSERT_EQUAL(8, used);
+
+    colliding_map_destroy(ht);
+}
+
+void test_hashtable_typed_ShouldMatchReferenceUnderRandomOperations(void)
+{
+    point_map *ht = point_map_create();
+    TEST_ASSERT_NOT_NULL(ht);
+
+    enum { KEYS = 512 };
+    int reference[KEYS];
+    memset(reference, -1, sizeof(reference));
+
+    unsigned int seed = 1;
+    for (int i = 0; i < 100000; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        uint64_t key = (seed >> 8) % KEYS;
+        if ((seed >> 4) % 3 == 0)
+        {
+            TEST_ASSERT_EQUAL(reference[key] != -1, point_map_remove(ht, key));
+            reference[key] = -1;
+        }
+        else
+        {
+            TEST_ASSERT_TRUE(point_map_put(ht, key, (struct point){ i, 0 }));
+            reference[key] = i;
+        }
+    }
+
+    size_t size, expected = 0;
+    for (uint64_t key = 0; key < KEYS; key++)
+    {
+        struct point *point = point_map_get(ht, key);
+        if (reference[key] == -1)
+            TEST_ASSERT_NULL(point);
+        else
+        {
+            TEST_ASSERT_NOT_NULL(point);
+            TEST_ASSERT_EQUAL_INT(reference[key], point->x);
+            expected++;
+        }
+    }
+    TEST_ASSERT_TRUE(point_map_size(ht, &size));
+    TEST_ASSERT_EQUAL(expected, size);
+
+    point_map_destroy(ht);
+}
+
+#endif // TEST
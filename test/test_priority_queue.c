@@ -0,0 +1,246 @@
+#ifdef TEST
+
+#include "unity.h"
+
+#include "priority_queue.h"
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+
+#define ELEMENTS 5000
+
+/* =================== UTILITIES =================== */
+struct job
+{
+    uint32_t priority;
+    uint32_t id;
+};
+
+int compare_int(const void *elem1, const void *elem2)
+{
+    // Smallest first
+    int a = *(const int *)elem1, b = *(const int *)elem2;
+    return (a > b) - (a < b);
+}
+
+int compare_job(const void *elem1, const void *elem2)
+{
+    // Smallest priority first, ties broken by id so the order is fully determined
+    const struct job *a = elem1, *b = elem2;
+    if (a->priority != b->priority)
+        return a->priority < b->priority ? -1 : 1;
+    return (a->id > b->id) - (a->id < b->id);
+}
+
+static unsigned int next_random(unsigned int *seed)
+{
+    *seed = *seed * 1103515245 + 12345;
+    return *seed >> 8;
+}
+/* ================================================ */
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+void test_priority_queue_InvalidArgumentsShouldFail(void)
+{
+    int value = 1;
+    priority_queue_handle handle;
+    size_t size;
+    TEST_ASSERT_NULL(priority_queue_create(0, 4, compare_int));
+    TEST_ASSERT_NULL(priority_queue_create(sizeof(int), 4, NULL));
+    TEST_ASSERT_NULL(priority_queue_create(sizeof(int), 1, compare_int));
+    TEST_ASSERT_NULL(priority_queue_create(sizeof(int), 6, compare_int));
+    TEST_ASSERT_NULL(priority_queue_create(sizeof(int), 2 * PRIORITY_QUEUE_MAX_ARITY, compare_int));
+    TEST_ASSERT_FALSE(priority_queue_push(NULL, &value, NULL));
+    TEST_ASSERT_FALSE(priority_queue_pop(NULL, &value));
+    TEST_ASSERT_NULL(priority_queue_peek(NULL));
+    TEST_ASSERT_FALSE(priority_queue_size(NULL, &size));
+
+    /* handles only exist in a tracked queue */
+    priority_queue *pq = priority_queue_create(sizeof(int), 4, compare_int);
+    TEST_ASSERT_NOT_NULL(pq);
+    TEST_ASSERT_FALSE(priority_queue_push(pq, NULL, NULL));
+    TEST_ASSERT_FALSE(priority_queue_push(pq, &value, &handle));
+    TEST_ASSERT_FALSE(priority_queue_push_n(pq, &value, 1, &handle));
+    TEST_ASSERT_TRUE(priority_queue_push(pq, &value, NULL));
+    TEST_ASSERT_FALSE(priority_queue_update(pq, 0, &value));
+    TEST_ASSERT_FALSE(priority_queue_remove(pq, 0, NULL));
+    TEST_ASSERT_FALSE(priority_queue_pop(pq, NULL));
+    priority_queue_destroy(pq);
+
+    pq = priority_queue_create_tracked(sizeof(int), 4, compare_int);
+    TEST_ASSERT_NOT_NULL(pq);
+    TEST_ASSERT_FALSE(priority_queue_update(pq, 0, &value));
+    TEST_ASSERT_TRUE(priority_queue_push(pq, &value, &handle));
+    TEST_ASSERT_TRUE(priority_queue_pop(pq, &value));
+    TEST_ASSERT_FALSE(priority_queue_update(pq, handle, &value));
+    TEST_ASSERT_FALSE(priority_queue_remove(pq, handle, NULL));
+    priority_queue_destroy(pq);
+}
+
+void test_priority_queue_ShouldPopInOrderForEveryArity(void)
+{
+    size_t arities[] = {2, 4, 8, 16};
+    for (size_t a = 0; a < sizeof(arities) / sizeof(arities[0]); a++)
+    {
+        priority_queue *pq = priority_queue_create(sizeof(struct job), arities[a], compare_job);
+        TEST_ASSERT_NOT_NULL(pq);
+
+        /* few distinct priorities, the ids keep the expected order unique */
+        unsigned int seed = 7;
+        for (uint32_t i = 0; i < ELEMENTS; i++)
+        {
+            struct job job = { next_random(&seed) % 100, i };
+            TEST_ASSERT_TRUE(priority_queue_push(pq, &job, NULL));
+        }
+        size_t size;
+        TEST_ASSERT_TRUE(priority_queue_size(pq, &size));
+        TEST_ASSERT_EQUAL(ELEMENTS, size);
+        /* sibling groups are aligned to their size, up to a cache line */
+        size_t group = arities[a] * sizeof(struct job) < PRIORITY_QUEUE_CACHE_LINE ? arities[a] * sizeof(struct job)
+                                                                                   : PRIORITY_QUEUE_CACHE_LINE;
+        TEST_ASSERT_EQUAL(0, (uintptr_t)(pq->elements + sizeof(struct job)) % group);
+
+        struct job previous = { 0, 0 }, job;
+        for (size_t i = 0; i < ELEMENTS; i++)
+        {
+            const struct job *top = priority_queue_peek(pq);
+            TEST_ASSERT_NOT_NULL(top);
+            struct job expected = *top;
+            TEST_ASSERT_TRUE(priority_queue_pop(pq, &job));
+            TEST_ASSERT_EQUAL_MEMORY(&expected, &job, sizeof(job));
+            if (i > 0)
+                TEST_ASSERT_TRUE(compare_job(&previous, &job) < 0);
+            previous = job;
+        }
+        TEST_ASSERT_FALSE(priority_queue_pop(pq, &job));
+        TEST_ASSERT_NULL(priority_queue_peek(pq));
+
+        priority_queue_destroy(pq);
+    }
+}
+
+void test_priority_queue_PushNShouldHeapifyAndPopNShouldBatch(void)
+{
+    int *values = malloc(ELEMENTS * sizeof(int));
+    int *out = malloc(ELEMENTS * sizeof(int));
+    TEST_ASSERT_NOT_NULL(values);
+    TEST_ASSERT_NOT_NULL(out);
+    unsigned int seed = 11;
+    for (int i = 0; i < ELEMENTS; i++)
+        values[i] = (int)(next_random(&seed) % 1000);
+
+    /* an empty queue is built bottom up, a smaller batch into a larger queue is sifted up */
+    priority_queue *pq = priority_queue_create(sizeof(int), 8, compare_int);
+    TEST_ASSERT_NOT_NULL(pq);
+    TEST_ASSERT_TRUE(priority_queue_push_n(pq, values, ELEMENTS - 100, NULL));
+    TEST_ASSERT_TRUE(priority_queue_push_n(pq, values + ELEMENTS - 100, 100, NULL));
+    TEST_ASSERT_TRUE(priority_queue_push_n(pq, NULL, 0, NULL));
+
+    qsort(values, ELEMENTS, sizeof(int), compare_int);
+    TEST_ASSERT_EQUAL(10, priority_queue_pop_n(pq, out, 10));
+    TEST_ASSERT_EQUAL(ELEMENTS - 10, priority_queue_pop_n(pq, out + 10, ELEMENTS));
+    TEST_ASSERT_EQUAL(0, priority_queue_pop_n(pq, out, 10));
+    for (int i = 0; i < ELEMENTS; i++)
+        TEST_ASSERT_EQUAL_INT(values[i], out[i]);
+
+    priority_queue_destroy(pq);
+    free(out);
+    free(values);
+}
+
+void test_priority_queue_HandlesShouldFollowTheirElements(void)
+{
+    priority_queue *pq = priority_queue_create_tracked(sizeof(struct job), 4, compare_job);
+    TEST_ASSERT_NOT_NULL(pq);
+
+    /* a reference copy of every live job, indexed by handle */
+    struct job *reference = calloc(ELEMENTS, sizeof(struct job));
+    bool *live = calloc(ELEMENTS, sizeof(bool));
+    priority_queue_handle *handles = malloc(ELEMENTS * sizeof(priority_queue_handle));
+    TEST_ASSERT_NOT_NULL(reference);
+    TEST_ASSERT_NOT_NULL(live);
+    TEST_ASSERT_NOT_NULL(handles);
+
+    struct job jobs[ELEMENTS / 2];
+    unsigned int seed = 3;
+    for (uint32_t i = 0; i < ELEMENTS / 2; i++)
+        jobs[i] = (struct job){ next_random(&seed) % 10000, i };
+    TEST_ASSERT_TRUE(priority_queue_push_n(pq, jobs, ELEMENTS / 2, handles));
+    for (uint32_t i = 0; i < ELEMENTS / 2; i++)
+    {
+        TEST_ASSERT_TRUE(handles[i] < ELEMENTS);
+        reference[handles[i]] = jobs[i];
+        live[handles[i]] = true;
+    }
+
+    /* random decrease-keys, increase-keys, removals, pops and pushes reusing handles */
+    uint32_t next_id = ELEMENTS / 2;
+    for (int step = 0; step < 20000; step++)
+    {
+        priority_queue_handle handle = next_random(&seed) % ELEMENTS;
+        unsigned int operation = next_random(&seed) % 5;
+        struct job job;
+        if (operation <= 1)
+        {
+            job = (struct job){ operation == 0 ? reference[handle].priority / 2 : reference[handle].priority + 500,
+                                reference[handle].id };
+            TEST_ASSERT_EQUAL(live[handle], priority_queue_update(pq, handle, &job));
+            if (live[handle])
+                reference[handle] = job;
+        }
+        else if (operation == 2)
+        {
+            TEST_ASSERT_EQUAL(live[handle], priority_queue_remove(pq, handle, &job));
+            if (live[handle])
+                TEST_ASSERT_EQUAL_MEMORY(&reference[handle], &job, sizeof(job));
+            live[handle] = false;
+        }
+        else if (operation == 3)
+        {
+            if (!priority_queue_pop(pq, &job))
+                continue;
+            /* the popped job is the smallest live one */
+            for (size_t h = 0; h < ELEMENTS; h++)
+                if (live[h])
+                    TEST_ASSERT_TRUE(compare_job(&job, &reference[h]) <= 0);
+            for (size_t h = 0; h < ELEMENTS; h++)
+                if (live[h] && reference[h].id == job.id)
+                    live[h] = false;
+        }
+        else
+        {
+            job = (struct job){ next_random(&seed) % 10000, next_id++ };
+            TEST_ASSERT_TRUE(priority_queue_push(pq, &job, &handle));
+            TEST_ASSERT_TRUE(handle < ELEMENTS);
+            TEST_ASSERT_FALSE(live[handle]);
+            reference[handle] = job;
+            live[handle] = true;
+        }
+
+        if (step % 1000 == 0)
+            for (size_t h = 0; h < ELEMENTS; h++)
+                if (live[h])
+                    TEST_ASSERT_EQUAL_MEMORY(&reference[h], pq->elements + pq->positions[h] * sizeof(struct job),
+                                             sizeof(struct job));
+    }
+
+    size_t size, live_number = 0;
+    for (size_t h = 0; h < ELEMENTS; h++)
+        live_number += live[h];
+    TEST_ASSERT_TRUE(priority_queue_size(pq, &size));
+    TEST_ASSERT_EQUAL(live_number, size);
+
+    free(handles);
+    free(live);
+    free(reference);
+    priority_queue_destroy(pq);
+}
+
+#endif // TEST
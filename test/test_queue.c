@@ -5,6 +5,12 @@
 #include "queue.h"
 
 #include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+
+#define MPMC_THREADS        4
+#define MPMC_PER_PRODUCER   50000
 
 #define CHECK_NOTHING_ADDED \
     { \
@@ -15,11 +21,65 @@
 
 #define INIT_DEFAULT_VALUES \
     int val = 10; \
-    queue *q = malloc(sizeof(queue)); \
+    queue *q = calloc(1, sizeof(queue)); \
     if (q == NULL) return; \
     q->head = q->tail = NULL; \
     q->size = 0;
 
+/* =================== UTILITIES =================== */
+struct mpmc_args
+{
+    mpmc_queue *q;
+    _Atomic int received[MPMC_THREADS * MPMC_PER_PRODUCER];  // times every value was dequeued
+};
+
+struct mpmc_worker
+{
+    struct mpmc_args *shared;
+    int               id;
+    int               errors;
+};
+
+void *mpmc_producer(void *argp)
+{
+    // Enqueues `id * MPMC_PER_PRODUCER + i`, yielding while the queue is full
+    struct mpmc_worker *worker = argp;
+    for (int i = 0; i < MPMC_PER_PRODUCER; i++)
+    {
+        int value = worker->id * MPMC_PER_PRODUCER + i;
+        while (!mpmc_queue_try_enque(worker->shared->q, &value))
+            sched_yield();
+    }
+    return NULL;
+}
+
+void *mpmc_consumer(void *argp)
+{
+    // Takes its share of the values, the ones of one producer must come in order
+    struct mpmc_worker *worker = argp;
+    int last[MPMC_THREADS];
+    for (int i = 0; i < MPMC_THREADS; i++)
+        last[i] = -1;
+
+    for (int taken = 0; taken < MPMC_PER_PRODUCER;)
+    {
+        int value;
+        if (!mpmc_queue_try_deque(worker->shared->q, &value))
+        {
+            sched_yield();
+            continue;
+        }
+        int producer = value / MPMC_PER_PRODUCER;
+        if (value <= last[producer])
+            worker->errors++;
+        last[producer] = value;
+        atomic_fetch_add(&worker->shared->received[value], 1);
+        taken++;
+    }
+    return NULL;
+}
+/* ================================================ */
+
 void setUp(void)
 {
 }
@@ -213,4 +273,173 @@ void test_queue_should_ReturnCorrectDataOnDequeueWithMultipleNodes(void)
     free(q);
 }
 
+void test_queue_should_RejectInvalidFixedQueues(void)
+{
+    TEST_ASSERT_NULL(queue_create_fixed(0, 16));
+
+    queue *q = queue_create_fixed(sizeof(int), 0);
+    TEST_ASSERT_NOT_NULL(q);
+    TEST_ASSERT_EQUAL_size_t(QUEUE_FIXED_MIN_CAPACITY, q->capacity);
+
+    long wrong_size = 1;
+    int out;
+    TEST_ASSERT_FALSE(queue_enque(q, &wrong_size, sizeof(wrong_size)));
+    TEST_ASSERT_FALSE(queue_deque_into(q, &out));
+    TEST_ASSERT_NULL(queue_deque(q));
+    TEST_ASSERT_FALSE(queue_deque_into(NULL, &out));
+    TEST_ASSERT_FALSE(queue_deque_into(q, NULL));
+    TEST_ASSERT_EQUAL_INT(0, queue_size(q));
+
+    queue_destroy(q);
+}
+
+void test_queue_should_KeepFifoOrderInARingAcrossWrapsAndGrowth(void)
+{
+    queue *q = queue_create_fixed(sizeof(int), 20);
+    TEST_ASSERT_NOT_NULL(q);
+    TEST_ASSERT_EQUAL_size_t(32, q->capacity);
+
+    /* move the head around the ring, then grow while it's wrapped */
+    int next_in = 0, next_out = 0, out;
+    for (int round = 0; round < 20; round++)
+    {
+        for (int i = 0; i < 10; i++, next_in++)
+            TEST_ASSERT_TRUE(queue_enque(q, &next_in, sizeof(int)));
+        for (int i = 0; i < 9; i++, next_out++)
+        {
+            TEST_ASSERT_TRUE(queue_deque_into(q, &out));
+            TEST_ASSERT_EQUAL_INT(next_out, out);
+        }
+    }
+    TEST_ASSERT_EQUAL_INT(20, queue_size(q));
+    TEST_ASSERT_TRUE(q->first + q->size > q->capacity);
+    TEST_ASSERT_EQUAL_size_t(32, q->capacity);
+
+    for (int i = 0; i < 100; i++, next_in++)
+        TEST_ASSERT_TRUE(queue_enque(q, &next_in, sizeof(int)));
+    TEST_ASSERT_EQUAL_size_t(128, q->capacity);
+
+    int *copy = queue_deque(q);
+    TEST_ASSERT_NOT_NULL(copy);
+    TEST_ASSERT_EQUAL_INT(next_out++, *copy);
+    free(copy);
+    while (queue_deque_into(q, &out))
+        TEST_ASSERT_EQUAL_INT(next_out++, out);
+    TEST_ASSERT_EQUAL_INT(next_in, next_out);
+    TEST_ASSERT_EQUAL_INT(0, queue_size(q));
+
+    queue_destroy(q);
+}
+
+void test_queue_should_DequeIntoCallerStorageFromALinkedQueue(void)
+{
+    queue *q = queue_create();
+    TEST_ASSERT_NOT_NULL(q);
+
+    int val = 10;
+    char text[] = "text";
+    TEST_ASSERT_TRUE(queue_enque(q, &val, sizeof(int)));
+    TEST_ASSERT_TRUE(queue_enque(q, text, sizeof(text)));
+
+    int out;
+    char out_text[sizeof(text)];
+    TEST_ASSERT_TRUE(queue_deque_into(q, &out));
+    TEST_ASSERT_EQUAL_INT(10, out);
+    TEST_ASSERT_TRUE(queue_deque_into(q, out_text));
+    TEST_ASSERT_EQUAL_STRING("text", out_text);
+    TEST_ASSERT_NULL(q->head);
+    TEST_ASSERT_NULL(q->tail);
+    TEST_ASSERT_FALSE(queue_deque_into(q, &out));
+
+    queue_destroy(q);
+}
+
+void test_queue_should_RejectInvalidMpmcQueues(void)
+{
+    int val = 10;
+    TEST_ASSERT_NULL(mpmc_queue_create(0, 16));
+    TEST_ASSERT_NULL(mpmc_queue_create(sizeof(int), 0));
+    TEST_ASSERT_NULL(mpmc_queue_create(SIZE_MAX, 16));
+    TEST_ASSERT_FALSE(mpmc_queue_try_enque(NULL, &val));
+    TEST_ASSERT_FALSE(mpmc_queue_try_deque(NULL, &val));
+    TEST_ASSERT_EQUAL_INT(-1, mpmc_queue_size(NULL));
+
+    mpmc_queue *q = mpmc_queue_create(sizeof(int), 1);
+    TEST_ASSERT_NOT_NULL(q);
+    TEST_ASSERT_EQUAL_size_t(2, q->capacity);
+    TEST_ASSERT_FALSE(mpmc_queue_try_enque(q, NULL));
+    TEST_ASSERT_FALSE(mpmc_queue_try_deque(q, NULL));
+
+    mpmc_queue_destroy(q);
+}
+
+void test_queue_should_KeepFifoOrderInAnMpmcQueueUntilFull(void)
+{
+    /* 3 byte elements, the cells are padded so every sequence stays aligned */
+    mpmc_queue *q = mpmc_queue_create(3, 5);
+    TEST_ASSERT_NOT_NULL(q);
+    TEST_ASSERT_EQUAL_size_t(8, q->capacity);
+    TEST_ASSERT_EQUAL_size_t(0, q->cell_size % alignof(size_t));
+
+    unsigned char in[3], out[3];
+    TEST_ASSERT_FALSE(mpmc_queue_try_deque(q, out));
+
+    int next_in = 0, next_out = 0;
+    for (int round = 0; round < 10; round++)
+    {
+        /* fill it, then empty it, every cell is reused once per round */
+        while (true)
+        {
+            memset(in, next_in & 0xff, sizeof(in));
+            if (!mpmc_queue_try_enque(q, in))
+                break;
+            next_in++;
+        }
+        TEST_ASSERT_EQUAL_INT(8, mpmc_queue_size(q));
+
+        while (mpmc_queue_try_deque(q, out))
+        {
+            TEST_ASSERT_EQUAL_UINT8(next_out & 0xff, out[0]);
+            TEST_ASSERT_EQUAL_UINT8(next_out & 0xff, out[2]);
+            next_out++;
+        }
+        TEST_ASSERT_EQUAL_INT(0, mpmc_queue_size(q));
+    }
+    TEST_ASSERT_EQUAL_INT(80, next_in);
+    TEST_ASSERT_EQUAL_INT(80, next_out);
+
+    mpmc_queue_destroy(q);
+}
+
+void test_queue_should_DeliverEveryElementOnceWithManyProducersAndConsumers(void)
+{
+    struct mpmc_args *args = calloc(1, sizeof(struct mpmc_args));
+    TEST_ASSERT_NOT_NULL(args);
+    args->q = mpmc_queue_create(sizeof(int), 64);
+    TEST_ASSERT_NOT_NULL(args->q);
+
+    pthread_t threads[2 * MPMC_THREADS];
+    struct mpmc_worker workers[2 * MPMC_THREADS];
+    for (int i = 0; i < 2 * MPMC_THREADS; i++)
+    {
+        workers[i] = (struct mpmc_worker){ args, i % MPMC_THREADS, 0 };
+        TEST_ASSERT_EQUAL(0, pthread_create(&threads[i], NULL, i < MPMC_THREADS ? mpmc_producer : mpmc_consumer,
+                                            &workers[i]));
+    }
+    int errors = 0;
+    for (int i = 0; i < 2 * MPMC_THREADS; i++)
+    {
+        pthread_join(threads[i], NULL);
+        errors += workers[i].errors;
+    }
+
+    TEST_ASSERT_EQUAL_INT(0, errors);
+    for (int i = 0; i < MPMC_THREADS * MPMC_PER_PRODUCER; i++)
+        TEST_ASSERT_EQUAL_INT(1, args->received[i]);
+    TEST_ASSERT_EQUAL_INT(0, mpmc_queue_size(args->q));
+
+    mpmc_queue_destroy(args->q);
+    free(args);
+}
+
 #endif // TEST
@@ -0,0 +1,175 @@
+#ifdef TEST
+
+#include "unity.h"
+
+#include "spsc_queue.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+
+#define MESSAGES 1000000
+
+/* =================== UTILITIES =================== */
+struct pipe_args
+{
+    spsc_queue *q;
+    size_t      batch;
+    uint64_t    errors;
+};
+
+/**
+ * pushes the sequence 0, 1, 2, ... in batches of `batch`, yielding while
+ * the queue is full
+ */
+void *producer(void *argp)
+{
+    struct pipe_args *args = argp;
+    uint64_t buffer[64];
+    uint64_t next = 0;
+
+    while (next < MESSAGES)
+    {
+        size_t n = args->batch;
+        if (n > MESSAGES - next)
+            n = MESSAGES - next;
+        for (size_t i = 0; i < n; i++)
+            buffer[i] = next + i;
+
+        size_t pushed = 0;
+        while (pushed < n)
+        {
+            size_t count = spsc_push_n(args->q, buffer + pushed, n - pushed);
+            if (count == 0)
+                sched_yield();
+            pushed += count;
+        }
+        next += n;
+    }
+    return NULL;
+}
+
+/**
+ * pops until the whole sequence arrived, every element must be the one after
+ * the previous one
+ */
+void *consumer(void *argp)
+{
+    struct pipe_args *args = argp;
+    uint64_t buffer[64];
+    uint64_t expected = 0;
+
+    while (expected < MESSAGES)
+    {
+        size_t n = spsc_pop_n(args->q, buffer, args->batch);
+        if (n == 0)
+            sched_yield();
+        for (size_t i = 0; i < n; i++)
+            if (buffer[i] != expected++)
+                args->errors++;
+    }
+    return NULL;
+}
+/* ================================================ */
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+void test_spsc_queue_InvalidArgumentsShouldFail(void)
+{
+    int value = 0;
+    size_t size;
+    TEST_ASSERT_NULL(spsc_queue_create(0, 16));
+    TEST_ASSERT_NULL(spsc_queue_create(sizeof(int), 0));
+    TEST_ASSERT_NULL(spsc_queue_create(sizeof(int), SIZE_MAX));
+    TEST_ASSERT_FALSE(spsc_push(NULL, &value));
+    TEST_ASSERT_FALSE(spsc_pop(NULL, &value));
+    TEST_ASSERT_FALSE(spsc_queue_size(NULL, &size));
+
+    spsc_queue *q = spsc_queue_create(sizeof(int), 16);
+    TEST_ASSERT_NOT_NULL(q);
+    TEST_ASSERT_FALSE(spsc_push(q, NULL));
+    TEST_ASSERT_FALSE(spsc_pop(q, NULL));
+    TEST_ASSERT_EQUAL(0, spsc_push_n(q, &value, 0));
+    TEST_ASSERT_FALSE(spsc_queue_size(q, NULL));
+
+    spsc_queue_destroy(q);
+}
+
+void test_spsc_queue_ShouldStopAtCapacityAndKeepFifoOrderAcrossWraps(void)
+{
+    /* rounded up to 8 slots */
+    spsc_queue *q = spsc_queue_create(sizeof(int), 5);
+    TEST_ASSERT_NOT_NULL(q);
+    TEST_ASSERT_EQUAL(8, q->capacity);
+
+    int out[8];
+    TEST_ASSERT_FALSE(spsc_pop(q, out));
+    for (int i = 0; i < 8; i++)
+        TEST_ASSERT_TRUE(spsc_push(q, &i));
+    int extra = 8;
+    TEST_ASSERT_FALSE(spsc_push(q, &extra));
+
+    size_t size;
+    TEST_ASSERT_TRUE(spsc_queue_size(q, &size));
+    TEST_ASSERT_EQUAL(8, size);
+
+    /* batches straddle the end of the ring, and are cut short when full or empty */
+    int next_in = 8, next_out = 0;
+    for (int round = 0; round < 50; round++)
+    {
+        TEST_ASSERT_EQUAL(3, spsc_pop_n(q, out, 3));
+        for (int i = 0; i < 3; i++)
+            TEST_ASSERT_EQUAL_INT(next_out++, out[i]);
+
+        int in[5];
+        for (int i = 0; i < 5; i++)
+            in[i] = next_in + i;
+        TEST_ASSERT_EQUAL(3, spsc_push_n(q, in, 5));
+        next_in += 3;
+    }
+
+    TEST_ASSERT_EQUAL(8, spsc_pop_n(q, out, 10));
+    for (int i = 0; i < 8; i++)
+        TEST_ASSERT_EQUAL_INT(next_out++, out[i]);
+    TEST_ASSERT_EQUAL(0, spsc_pop_n(q, out, 10));
+    TEST_ASSERT_EQUAL_INT(next_in, next_out);
+
+    TEST_ASSERT_TRUE(spsc_queue_size(q, &size));
+    TEST_ASSERT_EQUAL(0, size);
+
+    spsc_queue_destroy(q);
+}
+
+void test_spsc_queue_ShouldDeliverEveryMessageInOrderBetweenTwoThreads(void)
+{
+    /* one element at a time, then batches larger than a quarter of the ring */
+    size_t batches[] = {1, 7, 64};
+    for (size_t b = 0; b < sizeof(batches) / sizeof(batches[0]); b++)
+    {
+        spsc_queue *q = spsc_queue_create(sizeof(uint64_t), 256);
+        TEST_ASSERT_NOT_NULL(q);
+
+        struct pipe_args args = { q, batches[b], 0 };
+        pthread_t producer_thread, consumer_thread;
+        TEST_ASSERT_EQUAL(0, pthread_create(&consumer_thread, NULL, consumer, &args));
+        TEST_ASSERT_EQUAL(0, pthread_create(&producer_thread, NULL, producer, &args));
+        pthread_join(producer_thread, NULL);
+        pthread_join(consumer_thread, NULL);
+
+        TEST_ASSERT_EQUAL(0, args.errors);
+        size_t size;
+        TEST_ASSERT_TRUE(spsc_queue_size(q, &size));
+        TEST_ASSERT_EQUAL(0, size);
+
+        spsc_queue_destroy(q);
+    }
+}
+
+#endif // TEST
@@ -0,0 +1,175 @@
+#ifdef TEST
+
+#include "unity.h"
+
+#include "string_pool.h"
+#include "hashtable.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+/* =================== UTILITIES =================== */
+static size_t string_comparisons = 0;
+
+size_t counting_compare_hashtable_string(const void *key1, const void *key2)
+{
+    // Counts the comparisons the hashtable makes after matching a hash
+    string_comparisons++;
+    return compare_hashtable_string(key1, key2);
+}
+/* ================================================ */
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+void test_string_pool_InvalidArgumentsShouldFail(void)
+{
+    size_t size;
+    TEST_ASSERT_NULL(string_pool_intern(NULL, "a", 1));
+    TEST_ASSERT_NULL(string_pool_find(NULL, "a", 1));
+    TEST_ASSERT_FALSE(string_pool_size(NULL, &size));
+
+    string_pool *pool = string_pool_create();
+    TEST_ASSERT_NOT_NULL(pool);
+    TEST_ASSERT_NULL(string_pool_intern(pool, NULL, 1));
+    TEST_ASSERT_NULL(string_pool_find(pool, "a", 1));
+    TEST_ASSERT_FALSE(string_pool_size(pool, NULL));
+    TEST_ASSERT_FALSE(string_pool_stats(pool, NULL));
+
+    string_pool_destroy(pool);
+}
+
+void test_string_pool_InternShouldStoreEveryStringOnce(void)
+{
+    string_pool *pool = string_pool_create();
+    TEST_ASSERT_NOT_NULL(pool);
+
+    /* not NUL terminated, the pool copies only `length` bytes and terminates them */
+    const char *text = "hello world";
+    const hashtable_string *hello = string_pool_intern(pool, text, 5);
+    TEST_ASSERT_NOT_NULL(hello);
+    TEST_ASSERT_EQUAL_STRING("hello", hello->data);
+    TEST_ASSERT_EQUAL(5, hello->length);
+    TEST_ASSERT_EQUAL(hashtable_string_make("hello", 5).hash, hello->hash);
+    const hashtable_string *world = string_pool_intern(pool, text + 6, 5);
+    TEST_ASSERT_NOT_NULL(world);
+    const hashtable_string *empty = string_pool_intern(pool, "", 0);
+    TEST_ASSERT_NOT_NULL(empty);
+    TEST_ASSERT_EQUAL_STRING("", empty->data);
+
+    char copy[] = "hello";
+    TEST_ASSERT_EQUAL_PTR(hello, string_pool_intern(pool, copy, strlen(copy)));
+    TEST_ASSERT_NULL(string_pool_find(pool, "hell", 4));
+    TEST_ASSERT_EQUAL_PTR(world, string_pool_find(pool, "world", 5));
+
+    /* enough strings to grow the index and fill several blocks, interned strings never move */
+    enum { COUNT = 20000 };
+    const hashtable_string **interned = malloc(COUNT * sizeof(hashtable_string *));
+    TEST_ASSERT_NOT_NULL(interned);
+    char buffer[32];
+    for (int i = 0; i < COUNT; i++)
+    {
+        int length = snprintf(buffer, sizeof(buffer), "string number %d", i);
+        interned[i] = string_pool_intern(pool, buffer, length);
+        TEST_ASSERT_NOT_NULL(interned[i]);
+    }
+    char long_string[STRING_POOL_BLOCK_SIZE];
+    memset(long_string, 'x', sizeof(long_string));
+    const hashtable_string *long_interned = string_pool_intern(pool, long_string, sizeof(long_string));
+    TEST_ASSERT_NOT_NULL(long_interned);
+    TEST_ASSERT_EQUAL(sizeof(long_string), strlen(long_interned->data));
+
+    for (int i = 0; i < COUNT; i++)
+    {
+        int length = snprintf(buffer, sizeof(buffer), "string number %d", i);
+        TEST_ASSERT_EQUAL_PTR(interned[i], string_pool_intern(pool, buffer, length));
+        TEST_ASSERT_EQUAL_STRING(buffer, interned[i]->data);
+    }
+    TEST_ASSERT_EQUAL_PTR(hello, string_pool_find(pool, "hello", 5));
+
+    size_t size;
+    TEST_ASSERT_TRUE(string_pool_size(pool, &size));
+    TEST_ASSERT_EQUAL(COUNT + 4, size);
+
+    string_pool_statistics stats;
+    TEST_ASSERT_TRUE(string_pool_stats(pool, &stats));
+    TEST_ASSERT_EQUAL(COUNT + 4, stats.string_number);
+    TEST_ASSERT_TRUE(stats.block_bytes >= stats.string_bytes);
+    TEST_ASSERT_TRUE(stats.index_bytes >= (COUNT + 4) * sizeof(hashtable_string *));
+    TEST_ASSERT_EQUAL(sizeof(string_pool) + stats.index_bytes + stats.block_bytes, stats.total_bytes);
+
+    free(interned);
+    string_pool_destroy(pool);
+}
+
+void test_string_pool_InternedKeysShouldCompareByAddress(void)
+{
+    string_pool *pool = string_pool_create();
+    TEST_ASSERT_NOT_NULL(pool);
+    hashtable *ht = hashtable_create(hash_interned_string, compare_interned_string);
+    TEST_ASSERT_NOT_NULL(ht);
+
+    const char *words[] = {"apple", "banana", "cherry", "apple", "cherry", "apple"};
+    for (size_t i = 0; i < 6; i++)
+    {
+        const hashtable_string *key = string_pool_intern(pool, words[i], strlen(words[i]));
+        TEST_ASSERT_NOT_NULL(key);
+        int *count = hashtable_get_or_insert(ht, &key, sizeof(key), NULL, sizeof(int), NULL);
+        TEST_ASSERT_NOT_NULL(count);
+        (*count)++;
+    }
+
+    size_t size;
+    TEST_ASSERT_TRUE(hashtable_size(ht, &size));
+    TEST_ASSERT_EQUAL(3, size);
+
+    char apple[] = "apple";
+    const hashtable_string *key = string_pool_find(pool, apple, strlen(apple));
+    const int *count = hashtable_get_ref(ht, &key, NULL);
+    TEST_ASSERT_NOT_NULL(count);
+    TEST_ASSERT_EQUAL_INT(3, *count);
+
+    hashtable_destroy(ht);
+    string_pool_destroy(pool);
+}
+
+void test_string_pool_LengthPrefixedKeysShouldCheckLengthBeforeBytes(void)
+{
+    hashtable *ht = hashtable_create(hash_hashtable_string, counting_compare_hashtable_string);
+    TEST_ASSERT_NOT_NULL(ht);
+
+    /* the bytes live outside of the table, only the struct is copied */
+    const char *text = "apple banana cherry";
+    hashtable_string keys[] = {
+        hashtable_string_make(text, 5),
+        hashtable_string_make(text + 6, 6),
+        hashtable_string_make(text + 13, 6),
+    };
+    for (int i = 0; i < 3; i++)
+        TEST_ASSERT_TRUE(hashtable_put(ht, &keys[i], sizeof(hashtable_string), &i, sizeof(i)));
+
+    char banana[] = "banana";
+    hashtable_string key = hashtable_string_make(banana, strlen(banana));
+    const int *index = hashtable_get_ref(ht, &key, NULL);
+    TEST_ASSERT_NOT_NULL(index);
+    TEST_ASSERT_EQUAL_INT(1, *index);
+    key = hashtable_string_make(banana, 3);
+    TEST_ASSERT_NULL(hashtable_get_ref(ht, &key, NULL));
+
+    /* only the lookup of an equal string got past the cached hash */
+    TEST_ASSERT_EQUAL(1, string_comparisons);
+
+    /* a different length is rejected without reading the bytes */
+    hashtable_string truncated = { NULL, 4, keys[0].hash };
+    TEST_ASSERT_NOT_EQUAL(0, compare_hashtable_string(&keys[0], &truncated));
+    TEST_ASSERT_EQUAL(0, compare_hashtable_string(&keys[0], &keys[0]));
+
+    hashtable_destroy(ht);
+}
+
+#endif // TEST